@@ -1,11 +1,12 @@
 #include "config.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <functional>
+#include <limits>
 #include <netdb.h>
 #include <unistd.h>
-#include <fnmatch.h>
 #include <torrent/rate.h>
 #include <torrent/throttle.h>
 #include <torrent/tracker/tracker.h>
@@ -24,9 +25,15 @@
 #include <torrent/utils/string_manip.h>
 
 #include "core/download.h"
+#include "core/file_tree_index.h"
+#include "core/filesystem_registry.h"
 #include "core/manager.h"
+#include "core/ratio_engine.h"
+#include "core/tracker_governor.h"
 #include "rpc/parse.h"
 #include "session/session_manager.h"
+#include "utils/glob.h"
+#include "utils/tied_file_registry.h"
 
 #include "globals.h"
 #include "control.h"
@@ -92,7 +99,7 @@ apply_d_change_link(core::Download* download, const torrent::Object::list_type&
 //     link = path_expand(prefix + rpc::call_command_string("d.base_path", rpc::make_target(download)) + postfix);
 
   } else if (type == "tied") {
-    link = expand_path(rpc::call_command_string("d.tied_to_file", rpc::make_target(download)));
+    link = expand_path(download->tied_to_file());
 
     if (link.empty())
       return torrent::Object();
@@ -130,7 +137,7 @@ apply_d_change_link(core::Download* download, const torrent::Object::list_type&
 
 torrent::Object
 apply_d_delete_tied(core::Download* download) {
-  const std::string& tie = rpc::call_command_string("d.tied_to_file", rpc::make_target(download));
+  const std::string& tie = download->tied_to_file();
 
   if (tie.empty())
     return torrent::Object();
@@ -138,7 +145,8 @@ apply_d_delete_tied(core::Download* download) {
   if (::unlink(expand_path(tie).c_str()) == -1)
     control->core()->push_log_std("Could not unlink tied file: " + std::string(std::strerror(errno)));
 
-  rpc::call_command("d.tied_to_file.set", std::string(), rpc::make_target(download));
+  download->set_tied_to_file(std::string());
+  control->tied_file_registry()->update(download);
   return torrent::Object();
 }
 
@@ -328,46 +336,122 @@ d_chunks_seen(core::Download* download) {
   return result;
 }
 
+// An empty string matches all files, while an empty list matches
+// none. Returns false if no filtering should be done.
+bool
+f_multicall_patterns(const torrent::Object& arg, utils::GlobList* patterns) {
+  if (arg.is_list()) {
+    for (const auto& o : arg.as_list())
+      patterns->push_back(o.as_string_c());
+
+    return true;
+  }
+
+  if (arg.is_string() && !arg.as_string().empty()) {
+    patterns->push_back(arg.as_string());
+    return true;
+  }
+
+  return false;
+}
+
+void
+f_multicall_call(torrent::Object::list_type& row, torrent::File* file,
+                 torrent::Object::list_const_iterator first, torrent::Object::list_const_iterator last) {
+  for (; first != last; first++) {
+    const std::string& cmd = first->as_string();
+    row.push_back(rpc::parse_command(rpc::make_target(file), cmd.c_str(), cmd.c_str() + cmd.size()).first);
+  }
+}
+
 torrent::Object
 f_multicall(core::Download* download, const torrent::Object::list_type& args) {
   if (args.empty())
     throw torrent::input_error("Too few arguments.");
 
-  // We ignore the first arg for now, but it will be used for
-  // selecting what files to include.
-
-  // Add some pre-parsing of the commands, so we don't spend time
-  // parsing and searching command map for every single call.
   torrent::Object             resultRaw = torrent::Object::create_list();
   torrent::Object::list_type& result = resultRaw.as_list();
-  std::vector<std::string>    regex_list;
 
-  bool use_regex = true;
+  utils::GlobList patterns;
+  bool            use_patterns = f_multicall_patterns(args.front(), &patterns);
 
-  if (args.front().is_list())
-    for (const auto& o : args.front().as_list())
-      regex_list.push_back(o.as_string_c());
-  else if (args.front().is_string() && !args.front().as_string().empty())
-    regex_list.push_back(args.front().as_string());
-  else
-    use_regex = false;
+  auto index     = use_patterns ? download->file_tree_index() : nullptr;
+  auto file_list = download->file_list();
 
-  for (const auto& file : *download->file_list()) {
-    if (use_regex &&
-        std::none_of(regex_list.begin(), regex_list.end(), [&file](const auto& pattern) { return fnmatch(pattern.c_str(), file->path()->as_string().c_str(), 0) == 0; }))
+  for (uint32_t idx = 0, last = file_list->size_files(); idx != last; idx++) {
+    if (use_patterns && !patterns.match_any(index->path(idx)))
       continue;
 
     torrent::Object::list_type& row = result.insert(result.end(), torrent::Object::create_list())->as_list();
 
-    for (torrent::Object::list_const_iterator cItr = ++args.begin(); cItr != args.end(); cItr++) {
-      const std::string& cmd = cItr->as_string();
-      row.push_back(rpc::parse_command(rpc::make_target(file.get()), cmd.c_str(), cmd.c_str() + cmd.size()).first);
-    }
+    f_multicall_call(row, (*file_list)[idx].get(), ++args.begin(), args.end());
   }
 
   return resultRaw;
 }
 
+// Returns a map with the number of matching files as 'total', and
+// up to 'limit' rows starting at 'offset' as 'rows'. Each row starts
+// with the file index, usable as a 'f<index>' target.
+torrent::Object
+f_multicall_range(core::Download* download, const torrent::Object::list_type& args) {
+  if (args.size() < 3)
+    throw torrent::input_error("Too few arguments.");
+
+  auto    itr    = args.begin();
+  int64_t offset = rpc::convert_to_value(*itr++);
+  int64_t limit  = rpc::convert_to_value(*itr++);
+
+  if (offset < 0 || limit < 0)
+    throw torrent::input_error("Invalid offset or limit.");
+
+  utils::GlobList patterns;
+  bool            use_patterns = f_multicall_patterns(*itr++, &patterns);
+
+  auto    file_list = download->file_list();
+  int64_t total     = 0;
+  auto    matches   = download->file_tree_index()->match_range(use_patterns ? &patterns : nullptr, offset, limit, total);
+
+  auto    result = torrent::Object::create_map();
+  auto&   rows   = result.insert_key("rows", torrent::Object::create_list()).as_list();
+
+  for (auto idx : matches) {
+    auto& row = rows.insert(rows.end(), torrent::Object::create_list())->as_list();
+
+    row.push_back((int64_t)idx);
+    f_multicall_call(row, (*file_list)[idx].get(), itr, args.end());
+  }
+
+  result.insert_key("total", total);
+  return result;
+}
+
+// Lists a single directory level of the download, directories first
+// followed by files, each entry being:
+//
+//   [name, path, is_directory, file_index, size_bytes, size_files]
+//
+// The file index is -1 for directories.
+torrent::Object
+f_tree(core::Download* download, const torrent::Object::list_type& args) {
+  if (args.size() != 0 && args.size() != 1 && args.size() != 3)
+    throw torrent::input_error("Wrong argument count.");
+
+  std::string path   = args.empty() ? std::string() : args.front().as_string();
+  int64_t     offset = 0;
+  int64_t     limit  = std::numeric_limits<int64_t>::max();
+
+  if (args.size() == 3) {
+    offset = rpc::convert_to_value(*++args.begin());
+    limit  = rpc::convert_to_value(args.back());
+  }
+
+  if (offset < 0 || limit < 0)
+    throw torrent::input_error("Invalid offset or limit.");
+
+  return download->file_tree_index()->list_directory(path, offset, limit);
+}
+
 torrent::Object
 t_multicall(core::Download* download, const torrent::Object::list_type& args) {
   if (args.empty())
@@ -497,19 +581,6 @@ download_get_variable(core::Download* download, const char* first_key, const cha
   return download->bencode()->get_key(first_key).get_key(second_key);
 }
 
-torrent::Object
-download_get_value_or_zero(core::Download* download, const char* first_key, const char* second_key = NULL) {
-  auto object = download_get_variable(download, first_key, second_key);
-
-  if (object.is_empty())
-    return int64_t(0);
-
-  if (!object.is_value())
-    throw torrent::bencode_error("Download variable is not a value.");
-
-  return object;
-}
-
 torrent::Object
 download_set_variable(core::Download* download, const torrent::Object& rawArgs, const char* first_key, const char* second_key = NULL) {
   if (second_key == NULL)
@@ -527,19 +598,6 @@ download_set_variable_value(core::Download* download, const torrent::Object::val
   return download->bencode()->get_key(first_key).get_key(second_key) = args;
 }
 
-torrent::Object
-download_set_variable_value_ifz(core::Download* download, const torrent::Object::value_type& args,
-                                const char* first_key, const char* second_key = NULL) {
-  torrent::Object& object = second_key == NULL ?
-    download->bencode()->get_key(first_key) :
-    download->bencode()->get_key(first_key).get_key(second_key);
-
-  if (object.as_value() == 0)
-    object = args;
-
-  return object;
-}
-
 torrent::Object
 download_set_variable_string(core::Download* download, const torrent::Object::string_type& args,
                              const char* first_key, const char* second_key = NULL) {
@@ -607,24 +665,20 @@ d_list_remove(core::Download* download, const torrent::Object& rawArgs, const ch
                                              std::placeholders::_1, std::placeholders::_2, \
                                              first_key, second_key));
 
-#define CMD2_DL_VAR_VALUE_PUBLIC(key, first_key, second_key)            \
-  CMD2_DL(key, std::bind(&download_get_variable, std::placeholders::_1, first_key, second_key)); \
-  CMD2_DL_VALUE(key ".set", std::bind(&download_set_variable_value, \
-                                           std::placeholders::_1, std::placeholders::_2, \
-                                           first_key, second_key));
-
-#define CMD2_DL_TIMESTAMP(key, first_key, second_key)                   \
-  CMD2_DL(key, std::bind(&download_get_variable, std::placeholders::_1, first_key, second_key)); \
-  CMD2_DL_VALUE_P(key ".set", std::bind(&download_set_variable_value,   \
-                                        std::placeholders::_1, std::placeholders::_2, \
-                                        first_key, second_key));        \
-  CMD2_DL_VALUE_P(key ".set_if_z", std::bind(&download_set_variable_value_ifz, \
-                                             std::placeholders::_1, std::placeholders::_2, \
-                                             first_key, second_key));   \
-  CMD2_DL(key ".or_zero", [](core::Download* download, auto) {          \
-      return download_get_value_or_zero(download, first_key, second_key); }); \
-  CMD2_DL_VALUE(key ".elapsed", [](core::Download* download, auto value) { \
-      return download_get_value_or_zero(download, first_key, second_key).as_value() > value; });
+#define CMD2_DL_MEMBER_VALUE(key, get, set)                              \
+  CMD2_DL(key, [](core::Download* download, auto) { return download->get(); }); \
+  CMD2_DL_VALUE_P(key ".set", [](core::Download* download, int64_t value) { \
+      download->set(value); return torrent::Object(value); });
+
+#define CMD2_DL_MEMBER_TIMESTAMP(key, get, set)                          \
+  CMD2_DL_MEMBER_VALUE(key, get, set);                                   \
+  CMD2_DL_VALUE_P(key ".set_if_z", [](core::Download* download, int64_t value) { \
+      if (download->get() == 0)                                          \
+        download->set(value);                                            \
+      return torrent::Object(download->get()); });                       \
+  CMD2_DL(key ".or_zero", [](core::Download* download, auto) { return download->get(); }); \
+  CMD2_DL_VALUE(key ".elapsed", [](core::Download* download, int64_t value) { \
+      return torrent::Object((int64_t)(download->get() > value)); });
 
 #define CMD2_DL_VAR_STRING(key, first_key, second_key)                   \
   CMD2_DL(key, std::bind(&download_get_variable, std::placeholders::_1, first_key, second_key)); \
@@ -722,8 +776,8 @@ initialize_command_download() {
   CMD2_DL_V       ("d.erase",      std::bind(&core::DownloadList::erase_ptr, control->core()->download_list(), std::placeholders::_1));
   CMD2_DL_V       ("d.check_hash", std::bind(&core::DownloadList::check_hash, control->core()->download_list(), std::placeholders::_1));
 
-  CMD2_DL_V       ("d.save_resume",       [](core::Download* download, auto) { session_thread::manager()->save_resume_download(download); });
-  CMD2_DL_V       ("d.save_full_session", [](core::Download* download, auto) { session_thread::manager()->save_full_download(download); });
+  CMD2_DL_V       ("d.save_resume",       [](core::Download* download, auto) { control->core()->download_list()->save_resume(download); });
+  CMD2_DL_V       ("d.save_full_session", [](core::Download* download, auto) { control->core()->download_list()->save_full(download); });
 
   CMD2_DL_V       ("d.update_priorities", CMD2_ON_DL(update_priorities));
 
@@ -748,8 +802,8 @@ initialize_command_download() {
 
   // 0 - stopped
   // 1 - started
-  CMD2_DL_VAR_VALUE("d.state",      "rtorrent", "state");
-  CMD2_DL_VAR_VALUE("d.complete",   "rtorrent", "complete");
+  CMD2_DL_MEMBER_VALUE("d.state",    state,    set_state);
+  CMD2_DL_MEMBER_VALUE("d.complete", complete, set_complete);
 
   CMD2_FUNC_SINGLE ("d.incomplete", "not=(d.complete)");
 
@@ -763,30 +817,43 @@ initialize_command_download() {
   // 1 - Normal hashing
   // 2 - Download finished, hashing
   // 3 - Rehashing
-  CMD2_DL_VAR_VALUE("d.hashing", "rtorrent", "hashing");
+  CMD2_DL_MEMBER_VALUE("d.hashing", hashing, set_hashing);
 
   // 'tied_to_file' is the file the download is associated with, and
   // can be changed by the user.
   //
   // 'loaded_file' is the file this instance of the torrent was loaded
   // from, and should not be changed.
-  CMD2_DL_VAR_STRING_PUBLIC("d.tied_to_file", "rtorrent", "tied_to_file");
+  CMD2_DL         ("d.tied_to_file",     [](auto* download, auto) { return download->tied_to_file(); });
+  CMD2_DL_STRING  ("d.tied_to_file.set", [](auto* download, const std::string& path) {
+      download->set_tied_to_file(path);
+      control->tied_file_registry()->update(download);
+      return torrent::Object(path);
+    });
   CMD2_DL_VAR_STRING("d.loaded_file",  "rtorrent", "loaded_file");
 
-  CMD2_DL("d.tied_to_file.realpath.or_empty", [](auto* download, auto) { return resolve_path(rpc::convert_to_string(download_get_variable(download, "rtorrent", "tied_to_file"))); });
-  CMD2_DL("d.tied_to_file.realpath.or_throw", [](auto* download, auto) { return resolve_path_or_throw(rpc::convert_to_string(download_get_variable(download, "rtorrent", "tied_to_file"))); });
+  CMD2_DL("d.tied_to_file.realpath.or_empty", [](auto* download, auto) { return resolve_path(download->tied_to_file()); });
+  CMD2_DL("d.tied_to_file.realpath.or_throw", [](auto* download, auto) { return resolve_path_or_throw(download->tied_to_file()); });
   CMD2_DL("d.loaded_file.realpath.or_empty",  [](auto* download, auto) { return resolve_path(rpc::convert_to_string(download_get_variable(download, "rtorrent", "loaded_file"))); });
   CMD2_DL("d.loaded_file.realpath.or_throw",  [](auto* download, auto) { return resolve_path_or_throw(rpc::convert_to_string(download_get_variable(download, "rtorrent", "loaded_file"))); });
 
   // The "state_changed" variable is required to be a valid unix time
   // value, it indicates the last time the torrent changed its state,
   // resume/pause.
-  CMD2_DL_VAR_VALUE("d.state_changed",          "rtorrent", "state_changed");
-  CMD2_DL_VAR_VALUE("d.state_counter",          "rtorrent", "state_counter");
-  CMD2_DL_VAR_VALUE_PUBLIC("d.ignore_commands", "rtorrent", "ignore_commands");
+  CMD2_DL_MEMBER_VALUE       ("d.state_changed",   state_changed,   set_state_changed);
+  CMD2_DL_MEMBER_VALUE       ("d.state_counter",   state_counter,   set_state_counter);
 
-  CMD2_DL_TIMESTAMP("d.timestamp.started",      "rtorrent", "timestamp.started");
-  CMD2_DL_TIMESTAMP("d.timestamp.finished",     "rtorrent", "timestamp.finished");
+  // Downloads ignoring commands are skipped by 'on_ratio', so the ratio
+  // heaps are told when this changes.
+  CMD2_DL      ("d.ignore_commands",     [](auto* download, auto) { return download->ignore_commands(); });
+  CMD2_DL_VALUE("d.ignore_commands.set", [](core::Download* download, int64_t value) {
+      download->set_ignore_commands(value);
+      control->ratio_engine()->update(download);
+      return torrent::Object(value);
+    });
+
+  CMD2_DL_MEMBER_TIMESTAMP("d.timestamp.started",  timestamp_started,  set_timestamp_started);
+  CMD2_DL_MEMBER_TIMESTAMP("d.timestamp.finished", timestamp_finished, set_timestamp_finished);
 
   CMD2_DL         ("d.connection_current",     [](auto* d, auto)     { return torrent::option_to_c_str_or_throw(torrent::OPTION_CONNECTION_TYPE, d->download()->connection_type()); });
   CMD2_DL_STRING_V("d.connection_current.set", [](auto* d, auto arg) { apply_d_connection_type(d, arg); });
@@ -847,11 +914,20 @@ initialize_command_download() {
 
   CMD2_DL         ("d.throttle_name",     std::bind(&download_get_variable, std::placeholders::_1, "rtorrent", "throttle_name"));
   CMD2_DL_STRING_V("d.throttle_name.set", std::bind(&core::Download::set_throttle_name, std::placeholders::_1, std::placeholders::_2));
+  CMD2_DL         ("d.throttle_group",    [](auto* download, auto) {
+      return download->throttle_group() == ~uint32_t() ? (int64_t)-1 : (int64_t)download->throttle_group();
+    });
+  CMD2_DL_VALUE_V ("d.throttle_group.set", [](auto* download, auto& value) {
+      if (value < 0 || value > std::numeric_limits<uint32_t>::max())
+        throw torrent::input_error("Invalid throttle group id.");
+
+      download->set_throttle_group(value);
+    });
 
   CMD2_DL         ("d.bytes_done",     CMD2_ON_DL(bytes_done));
   CMD2_DL         ("d.ratio",          std::bind(&retrieve_d_ratio, std::placeholders::_1));
   CMD2_DL         ("d.chunks_hashed",  CMD2_ON_DL(chunks_hashed));
-  CMD2_DL         ("d.free_diskspace", [](auto* download, auto) { return download->file_list()->free_diskspace_no_cache(); });
+  CMD2_DL         ("d.free_diskspace", [](auto* download, auto) { return control->filesystem_registry()->free_diskspace(download); });
 
   CMD2_DL         ("d.size_files",     CMD2_ON_FL(size_files));
   CMD2_DL         ("d.size_bytes",     CMD2_ON_FL(size_bytes));
@@ -882,7 +958,7 @@ initialize_command_download() {
   CMD2_DL         ("d.tracker.has_active_not_scrape", std::bind(&torrent::tracker::TrackerControllerWrapper::has_active_trackers_not_scrape, CMD2_BIND_TC));
   CMD2_DL         ("d.tracker.has_usable",            std::bind(&torrent::tracker::TrackerControllerWrapper::has_usable_trackers, CMD2_BIND_TC));
   CMD2_DL_LIST    ("d.tracker.insert",                std::bind(&download_tracker_insert, std::placeholders::_1, std::placeholders::_2));
-  CMD2_DL_VALUE_V ("d.tracker.send_scrape",           [](auto download, uint64_t arg) { download->tracker_controller().scrape_request(arg); });
+  CMD2_DL_VALUE_V ("d.tracker.send_scrape",           [](auto download, uint64_t arg) { control->tracker_governor()->scrape(download, arg); });
 
   CMD2_DL         ("d.directory",          CMD2_ON_FL(root_dir));
   CMD2_DL         ("d.directory.realpath.or_empty", [](auto* download, auto) { return resolve_path(download->file_list()->root_dir()); });
@@ -910,6 +986,8 @@ initialize_command_download() {
   CMD2_DL_V       ("d.group.set",  std::bind(&cg_d_group_set, std::placeholders::_1, std::placeholders::_2));
 
   CMD2_DL_LIST    ("f.multicall", std::bind(&f_multicall, std::placeholders::_1, std::placeholders::_2));
+  CMD2_DL_LIST    ("f.multicall.range", std::bind(&f_multicall_range, std::placeholders::_1, std::placeholders::_2));
+  CMD2_DL_LIST    ("f.tree",      std::bind(&f_tree, std::placeholders::_1, std::placeholders::_2));
   CMD2_DL_LIST    ("p.multicall", std::bind(&p_multicall, std::placeholders::_1, std::placeholders::_2));
   CMD2_DL_LIST    ("t.multicall", std::bind(&t_multicall, std::placeholders::_1, std::placeholders::_2));
 
@@ -1009,6 +1087,7 @@ initialize_command_download() {
   rpc::rpc.mark_safe("d.connection_leech");
   rpc::rpc.mark_safe("d.connection_seed");
   rpc::rpc.mark_safe("d.throttle_name");
+  rpc::rpc.mark_safe("d.throttle_group");
   rpc::rpc.mark_safe("d.uploads_max");
   rpc::rpc.mark_safe("d.downloads_max");
   rpc::rpc.mark_safe("d.peers_min");
@@ -1027,7 +1106,21 @@ initialize_command_download() {
   rpc::rpc.mark_safe("d.views.push_back_unique");
   rpc::rpc.mark_safe("d.ratio");
   rpc::rpc.mark_safe("f.multicall");
+  rpc::rpc.mark_safe("f.multicall.range");
+  rpc::rpc.mark_safe("f.tree");
   rpc::rpc.mark_safe("p.multicall");
   rpc::rpc.mark_safe("p.call_target");
   rpc::rpc.mark_safe("t.multicall");
+
+  // Getters that only read the download's own state, so views can be
+  // filtered and sorted on them from worker threads.
+  for (const auto name : {"d.hash", "d.name", "d.base_path", "d.directory", "d.tied_to_file", "d.message",
+                          "d.state", "d.state_changed", "d.complete", "d.hashing", "d.ignore_commands", "d.priority",
+                          "d.is_open", "d.is_active", "d.is_private", "d.is_multi_file", "d.is_meta",
+                          "d.is_hash_checked", "d.is_hash_checking",
+                          "d.size_bytes", "d.size_files", "d.size_chunks", "d.completed_bytes", "d.completed_chunks",
+                          "d.left_bytes", "d.bytes_done", "d.up.total", "d.down.total",
+                          "d.creation_date", "d.load_date", "d.views", "d.throttle_name",
+                          "d.custom", "d.custom1", "d.custom2", "d.custom3", "d.custom4", "d.custom5"})
+    rpc::commands.mark_parallel_safe(name);
 }
@@ -1,14 +1,18 @@
 #include "config.h"
 
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <cstdio>
+#include <exception>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <torrent/rate.h>
 #include <torrent/hash_string.h>
+#include <torrent/torrent.h>
 #include <torrent/utils/log.h>
 #include <torrent/utils/directory_events.h>
-#include <torrent/utils/file_stat.h>
 #include <torrent/utils/string_manip.h>
 
 #include "globals.h"
@@ -16,11 +20,17 @@
 #include "command_helpers.h"
 #include "core/download.h"
 #include "core/download_list.h"
+#include "core/event_stream.h"
+#include "core/filesystem_registry.h"
 #include "core/manager.h"
+#include "core/ratio_engine.h"
+#include "core/startup_profile.h"
 #include "core/view_manager.h"
 #include "rpc/command_scheduler.h"
+#include "rpc/object_order.h"
 #include "rpc/parse.h"
 #include "rpc/parse_commands.h"
+#include "utils/tied_file_registry.h"
 #include "utils/watch_ready_queue.h"
 
 torrent::Object
@@ -31,47 +41,60 @@ apply_on_ratio(const torrent::Object& rawArgs) {
   if (view_itr == control->view_manager()->end())
     throw torrent::input_error("Could not find view.");
 
-  // first argument:  minimum ratio to reach
-  // second argument: minimum upload amount to reach [optional]
-  // third argument:  maximum ratio to reach [optional]
-  int64_t min_ratio  = rpc::commands.call("group." + group_name + ".ratio.min", rpc::make_target()).as_value();
-  int64_t max_ratio  = rpc::commands.call("group." + group_name + ".ratio.max", rpc::make_target()).as_value();
-  int64_t min_upload = rpc::commands.call("group." + group_name + ".ratio.upload", rpc::make_target()).as_value();
+  // min_ratio:  minimum ratio to reach
+  // min_upload: minimum upload amount to reach
+  // max_ratio:  maximum ratio to reach, disabled if zero
+  core::RatioEngine::settings_type settings;
+  settings.min_ratio  = rpc::commands.call("group." + group_name + ".ratio.min", rpc::make_target()).as_value();
+  settings.max_ratio  = rpc::commands.call("group." + group_name + ".ratio.max", rpc::make_target()).as_value();
+  settings.min_upload = rpc::commands.call("group." + group_name + ".ratio.upload", rpc::make_target()).as_value();
 
-  std::vector<core::Download*> downloads;
+  core::RatioEngine::download_list downloads;
+  control->ratio_engine()->process(group_name, view_itr->get(), settings, torrent::up_rate()->total(), &downloads);
 
-  for  (auto itr = (*view_itr)->begin_visible(), last = (*view_itr)->end_visible(); itr != last; itr++) {
-    if (!(*itr)->is_seeding() || rpc::call_command_value("d.ignore_commands", rpc::make_target(*itr)) != 0)
-      continue;
+  auto ratio_command = "group." + group_name + ".ratio.command";
 
-    int64_t total_done   = (*itr)->download()->bytes_done();
-    int64_t total_upload = (*itr)->info()->up_rate()->total();
+  for (auto download : downloads)
+    if (control->ratio_engine()->is_tracked(group_name, download))
+      rpc::commands.call_catch(ratio_command, rpc::make_target(download), torrent::Object(), "Ratio reached, but command failed: ");
 
-    if (!(total_upload >= min_upload && total_upload * 100 >= total_done * min_ratio) &&
-        !(max_ratio > 0 && total_upload * 100 > total_done * max_ratio))
-      continue;
+  return torrent::Object();
+}
 
-    downloads.push_back(itr->get());
-  }
+// The tied file state comes from TiedFileRegistry, downloads whose
+// tied file hasn't been checked yet are left alone.
+//
+// Commands may erase downloads and the pointers could be reused by
+// new ones, so the downloads are kept by info hash and looked up
+// again before each command.
 
-  auto ratio_command = "group." + group_name + ".ratio.command";
+static std::vector<torrent::HashString>
+tied_downloads_with_state(utils::TiedFileRegistry::file_state state) {
+  std::vector<torrent::HashString> result;
 
-  for (const auto& download : downloads)
-    rpc::commands.call_catch(ratio_command, rpc::make_target(download), torrent::Object(), "Ratio reached, but command failed: ");
+  for (auto download : control->tied_file_registry()->downloads_with_state(state))
+    result.push_back(download->info()->hash());
 
-  return torrent::Object();
+  return result;
+}
+
+static core::Download*
+tied_download_find(const torrent::HashString& hash, utils::TiedFileRegistry::file_state state) {
+  auto download_list = control->core()->download_list();
+  auto itr           = download_list->find(hash);
+
+  if (itr == download_list->end() || control->tied_file_registry()->state(itr->get()) != state)
+    return nullptr;
+
+  return itr->get();
 }
 
 torrent::Object
 apply_start_tied() {
-  for (const auto& download : *control->core()->download_list()) {
-    if (rpc::call_command_value("d.state", rpc::make_target(download)) == 1)
-      continue;
-
-    torrent::utils::FileStat fs;
-    const std::string& tied_to_file = rpc::call_command_string("d.tied_to_file", rpc::make_target(download));
+  for (const auto& hash : tied_downloads_with_state(utils::TiedFileRegistry::state_present)) {
+    auto download = tied_download_find(hash, utils::TiedFileRegistry::state_present);
 
-    if (!tied_to_file.empty() && fs.update(expand_path(tied_to_file)))
+    if (download != nullptr && download->state() != 1)
       rpc::parse_command_single(rpc::make_target(download), "d.try_start=");
   }
 
@@ -80,14 +103,10 @@ apply_start_tied() {
 
 torrent::Object
 apply_stop_untied() {
-  for (const auto& download : *control->core()->download_list()) {
-    if (rpc::call_command_value("d.state", rpc::make_target(download)) == 0)
-      continue;
-
-    torrent::utils::FileStat fs;
-    const std::string& tied_to_file = rpc::call_command_string("d.tied_to_file", rpc::make_target(download));
+  for (const auto& hash : tied_downloads_with_state(utils::TiedFileRegistry::state_missing)) {
+    auto download = tied_download_find(hash, utils::TiedFileRegistry::state_missing);
 
-    if (!tied_to_file.empty() && !fs.update(expand_path(tied_to_file)))
+    if (download != nullptr && download->state() != 0)
       rpc::parse_command_single(rpc::make_target(download), "d.try_stop=");
   }
 
@@ -96,11 +115,10 @@ apply_stop_untied() {
 
 torrent::Object
 apply_close_untied() {
-  for (const auto& download : *control->core()->download_list()) {
-    torrent::utils::FileStat fs;
-    const std::string& tied_to_file = rpc::call_command_string("d.tied_to_file", rpc::make_target(download));
+  for (const auto& hash : tied_downloads_with_state(utils::TiedFileRegistry::state_missing)) {
+    auto download = tied_download_find(hash, utils::TiedFileRegistry::state_missing);
 
-    if (rpc::call_command_value("d.ignore_commands", rpc::make_target(download)) == 0 && !tied_to_file.empty() && !fs.update(expand_path(tied_to_file)))
+    if (download != nullptr && download->ignore_commands() == 0)
       rpc::parse_command_single(rpc::make_target(download), "d.try_close=");
   }
 
@@ -109,24 +127,40 @@ apply_close_untied() {
 
 torrent::Object
 apply_remove_untied() {
-  for (auto itr = control->core()->download_list()->begin(); itr != control->core()->download_list()->end(); ) {
-    torrent::utils::FileStat fs;
-    const std::string& tied_to_file = rpc::call_command_string("d.tied_to_file", rpc::make_target(*itr));
+  auto download_list = control->core()->download_list();
 
-    if (!tied_to_file.empty() && !fs.update(expand_path(tied_to_file))) {
-      // Need to clear tied_to_file so it doesn't try to delete it.
-      rpc::call_command("d.tied_to_file.set", std::string(), rpc::make_target(*itr));
+  for (const auto& hash : tied_downloads_with_state(utils::TiedFileRegistry::state_missing)) {
+    auto itr = download_list->find(hash);
 
-      itr = control->core()->download_list()->erase(itr);
+    if (itr == download_list->end() || control->tied_file_registry()->state(itr->get()) != utils::TiedFileRegistry::state_missing)
+      continue;
 
-    } else {
-      ++itr;
-    }
+    // Need to clear tied_to_file so it doesn't try to delete it.
+    (*itr)->set_tied_to_file(std::string());
+    control->tied_file_registry()->update(itr->get());
+
+    download_list->erase(itr);
   }
 
   return torrent::Object();
 }
 
+torrent::Object
+apply_tied_files_status() {
+  auto registry = control->tied_file_registry();
+  auto result = torrent::Object::create_map();
+
+  result.insert_key("downloads",          (int64_t)registry->size_downloads());
+  result.insert_key("files",              (int64_t)registry->size_files());
+  result.insert_key("directories",        (int64_t)registry->size_directories());
+  result.insert_key("present",            (int64_t)registry->count_state(utils::TiedFileRegistry::state_present));
+  result.insert_key("missing",            (int64_t)registry->count_state(utils::TiedFileRegistry::state_missing));
+  result.insert_key("unknown",            (int64_t)registry->count_state(utils::TiedFileRegistry::state_unknown));
+  result.insert_key("reconcile_interval", (int64_t)registry->reconcile_interval().count());
+
+  return result;
+}
+
 torrent::Object
 apply_schedule(const torrent::Object::list_type& args, bool if_absent) {
   if (args.size() != 4)
@@ -164,28 +198,52 @@ apply_load(const torrent::Object::list_type& args, int flags) {
   return torrent::Object();
 }
 
-void apply_import(const std::string& path)     { if (!rpc::parse_command_file(path)) throw torrent::input_error("Could not open option file: " + path); }
-void apply_try_import(const std::string& path) { if (!rpc::parse_command_file(path)) control->core()->push_log_std("Could not read resource file: " + path); }
+void
+apply_import(const std::string& path) {
+  core::StartupProfile::scope span(control->startup_profile(), "import", path);
+
+  if (!rpc::parse_command_file(path))
+    throw torrent::input_error("Could not open option file: " + path);
+}
+
+void
+apply_try_import(const std::string& path) {
+  core::StartupProfile::scope span(control->startup_profile(), "import", path);
+
+  if (!rpc::parse_command_file(path))
+    control->core()->push_log_std("Could not read resource file: " + path);
+}
+
+static void
+close_low_diskspace(core::Download* download) {
+  control->core()->download_list()->close(download);
+
+  download->set_hash_failed(true);
+  download->set_message(std::string("Low diskspace."));
+}
+
+// Free diskspace is looked up per filesystem in the registry, which
+// caches statvfs for 'system.filesystems.ttl' seconds. Stale values
+// are refreshed before acting on them.
 
 torrent::Object
 apply_close_low_diskspace(int64_t arg, uint32_t skip_priority) {
   bool closed = false;
 
-  torrent::FileList::cache_list cache;
+  auto registry = control->filesystem_registry();
 
   for (const auto& download : *control->core()->download_list()) {
     if (!download->is_downloading())
       continue;
     if (download->priority() >= skip_priority)
       continue;
-    if (download->file_list()->free_diskspace(cache) >= (uint64_t)arg)
-      continue;
 
-    control->core()->download_list()->close(download);
+    auto filesystem = registry->find(download, true);
 
-    download->set_hash_failed(true);
-    download->set_message(std::string("Low diskspace."));
+    if (filesystem == nullptr || filesystem->free >= (uint64_t)arg)
+      continue;
 
+    close_low_diskspace(download);
     closed = true;
   }
 
@@ -195,6 +253,45 @@ apply_close_low_diskspace(int64_t arg, uint32_t skip_priority) {
   return torrent::Object();
 }
 
+// Closes downloads on filesystems where the free diskspace, less the
+// bytes still left to download, is below 'arg'. The lowest priority
+// and then largest downloads are closed first, until the projected
+// free diskspace is above 'arg' again.
+
+torrent::Object
+apply_close_low_diskspace_projected(int64_t arg) {
+  auto registry = control->filesystem_registry();
+  registry->update_accounting(true);
+
+  std::map<core::FilesystemRegistry::filesystem_type*, std::vector<core::FilesystemRegistry::candidate_type>> candidates;
+
+  for (const auto& download : *control->core()->download_list()) {
+    if (!download->is_downloading())
+      continue;
+
+    auto filesystem = registry->find(download);
+
+    if (filesystem == nullptr || filesystem->projected_free() >= arg)
+      continue;
+
+    candidates[filesystem].push_back({download, download->priority(), download->file_list()->left_bytes()});
+  }
+
+  bool closed = false;
+
+  for (auto& [filesystem, downloads] : candidates) {
+    for (auto download : core::FilesystemRegistry::select_closing(std::move(downloads), filesystem->projected_free(), arg)) {
+      close_low_diskspace(download);
+      closed = true;
+    }
+  }
+
+  if (closed)
+    lt_log_print(torrent::LOG_TORRENT_ERROR, "Closed torrents due to low projected diskspace.");
+
+  return torrent::Object();
+}
+
 torrent::Object
 apply_download_list(const torrent::Object::list_type& args) {
   torrent::Object::list_const_iterator argsItr = args.begin();
@@ -313,6 +410,204 @@ d_multicall_filtered(const torrent::Object::list_type& args) {
   return resultRaw;
 }
 
+// Returns a map with the number of visible downloads as 'total', and
+// the rows of up to 'limit' downloads starting at 'offset' as 'rows'.
+//
+// An empty sort key uses the view's current order. Otherwise the key
+// command is called once per download and only the requested page is
+// sorted, before any of the row commands are called. Values sort
+// before strings, ties keep the view order.
+torrent::Object
+d_multicall_page(const torrent::Object::list_type& args) {
+  if (args.size() < 5)
+    throw torrent::input_error("Too few arguments.");
+
+  auto arg = args.begin();
+
+  auto* viewManager = control->view_manager();
+  auto  view_itr    = viewManager->find(arg->as_string().empty() ? "default" : arg->as_string());
+
+  if (view_itr == viewManager->end())
+    throw torrent::input_error("Could not find view.");
+
+  const std::string& sort_key = (++arg)->as_string();
+  const std::string& order    = (++arg)->as_string();
+  int64_t            offset   = rpc::convert_to_value(*++arg);
+  int64_t            limit    = rpc::convert_to_value(*++arg);
+
+  ++arg;  // skip to first command
+
+  if (offset < 0 || limit < 0)
+    throw torrent::input_error("Invalid offset or limit.");
+
+  bool descending;
+
+  if (order.empty() || order == "asc" || order == "+")
+    descending = false;
+  else if (order == "desc" || order == "-")
+    descending = true;
+  else
+    throw torrent::input_error("Invalid order.");
+
+  // Hold a reference to each download so a command that erases one cannot
+  // free it under us.
+  core::View::base_type dlist((*view_itr)->begin_visible(), (*view_itr)->end_visible());
+
+  int64_t total = dlist.size();
+  int64_t first = std::min(offset, total);
+  int64_t last  = first + std::min(limit, total - first);
+
+  core::View::base_type page;
+
+  if (sort_key.empty()) {
+    if (descending)
+      page.assign(dlist.rbegin() + first, dlist.rbegin() + last);
+    else
+      page.assign(dlist.begin() + first, dlist.begin() + last);
+
+  } else {
+    std::vector<torrent::Object> keys;
+    keys.reserve(dlist.size());
+
+    for (const auto& d : dlist)
+      keys.push_back(rpc::parse_command_single(rpc::make_target(d), sort_key));
+
+    for (auto idx : rpc::object_order_range(keys, descending, first, last))
+      page.push_back(dlist[idx]);
+  }
+
+  dlist.clear();
+
+  auto  resultRaw = torrent::Object::create_map();
+  auto& result    = resultRaw.insert_key("rows", torrent::Object::create_list()).as_list();
+
+  for (const auto& item : page) {
+    if (item.use_count() == 1)
+      continue;
+
+    torrent::Object::list_type& row = result.insert(result.end(), torrent::Object::create_list())->as_list();
+
+    for (torrent::Object::list_const_iterator command = arg; command != args.end(); command++) {
+      if (item.use_count() == 1)
+        break;
+
+      auto& cmdstr = command->as_string();
+      row.push_back(rpc::parse_command(rpc::make_target(item), cmdstr.c_str(), cmdstr.c_str() + cmdstr.size()).first);
+    }
+  }
+
+  resultRaw.insert_key("total", total);
+  return resultRaw;
+}
+
+// Keeps view filtering and session saves deferred for the lifetime of
+// the object, see DownloadList::begin_batch.
+//
+// If a command threw, the batch is still ended but any further error
+// is logged, as throwing while unwinding would terminate.
+class downloads_batch {
+public:
+  downloads_batch() : m_exceptions(std::uncaught_exceptions()) { control->core()->download_list()->begin_batch(); }
+
+  ~downloads_batch() noexcept(false) {
+    if (std::uncaught_exceptions() == m_exceptions)
+      return control->core()->download_list()->end_batch();
+
+    try {
+      control->core()->download_list()->end_batch();
+    } catch (const torrent::base_error& e) {
+      lt_log_print(torrent::LOG_ERROR, "Error ending download batch: %s", e.what());
+    }
+  }
+
+private:
+  int m_exceptions;
+};
+
+// Appends the downloads matching the info-hashes in [first, last) to
+// 'result', nested lists are flattened. Unknown hashes are ignored as
+// downloads may have been erased since the caller listed them, and
+// each download is only added once.
+static void
+downloads_resolve(torrent::Object::list_const_iterator first, torrent::Object::list_const_iterator last, core::View::base_type& result) {
+  auto download_list = control->core()->download_list();
+  std::unordered_set<core::Download*> resolved;
+
+  std::function<void (const torrent::Object&)> resolve = [&](const torrent::Object& obj) {
+      if (obj.is_list()) {
+        for (const auto& entry : obj.as_list())
+          resolve(entry);
+
+        return;
+      }
+
+      const std::string& hex = obj.as_string();
+      torrent::HashString hash;
+
+      if (hex.size() != 40 || torrent::utils::transform_from_hex(hex.c_str(), hex.c_str() + 40, hash) != hash.end())
+        throw torrent::input_error("Not a valid info-hash: " + hex);
+
+      auto itr = download_list->find(hash);
+
+      if (itr == download_list->end() || !resolved.insert(itr->get()).second)
+        return;
+
+      result.push_back(*itr);
+    };
+
+  std::for_each(first, last, resolve);
+}
+
+// Calls each of the commands on every download, returning the number
+// of downloads the commands were called on.
+static int64_t
+downloads_call(const core::View::base_type& downloads,
+               torrent::Object::list_const_iterator first, torrent::Object::list_const_iterator last) {
+  downloads_batch batch;
+  int64_t count = 0;
+
+  for (const auto& download : downloads) {
+    // The download list dropping its reference means an earlier
+    // command erased the download.
+    if (download.use_count() == 1)
+      continue;
+
+    for (auto command = first; command != last; command++) {
+      if (download.use_count() == 1)
+        break;
+
+      auto& cmdstr = command->as_string();
+      rpc::parse_command(rpc::make_target(download), cmdstr.c_str(), cmdstr.c_str() + cmdstr.size());
+    }
+
+    count++;
+  }
+
+  return count;
+}
+
+torrent::Object
+downloads_command(const torrent::Object::list_type& args, const char* command) {
+  core::View::base_type downloads;
+  downloads_resolve(args.begin(), args.end(), downloads);
+
+  torrent::Object::list_type commands{torrent::Object(std::string(command))};
+  return downloads_call(downloads, commands.begin(), commands.end());
+}
+
+// The first argument is the info-hash, or list of info-hashes, the
+// rest are the commands to call on each of them.
+torrent::Object
+downloads_apply(const torrent::Object::list_type& args) {
+  if (args.size() < 2)
+    throw torrent::input_error("Too few arguments.");
+
+  core::View::base_type downloads;
+  downloads_resolve(args.begin(), std::next(args.begin()), downloads);
+
+  return downloads_call(downloads, ++args.begin(), args.end());
+}
+
 static void
 call_watch_command(const std::string& command, const std::string& path) {
   rpc::commands.call_catch(command.c_str(), rpc::make_target(), path);
@@ -352,6 +647,40 @@ directory_watch_ready(const torrent::Object::list_type& args) {
                          torrent::directory_events::flag_on_ready);
 }
 
+static constexpr size_t events_wait_max_batch = 256;
+
+// Arguments are the cursor, the timeout in seconds and optionally the
+// event types to return. When called over SCGI with no new events, the
+// request is parked until an event happens or the timeout expires.
+torrent::Object
+apply_events_wait(const torrent::Object::list_type& args) {
+  if (args.size() < 2)
+    throw torrent::input_error("Invalid number of arguments.");
+
+  auto itr     = args.begin();
+  auto cursor  = rpc::convert_to_value(*itr++);
+  auto timeout = rpc::convert_to_value(*itr++);
+
+  if (cursor < 0 || timeout < 0)
+    throw torrent::input_error("Invalid cursor or timeout.");
+
+  std::vector<std::string> types;
+
+  for (; itr != args.end(); ++itr)
+    types.push_back(itr->as_string());
+
+  auto stream = control->event_stream();
+
+  // A cursor past the end returns immediately so the client resyncs.
+  if (timeout != 0 && rpc::rpc.is_park_allowed() &&
+      (uint64_t)cursor <= stream->next_sequence() && !stream->has_events(cursor, types)) {
+    rpc::rpc.request_park(std::chrono::seconds(timeout));
+    return torrent::Object();
+  }
+
+  return stream->events(cursor, events_wait_max_batch, types);
+}
+
 void
 initialize_command_events() {
   CMD2_ANY_STRING  ("on_ratio",                   [](auto, auto& args) { return apply_on_ratio(args); });
@@ -361,6 +690,16 @@ initialize_command_events() {
   CMD2_ANY         ("close_untied",               [](auto, auto) { return apply_close_untied(); });
   CMD2_ANY         ("remove_untied",              [](auto, auto) { return apply_remove_untied(); });
 
+  CMD2_ANY         ("system.tied_files",          [](auto, auto) { return apply_tied_files_status(); });
+  CMD2_ANY_V       ("system.tied_files.reconcile", [](auto, auto) { return control->tied_file_registry()->reconcile(); });
+  CMD2_ANY         ("system.tied_files.reconcile_interval", [](auto, auto) { return (int64_t)control->tied_file_registry()->reconcile_interval().count(); });
+  CMD2_ANY_VALUE_V ("system.tied_files.reconcile_interval.set", [](auto, auto& arg) {
+      if (arg <= 0)
+        throw torrent::input_error("Reconcile interval must be positive.");
+
+      return control->tied_file_registry()->set_reconcile_interval(std::chrono::seconds(arg));
+    });
+
   CMD2_ANY_LIST    ("schedule",                   [](auto, auto& args) { return apply_schedule(args, false); });
   CMD2_ANY_LIST    ("schedule.if_absent",         [](auto, auto& args) { return apply_schedule(args, true); });
   CMD2_ANY_STRING_V("schedule.remove",            [](auto, auto& str) { return control->command_scheduler()->erase_str(str); });
@@ -379,24 +718,55 @@ initialize_command_events() {
 
   CMD2_ANY_VALUE   ("close_low_diskspace",        [](auto, auto& arg) { return apply_close_low_diskspace(arg, 99); });
   CMD2_ANY_VALUE   ("close_low_diskspace.normal", [](auto, auto& arg) { return apply_close_low_diskspace(arg, 3); });
+  CMD2_ANY_VALUE   ("close_low_diskspace.projected", [](auto, auto& arg) { return apply_close_low_diskspace_projected(arg); });
+
+  CMD2_ANY         ("system.filesystems",         [](auto, auto) { return control->filesystem_registry()->filesystems(); });
+  CMD2_ANY         ("system.filesystems.ttl",     [](auto, auto) { return (int64_t)control->filesystem_registry()->ttl(); });
+  CMD2_ANY_VALUE_V ("system.filesystems.ttl.set", [](auto, auto& arg) {
+      if (arg < 0)
+        throw torrent::input_error("Filesystem ttl must be non-negative.");
+
+      return control->filesystem_registry()->set_ttl(arg);
+    });
 
   CMD2_ANY_LIST    ("download_list",              [](auto, auto& args) { return apply_download_list(args); });
 
   // TODO: Deprecate d.multicall2. (6/2026)
   CMD2_ANY_LIST    ("d.multicall",                [](auto, auto& args) { return d_multicall(args); });
   CMD2_ANY_LIST    ("d.multicall.filtered",       [](auto, auto& args) { return d_multicall_filtered(args); });
+  CMD2_ANY_LIST    ("d.multicall.page",           [](auto, auto& args) { return d_multicall_page(args); });
+
+  CMD2_ANY_LIST    ("downloads.start",            [](auto, auto& args) { return downloads_command(args, "d.start="); });
+  CMD2_ANY_LIST    ("downloads.stop",             [](auto, auto& args) { return downloads_command(args, "d.stop="); });
+  CMD2_ANY_LIST    ("downloads.erase",            [](auto, auto& args) { return downloads_command(args, "d.erase="); });
+  CMD2_ANY_LIST    ("downloads.apply",            [](auto, auto& args) { return downloads_apply(args); });
 
   CMD2_ANY_LIST    ("directory.watch.added",      [](auto, auto& args) { return directory_watch_added(args); });
   CMD2_ANY_LIST    ("directory.watch.ready",      [](auto, auto& args) { return directory_watch_ready(args); });
 
+  CMD2_ANY_LIST    ("system.events.wait",         [](auto, auto& args) { return apply_events_wait(args); });
+  CMD2_ANY         ("system.events.cursor",       [](auto, auto) { return (int64_t)control->event_stream()->next_sequence(); });
+
   rpc::rpc.mark_safe("start_tied");
   rpc::rpc.mark_safe("stop_untied");
   rpc::rpc.mark_safe("close_untied");
   rpc::rpc.mark_safe("remove_untied");
+  rpc::rpc.mark_safe("system.tied_files");
+  rpc::rpc.mark_safe("system.tied_files.reconcile_interval");
 
   rpc::rpc.mark_safe("close_low_diskspace");
   rpc::rpc.mark_safe("close_low_diskspace.normal");
+  rpc::rpc.mark_safe("close_low_diskspace.projected");
+  rpc::rpc.mark_safe("system.filesystems");
+  rpc::rpc.mark_safe("system.filesystems.ttl");
   rpc::rpc.mark_safe("download_list");
   rpc::rpc.mark_safe("d.multicall");
   rpc::rpc.mark_safe("d.multicall.filtered");
+  rpc::rpc.mark_safe("d.multicall.page");
+  rpc::rpc.mark_safe("downloads.start");
+  rpc::rpc.mark_safe("downloads.stop");
+  rpc::rpc.mark_safe("downloads.erase");
+  rpc::rpc.mark_safe("downloads.apply");
+  rpc::rpc.mark_safe("system.events.wait");
+  rpc::rpc.mark_safe("system.events.cursor");
 }
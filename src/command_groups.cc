@@ -17,6 +17,7 @@
 #include "command_helpers.h"
 
 // For cg_d_group.
+#include "core/choke_balancer.h"
 #include "core/download.h"
 
 #define LT_LOG_SUBSYSTEM(log_fmt, ...)                                  \
@@ -80,6 +81,11 @@ apply_cg_list() {
   return torrent::Object::from_list(result);
 }
 
+core::ChokeBalancer::group_list
+cg_list_groups() {
+  return core::ChokeBalancer::group_list(torrent::resource_manager()->group_begin(), torrent::resource_manager()->group_end());
+}
+
 torrent::Object
 apply_cg_insert(const std::string& arg) {
   int64_t dummy;
@@ -170,6 +176,16 @@ apply_cg_list() {
   return torrent::Object::from_list(result);
 }
 
+core::ChokeBalancer::group_list
+cg_list_groups() {
+  core::ChokeBalancer::group_list result;
+
+  for (const auto& itr : cg_list_hack)
+    result.push_back(itr.get());
+
+  return result;
+}
+
 int
 cg_get_can_unchoke(torrent::choke_queue* cq) {
   return cq->max_unchoked_signed() - (int)cq->size_unchoked();
@@ -268,6 +284,57 @@ apply_cg_tracker_mode_set(const torrent::Object::list_type& args) {
   return torrent::Object();
 }
 
+// Args: cg_index, value
+std::pair<torrent::choke_group*, int64_t>
+cg_balance_args(const torrent::Object::list_type& args) {
+  if (args.size() != 2)
+    throw torrent::input_error("Incorrect number of arguments.");
+
+  int64_t value = 0;
+  rpc::parse_whole_value(args.back().as_string().c_str(), &value);
+
+  return std::make_pair(cg_get_group(args.front()), value);
+}
+
+uint32_t
+cg_balance_value(int64_t value) {
+  if (value < 0 || value >= core::ChokeBalancer::unlimited)
+    throw torrent::input_error("Invalid choke group balance value.");
+
+  return value;
+}
+
+torrent::Object
+apply_cg_balance_weight_set(const torrent::Object::list_type& args) {
+  auto [group, value] = cg_balance_args(args);
+
+  control->choke_balancer()->group(group->name()).weight = cg_balance_value(value);
+  return torrent::Object();
+}
+
+// A max bound of -1 is unlimited.
+torrent::Object
+apply_cg_balance_bound_set(const torrent::Object::list_type& args, bool is_up, bool is_max) {
+  auto [group, value] = cg_balance_args(args);
+  auto& state = control->choke_balancer()->group(group->name());
+  auto& direction = is_up ? state.up : state.down;
+
+  if (is_max)
+    direction.max = value == -1 ? core::ChokeBalancer::unlimited : cg_balance_value(value);
+  else
+    direction.min = cg_balance_value(value);
+
+  return torrent::Object();
+}
+
+int64_t
+retrieve_cg_balance_bound(const torrent::Object& arg, bool is_up, bool is_max) {
+  auto& state = control->choke_balancer()->group(cg_get_group(arg)->name());
+  auto  value = is_max ? (is_up ? state.up.max : state.down.max) : (is_up ? state.up.min : state.down.min);
+
+  return value == core::ChokeBalancer::unlimited ? -1 : (int64_t)value;
+}
+
 #define CG_GROUP_AT()          std::bind(&cg_get_group, std::placeholders::_2)
 #define CHOKE_GROUP(direction) std::bind(direction, CG_GROUP_AT())
 
@@ -330,6 +397,35 @@ Heuristics are used for deciding what peers to choke and unchoke, see
 'strings.choke_heuristics{,_download,_upload}' for a list of available
 options.
 
+(choke_group.balance.enabled) -> <bool>
+(choke_group.balance.enabled.set,<bool>)
+(choke_group.balance.interval) -> <seconds>
+(choke_group.balance.interval.set,<seconds>)
+(choke_group.balance.hysteresis) -> <slots>
+(choke_group.balance.hysteresis.set,<slots>)
+(choke_group.balance.up.slots) -> <slots>
+(choke_group.balance.up.slots.set,<slots>)
+(choke_group.balance.down.slots) -> <slots>
+(choke_group.balance.down.slots.set,<slots>)
+
+Periodically divide the up / down slot pools between the groups, see
+'core/choke_balancer.h'. A pool of zero leaves the group limits alone.
+
+(choke_group.balance.weight,<cg_index>) -> <weight>
+(choke_group.balance.weight.set,<cg_index>,<weight>)
+(choke_group.balance.up.min,<cg_index>) -> <slots>
+(choke_group.balance.up.min.set,<cg_index>,<slots>)
+(choke_group.balance.up.max,<cg_index>) -> <slots>
+(choke_group.balance.up.max.set,<cg_index>,<slots>)
+(choke_group.balance.down.min,<cg_index>) -> <slots>
+(choke_group.balance.down.min.set,<cg_index>,<slots>)
+(choke_group.balance.down.max,<cg_index>) -> <slots>
+(choke_group.balance.down.max.set,<cg_index>,<slots>)
+
+(choke_group.balance.state,<cg_index>) -> {demand, rate, current, target, reason, ...}
+(choke_group.balance.decisions) -> [{time, group, direction, from, to, reason}, ...]
+(choke_group.balance.update)
+
 (d.group) -> <choke_group_index>
 (d.group.name) -> "choke_group_name"
 (d.group.set,<cg_index>)
@@ -385,6 +481,34 @@ initialize_command_groups() {
   CMD_ANY         ("choke_group.down.heuristics",     [](auto, auto arg) { return torrent::option_to_str_or_throw(torrent::OPTION_CHOKE_HEURISTICS, cg_get_group(arg)->down_queue()->heuristics()); });
   CMD_ANY_LIST    ("choke_group.down.heuristics.set", [](auto, auto arg) { return apply_cg_heuristics_set(arg, false); });
 
+  control->choke_balancer()->slot_choke_groups() = [] { return cg_list_groups(); };
+
+  CMD_ANY         ("choke_group.balance.enabled",         [](auto, auto)        { return control->choke_balancer()->is_enabled(); });
+  CMD_ANY_VALUE_V ("choke_group.balance.enabled.set",     [](auto, auto& value) { control->choke_balancer()->set_enabled(value != 0); });
+  CMD_ANY         ("choke_group.balance.interval",        [](auto, auto)        { return (int64_t)control->choke_balancer()->interval(); });
+  CMD_ANY_VALUE_V ("choke_group.balance.interval.set",    [](auto, auto& value) { control->choke_balancer()->set_interval(cg_balance_value(value)); });
+  CMD_ANY         ("choke_group.balance.hysteresis",      [](auto, auto)        { return (int64_t)control->choke_balancer()->hysteresis(); });
+  CMD_ANY_VALUE_V ("choke_group.balance.hysteresis.set",  [](auto, auto& value) { control->choke_balancer()->set_hysteresis(cg_balance_value(value)); });
+  CMD_ANY         ("choke_group.balance.up.slots",        [](auto, auto)        { return (int64_t)control->choke_balancer()->slots(true); });
+  CMD_ANY_VALUE_V ("choke_group.balance.up.slots.set",    [](auto, auto& value) { control->choke_balancer()->set_slots(true, cg_balance_value(value)); });
+  CMD_ANY         ("choke_group.balance.down.slots",      [](auto, auto)        { return (int64_t)control->choke_balancer()->slots(false); });
+  CMD_ANY_VALUE_V ("choke_group.balance.down.slots.set",  [](auto, auto& value) { control->choke_balancer()->set_slots(false, cg_balance_value(value)); });
+
+  CMD_ANY         ("choke_group.balance.weight",          [](auto, auto arg) { return (int64_t)control->choke_balancer()->group(cg_get_group(arg)->name()).weight; });
+  CMD_ANY_LIST    ("choke_group.balance.weight.set",      [](auto, auto arg) { return apply_cg_balance_weight_set(arg); });
+  CMD_ANY         ("choke_group.balance.up.min",          [](auto, auto arg) { return retrieve_cg_balance_bound(arg, true, false); });
+  CMD_ANY_LIST    ("choke_group.balance.up.min.set",      [](auto, auto arg) { return apply_cg_balance_bound_set(arg, true, false); });
+  CMD_ANY         ("choke_group.balance.up.max",          [](auto, auto arg) { return retrieve_cg_balance_bound(arg, true, true); });
+  CMD_ANY_LIST    ("choke_group.balance.up.max.set",      [](auto, auto arg) { return apply_cg_balance_bound_set(arg, true, true); });
+  CMD_ANY         ("choke_group.balance.down.min",        [](auto, auto arg) { return retrieve_cg_balance_bound(arg, false, false); });
+  CMD_ANY_LIST    ("choke_group.balance.down.min.set",    [](auto, auto arg) { return apply_cg_balance_bound_set(arg, false, false); });
+  CMD_ANY         ("choke_group.balance.down.max",        [](auto, auto arg) { return retrieve_cg_balance_bound(arg, false, true); });
+  CMD_ANY_LIST    ("choke_group.balance.down.max.set",    [](auto, auto arg) { return apply_cg_balance_bound_set(arg, false, true); });
+
+  CMD_ANY         ("choke_group.balance.state",           [](auto, auto arg) { return control->choke_balancer()->group_state(cg_get_group(arg)->name()); });
+  CMD_ANY         ("choke_group.balance.decisions",       [](auto, auto)     { return control->choke_balancer()->decisions(); });
+  CMD_ANY         ("choke_group.balance.update",          [](auto, auto)     { control->choke_balancer()->update(); return torrent::Object(); });
+
   rpc::rpc.mark_safe("choke_group.list");
   rpc::rpc.mark_safe("choke_group.size");
   rpc::rpc.mark_safe("choke_group.index_of");
@@ -404,4 +528,16 @@ initialize_command_groups() {
   rpc::rpc.mark_safe("choke_group.down.queued");
   rpc::rpc.mark_safe("choke_group.down.unchoked");
   rpc::rpc.mark_safe("choke_group.down.heuristics");
+  rpc::rpc.mark_safe("choke_group.balance.enabled");
+  rpc::rpc.mark_safe("choke_group.balance.interval");
+  rpc::rpc.mark_safe("choke_group.balance.hysteresis");
+  rpc::rpc.mark_safe("choke_group.balance.up.slots");
+  rpc::rpc.mark_safe("choke_group.balance.down.slots");
+  rpc::rpc.mark_safe("choke_group.balance.weight");
+  rpc::rpc.mark_safe("choke_group.balance.up.min");
+  rpc::rpc.mark_safe("choke_group.balance.up.max");
+  rpc::rpc.mark_safe("choke_group.balance.down.min");
+  rpc::rpc.mark_safe("choke_group.balance.down.max");
+  rpc::rpc.mark_safe("choke_group.balance.state");
+  rpc::rpc.mark_safe("choke_group.balance.decisions");
 }
@@ -1,11 +1,13 @@
 #include "config.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <fcntl.h>
 #include <functional>
 #include <limits>
 #include <stdio.h>
 #include <unistd.h>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <torrent/torrent.h>
@@ -20,9 +22,12 @@
 #include "core/download.h"
 #include "core/download_list.h"
 #include "core/manager.h"
+#include "core/startup_admission.h"
+#include "core/startup_profile.h"
 #include "rpc/parse_commands.h"
 #include "rpc/scgi.h"
 #include "session/session_manager.h"
+#include "utils/directory_cache.h"
 #include "utils/file_status_cache.h"
 
 #include "globals.h"
@@ -186,6 +191,53 @@ cmd_file_append(const torrent::Object::list_type& args) {
   return torrent::Object();
 }
 
+// Returns the 'limit' commands with the most self time, defaulting to
+// 20, as maps with the call count, self and inclusive time in usec
+// and the latency histogram.
+torrent::Object
+system_profile_commands(const torrent::Object::list_type& args) {
+  int64_t limit = 20;
+
+  if (args.size() > 1)
+    throw torrent::input_error("Too many arguments.");
+
+  if (!args.empty() && !(args.front().is_string() && args.front().as_string().empty()))
+    limit = rpc::convert_to_value(args.front());
+
+  if (limit < 0)
+    throw torrent::input_error("Invalid limit.");
+
+  std::vector<rpc::CommandMap::const_iterator> entries;
+
+  for (auto itr = rpc::commands.begin(), last = rpc::commands.end(); itr != last; itr++)
+    if (itr->second.m_profile.calls != 0)
+      entries.push_back(itr);
+
+  auto middle = entries.begin() + std::min<int64_t>(limit, entries.size());
+
+  std::partial_sort(entries.begin(), middle, entries.end(), [](auto a, auto b) {
+      return a->second.m_profile.self_time > b->second.m_profile.self_time;
+    });
+
+  torrent::Object result = torrent::Object::create_list();
+
+  std::for_each(entries.begin(), middle, [&result](auto itr) {
+      auto& profile   = itr->second.m_profile;
+      auto& entry     = result.as_list().insert(result.as_list().end(), torrent::Object::create_map())->as_map();
+      auto& histogram = (entry["histogram"] = torrent::Object::create_list()).as_list();
+
+      entry["name"]           = itr->first;
+      entry["calls"]          = (int64_t)profile.calls;
+      entry["self_usec"]      = (int64_t)(profile.self_time / 1000);
+      entry["inclusive_usec"] = (int64_t)(profile.inclusive_time / 1000);
+
+      for (auto count : profile.histogram)
+        histogram.push_back((int64_t)count);
+    });
+
+  return result;
+}
+
 uint32_t
 checked_socket_value(int64_t value, const char* label) {
   if (value < 0 || value > std::numeric_limits<uint32_t>::max())
@@ -194,6 +246,37 @@ checked_socket_value(int64_t value, const char* label) {
   return static_cast<uint32_t>(value);
 }
 
+uint32_t
+checked_startup_rate(int64_t value) {
+  if (value < 0 || value > std::numeric_limits<uint32_t>::max())
+    throw torrent::input_error("Invalid startup rate value.");
+
+  return static_cast<uint32_t>(value);
+}
+
+// Scrape delays are in seconds, a day is plenty.
+uint32_t
+checked_scrape_delay(int64_t value) {
+  if (value < 0 || value > 24 * 3600)
+    throw torrent::input_error("Invalid scrape delay value.");
+
+  return static_cast<uint32_t>(value);
+}
+
+torrent::Object
+system_startup_status() {
+  auto* admission = control->startup_admission();
+  auto  result    = torrent::Object::create_map();
+
+  result.insert_key("active",   (int64_t)admission->is_active());
+  result.insert_key("queued",   (int64_t)admission->size_queued());
+  result.insert_key("admitted", (int64_t)admission->count_admitted());
+  result.insert_key("scrapes",  (int64_t)admission->count_scrapes());
+  result.insert_key("elapsed",  (int64_t)admission->elapsed().count());
+
+  return result;
+}
+
 void
 initialize_command_local() {
   core::DownloadList*    dList = control->core()->download_list();
@@ -213,7 +296,11 @@ initialize_command_local() {
 
   CMD_ANY         ("system.file_status_cache.size",   std::bind(&utils::FileStatusCache::size,
                                                                  (utils::FileStatusCache::base_type*)control->core()->file_status_cache()));
-  CMD_ANY_V       ("system.file_status_cache.prune",  std::bind(&utils::FileStatusCache::prune, control->core()->file_status_cache()));
+  CMD_ANY_V       ("system.file_status_cache.prune",  [](auto, auto) {
+      control->core()->file_status_cache()->prune();
+      control->core()->directory_cache()->prune();
+    });
+  CMD_ANY         ("system.directory_cache.size",     [](auto, auto) { return (int64_t)control->core()->directory_cache()->size(); });
 
   CMD_VAR_BOOL    ("file.prioritize_toc",          0);
   CMD_VAR_LIST    ("file.prioritize_toc.first");
@@ -236,6 +323,20 @@ initialize_command_local() {
   CMD_ANY         ("system.time_seconds",             [](auto, auto)        { return torrent::utils::cast_seconds(torrent::utils::time_since_epoch()).count(); });
   CMD_ANY         ("system.time_usec",                [](auto, auto)        { return torrent::utils::time_since_epoch().count(); });
 
+  CMD_ANY         ("system.profile",                  [](auto, auto)        { return (int64_t)rpc::commands.is_profiling(); });
+  CMD_ANY_VALUE_V ("system.profile.set",              [](auto, auto& value) { rpc::commands.set_profiling(value != 0); });
+  CMD_ANY_LIST    ("system.profile.commands",         [](auto, auto& args)  { return system_profile_commands(args); });
+  CMD_ANY_V       ("system.profile.reset",            [](auto, auto)        { rpc::commands.reset_profile(); });
+
+  CMD_ANY         ("system.startup.status",           [](auto, auto)        { return system_startup_status(); });
+  CMD_ANY         ("system.startup.resume_rate",      [](auto, auto)        { return (int64_t)control->startup_admission()->resume_rate(); });
+  CMD_ANY_VALUE_V ("system.startup.resume_rate.set",  [](auto, auto& value) { return control->startup_admission()->set_resume_rate(checked_startup_rate(value)); });
+  CMD_ANY         ("system.startup.scrape_rate",      [](auto, auto)        { return (int64_t)control->startup_admission()->scrape_rate(); });
+  CMD_ANY_VALUE_V ("system.startup.scrape_rate.set",  [](auto, auto& value) { return control->startup_admission()->set_scrape_rate(checked_startup_rate(value)); });
+  CMD_ANY_VALUE   ("system.startup.scrape_delay",     [](auto, auto& value) { return (int64_t)control->startup_admission()->scrape_delay(checked_scrape_delay(value)); });
+  CMD_ANY         ("system.startup.profile",          [](auto, auto)        { return control->startup_profile()->summary(); });
+  CMD_ANY_STRING_V("system.startup.profile.trace",    [](auto, auto& str)   { return control->startup_profile()->write_trace(str); });
+
   CMD_ANY_VALUE_V ("system.umask.set",                [](auto, auto& value) { return ::umask(value); });
 
   CMD_VAR_BOOL    ("system.daemon",                   false);
@@ -359,6 +460,10 @@ initialize_command_local() {
   CMD_ANY_LIST  ("group.insert", std::bind(&group_insert, std::placeholders::_2));
 
   rpc::rpc.mark_safe("system.api_version");
+  rpc::rpc.mark_safe("system.startup.status");
+  rpc::rpc.mark_safe("system.startup.profile");
+  rpc::rpc.mark_safe("system.startup.resume_rate");
+  rpc::rpc.mark_safe("system.startup.scrape_rate");
   rpc::rpc.mark_safe("system.client_version");
   rpc::rpc.mark_safe("system.library_version");
   rpc::rpc.mark_safe("system.file.max_size");
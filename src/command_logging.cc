@@ -15,6 +15,7 @@
 #include "setup.h"
 #include "core/download.h"
 #include "core/download_list.h"
+#include "core/log_ring.h"
 #include "core/manager.h"
 #include "rpc/parse.h"
 #include "rpc/parse_commands.h"
@@ -40,23 +41,30 @@ apply_log_add_output(const torrent::Object::list_type& args) {
   return torrent::Object();
 }
 
-torrent::Object
-apply_log_print(const torrent::Object::list_type& args) {
-  if (args.size() < 2)
-    throw torrent::input_error("Invalid number of arguments.");
-
-  torrent::Object::value_type group;
+int
+log_group_from_object(const torrent::Object& obj) {
+  int64_t group;
 
-  if (args.front().is_value())
-    group = args.front().as_value();
-  else if (args.front().is_string())
-    group = torrent::option_find_string_str(torrent::OPTION_LOG_GROUP, args.front().as_string());
+  if (obj.is_value())
+    group = obj.as_value();
+  else if (obj.is_string())
+    group = torrent::option_find_string_str(torrent::OPTION_LOG_GROUP, obj.as_string());
   else
     throw torrent::input_error("Invalid log group.");
 
   if (group < 0 || group >= torrent::LOG_GROUP_MAX_SIZE)
     throw torrent::input_error("Invalid log group.");
 
+  return group;
+}
+
+torrent::Object
+apply_log_print(const torrent::Object::list_type& args) {
+  if (args.size() < 2)
+    throw torrent::input_error("Invalid number of arguments.");
+
+  int group = log_group_from_object(args.front());
+
   std::string message;
 
   for (auto itr = std::next(args.begin()); itr != args.end(); ++itr)
@@ -66,6 +74,48 @@ apply_log_print(const torrent::Object::list_type& args) {
   return torrent::Object();
 }
 
+// Arguments are the cursor, the max number of entries and optionally
+// the log groups to include.
+torrent::Object
+apply_log_tail(const torrent::Object::list_type& args) {
+  if (args.size() < 2)
+    throw torrent::input_error("Invalid number of arguments.");
+
+  auto cursor = rpc::convert_to_value(args.front());
+  auto max    = rpc::convert_to_value(*std::next(args.begin()));
+
+  if (cursor < 0 || max <= 0)
+    throw torrent::input_error("Invalid cursor or max entries.");
+
+  std::vector<bool> groups;
+
+  for (auto itr = std::next(args.begin(), 2); itr != args.end(); ++itr) {
+    groups.resize(torrent::LOG_GROUP_MAX_SIZE);
+    groups[log_group_from_object(*itr)] = true;
+  }
+
+  auto tail = control->core()->log_ring()->tail(cursor, max, groups);
+
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["cursor"]  = (int64_t)tail.cursor;
+  result["dropped"] = (int64_t)tail.dropped;
+
+  auto& entries = (result["entries"] = torrent::Object::create_list()).as_list();
+
+  for (auto& entry : tail.entries) {
+    auto& value = entries.insert(entries.end(), torrent::Object::create_map())->as_map();
+
+    value["sequence"] = (int64_t)entry.sequence;
+    value["time"]     = entry.time;
+    value["group"]    = std::string(torrent::option_to_string(torrent::OPTION_LOG_GROUP, entry.group));
+    value["message"]  = std::move(entry.message);
+  }
+
+  return raw_result;
+}
+
 // TODO: Deprecated.
 torrent::Object
 apply_log(const torrent::Object::string_type& arg, int logType) {
@@ -136,15 +186,26 @@ initialize_command_logging() {
   CMD2_ANY_LIST    ("log.append_file",        std::bind(&apply_log_open, log_flag_append_file, std::placeholders::_2));
   CMD2_ANY_LIST    ("log.append_file.flush",  std::bind(&apply_log_open, log_flag_append_file | log_flag_flush, std::placeholders::_2));
   CMD2_ANY_LIST    ("log.append_gz_file",     std::bind(&apply_log_open, log_flag_append_file, std::placeholders::_2));
+  CMD2_ANY_LIST    ("log.open_binary_file",   std::bind(&apply_log_open, log_flag_binary, std::placeholders::_2));
+  CMD2_ANY_LIST    ("log.append_binary_file", std::bind(&apply_log_open, log_flag_append_file | log_flag_binary, std::placeholders::_2));
 
   CMD2_ANY_STRING_V("log.close",            std::bind(&torrent::log_close_output_str, std::placeholders::_2));
 
   CMD2_ANY_LIST    ("log.add_output",       std::bind(&apply_log_add_output, std::placeholders::_2));
   CMD2_ANY_LIST    ("log.print",            std::bind(&apply_log_print, std::placeholders::_2));
 
+  CMD2_ANY_LIST    ("log.tail",             std::bind(&apply_log_tail, std::placeholders::_2));
+  CMD2_ANY         ("log.tail.cursor",      [](auto, auto)        { return (int64_t)control->core()->log_ring()->next_sequence(); });
+  CMD2_ANY         ("log.ring.size",        [](auto, auto)        { return (int64_t)control->core()->log_ring()->size(); });
+  CMD2_ANY_VALUE_V ("log.ring.size.set",    [](auto, auto& value) { return control->core()->log_ring()->set_size(value); });
+
   CMD2_ANY_STRING  ("log.execute",          std::bind(&apply_log, std::placeholders::_2, 0));
   CMD2_ANY_STRING  ("log.vmmap.dump",       std::bind(&log_vmmap_dump, std::placeholders::_2));
   CMD2_ANY_STRING_V("log.rpc",              [](const auto&, const auto& str) { scgi_thread::set_rpc_log(str); });
 
   CMD2_REDIRECT    ("log.xmlrpc", "log.rpc"); // For backwards compatibility
+
+  rpc::rpc.mark_safe("log.tail");
+  rpc::rpc.mark_safe("log.tail.cursor");
+  rpc::rpc.mark_safe("log.ring.size");
 }
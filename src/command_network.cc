@@ -23,6 +23,7 @@
 #include "control.h"
 #include "command_helpers.h"
 #include "core/download.h"
+#include "core/http_queue.h"
 #include "core/manager.h"
 #include "rpc/scgi.h"
 #include "ui/root.h"
@@ -367,6 +368,16 @@ initialize_command_network() {
   CMD_ANY         ("network.http.ssl_verify_peer",           [http_stack](auto, auto)        { return http_stack->ssl_verify_peer(); });
   CMD_ANY_VALUE_V ("network.http.ssl_verify_peer.set",       [http_stack](auto, auto& value) { return http_stack->set_ssl_verify_peer(value); });
 
+  CMD_ANY         ("network.http.queue.size",                [](auto, auto)                  { return control->core()->http_queue()->size(); });
+  CMD_ANY         ("network.http.queue.status",              [](auto, auto)                  { return control->core()->http_queue()->status(); });
+  CMD_ANY         ("network.http.queue.max_per_host",        [](auto, auto)                  { return control->core()->http_queue()->max_per_host(); });
+  CMD_ANY_VALUE_V ("network.http.queue.max_per_host.set",    [](auto, auto& value)           { return control->core()->http_queue()->set_max_per_host(value); });
+  CMD_ANY         ("network.http.queue.cache.path",          [](auto, auto)                  { return control->core()->http_queue()->cache_path(); });
+  CMD_ANY_STRING_V("network.http.queue.cache.path.set",      [](auto, auto& str)             { return control->core()->http_queue()->set_cache_path(str); });
+  CMD_ANY         ("network.http.queue.cache.ttl",           [](auto, auto)                  { return control->core()->http_queue()->cache_ttl(); });
+  CMD_ANY_VALUE_V ("network.http.queue.cache.ttl.set",       [](auto, auto& value)           { return control->core()->http_queue()->set_cache_ttl(value); });
+  CMD_ANY         ("network.http.queue.cache.size",          [](auto, auto)                  { return control->core()->http_queue()->cache_size(); });
+
   CMD_ANY         ("network.send_buffer.size",               [nw_config](auto, auto)         { return nw_config->send_buffer_size(); });
   CMD_ANY_VALUE_V ("network.send_buffer.size.set",           [nw_config](auto, auto& value)  { return nw_config->set_send_buffer_size(value); });
   CMD_ANY         ("network.receive_buffer.size",            [nw_config](auto, auto)         { return nw_config->receive_buffer_size(); });
@@ -443,6 +454,11 @@ initialize_command_network() {
   rpc::rpc.mark_safe("network.http.max_cache_connections");
   rpc::rpc.mark_safe("network.http.max_host_connections");
   rpc::rpc.mark_safe("network.http.max_total_connections");
+  rpc::rpc.mark_safe("network.http.queue.size");
+  rpc::rpc.mark_safe("network.http.queue.status");
+  rpc::rpc.mark_safe("network.http.queue.max_per_host");
+  rpc::rpc.mark_safe("network.http.queue.cache.ttl");
+  rpc::rpc.mark_safe("network.http.queue.cache.size");
 
   rpc::rpc.mark_safe("network.total_handshakes");
   rpc::rpc.mark_safe("network.open_files");
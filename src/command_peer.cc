@@ -12,25 +12,12 @@
 #include "command_helpers.h"
 #include "control.h"
 #include "core/manager.h"
-#include "display/utils.h"
+#include "core/peer_client_cache.h"
 
-torrent::Object
-retrieve_p_address(torrent::Peer* peer) {
-  auto sa = peer->peer_info()->socket_address();
-  auto addr_str = torrent::sa_addr_str(sa);
-
-  if (sa->sa_family == AF_INET6)
-    return "[" + addr_str + "]";
-
-  return addr_str;
-}
-
-torrent::Object
-retrieve_p_client_version(torrent::Peer* peer) {
-  char buf[128];
-  display::print_client_version(buf, buf + 128, peer->peer_info()->client_info());
-
-  return std::string(buf);
+// Formatted per peer once on connect, see PeerClientCache.
+const core::PeerClientCache::entry_type&
+p_client_entry(torrent::Peer* peer) {
+  return control->peer_client_cache()->find(peer);
 }
 
 torrent::Object
@@ -47,9 +34,10 @@ retrieve_p_completed_percent(torrent::Peer* peer) {
 
 void
 initialize_command_peer() {
-  CMD2_PEER("p.id",                [](auto* peer, auto) { return torrent::utils::transform_to_hex_str(peer->id()); });
-  CMD2_PEER("p.id_html",           [](auto* peer, auto) { return torrent::utils::copy_escape_html_str(peer->id()); });
-  CMD2_PEER("p.client_version",    std::bind(&retrieve_p_client_version, std::placeholders::_1));
+  CMD2_PEER("p.id",                [](auto* peer, auto) { return p_client_entry(peer).id_hex; });
+  CMD2_PEER("p.id_html",           [](auto* peer, auto) { return p_client_entry(peer).id_html; });
+  CMD2_PEER("p.client_name",       [](auto* peer, auto) { return p_client_entry(peer).client_name; });
+  CMD2_PEER("p.client_version",    [](auto* peer, auto) { return p_client_entry(peer).client_version; });
 
   CMD2_PEER("p.options_str",       std::bind(&retrieve_p_options_str, std::placeholders::_1));
 
@@ -61,7 +49,7 @@ initialize_command_peer() {
   CMD2_PEER("p.is_unwanted",       std::bind(&torrent::PeerInfo::is_unwanted,  std::bind(&torrent::Peer::peer_info, std::placeholders::_1)));
   CMD2_PEER("p.is_preferred",      std::bind(&torrent::PeerInfo::is_preferred, std::bind(&torrent::Peer::peer_info, std::placeholders::_1)));
 
-  CMD2_PEER("p.address",           std::bind(&retrieve_p_address, std::placeholders::_1));
+  CMD2_PEER("p.address",           [](auto* peer, auto) { return p_client_entry(peer).address; });
   CMD2_PEER("p.port",              [](auto* peer, auto) { return torrent::sa_port(peer->peer_info()->socket_address()); });
 
   CMD2_PEER("p.completed_percent", std::bind(&retrieve_p_completed_percent, std::placeholders::_1));
@@ -81,8 +69,12 @@ initialize_command_peer() {
   CMD2_PEER_V("p.disconnect",         std::bind(&torrent::Peer::disconnect, std::placeholders::_1, 0));
   CMD2_PEER_V("p.disconnect_delayed", std::bind(&torrent::Peer::disconnect, std::placeholders::_1, torrent::ConnectionList::disconnect_delayed));
 
+  CMD2_ANY   ("peers.clients",        [](auto, auto) { return control->peer_client_cache()->clients(); });
+  CMD2_ANY   ("peers.clients.cached", [](auto, auto) { return (int64_t)control->peer_client_cache()->size(); });
+
   rpc::rpc.mark_safe("p.address");
   rpc::rpc.mark_safe("p.port");
+  rpc::rpc.mark_safe("p.client_name");
   rpc::rpc.mark_safe("p.client_version");
   rpc::rpc.mark_safe("p.options_str");
   rpc::rpc.mark_safe("p.id");
@@ -106,4 +98,6 @@ initialize_command_peer() {
   rpc::rpc.mark_safe("p.completed_percent");
   rpc::rpc.mark_safe("p.disconnect");
   rpc::rpc.mark_safe("p.disconnect_delayed");
+  rpc::rpc.mark_safe("peers.clients");
+  rpc::rpc.mark_safe("peers.clients.cached");
 }
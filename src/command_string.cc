@@ -362,4 +362,7 @@ initialize_command_string() {
                           "string.equals", "string.starts_with", "string.ends_with", "string.contains", "string.contains_i",
                           "string.lpad", "string.rpad", "string.strip", "string.lstrip", "string.rstrip"})
     rpc::rpc.mark_safe(name);
+
+  for (const auto name : {"string.length", "string.equals", "string.starts_with", "string.ends_with", "string.contains", "string.contains_i"})
+    rpc::commands.mark_parallel_safe(name);
 }
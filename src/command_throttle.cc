@@ -6,7 +6,9 @@
 #include <torrent/download/resource_manager.h>
 #include <torrent/net/socket_address.h>
 
+#include "core/download.h"
 #include "core/manager.h"
+#include "core/throttle_groups.h"
 #include "ui/root.h"
 #include "rpc/parse.h"
 #include "rpc/parse_commands.h"
@@ -88,15 +90,12 @@ apply_throttle(const torrent::Object::list_type& args, bool up) {
   if (rate < 0)
     throw torrent::input_error("Throttle rate must be non-negative.");
 
-  auto itr = control->core()->throttles().find(name);
-
-  if (itr == control->core()->throttles().end())
-    itr = control->core()->throttles().insert(std::make_pair(name, core::ThrottlePair(nullptr, nullptr))).first;
-
-  auto*& throttle = up ? itr->second.first : itr->second.second;
+  auto groups   = control->core()->throttle_groups();
+  auto id       = groups->find_or_insert(name);
+  auto throttle = groups->throttle(id, up);
 
   if (rate != 0 && throttle == nullptr)
-    throttle = (up ? torrent::up_throttle_global() : torrent::down_throttle_global())->create_slave();
+    throttle = groups->create_throttle(id, up);
 
   if (throttle != nullptr)
     throttle->set_max_rate(rate * 1024);
@@ -104,6 +103,61 @@ apply_throttle(const torrent::Object::list_type& args, bool up) {
   return torrent::Object();
 }
 
+// Args: name, [parent]
+torrent::Object
+apply_throttle_group_insert(const torrent::Object::list_type& args) {
+  if (args.empty() || args.size() > 2)
+    throw torrent::input_error("Invalid number of arguments.");
+
+  auto groups = control->core()->throttle_groups();
+  auto parent = core::ThrottleGroups::invalid_id;
+
+  if (args.size() == 2 && !args.back().as_string().empty())
+    parent = groups->find_throw(args.back().as_string());
+
+  return (int64_t)groups->insert(args.front().as_string(), parent);
+}
+
+torrent::Object
+retrieve_throttle_groups_list() {
+  auto groups = control->core()->throttle_groups();
+
+  std::vector<int64_t> downloads(groups->size());
+
+  for (const auto& download : *control->core()->download_list())
+    if (download->throttle_group() < downloads.size())
+      downloads[download->throttle_group()]++;
+
+  auto  raw_result = torrent::Object::create_list();
+  auto& result     = raw_result.as_list();
+
+  for (core::ThrottleGroups::id_type id = 0; id != groups->size(); id++) {
+    auto& info = result.insert(result.end(), groups->group_info(id))->as_map();
+
+    info["downloads"] = downloads[id];
+  }
+
+  return raw_result;
+}
+
+// An empty name returns the stats of all groups, keyed by name.
+torrent::Object
+retrieve_throttle_group_stats(const std::string& name) {
+  auto groups = control->core()->throttle_groups();
+
+  if (!name.empty())
+    return groups->group_stats(groups->find_throw(name));
+
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  for (core::ThrottleGroups::id_type id = 0; id != groups->size(); id++)
+    if (!groups->at(id).fixed)
+      result[groups->at(id).name] = groups->group_stats(id);
+
+  return raw_result;
+}
+
 static const int throttle_info_up   = (1 << 0);
 static const int throttle_info_down = (1 << 1);
 static const int throttle_info_max  = (1 << 2);
@@ -111,9 +165,7 @@ static const int throttle_info_rate = (1 << 3);
 
 torrent::Object
 retrieve_throttle_info(const torrent::Object::string_type& name, int flags) {
-  auto  itr       = control->core()->throttles().find(name);
-  auto  throttles = (itr == control->core()->throttles().end()) ? core::ThrottlePair(nullptr, nullptr) : itr->second;
-  auto* throttle  = flags & throttle_info_down ? throttles.second : throttles.first;
+  auto* throttle  = control->core()->throttle_groups()->find_throttle(name, !(flags & throttle_info_down));
   auto* global    = flags & throttle_info_down ? torrent::down_throttle_global() : torrent::up_throttle_global();
 
   if (throttle == NULL && name.empty())
@@ -192,6 +244,11 @@ initialize_command_throttle() {
   CMD2_ANY_STRING  ("throttle.down.max",  std::bind(&retrieve_throttle_info, std::placeholders::_2, throttle_info_down | throttle_info_max));
   CMD2_ANY_STRING  ("throttle.down.rate", std::bind(&retrieve_throttle_info, std::placeholders::_2, throttle_info_down | throttle_info_rate));
 
+  CMD2_ANY_LIST    ("throttle.group.insert", [](auto, auto& args) { return apply_throttle_group_insert(args); });
+  CMD2_ANY_STRING  ("throttle.group.id",     [](auto, auto& name) { return (int64_t)control->core()->throttle_groups()->find_throw(name); });
+  CMD2_ANY_STRING  ("throttle.group.stats",  [](auto, auto& name) { return retrieve_throttle_group_stats(name); });
+  CMD2_ANY         ("throttle.groups.list",  [](auto, auto)       { return retrieve_throttle_groups_list(); });
+
   rpc::rpc.mark_safe("throttle.unchoked_uploads");
   rpc::rpc.mark_safe("throttle.max_unchoked_uploads");
   rpc::rpc.mark_safe("throttle.unchoked_downloads");
@@ -247,4 +304,8 @@ initialize_command_throttle() {
   rpc::rpc.mark_safe("throttle.up.rate");
   rpc::rpc.mark_safe("throttle.down.max");
   rpc::rpc.mark_safe("throttle.down.rate");
+
+  rpc::rpc.mark_safe("throttle.group.id");
+  rpc::rpc.mark_safe("throttle.group.stats");
+  rpc::rpc.mark_safe("throttle.groups.list");
 }
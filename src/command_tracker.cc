@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <limits>
 #include <netdb.h>
 #include <torrent/net/resolver.h>
 #include <torrent/runtime/network_config.h>
@@ -13,6 +14,7 @@
 
 #include "core/download.h"
 #include "core/manager.h"
+#include "core/tracker_governor.h"
 
 #include "globals.h"
 #include "control.h"
@@ -65,20 +67,32 @@ apply_dht_add_node(const std::string& arg) {
   return torrent::Object();
 }
 
+// Enabling goes through the tracker governor, so that enabling
+// thousands of downloads on the same tracker doesn't announce them
+// all at once.
+
 torrent::Object
 apply_enable_trackers(int64_t arg) {
   if (arg == 0) {
     for (const auto& download : *control->core()->download_list())
-      download->tracker_controller().for_each([](auto& tracker) { tracker.disable(); });
+      control->tracker_governor()->disable(download.get());
 
   } else {
     for (const auto& download : *control->core()->download_list())
-      download->tracker_controller().for_each([](auto& tracker) { tracker.enable(); });
+      control->tracker_governor()->enable(download.get());
   }
 
   return torrent::Object();
 }
 
+uint32_t
+checked_governor_value(int64_t value) {
+  if (value < 0 || value > std::numeric_limits<uint32_t>::max())
+    throw torrent::input_error("Invalid tracker governor value.");
+
+  return static_cast<uint32_t>(value);
+}
+
 void
 initialize_command_tracker() {
   CMD2_TRACKER        ("t.is_busy",            [](auto* tracker, auto) { return tracker->is_requesting(); });
@@ -100,6 +114,14 @@ initialize_command_tracker() {
   CMD2_TRACKER        ("t.group",              [](auto* tracker, auto) { return tracker->group(); });
   CMD2_TRACKER        ("t.type",               [](auto* tracker, auto) { return tracker->type(); });
   CMD2_TRACKER        ("t.id",                 [](auto* tracker, auto) { return tracker->tracker_id(); });
+  CMD2_TRACKER        ("t.host",               [](auto* tracker, auto) { return core::TrackerGovernor::url_host(tracker->url()); });
+
+  CMD2_TRACKER        ("t.host.queued",        [](auto* tracker, auto) {
+      return (int64_t)control->tracker_governor()->size_queued(core::TrackerGovernor::url_host(tracker->url()));
+    });
+  CMD2_TRACKER        ("t.host.active",        [](auto* tracker, auto) {
+      return (int64_t)control->tracker_governor()->size_active(core::TrackerGovernor::url_host(tracker->url()));
+    });
 
   CMD2_TRACKER        ("t.latest_event",       [](auto* tracker, auto) { return tracker->state().latest_event(); });
   CMD2_TRACKER        ("t.latest_new_peers",   [](auto* tracker, auto) { return tracker->state().latest_new_peers(); });
@@ -129,6 +151,13 @@ initialize_command_tracker() {
   CMD2_ANY_VALUE      ("trackers.enable",      [](auto, auto)          { return apply_enable_trackers(1); });
   CMD2_ANY_VALUE      ("trackers.disable",     [](auto, auto)          { return apply_enable_trackers(0); });
   CMD2_VAR_BOOL       ("trackers.delay_scrape", false);
+
+  CMD2_ANY            ("trackers.governor.rate",           [](auto, auto)        { return (int64_t)control->tracker_governor()->rate(); });
+  CMD2_ANY_VALUE_V    ("trackers.governor.rate.set",       [](auto, auto& value) { control->tracker_governor()->set_rate(checked_governor_value(value)); });
+  CMD2_ANY            ("trackers.governor.max_active",     [](auto, auto)        { return (int64_t)control->tracker_governor()->max_active(); });
+  CMD2_ANY_VALUE_V    ("trackers.governor.max_active.set", [](auto, auto& value) { control->tracker_governor()->set_max_active(checked_governor_value(value)); });
+  CMD2_ANY            ("trackers.governor.queued",         [](auto, auto)        { return (int64_t)control->tracker_governor()->size_queued(); });
+  CMD2_ANY            ("trackers.governor.hosts",          [](auto, auto)        { return control->tracker_governor()->hosts(); });
   CMD2_VAR_VALUE      ("trackers.numwant",      -1);
 
   CMD2_ANY            ("trackers.use_udp",     [](auto, auto) { return true; });
@@ -147,10 +176,22 @@ initialize_command_tracker() {
   CMD2_ANY_STRING     ("dht.add_node",          [](auto, auto& str)   { return apply_dht_add_node(str); });
   CMD2_ANY            ("dht.statistics",        [](auto, auto)        { return control->dht_manager()->dht_statistics(); });
 
+  CMD2_ANY_V          ("dht.cache.save",         [](auto, auto)        { control->dht_manager()->save_dht_cache(); });
+  CMD2_ANY            ("dht.cache.interval",     [](auto, auto)        { return (int64_t)control->dht_manager()->checkpoint_interval(); });
+  CMD2_ANY_VALUE_V    ("dht.cache.interval.set", [](auto, auto& value) {
+      if (value < 0 || value > std::numeric_limits<uint32_t>::max())
+        throw torrent::input_error("Invalid DHT cache interval.");
+
+      control->dht_manager()->set_checkpoint_interval(value);
+    });
+
   rpc::rpc.mark_safe("t.url");
   rpc::rpc.mark_safe("t.group");
   rpc::rpc.mark_safe("t.id");
   rpc::rpc.mark_safe("t.type");
+  rpc::rpc.mark_safe("t.host");
+  rpc::rpc.mark_safe("t.host.queued");
+  rpc::rpc.mark_safe("t.host.active");
   rpc::rpc.mark_safe("t.is_usable");
   rpc::rpc.mark_safe("t.is_busy");
   rpc::rpc.mark_safe("t.is_enabled");
@@ -175,6 +216,11 @@ initialize_command_tracker() {
   rpc::rpc.mark_safe("dht.override_port");
   rpc::rpc.mark_safe("dht.add_node");
   rpc::rpc.mark_safe("dht.statistics");
+  rpc::rpc.mark_safe("dht.cache.interval");
   rpc::rpc.mark_safe("trackers.numwant");
   rpc::rpc.mark_safe("trackers.use_udp");
+  rpc::rpc.mark_safe("trackers.governor.rate");
+  rpc::rpc.mark_safe("trackers.governor.max_active");
+  rpc::rpc.mark_safe("trackers.governor.queued");
+  rpc::rpc.mark_safe("trackers.governor.hosts");
 }
@@ -554,6 +554,26 @@ cmd_view_size_not_visible(const torrent::Object::string_type& args) {
   return (*control->view_manager()->find_throw(args))->size_not_visible();
 }
 
+torrent::Object
+cmd_view_stats(const torrent::Object::string_type& args) {
+  const core::View::stats_type& stats = control->view_manager()->stats(args);
+
+  torrent::Object result = torrent::Object::create_map();
+
+  result.insert_key("size",            stats.size);
+  result.insert_key("complete",        stats.complete);
+  result.insert_key("incomplete",      stats.size - stats.complete);
+  result.insert_key("active",          stats.active);
+  result.insert_key("hashing",         stats.hashing);
+  result.insert_key("size_bytes",      (int64_t)stats.size_bytes);
+  result.insert_key("completed_bytes", (int64_t)stats.completed_bytes);
+  result.insert_key("left_bytes",      (int64_t)stats.left_bytes);
+  result.insert_key("up_rate",         (int64_t)stats.up_rate);
+  result.insert_key("down_rate",       (int64_t)stats.down_rate);
+
+  return result;
+}
+
 torrent::Object
 cmd_view_persistent(const torrent::Object::string_type& args) {
   core::View* view = *control->view_manager()->find_throw(args);
@@ -828,13 +848,27 @@ initialize_command_ui() {
   CMD2_ANY_LIST    ("view.event_added",   std::bind(&apply_view_event, &core::ViewManager::set_event_added, std::placeholders::_2));
   CMD2_ANY_LIST    ("view.event_removed", std::bind(&apply_view_event, &core::ViewManager::set_event_removed, std::placeholders::_2));
 
+  CMD2_ANY_STRING  ("view.id",                [](auto, auto& name) { return (int64_t)control->view_manager()->find_ptr_throw(name)->id(); });
   CMD2_ANY_STRING  ("view.size",              std::bind(&cmd_view_size, std::placeholders::_2));
   CMD2_ANY_STRING  ("view.size_not_visible",  std::bind(&cmd_view_size_not_visible, std::placeholders::_2));
+  CMD2_ANY_STRING  ("view.stats",             std::bind(&cmd_view_stats, std::placeholders::_2));
+  CMD2_ANY_STRING  ("view.stats.enabled",     [](auto, auto& name) { return (int64_t)control->view_manager()->is_stats_enabled(name); });
+  CMD2_ANY_STRING_V("view.stats.enable",      [](auto, auto& name) { control->view_manager()->set_stats_enabled(name, true); });
+  CMD2_ANY_STRING_V("view.stats.disable",     [](auto, auto& name) { control->view_manager()->set_stats_enabled(name, false); });
   CMD2_ANY_STRING  ("view.persistent",        std::bind(&cmd_view_persistent, std::placeholders::_2));
 
+  CMD2_ANY         ("view.threads",           [](auto, auto) { return (int64_t)core::View::parallel_threads(); });
+  CMD2_ANY_VALUE_V ("view.threads.set",       [](auto, auto threads) {
+      if (threads < 0 || threads > 256)
+        throw torrent::input_error("view.threads.set: Invalid number of threads.");
+
+      core::View::set_parallel_threads(threads);
+    });
+
   CMD2_ANY_STRING_V("view.filter_all",      std::bind(&core::View::filter, std::bind(&core::ViewManager::find_ptr_throw, control->view_manager(), std::placeholders::_2)));
 
   CMD2_DL_STRING   ("view.filter_download", std::bind(&cmd_view_filter_download, std::placeholders::_1, std::placeholders::_2));
+  CMD2_DL_VALUE_V  ("view.filter_download.id", [](auto* download, auto id) { control->view_manager()->find_id_throw(id)->filter_download(download); });
   CMD2_DL_STRING   ("view.set_visible",     std::bind(&cmd_view_set_visible,     std::placeholders::_1, std::placeholders::_2));
   CMD2_DL_STRING   ("view.set_not_visible", std::bind(&cmd_view_set_not_visible, std::placeholders::_1, std::placeholders::_2));
 
@@ -920,6 +954,8 @@ initialize_command_ui() {
     });
   }
 
+  rpc::rpc.mark_safe("view.stats");
+  rpc::rpc.mark_safe("view.stats.enabled");
   rpc::rpc.mark_safe("view.set_visible");
   rpc::rpc.mark_safe("view.set_not_visible");
 
@@ -934,6 +970,11 @@ initialize_command_ui() {
   rpc::rpc.mark_safe("elapsed.less");
   rpc::rpc.mark_safe("elapsed.greater");
 
+  for (const auto name : {"cat", "value", "if", "branch", "not", "false", "and", "or",
+                          "less", "greater", "equal", "compare",
+                          "math.add", "math.sub", "math.mul", "math.div", "math.mod", "math.min", "math.max"})
+    rpc::commands.mark_parallel_safe(name);
+
   rpc::rpc.mark_safe("convert.gm_time");
   rpc::rpc.mark_safe("convert.gm_date");
   rpc::rpc.mark_safe("convert.time");
@@ -9,9 +9,20 @@
 #include <torrent/runtime/runtime.h>
 #include <torrent/utils/directory_events.h>
 
+#include "globals.h"
+#include "core/choke_balancer.h"
 #include "core/dht_manager.h"
+#include "core/download.h"
+#include "core/event_stream.h"
+#include "core/filesystem_registry.h"
+#include "core/ratio_engine.h"
+#include "core/startup_admission.h"
+#include "core/startup_profile.h"
+#include "core/tracker_governor.h"
 #include "core/http_queue.h"
 #include "core/manager.h"
+#include "core/peer_client_cache.h"
+#include "core/peer_filter.h"
 #include "core/view_manager.h"
 #include "display/canvas.h"
 #include "display/window.h"
@@ -28,6 +39,7 @@
 #include "rpc/object_storage.h"
 #include "session/session_manager.h"
 #include "ui/root.h"
+#include "utils/tied_file_registry.h"
 #include "utils/watch_ready_queue.h"
 
 Control::Control()
@@ -39,17 +51,47 @@ Control::Control()
     m_objectStorage(new rpc::object_storage()),
     m_lua_engine(new rpc::LuaEngine()),
     m_directory_events(new torrent::directory_events()),
-    m_watch_ready_queue(new utils::WatchReadyQueue()) {
+    m_watch_ready_queue(new utils::WatchReadyQueue()),
+    m_tied_file_registry(new utils::TiedFileRegistry()) {
 
   m_core         = std::make_unique<core::Manager>();
   m_view_manager = std::make_unique<core::ViewManager>();
   m_dht_manager  = std::make_unique<core::DhtManager>();
+  m_event_stream = std::make_unique<core::EventStream>();
+  m_filesystem_registry = std::make_unique<core::FilesystemRegistry>();
+  m_choke_balancer = std::make_unique<core::ChokeBalancer>();
+  m_peer_filter  = std::make_unique<core::PeerFilter>();
+  m_peer_client_cache = std::make_unique<core::PeerClientCache>();
+  m_ratio_engine = std::make_unique<core::RatioEngine>();
+
+  m_startup_admission = std::make_unique<core::StartupAdmission>();
+  m_startup_profile   = std::make_unique<core::StartupProfile>();
+  m_tracker_governor  = std::make_unique<core::TrackerGovernor>();
 
   m_inputStdin->slot_pressed(std::bind(&input::Manager::pressed, m_input.get(), std::placeholders::_1));
 
   m_task_shutdown.slot()                = [this] { handle_shutdown(); };
   m_task_shutdown_clear_requests.slot() = [this] { handle_shutdown_clear_requests(); };
 
+  m_event_stream->slot_pushed() = []() { scgi_thread::wake_parked(); };
+
+  m_core->download_list()->batch()->slot_filter_deferred() = [this](bool state) { m_view_manager->set_filter_deferred(state); };
+  m_core->download_list()->batch()->slot_save_download()   = [](core::Download* download, bool full) {
+      if (full)
+        session_thread::manager()->save_full_download(download);
+      else
+        session_thread::manager()->save_resume_download(download);
+    };
+
+  m_tied_file_registry->slot_tied_path() = [](core::Download* download) {
+      return download->tied_to_file().empty() ? std::string() : expand_path(download->tied_to_file());
+    };
+  m_tied_file_registry->slot_directory_events() = [this]() { return m_directory_events.get(); };
+
+  m_startup_admission->slot_download_host()   = [](core::Download* download) { return core::TrackerGovernor::download_host(download); };
+  m_startup_admission->slot_try_acquire()     = [this](core::Download* download) { return m_tracker_governor->try_acquire(download); };
+  m_startup_admission->slot_resume_download() = [this](core::Download* download, int flags) { m_core->download_list()->resume(download, flags); };
+
   m_commandScheduler->set_slot_error_message([this](const std::string& msg) { m_core->push_log_std(msg); });
 }
 
@@ -94,6 +136,8 @@ Control::cleanup() {
     scgi_thread::thread()->stop_thread_wait();
 
   // Wait for all session files to be written.
+  m_dht_manager->flush_dht_cache();
+  m_filesystem_registry->shutdown();
   session_thread::manager()->flush_all_pending_builds();
   session_thread::thread()->stop_thread_wait();
 
@@ -131,6 +175,11 @@ Control::is_shutdown_completed() {
 void
 Control::handle_shutdown() {
   m_watch_ready_queue->shutdown();
+  m_tied_file_registry->shutdown();
+  m_peer_filter->shutdown();
+  m_startup_admission->shutdown();
+  m_tracker_governor->shutdown();
+  m_choke_balancer->shutdown();
 
   rpc::commands.call_catch("event.system.shutdown", rpc::make_target(), "shutdown", "System shutdown event action failed: ");
 
@@ -13,7 +13,16 @@ namespace ui {
 }
 
 namespace core {
+  class ChokeBalancer;
+  class EventStream;
+  class FilesystemRegistry;
   class Manager;
+  class PeerClientCache;
+  class PeerFilter;
+  class RatioEngine;
+  class StartupAdmission;
+  class StartupProfile;
+  class TrackerGovernor;
   class ViewManager;
   class DhtManager;
 }
@@ -39,6 +48,7 @@ namespace torrent {
 }
 
 namespace utils {
+  class TiedFileRegistry;
   class WatchReadyQueue;
 }
 
@@ -64,6 +74,15 @@ public:
   core::Manager*      core()                        { return m_core.get(); }
   core::ViewManager*  view_manager()                { return m_view_manager.get(); }
   core::DhtManager*   dht_manager()                 { return m_dht_manager.get(); }
+  core::EventStream*  event_stream()                { return m_event_stream.get(); }
+  core::FilesystemRegistry* filesystem_registry()   { return m_filesystem_registry.get(); }
+  core::ChokeBalancer* choke_balancer()             { return m_choke_balancer.get(); }
+  core::PeerClientCache* peer_client_cache()        { return m_peer_client_cache.get(); }
+  core::PeerFilter*   peer_filter()                 { return m_peer_filter.get(); }
+  core::RatioEngine*  ratio_engine()                { return m_ratio_engine.get(); }
+  core::StartupAdmission* startup_admission()       { return m_startup_admission.get(); }
+  core::StartupProfile*   startup_profile()         { return m_startup_profile.get(); }
+  core::TrackerGovernor*  tracker_governor()        { return m_tracker_governor.get(); }
 
   ui::Root*           ui()                          { return m_ui.get(); }
   display::Manager*   display()                     { return m_display.get(); }
@@ -76,6 +95,7 @@ public:
 
   torrent::directory_events* directory_events()     { return m_directory_events.get(); }
   utils::WatchReadyQueue*    watch_ready_queue()    { return m_watch_ready_queue.get(); }
+  utils::TiedFileRegistry*   tied_file_registry()   { return m_tied_file_registry.get(); }
 
   uint64_t            tick() const                  { return m_tick; }
   void                inc_tick()                    { m_tick++; }
@@ -90,6 +110,15 @@ private:
   std::unique_ptr<core::Manager>     m_core;
   std::unique_ptr<core::ViewManager> m_view_manager;
   std::unique_ptr<core::DhtManager>  m_dht_manager;
+  std::unique_ptr<core::EventStream> m_event_stream;
+  std::unique_ptr<core::FilesystemRegistry> m_filesystem_registry;
+  std::unique_ptr<core::ChokeBalancer> m_choke_balancer;
+  std::unique_ptr<core::PeerClientCache> m_peer_client_cache;
+  std::unique_ptr<core::PeerFilter>  m_peer_filter;
+  std::unique_ptr<core::RatioEngine> m_ratio_engine;
+  std::unique_ptr<core::StartupAdmission> m_startup_admission;
+  std::unique_ptr<core::StartupProfile>   m_startup_profile;
+  std::unique_ptr<core::TrackerGovernor>  m_tracker_governor;
 
   std::unique_ptr<ui::Root>          m_ui;
   std::unique_ptr<display::Manager>  m_display;
@@ -101,6 +130,7 @@ private:
   std::unique_ptr<rpc::LuaEngine>            m_lua_engine;
   std::unique_ptr<torrent::directory_events> m_directory_events;
   std::unique_ptr<utils::WatchReadyQueue>    m_watch_ready_queue;
+  std::unique_ptr<utils::TiedFileRegistry>   m_tied_file_registry;
 
   uint64_t            m_tick{};
 
@@ -0,0 +1,254 @@
+#include "config.h"
+
+#include "core/choke_balancer.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <queue>
+#include <torrent/exceptions.h>
+#include <torrent/download/choke_group.h>
+#include <torrent/download/choke_queue.h>
+#include <torrent/utils/log.h>
+
+namespace core {
+
+ChokeBalancer::ChokeBalancer() {
+  m_task_update.slot() = [this]() { receive_update(); };
+}
+
+ChokeBalancer::~ChokeBalancer() {
+  torrent::this_thread::scheduler()->erase(&m_task_update);
+}
+
+void
+ChokeBalancer::set_enabled(bool state) {
+  if (state == m_enabled)
+    return;
+
+  m_enabled = state;
+
+  if (m_enabled)
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_update, std::chrono::seconds(m_interval));
+  else
+    torrent::this_thread::scheduler()->erase(&m_task_update);
+}
+
+void
+ChokeBalancer::set_interval(uint32_t seconds) {
+  if (seconds == 0)
+    throw torrent::input_error("Choke group balance interval must be non-zero.");
+
+  m_interval = seconds;
+
+  if (m_task_update.is_scheduled())
+    torrent::this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_update, std::chrono::seconds(m_interval));
+}
+
+void
+ChokeBalancer::set_slots(bool is_up, uint32_t slots) {
+  (is_up ? m_up_slots : m_down_slots) = slots;
+}
+
+void
+ChokeBalancer::update() {
+  if (!m_slot_choke_groups)
+    return;
+
+  auto groups = m_slot_choke_groups();
+
+  update_direction(groups, true);
+  update_direction(groups, false);
+}
+
+void
+ChokeBalancer::shutdown() {
+  torrent::this_thread::scheduler()->erase(&m_task_update);
+  m_enabled = false;
+}
+
+void
+ChokeBalancer::allocate(uint32_t pool, std::vector<entry_type>& entries) {
+  uint32_t used = 0;
+
+  for (auto& entry : entries) {
+    entry.target = std::min(entry.min, entry.max);
+    used += entry.target;
+  }
+
+  uint32_t remaining = pool > used ? pool - used : 0;
+
+  // The first pass fills groups up to their demand, the second hands
+  // out what is left up to their max.
+  for (int pass = 0; pass != 2 && remaining != 0; pass++) {
+    auto cap = [pass](const entry_type& entry) {
+        return pass == 0 ? std::min(std::max(entry.demand, entry.min), entry.max) : entry.max;
+      };
+
+    using item_type = std::pair<double, size_t>;
+    std::priority_queue<item_type, std::vector<item_type>, std::greater<>> queue;
+
+    for (size_t i = 0; i != entries.size(); i++)
+      if (entries[i].weight > 0 && entries[i].target < cap(entries[i]))
+        queue.emplace((entries[i].target + 1) / entries[i].weight, i);
+
+    while (remaining != 0 && !queue.empty()) {
+      auto& entry = entries[queue.top().second];
+      auto  index = queue.top().second;
+      queue.pop();
+
+      entry.target++;
+      remaining--;
+
+      if (entry.target < cap(entry))
+        queue.emplace((entry.target + 1) / entry.weight, index);
+    }
+  }
+}
+
+void
+ChokeBalancer::update_direction(const group_list& groups, bool is_up) {
+  uint32_t pool = slots(is_up);
+
+  if (pool == 0 || groups.empty())
+    return;
+
+  std::vector<direction_type*> states;
+  std::vector<entry_type>      entries;
+  double                       total_rate = 0;
+
+  for (auto group : groups) {
+    auto& state = is_up ? m_groups[group->name()].up : m_groups[group->name()].down;
+    auto  queue = is_up ? group->up_queue() : group->down_queue();
+
+    // Halve the distance to the current number of interested peers,
+    // so a short burst doesn't move slots around.
+    state.demand  = (state.demand + (double)queue->size_total()) / 2;
+    state.rate    = is_up ? group->up_rate() : group->down_rate();
+    state.current = queue->is_unlimited() ? unlimited : (uint32_t)std::max<int64_t>(queue->max_unchoked_signed(), 0);
+
+    total_rate += state.rate;
+    states.push_back(&state);
+  }
+
+  for (size_t i = 0; i != groups.size(); i++) {
+    double share = total_rate > 0 ? states[i]->rate / total_rate : 0.0;
+
+    entries.push_back(entry_type{m_groups[groups[i]->name()].weight * (1.0 + share),
+                                 states[i]->min, states[i]->max,
+                                 (uint32_t)std::ceil(states[i]->demand), 0});
+  }
+
+  allocate(pool, entries);
+
+  for (size_t i = 0; i != groups.size(); i++) {
+    auto& state    = *states[i];
+    auto  target   = entries[i].target;
+    auto  current  = state.current;
+    bool  in_bounds = current != unlimited && current >= state.min && current <= state.max;
+
+    state.target = target;
+
+    if (target == current) {
+      state.reason = "unchanged";
+      continue;
+    }
+
+    if (in_bounds && (target > current ? target - current : current - target) < m_hysteresis) {
+      state.reason = "hysteresis";
+      continue;
+    }
+
+    if (!in_bounds)
+      state.reason = "bounds";
+    else if (target < current)
+      state.reason = "surplus";
+    else
+      state.reason = target <= entries[i].demand ? "demand" : "idle";
+
+    (is_up ? groups[i]->up_queue() : groups[i]->down_queue())->set_max_unchoked(target);
+
+    lt_log_print(torrent::LOG_TORRENT_INFO, "choke_balancer: %s %s %" PRIi64 " -> %" PRIu32 " (%s)",
+                 groups[i]->name().c_str(), is_up ? "up" : "down",
+                 current == unlimited ? (int64_t)-1 : (int64_t)current, target, state.reason);
+
+    m_decisions.push_back(decision_type{std::chrono::duration_cast<std::chrono::seconds>(torrent::this_thread::cached_time()).count(),
+                                        groups[i]->name(), is_up, current, target, state.reason});
+
+    if (m_decisions.size() > max_decisions)
+      m_decisions.pop_front();
+
+    state.current = target;
+  }
+}
+
+void
+ChokeBalancer::receive_update() {
+  update();
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_update, std::chrono::seconds(m_interval));
+}
+
+namespace {
+
+int64_t
+slots_value(uint32_t slots) {
+  return slots == ChokeBalancer::unlimited ? -1 : (int64_t)slots;
+}
+
+torrent::Object
+direction_object(const ChokeBalancer::direction_type& direction) {
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["min"]     = slots_value(direction.min);
+  result["max"]     = slots_value(direction.max);
+  result["demand"]  = (int64_t)std::ceil(direction.demand);
+  result["rate"]    = (int64_t)direction.rate;
+  result["current"] = slots_value(direction.current);
+  result["target"]  = slots_value(direction.target);
+  result["reason"]  = std::string(direction.reason);
+
+  return raw_result;
+}
+
+}
+
+torrent::Object
+ChokeBalancer::group_state(const std::string& name) const {
+  static const group_type default_group;
+
+  auto        itr   = m_groups.find(name);
+  const auto& group = itr != m_groups.end() ? itr->second : default_group;
+
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["name"]   = name;
+  result["weight"] = (int64_t)group.weight;
+  result["up"]     = direction_object(group.up);
+  result["down"]   = direction_object(group.down);
+
+  return raw_result;
+}
+
+torrent::Object
+ChokeBalancer::decisions() const {
+  auto  raw_result = torrent::Object::create_list();
+  auto& result     = raw_result.as_list();
+
+  for (const auto& decision : m_decisions) {
+    auto& entry = result.insert(result.end(), torrent::Object::create_map())->as_map();
+
+    entry["time"]      = decision.time;
+    entry["group"]     = decision.group;
+    entry["direction"] = std::string(decision.is_up ? "up" : "down");
+    entry["from"]      = slots_value(decision.from);
+    entry["to"]        = slots_value(decision.to);
+    entry["reason"]    = std::string(decision.reason);
+  }
+
+  return raw_result;
+}
+
+}
@@ -0,0 +1,133 @@
+// Periodically moves unchoke slots between choke groups, so that busy
+// groups don't starve while others leave their slots idle.
+//
+// For each direction with a non-zero slot pool, the pool is divided
+// between the choke groups every 'interval' seconds. Each group first
+// gets its 'min' slots, the rest is handed out one slot at a time to
+// the group with the fewest slots per weight. A group's weight is its
+// configured weight scaled by up to 2x by its share of the measured
+// throughput. Groups are first filled up to their smoothed count of
+// interested peers, then any idle slots are spread up to 'max'.
+//
+// A group's limit is only changed when the new target differs by at
+// least 'hysteresis' slots, unless it is outside its bounds. Changes
+// are kept in a short decision log for 'choke_group.balance.*'.
+
+#ifndef RTORRENT_CORE_CHOKE_BALANCER_H
+#define RTORRENT_CORE_CHOKE_BALANCER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <torrent/object.h>
+#include <torrent/system/scheduler.h>
+
+namespace torrent {
+class choke_group;
+}
+
+namespace core {
+
+class ChokeBalancer {
+public:
+  using group_list    = std::vector<torrent::choke_group*>;
+  using slot_groups   = std::function<group_list()>;
+
+  static constexpr uint32_t unlimited          = ~uint32_t();
+  static constexpr uint32_t default_interval   = 30;
+  static constexpr uint32_t default_hysteresis = 2;
+  static constexpr size_t   max_decisions      = 64;
+
+  struct direction_type {
+    uint32_t          min{};
+    uint32_t          max{unlimited};
+
+    double            demand{};
+    uint64_t          rate{};
+    uint32_t          current{unlimited};
+    uint32_t          target{unlimited};
+    const char*       reason{"none"};
+  };
+
+  struct group_type {
+    uint32_t          weight{1};
+
+    direction_type    up;
+    direction_type    down;
+  };
+
+  struct decision_type {
+    int64_t           time;
+    std::string       group;
+    bool              is_up;
+    uint32_t          from;
+    uint32_t          to;
+    const char*       reason;
+  };
+
+  // Input to 'allocate', 'target' is set to the group's share.
+  struct entry_type {
+    double            weight;
+    uint32_t          min;
+    uint32_t          max;
+    uint32_t          demand;
+    uint32_t          target;
+  };
+
+  ChokeBalancer();
+  ~ChokeBalancer();
+
+  bool                is_enabled() const                   { return m_enabled; }
+  void                set_enabled(bool state);
+
+  uint32_t            interval() const                     { return m_interval; }
+  void                set_interval(uint32_t seconds);
+
+  uint32_t            hysteresis() const                   { return m_hysteresis; }
+  void                set_hysteresis(uint32_t slots)       { m_hysteresis = slots; }
+
+  // The number of unchoke slots to divide, zero leaves the groups'
+  // limits alone.
+  uint32_t            slots(bool is_up) const              { return is_up ? m_up_slots : m_down_slots; }
+  void                set_slots(bool is_up, uint32_t slots);
+
+  // Groups are configured by name, the settings are kept if the
+  // group doesn't exist yet.
+  group_type&         group(const std::string& name)       { return m_groups[name]; }
+
+  slot_groups&        slot_choke_groups()                  { return m_slot_choke_groups; }
+
+  void                update();
+  void                shutdown();
+
+  torrent::Object     group_state(const std::string& name) const;
+  torrent::Object     decisions() const;
+
+  // Divides 'pool' slots between 'entries', see above.
+  static void         allocate(uint32_t pool, std::vector<entry_type>& entries);
+
+private:
+  void                update_direction(const group_list& groups, bool is_up);
+  void                receive_update();
+
+  bool                m_enabled{};
+  uint32_t            m_interval{default_interval};
+  uint32_t            m_hysteresis{default_hysteresis};
+  uint32_t            m_up_slots{};
+  uint32_t            m_down_slots{};
+
+  std::map<std::string, group_type> m_groups;
+  std::deque<decision_type>         m_decisions;
+
+  slot_groups         m_slot_choke_groups;
+
+  torrent::system::SchedulerEntry m_task_update;
+};
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "config.h"
+
+#include "core/dht_cache.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <torrent/object_stream.h>
+
+namespace core {
+
+dht_cache_load_result
+dht_cache_read(const std::string& path) {
+  dht_cache_load_result result;
+
+  auto stream = std::fstream(path.c_str(), std::ios::in | std::ios::binary);
+
+  if (!stream.is_open())
+    return result;
+
+  result.found = true;
+  stream >> result.cache;
+
+  // If the cache file is corrupted we will just discard it with an
+  // error message.
+  if (stream.fail()) {
+    result.cache = torrent::Object::create_map();
+    result.error = "cache file corrupted, discarding";
+  }
+
+  return result;
+}
+
+static std::string
+write_failed(int fd, const std::string& path_tmp, const char* action) {
+  auto error = std::string("could not ") + action + " '" + path_tmp + "': " + std::strerror(errno);
+
+  ::close(fd);
+  ::unlink(path_tmp.c_str());
+  return error;
+}
+
+std::string
+dht_cache_write(const std::string& path, const torrent::Object& cache) {
+  std::ostringstream stream;
+  stream << cache;
+
+  auto data     = stream.str();
+  auto path_tmp = path + ".new";
+
+  int fd = ::open(path_tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+  if (fd == -1)
+    return "could not open '" + path_tmp + "': " + std::strerror(errno);
+
+  for (size_t written = 0; written != data.size(); ) {
+    auto result = ::write(fd, data.data() + written, data.size() - written);
+
+    if (result == -1 && errno == EINTR)
+      continue;
+
+    if (result == -1)
+      return write_failed(fd, path_tmp, "write");
+
+    written += result;
+  }
+
+  // Renaming a file that didn't reach the disk could replace a good
+  // cache with an empty one after a crash.
+#ifdef __APPLE__
+  if (::fsync(fd) == -1)
+    return write_failed(fd, path_tmp, "sync");
+#else
+  if (::fdatasync(fd) == -1)
+    return write_failed(fd, path_tmp, "sync");
+#endif
+
+  if (::close(fd) == -1) {
+    auto error = "could not close '" + path_tmp + "': " + std::strerror(errno);
+    ::unlink(path_tmp.c_str());
+    return error;
+  }
+
+  if (::rename(path_tmp.c_str(), path.c_str()) == -1) {
+    auto error = "could not rename '" + path_tmp + "': " + std::strerror(errno);
+    ::unlink(path_tmp.c_str());
+    return error;
+  }
+
+  return std::string();
+}
+
+}
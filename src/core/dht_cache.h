@@ -0,0 +1,40 @@
+#ifndef RTORRENT_CORE_DHT_CACHE_H
+#define RTORRENT_CORE_DHT_CACHE_H
+
+#include <atomic>
+#include <string>
+#include <torrent/object.h>
+
+namespace core {
+
+struct dht_cache_load_result {
+  torrent::Object   cache{torrent::Object::create_map()};
+  std::string       error;
+  bool              found{};
+};
+
+// A snapshot of the routing table waiting to be written. The job is
+// written by whoever claims it first, either the session thread or
+// 'DhtManager::flush_dht_cache', and is claimed when replaced by a
+// newer snapshot so it is never written.
+struct dht_cache_save_job {
+  std::string       path;
+  torrent::Object   cache;
+
+  std::atomic<bool> claimed{};
+
+  bool              claim() { return !claimed.exchange(true); }
+};
+
+// A missing file is not an error, a corrupted file is discarded and
+// an empty cache returned.
+dht_cache_load_result dht_cache_read(const std::string& path);
+
+// Writes to 'path' with the ".new" suffix and renames it over 'path'
+// once synced, so a failed write leaves the old cache in place.
+// Returns an empty string on success.
+std::string           dht_cache_write(const std::string& path, const torrent::Object& cache);
+
+}
+
+#endif
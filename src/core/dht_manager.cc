@@ -2,17 +2,17 @@
 
 #include "dht_manager.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
 #include <torrent/object.h>
-#include <torrent/object_stream.h>
 #include <torrent/rate.h>
 #include <torrent/runtime/network_manager.h>
 #include <torrent/runtime/runtime.h>
+#include <torrent/system/thread.h>
 #include <torrent/tracker/dht_controller.h>
 #include <torrent/utils/log.h>
 
 #include "control.h"
+#include "dht_cache.h"
 #include "download.h"
 #include "globals.h"
 #include "manager.h"
@@ -29,9 +29,15 @@ namespace core {
 
 const char* DhtManager::dht_settings[dht_settings_num] = { "disable", "off", "auto", "on" };
 
+DhtManager::DhtManager() :
+  m_callback_id(torrent::system::make_callback_id()) {
+  m_checkpoint_timeout.slot() = [this] { receive_checkpoint(); };
+}
+
 DhtManager::~DhtManager() {
   torrent::this_thread::scheduler()->erase(&m_update_timeout);
   torrent::this_thread::scheduler()->erase(&m_stop_timeout);
+  torrent::this_thread::scheduler()->erase(&m_checkpoint_timeout);
 }
 
 void
@@ -41,30 +47,32 @@ DhtManager::load_dht_cache() {
     return;
   }
 
-  auto cache_filename = session_thread::manager()->path() + "rtorrent.dht_cache";
-  auto cache_stream   = std::fstream(cache_filename.c_str(), std::ios::in | std::ios::binary);
+  auto path = session_thread::manager()->path() + "rtorrent.dht_cache";
 
-  torrent::Object cache = torrent::Object::create_map();
+  session_thread::callback(m_callback_id, [this, path]() {
+      auto result = std::make_shared<dht_cache_load_result>(dht_cache_read(path));
 
-  if (cache_stream.is_open()) {
-    cache_stream >> cache;
+      torrent::main_thread::callback(m_callback_id, [this, path, result]() {
+          if (!result->found)
+            LT_LOG("could not open cache file (path:%s)", path.c_str());
+          else if (!result->error.empty())
+            LT_LOG_ERROR("%s (path:%s)", result->error.c_str(), path.c_str());
+          else
+            LT_LOG("cache file read (path:%s)", path.c_str());
 
-    // If the cache file is corrupted we will just discard it with an
-    // error message.
-    if (cache_stream.fail()) {
-      LT_LOG_ERROR("cache file corrupted, discarding (path:%s)", cache_filename.c_str());
-      cache = torrent::Object::create_map();
-    } else {
-      LT_LOG("cache file read (path:%s)", cache_filename.c_str());
-    }
+          receive_loaded(result->cache);
+        });
+    });
+}
 
-  } else {
-    LT_LOG("could not open cache file (path:%s)", cache_filename.c_str());
-  }
+// Downloads may have started while the cache was loading, so also
+// check if auto mode should start the DHT.
 
+void
+DhtManager::receive_loaded(const torrent::Object& cache) {
   torrent::runtime::network_manager()->dht_controller()->initialize(cache);
 
-  if (m_start == dht_on)
+  if (m_start == dht_on || (m_start == dht_auto && has_active_public_download()))
     start_dht();
 }
 
@@ -122,22 +130,69 @@ DhtManager::save_dht_cache() {
   if (!torrent::runtime::network_manager()->is_dht_valid())
     return;
 
-  auto filename     = session_thread::manager()->path() + "rtorrent.dht_cache";
-  auto filename_tmp = filename + ".new";
-  auto cache_file   = std::fstream(filename_tmp.c_str(), std::ios::out | std::ios::trunc);
+  auto job = std::make_shared<dht_cache_save_job>();
 
-  if (!cache_file.is_open())
-    return;
+  job->path  = session_thread::manager()->path() + "rtorrent.dht_cache";
+  job->cache = torrent::Object::create_map();
+
+  torrent::runtime::network_manager()->dht_controller()->store_cache(&job->cache);
+
+  if (m_save_job != nullptr)
+    m_save_job->claim();
 
-  torrent::Object cache = torrent::Object::create_map();
-  cache_file << *torrent::runtime::network_manager()->dht_controller()->store_cache(&cache);
+  m_save_job = job;
 
-  if (!cache_file.good())
+  session_thread::callback(m_callback_id, [this, job]() {
+      if (!job->claim())
+        return;
+
+      auto error = dht_cache_write(job->path, job->cache);
+
+      torrent::main_thread::callback(m_callback_id, [this, job, error]() {
+          if (!error.empty())
+            LT_LOG_ERROR("%s", error.c_str());
+          else
+            LT_LOG("cache file written (path:%s)", job->path.c_str());
+
+          if (m_save_job == job)
+            m_save_job.reset();
+        });
+    });
+}
+
+void
+DhtManager::flush_dht_cache() {
+  torrent::this_thread::scheduler()->erase(&m_checkpoint_timeout);
+  torrent::system::cancel_callback_and_wait(m_callback_id, session_thread::thread(), torrent::main_thread::thread());
+
+  if (m_save_job == nullptr)
     return;
 
-  cache_file.close();
+  if (m_save_job->claim()) {
+    auto error = dht_cache_write(m_save_job->path, m_save_job->cache);
 
-  ::rename(filename_tmp.c_str(), filename.c_str());
+    if (!error.empty())
+      LT_LOG_ERROR("%s", error.c_str());
+  }
+
+  m_save_job.reset();
+}
+
+void
+DhtManager::set_checkpoint_interval(uint32_t seconds) {
+  m_checkpoint_interval = seconds;
+
+  torrent::this_thread::scheduler()->erase(&m_checkpoint_timeout);
+
+  if (m_checkpoint_interval != 0)
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_checkpoint_timeout, std::chrono::seconds(m_checkpoint_interval));
+}
+
+void
+DhtManager::receive_checkpoint() {
+  save_dht_cache();
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_checkpoint_timeout, std::chrono::seconds(m_checkpoint_interval));
 }
 
 void
@@ -196,17 +251,9 @@ DhtManager::update() {
   if (!torrent::runtime::network_manager()->is_dht_active())
     throw torrent::internal_error("DhtManager::update called with DHT inactive.");
 
-  if (m_start == dht_auto && !m_stop_timeout.is_scheduled()) {
-    DownloadList::const_iterator itr, end;
-
-    for (itr = control->core()->download_list()->begin(), end = control->core()->download_list()->end(); itr != end; ++itr)
-      if ((*itr)->download()->info()->is_active() && !(*itr)->download()->info()->is_private())
-        break;
-
-    if (itr == end) {
-      m_stop_timeout.slot() = std::bind(&DhtManager::stop_dht, this);
-      torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_stop_timeout, 15min);
-    }
+  if (m_start == dht_auto && !m_stop_timeout.is_scheduled() && !has_active_public_download()) {
+    m_stop_timeout.slot() = std::bind(&DhtManager::stop_dht, this);
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_stop_timeout, 15min);
   }
 
   // While bootstrapping (log_statistics returns true), check every minute if it completed, otherwise update every 15 minutes.
@@ -216,6 +263,13 @@ DhtManager::update() {
     torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_update_timeout, 15min);
 }
 
+bool
+DhtManager::has_active_public_download() {
+  return std::any_of(control->core()->download_list()->begin(), control->core()->download_list()->end(), [](const auto& download) {
+      return download->download()->info()->is_active() && !download->download()->info()->is_private();
+    });
+}
+
 bool
 DhtManager::log_statistics(bool force) {
   auto stats = torrent::runtime::network_manager()->dht_controller()->get_statistics();
@@ -1,11 +1,16 @@
 #ifndef RTORRENT_CORE_DHT_MANAGER_H
 #define RTORRENT_CORE_DHT_MANAGER_H
 
+#include <memory>
+#include <string>
 #include <torrent/object.h>
+#include <torrent/system/callbacks.h>
 #include <torrent/system/scheduler.h>
 
 namespace core {
 
+struct dht_cache_save_job;
+
 class DhtManager {
 public:
   static constexpr int dht_disable = 0;
@@ -13,10 +18,25 @@ public:
   static constexpr int dht_auto    = 2;
   static constexpr int dht_on      = 3;
 
+  DhtManager();
   ~DhtManager();
 
+  // The cache file is read and parsed in the session thread, and the
+  // DHT is initialized and started once it has been loaded.
   void                load_dht_cache();
+
+  // Snapshots the routing table and hands it to the session thread to
+  // be encoded and written, replacing any save not yet started.
   void                save_dht_cache();
+
+  // Waits for a save in progress, and writes a save that was not yet
+  // started. Called during cleanup.
+  void                flush_dht_cache();
+
+  // Seconds between checkpoints of the cache, zero disables.
+  uint32_t            checkpoint_interval() const  { return m_checkpoint_interval; }
+  void                set_checkpoint_interval(uint32_t seconds);
+
   torrent::Object     dht_statistics();
 
   void                start_dht();
@@ -35,6 +55,11 @@ private:
   void                update();
   bool                log_statistics(bool force);
 
+  void                receive_loaded(const torrent::Object& cache);
+  void                receive_checkpoint();
+
+  bool                has_active_public_download();
+
   unsigned int        m_dhtPrevCycle;
   unsigned int        m_dhtPrevQueriesSent;
   unsigned int        m_dhtPrevRepliesReceived;
@@ -44,6 +69,11 @@ private:
 
   torrent::system::SchedulerEntry m_update_timeout;
   torrent::system::SchedulerEntry m_stop_timeout;
+  torrent::system::SchedulerEntry m_checkpoint_timeout;
+
+  torrent::system::callback_id m_callback_id;
+  std::shared_ptr<dht_cache_save_job> m_save_job;
+  uint32_t            m_checkpoint_interval{};
 
   bool                m_warned{};
   bool                m_set_by_user{};
@@ -14,7 +14,10 @@
 #include "rpc/parse_commands.h"
 
 #include "control.h"
+#include "core/event_stream.h"
+#include "core/file_tree_index.h"
 #include "core/manager.h"
+#include "core/throttle_groups.h"
 
 namespace core {
 
@@ -23,6 +26,9 @@ Download::Download(download_type d)
 
   m_download.info()->signal_tracker_success().push_back(std::bind(&Download::receive_tracker_msg, this, ""));
   m_download.info()->signal_tracker_failed().push_back(std::bind(&Download::receive_tracker_msg, this, std::placeholders::_1));
+  m_download.info()->signal_tracker_failed().push_back([this](const std::string& msg) {
+      control->event_stream()->push_download(this, "tracker_failed", msg);
+    });
 }
 
 Download::~Download() {
@@ -32,11 +38,6 @@ Download::~Download() {
   m_download = download_type();
 }
 
-uint32_t
-Download::priority() {
-  return bencode()->get_key("rtorrent").get_key_value("priority");
-}
-
 void
 Download::set_priority(uint32_t p) {
   p %= 4;
@@ -47,7 +48,46 @@ Download::set_priority(uint32_t p) {
   else
     torrent::download_set_priority(m_download, p * p);
 
-  bencode()->get_key("rtorrent").insert_key("priority", (int64_t)p);
+  m_priority = p;
+}
+
+void
+Download::load_variables(torrent::Object* rtorrent) {
+  m_state              = rtorrent->get_key_value("state");
+  m_state_changed      = rtorrent->get_key_value("state_changed");
+  m_state_counter      = rtorrent->get_key_value("state_counter");
+  m_complete           = rtorrent->get_key_value("complete");
+  m_hashing            = rtorrent->get_key_value("hashing");
+  m_ignore_commands    = rtorrent->get_key_value("ignore_commands");
+  m_timestamp_started  = rtorrent->get_key_value("timestamp.started");
+  m_timestamp_finished = rtorrent->get_key_value("timestamp.finished");
+  m_tied_to_file       = rtorrent->get_key_string("tied_to_file");
+
+  for (auto key : {"priority", "state", "state_changed", "state_counter", "complete", "hashing",
+                   "ignore_commands", "timestamp.started", "timestamp.finished", "tied_to_file"})
+    rtorrent->erase_key(key);
+}
+
+void
+Download::save_variables(torrent::Object* rtorrent) const {
+  rtorrent->insert_key("priority",           (int64_t)m_priority);
+  rtorrent->insert_key("state",              m_state);
+  rtorrent->insert_key("state_changed",      m_state_changed);
+  rtorrent->insert_key("state_counter",      m_state_counter);
+  rtorrent->insert_key("complete",           m_complete);
+  rtorrent->insert_key("hashing",            m_hashing);
+  rtorrent->insert_key("ignore_commands",    m_ignore_commands);
+  rtorrent->insert_key("timestamp.started",  m_timestamp_started);
+  rtorrent->insert_key("timestamp.finished", m_timestamp_finished);
+  rtorrent->insert_key("tied_to_file",       m_tied_to_file);
+}
+
+const FileTreeIndex*
+Download::file_tree_index() {
+  if (!m_file_tree_index)
+    m_file_tree_index = std::make_unique<FileTreeIndex>(m_download.file_list());
+
+  return m_file_tree_index.get();
 }
 
 uint32_t
@@ -92,12 +132,25 @@ Download::set_throttle_name(const std::string& name) {
   if (m_download.info()->is_active())
     throw torrent::input_error("Cannot set throttle on active download.");
 
-  auto throttles = control->core()->get_throttle(name);
+  auto id        = control->core()->throttle_groups()->find(name);
+  auto throttles = control->core()->get_throttle(id);
 
   m_download.set_upload_throttle(throttles.first);
   m_download.set_download_throttle(throttles.second);
 
   m_download.bencode()->get_key("rtorrent").insert_key("throttle_name", name);
+
+  m_throttle_group = id;
+}
+
+void
+Download::set_throttle_group(uint32_t id) {
+  auto groups = control->core()->throttle_groups();
+
+  if (id >= groups->size())
+    throw torrent::input_error("Invalid throttle group id.");
+
+  set_throttle_name(groups->at(id).name);
 }
 
 void
@@ -14,6 +14,8 @@
 
 namespace core {
 
+class FileTreeIndex;
+
 class Download {
 public:
   typedef torrent::Download             download_type;
@@ -67,15 +69,52 @@ public:
   auto                tracker_controller()                     { return m_download.tracker_controller(); }
   uint32_t            tracker_list_size() const                { return m_download.c_tracker_controller().size(); }
 
+  // Built on first use, the file paths of a torrent never change.
+  const FileTreeIndex* file_tree_index();
+
   auto                connection_list()                        { return m_download.connection_list(); }
   uint32_t            connection_list_size() const;
 
   const std::string&  message() const                          { return m_message; }
   void                set_message(const std::string& msg)      { m_message = msg; }
 
-  uint32_t            priority();
+  uint32_t            priority() const                         { return m_priority; }
   void                set_priority(uint32_t p);
 
+  // Per-download session state, held as typed members and written to
+  // the "rtorrent" bencode map only when the session is saved.
+  int64_t             state() const                            { return m_state; }
+  void                set_state(int64_t v)                     { m_state = v; }
+  int64_t             state_changed() const                    { return m_state_changed; }
+  void                set_state_changed(int64_t v)             { m_state_changed = v; }
+  int64_t             state_counter() const                    { return m_state_counter; }
+  void                set_state_counter(int64_t v)             { m_state_counter = v; }
+
+  int64_t             complete() const                         { return m_complete; }
+  void                set_complete(int64_t v)                  { m_complete = v; }
+  int64_t             hashing() const                          { return m_hashing; }
+  void                set_hashing(int64_t v)                   { m_hashing = v; }
+  int64_t             ignore_commands() const                  { return m_ignore_commands; }
+  void                set_ignore_commands(int64_t v)           { m_ignore_commands = v; }
+
+  int64_t             timestamp_started() const                { return m_timestamp_started; }
+  void                set_timestamp_started(int64_t v)         { m_timestamp_started = v; }
+  int64_t             timestamp_finished() const               { return m_timestamp_finished; }
+  void                set_timestamp_finished(int64_t v)        { m_timestamp_finished = v; }
+
+  const std::string&  tied_to_file() const                     { return m_tied_to_file; }
+  void                set_tied_to_file(const std::string& path) { m_tied_to_file = path; }
+
+  // Moves the state variables out of the "rtorrent" map, and back in
+  // when building the session streams.
+  void                load_variables(torrent::Object* rtorrent);
+  void                save_variables(torrent::Object* rtorrent) const;
+
+  // Set while a download is being loaded from the session, only the
+  // resumes done then wait for core::StartupAdmission.
+  bool                is_session_loaded() const                { return m_session_loaded; }
+  void                set_session_loaded(bool v)               { m_session_loaded = v; }
+
   uint32_t            resume_flags()                           { return m_resumeFlags; }
   void                set_resume_flags(uint32_t flags)         { m_resumeFlags = flags; }
 
@@ -83,6 +122,11 @@ public:
 
   void                set_throttle_name(const std::string& name);
 
+  // The ThrottleGroups id of the throttle name, or ~0 if the name
+  // isn't a throttle group.
+  uint32_t            throttle_group() const                   { return m_throttle_group; }
+  void                set_throttle_group(uint32_t id);
+
   bool                operator == (const std::string& str) const;
 
   float               distributed_copies() const;
@@ -102,9 +146,24 @@ private:
   // Store the FileList instance so we can use slots etc on it.
   download_type       m_download;
   bool                m_hashFailed{};
+  bool                m_session_loaded{};
   std::string         m_message;
   uint32_t            m_resumeFlags{default_resume_flags};
   unsigned int        m_group{};
+  uint32_t            m_throttle_group{~uint32_t()};
+
+  uint32_t            m_priority{};
+  int64_t             m_state{};
+  int64_t             m_state_changed{};
+  int64_t             m_state_counter{};
+  int64_t             m_complete{};
+  int64_t             m_hashing{};
+  int64_t             m_ignore_commands{};
+  int64_t             m_timestamp_started{};
+  int64_t             m_timestamp_finished{};
+  std::string         m_tied_to_file;
+
+  std::unique_ptr<FileTreeIndex> m_file_tree_index;
 };
 
 inline bool
@@ -0,0 +1,62 @@
+#include "config.h"
+
+#include "core/download_batch.h"
+
+#include <torrent/exceptions.h>
+
+namespace core {
+
+void
+DownloadBatch::begin() {
+  if (m_depth++ != 0)
+    return;
+
+  m_slot_filter_deferred(true);
+}
+
+void
+DownloadBatch::end() {
+  if (m_depth == 0)
+    throw torrent::internal_error("DownloadBatch::end() called without a matching begin().");
+
+  if (--m_depth != 0)
+    return;
+
+  m_slot_filter_deferred(false);
+
+  auto saves = std::move(m_saves);
+  m_saves.clear();
+  m_index.clear();
+
+  for (const auto& [download, full] : saves)
+    if (download != nullptr)
+      m_slot_save_download(download, full);
+}
+
+void
+DownloadBatch::save(Download* download, bool full) {
+  if (m_depth == 0)
+    return m_slot_save_download(download, full);
+
+  auto result = m_index.emplace(download, m_saves.size());
+
+  if (result.second)
+    m_saves.emplace_back(download, full);
+  else
+    m_saves[result.first->second].second |= full;
+}
+
+// Erased downloads keep their slot so the indices stay valid.
+
+void
+DownloadBatch::erase(Download* download) {
+  auto itr = m_index.find(download);
+
+  if (itr == m_index.end())
+    return;
+
+  m_saves[itr->second].first = nullptr;
+  m_index.erase(itr);
+}
+
+}
@@ -0,0 +1,53 @@
+// Tracks the work DownloadList defers while a batch of commands is
+// run on many downloads, see DownloadList::begin_batch.
+//
+// View filtering is deferred when the outermost batch begins, and
+// the views filter their pending downloads in a single pass when it
+// ends. Saves of a download are merged into one, a full save
+// replacing resume saves, and done in the order the downloads were
+// first saved.
+
+#ifndef RTORRENT_CORE_DOWNLOAD_BATCH_H
+#define RTORRENT_CORE_DOWNLOAD_BATCH_H
+
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+class Download;
+
+class DownloadBatch {
+public:
+  using slot_deferred = std::function<void (bool)>;
+  using slot_save     = std::function<void (Download*, bool)>;
+
+  bool                is_active() const             { return m_depth != 0; }
+  size_t              size_saves() const            { return m_index.size(); }
+
+  void                begin();
+  void                end();
+
+  // Saves right away unless a batch is open.
+  void                save(Download* download, bool full);
+  void                erase(Download* download);
+
+  // Control sets these to use ViewManager::set_filter_deferred and the
+  // session manager.
+  slot_deferred&      slot_filter_deferred()        { return m_slot_filter_deferred; }
+  slot_save&          slot_save_download()          { return m_slot_save_download; }
+
+private:
+  unsigned int                          m_depth{};
+  std::vector<std::pair<Download*, bool>> m_saves;
+  std::unordered_map<Download*, size_t> m_index;
+
+  slot_deferred       m_slot_filter_deferred;
+  slot_save           m_slot_save_download;
+};
+
+}
+
+#endif
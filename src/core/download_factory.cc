@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <functional>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <torrent/utils/log.h>
@@ -21,8 +22,10 @@
 #include "control.h"
 #include "globals.h"
 #include "core/download.h"
+#include "core/download_list.h"
 #include "core/http_queue.h"
 #include "core/manager.h"
+#include "core/startup_profile.h"
 #include "rpc/parse_commands.h"
 
 namespace core {
@@ -61,6 +64,16 @@ is_magnet_uri(const std::string& uri) {
     std::strncmp(uri.c_str(), "magnet:?", 8) == 0;
 }
 
+// Torrents loaded at startup get a span each for reading and for
+// creating the download.
+static void
+download_factory_profile(std::optional<StartupProfile::scope>* span, bool init_load, bool session, const char* step, const std::string& uri) {
+  if (!init_load || !control->startup_profile()->is_recording())
+    return;
+
+  span->emplace(control->startup_profile(), session ? "session_torrent" : "arg_torrent", step + uri);
+}
+
 DownloadFactory::DownloadFactory(Manager* m) :
     m_manager(m) {
 
@@ -88,13 +101,65 @@ DownloadFactory::load(const std::string& uri) {
   torrent::this_thread::scheduler()->wait_for(&m_task_load, 0ms);
 }
 
-// This function must be called before DownloadFactory::commit().
+// Decodes the torrent directly from the caller's buffer rather than
+// copying it into a stringstream first, as raw data passed through
+// RPC may be several megabytes.
+namespace {
+
+class raw_data_buffer : public std::streambuf {
+public:
+  raw_data_buffer(const std::string& data) {
+    auto first = const_cast<char*>(data.data());
+    setg(first, first, first + data.size());
+  }
+};
+
+}
+
+std::unique_ptr<torrent::Object>
+DownloadFactory::decode_raw_data(const std::string& input) {
+  raw_data_buffer buffer(input);
+  std::istream stream(&buffer);
+
+  auto object = std::make_unique<torrent::Object>();
+
+  try {
+    stream >> *object;
+  } catch (const torrent::local_error& e) {
+    throw torrent::input_error("Could not decode torrent: " + std::string(e.what()));
+  }
+
+  if (stream.fail() || !object->is_map())
+    throw torrent::input_error("Could not create download, the input is not a valid torrent");
+
+  return object;
+}
+
+// These functions must be called before DownloadFactory::commit().
+//
+// Invalid raw data is reported by receive_success() once the download
+// is committed, as the caller still owns the factory here.
 void
 DownloadFactory::load_raw_data(const std::string& input) {
-  if (m_stream)
-    throw torrent::internal_error("DownloadFactory::load*() called on an object with m_stream != NULL");
+  if (m_stream || m_object)
+    throw torrent::internal_error("DownloadFactory::load*() called on an object with m_stream or m_object != NULL");
+
+  try {
+    m_object = decode_raw_data(input).release();
+  } catch (const torrent::input_error& e) {
+    m_error = e.what();
+  }
 
-  m_stream.reset(new std::stringstream(input));
+  m_loaded = true;
+}
+
+void
+DownloadFactory::load_object(torrent::Object&& object) {
+  if (m_stream || m_object)
+    throw torrent::internal_error("DownloadFactory::load*() called on an object with m_stream or m_object != NULL");
+
+  m_object = new torrent::Object;
+  m_object->swap(object);
   m_loaded = true;
 }
 
@@ -105,25 +170,37 @@ DownloadFactory::commit() {
 
 void
 DownloadFactory::receive_load() {
-  if (m_stream)
-    throw torrent::internal_error("DownloadFactory::load*() called on an object with m_stream != NULL");
+  if (m_stream || m_object)
+    throw torrent::internal_error("DownloadFactory::load*() called on an object with m_stream or m_object != NULL");
+
+  std::optional<StartupProfile::scope> span;
+  download_factory_profile(&span, m_initLoad, m_session, "load:", m_uri);
 
   if (is_network_uri(m_uri)) {
+    auto cached_hash = m_manager->http_queue()->cached_hash(m_uri);
+
+    // Reloading a url whose download still exists would only fail on
+    // the duplicate info hash after fetching and decoding it.
+    if (cached_hash.size() == torrent::HashString::size_data &&
+        m_manager->download_list()->find(*torrent::HashString::cast_from(cached_hash)) != m_manager->download_list()->end()) {
+      m_manager->http_queue()->record_skipped();
+      return receive_failed("Info hash already used by another torrent");
+    }
+
     m_stream.reset(new std::stringstream);
+    m_variables["tied_to_file"] = (int64_t)false;
 
     auto done_fn   = [this]() { receive_loaded(); };
     auto failed_fn = [this](const std::string& error) { receive_failed(error); };
 
+    // May call done_fn before returning if the url is cached.
     m_manager->http_queue()->insert(m_uri, m_stream, done_fn, failed_fn);
-
-    m_variables["tied_to_file"] = (int64_t)false;
     return;
   }
 
   if (is_magnet_uri(m_uri)) {
-    // DEBUG: Use m_object.
-    m_stream.reset(new std::stringstream());
-    *m_stream << "d10:magnet-uri" << m_uri.length() << ":" << m_uri << "e";
+    m_object = new torrent::Object(torrent::Object::create_map());
+    m_object->insert_key("magnet-uri", m_uri);
 
     m_variables["tied_to_file"] = (int64_t)false;
 
@@ -165,6 +242,12 @@ DownloadFactory::receive_commit() {
 
 void
 DownloadFactory::receive_success() {
+  std::optional<StartupProfile::scope> span;
+  download_factory_profile(&span, m_initLoad, m_session, "create:", m_uri);
+
+  if (!m_error.empty())
+    return receive_failed(m_error);
+
   bool session_invalid = false;
 
   auto rtorrent_object          = download_factory_load_stream((expand_path(m_uri) + ".rtorrent").c_str(), &session_invalid);
@@ -250,7 +333,7 @@ DownloadFactory::receive_success() {
   rpc::call_command("d.tracker_numwant.set",  rpc::call_command("trackers.numwant"), rpc::make_target(download));
   rpc::call_command("d.max_file_size.set",    rpc::call_command("system.file.max_size"), rpc::make_target(download));
 
-  if (rpc::call_command_value("d.complete", rpc::make_target(download)) != 0) {
+  if (download->complete() != 0) {
     if (rpc::call_command_value("throttle.min_peers.seed") >= 0)
       rpc::call_command("d.peers_min.set", rpc::call_command("throttle.min_peers.seed"), rpc::make_target(download));
 
@@ -308,6 +391,8 @@ DownloadFactory::receive_success() {
     download->set_message(msg);
   }
 
+  download->set_session_loaded(m_session);
+
   // The action of inserting might cause the torrent to be
   // opened/started or such. Figure out a nicer way of handling this.
   if (m_manager->download_list()->insert(download) == m_manager->download_list()->end()) {
@@ -321,6 +406,9 @@ DownloadFactory::receive_success() {
   // Save the info-hash just in case the commands decide to delete it.
   torrent::HashString infohash = download->info()->hash();
 
+  if (is_network_uri(m_uri))
+    m_manager->http_queue()->set_cached_hash(m_uri, std::string(infohash.begin(), infohash.end()));
+
   try {
     if (torrent::log_groups[torrent::LOG_TORRENT_DEBUG].valid())
       log_created(download, rtorrent);
@@ -351,6 +439,11 @@ DownloadFactory::receive_success() {
     }
   }
 
+  // Later resumes, such as a user starting the download, are not
+  // gated by the startup admission.
+  if (m_session && m_manager->download_list()->find(infohash) != m_manager->download_list()->end())
+    download->set_session_loaded(false);
+
   m_slot_finished();
 }
 
@@ -383,7 +476,9 @@ DownloadFactory::log_created(Download* download, torrent::Object* rtorrent) {
 void
 DownloadFactory::receive_failed(const std::string& msg) {
   // Add message to log.
-  if (m_printLog)
+  if (m_printLog && m_uri.empty())
+    m_manager->push_log_std(msg);
+  else if (m_printLog)
     m_manager->push_log_std(msg + ": \"" + m_uri + "\"");
 
   m_slot_finished();
@@ -412,6 +507,7 @@ DownloadFactory::initialize_rtorrent(Download* download, torrent::Object* rtorre
   rtorrent->insert_preserve_copy("timestamp.finished", (int64_t)0);
 
   rtorrent->insert_preserve_copy("tied_to_file", "");
+  rtorrent->insert_preserve_copy("ignore_commands", (int64_t)0);
   rtorrent->insert_key("loaded_file", m_isFile ? m_uri : std::string());
 
   if (rtorrent->has_key_value("priority"))
@@ -432,7 +528,6 @@ DownloadFactory::initialize_rtorrent(Download* download, torrent::Object* rtorre
                               ? rtorrent->get_key_string("throttle_name")
                               : std::string());
 
-  rtorrent->insert_preserve_copy("ignore_commands", (int64_t)0);
   rtorrent->insert_preserve_copy("views", torrent::Object::create_list());
 
   rtorrent->insert_preserve_type("connection_leech", m_variables["connection_leech"]);
@@ -442,6 +537,8 @@ DownloadFactory::initialize_rtorrent(Download* download, torrent::Object* rtorre
   rtorrent->insert_preserve_copy("choke_heuristics.up.seed",    std::string());
   rtorrent->insert_preserve_copy("choke_heuristics.down.leech", std::string());
   rtorrent->insert_preserve_copy("choke_heuristics.down.seed",  std::string());
+
+  download->load_variables(rtorrent);
 }
 
 }
@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <iosfwd>
+#include <memory>
 
 #include <torrent/object.h>
 #include <torrent/system/scheduler.h>
@@ -32,8 +33,14 @@ public:
   // load() or commit().
   void                load(const std::string& uri);
   void                load_raw_data(const std::string& input);
+
+  // Takes over an already decoded torrent, leaving 'object' empty.
+  void                load_object(torrent::Object&& object);
   void                commit();
 
+  // Throws input_error if 'input' isn't a bencoded map.
+  static std::unique_ptr<torrent::Object> decode_raw_data(const std::string& input);
+
   command_list_type&         commands()     { return m_commands; }
   torrent::Object::map_type& variables()    { return m_variables; }
 
@@ -70,6 +77,7 @@ private:
   bool                m_loaded{};
 
   std::string         m_uri;
+  std::string         m_error;
   bool                m_session{};
   bool                m_start{};
   bool                m_printLog{true};
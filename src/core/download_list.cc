@@ -25,15 +25,34 @@
 
 #include "core/dht_manager.h"
 #include "core/download.h"
+#include "core/event_stream.h"
+#include "core/peer_client_cache.h"
+#include "core/peer_filter.h"
+#include "core/ratio_engine.h"
+#include "core/startup_admission.h"
+#include "core/tracker_governor.h"
 #include "core/download_list.h"
 #include "session/session_manager.h"
 #include "ui/root.h"
+#include "utils/tied_file_registry.h"
 
 #define DL_TRIGGER_EVENT(download, event_name) \
-  rpc::commands.call_catch(event_name, rpc::make_target(download), torrent::Object(), "Event '" event_name "' failed: ");
+  trigger_event(download, event_name, "Event '" event_name "' failed: ");
 
 namespace core {
 
+// Events are recorded, and view stats and ratio heaps updated, before
+// the handlers run, so an erase from a handler is seen after the event
+// that caused it.
+static void
+trigger_event(Download* download, const char* event_name, const char* error_msg) {
+  control->event_stream()->push_download(download, event_name);
+  control->view_manager()->update_stats(download);
+  control->ratio_engine()->update(download);
+
+  rpc::commands.call_catch(event_name, rpc::make_target(download), torrent::Object(), error_msg);
+}
+
 inline void
 DownloadList::check_contains([[maybe_unused]] Download* d) {
 #ifdef USE_EXTRA_DEBUG
@@ -51,6 +70,11 @@ DownloadList::clear() {
 
     try {
       close(download);
+      control->tied_file_registry()->erase(download.get());
+      control->tracker_governor()->erase(download.get());
+      control->peer_client_cache()->erase(download.get());
+      m_batch.erase(download.get());
+      m_index.erase(hash_key(download->info()->hash()));
       base_type::pop_back();
 
       torrent::download_remove(*download->download());
@@ -75,9 +99,26 @@ DownloadList::session_save() {
   control->ui()->save_input_history();
 }
 
+void
+DownloadList::save_resume(Download* download) {
+  m_batch.save(download, false);
+}
+
+void
+DownloadList::save_full(Download* download) {
+  m_batch.save(download, true);
+}
+
+std::string_view
+DownloadList::hash_key(const torrent::HashString& hash) {
+  return std::string_view(hash.begin(), torrent::HashString::size_data);
+}
+
 DownloadList::iterator
 DownloadList::find(const torrent::HashString& hash) {
-  return std::find_if(begin(), end(), [hash](const auto& d) { return hash == d->info()->hash(); });
+  auto itr = m_index.find(hash_key(hash));
+
+  return itr != m_index.end() ? itr->second : end();
 }
 
 DownloadList::iterator
@@ -159,6 +200,7 @@ DownloadList::create(std::istream* str, uint32_t tracker_key, bool printLog) {
 DownloadList::iterator
 DownloadList::insert(Download* download) {
   iterator itr = base_type::insert(end(), std::shared_ptr<Download>(download));
+  m_index.emplace(hash_key(download->info()->hash()), itr);
 
   lt_log_print_info(torrent::LOG_TORRENT_INFO, download->info(), "download_list", "Inserting download.");
 
@@ -166,6 +208,12 @@ DownloadList::insert(Download* download) {
     (*itr)->data()->slot_initial_hash()        = std::bind(&DownloadList::hash_done, this, download);
     (*itr)->data()->slot_download_done()       = std::bind(&DownloadList::received_finished, this, download);
 
+    control->tied_file_registry()->insert(download);
+
+    // Cache the client first, the peer filter may disconnect the peer.
+    control->peer_client_cache()->watch(download);
+    control->peer_filter()->watch(download);
+
     // This needs to be separated into two different calls to ensure
     // the download remains in the view.
     for (auto v : *control->view_manager())
@@ -201,14 +249,22 @@ DownloadList::erase(iterator itr) {
 
   close(*itr);
   session_thread::manager()->remove_download(itr->get());
+  m_batch.erase(itr->get());
 
   DL_TRIGGER_EVENT(*itr, "event.download.erased");
 
+  control->tied_file_registry()->erase(itr->get());
+  control->ratio_engine()->erase(itr->get());
+  control->startup_admission()->erase(itr->get());
+  control->tracker_governor()->erase(itr->get());
+  control->peer_client_cache()->erase(itr->get());
+
   for (auto v : *control->view_manager())
     v->erase(itr->get());
 
   torrent::download_remove(*(*itr)->download());
 
+  m_index.erase(hash_key((*itr)->info()->hash()));
   return base_type::erase(itr);
 }
 
@@ -306,8 +362,9 @@ DownloadList::close_throw(Download* download) {
   //control->core()->download_store()->save(download);
 
   download->download()->close();
+  control->peer_client_cache()->erase(download);
 
-  if (!download->is_hash_failed() && rpc::call_command_value("d.hashing", rpc::make_target(download)) != Download::variable_hashing_stopped)
+  if (!download->is_hash_failed() && download->hashing() != Download::variable_hashing_stopped)
     throw torrent::internal_error("DownloadList::close_throw(...) called but we're going into a hashing loop.");
 
   DL_TRIGGER_EVENT(download, "event.download.hash_removed");
@@ -325,6 +382,12 @@ DownloadList::resume(Download* download, int flags) {
     if (download->download()->info()->is_active())
       return;
 
+    // Session downloads are queued until admitted by StartupAdmission,
+    // which then resumes them. User starts and arg torrents are not
+    // gated.
+    if (download->is_session_loaded() && !control->startup_admission()->admit(download, flags))
+      return;
+
     rpc::parse_command_single(rpc::make_target(download), "view.set_visible=active");
 
     // We need to make sure the flags aren't reset if someone decideds
@@ -343,8 +406,8 @@ DownloadList::resume(Download* download, int flags) {
       if (download->is_hash_failed())
         return;
 
-      if (rpc::call_command_value("d.hashing", rpc::make_target(download)) == Download::variable_hashing_stopped)
-        rpc::call_command("d.hashing.set", Download::variable_hashing_initial, rpc::make_target(download));
+      if (download->hashing() == Download::variable_hashing_stopped)
+        download->set_hashing(Download::variable_hashing_initial);
 
       DL_TRIGGER_EVENT(download, "event.download.hash_queued");
       return;
@@ -355,8 +418,8 @@ DownloadList::resume(Download* download, int flags) {
 
     auto cached_seconds = torrent::this_thread::cached_seconds().count();
 
-    rpc::call_command("d.state_changed.set", cached_seconds, rpc::make_target(download));
-    rpc::call_command("d.state_counter.set", rpc::call_command_value("d.state_counter", rpc::make_target(download)) + 1, rpc::make_target(download));
+    download->set_state_changed(cached_seconds);
+    download->set_state_counter(download->state_counter() + 1);
 
     if (download->is_done()) {
       torrent::Object conn_current = rpc::call_command("d.connection_seed", torrent::Object(), rpc::make_target(download));
@@ -417,6 +480,8 @@ DownloadList::pause(Download* download, int flags) {
 
   lt_log_print_info(torrent::LOG_TORRENT_INFO, download->info(), "download_list", "Pausing download: flags:%0x.", flags);
 
+  control->startup_admission()->erase(download);
+
   try {
 
     download->set_resume_flags(Download::default_resume_flags);
@@ -425,9 +490,9 @@ DownloadList::pause(Download* download, int flags) {
 
     // Always clear hashing on pause. When a hashing request is added,
     // it should have cleared the hash resume data.
-    if (rpc::call_command_value("d.hashing", rpc::make_target(download)) != Download::variable_hashing_stopped) {
+    if (download->hashing() != Download::variable_hashing_stopped) {
       download->download()->hash_stop();
-      rpc::call_command_set_value("d.hashing.set", Download::variable_hashing_stopped, rpc::make_target(download));
+      download->set_hashing(Download::variable_hashing_stopped);
 
       DL_TRIGGER_EVENT(download, "event.download.hash_removed");
     }
@@ -445,8 +510,7 @@ DownloadList::pause(Download* download, int flags) {
 
     auto cached_seconds = torrent::this_thread::cached_seconds().count();
 
-    rpc::call_command("d.state_changed.set", cached_seconds, rpc::make_target(download));
-    rpc::call_command("d.state_counter.set", rpc::call_command_value("d.state_counter", rpc::make_target(download)), rpc::make_target(download));
+    download->set_state_changed(cached_seconds);
 
     // If initial seeding is complete, don't try it again when restarting.
     if (download->is_done() &&
@@ -469,7 +533,7 @@ DownloadList::check_hash(Download* download) {
   lt_log_print_info(torrent::LOG_TORRENT_INFO, download->info(), "download_list", "Checking hash.");
 
   try {
-    if (rpc::call_command_value("d.hashing", rpc::make_target(download)) != Download::variable_hashing_stopped)
+    if (download->hashing() != Download::variable_hashing_stopped)
       return;
 
     hash_queue(download, Download::variable_hashing_rehash);
@@ -508,8 +572,8 @@ DownloadList::hash_done(Download* download) {
   // confirm all the data, avoiding large BW usage on f.ex. the
   // ReiserFS bug with >4GB files.
 
-  int64_t hashing = rpc::call_command_value("d.hashing", rpc::make_target(download));
-  rpc::call_command_set_value("d.hashing.set", Download::variable_hashing_stopped, rpc::make_target(download));
+  int64_t hashing = download->hashing();
+  download->set_hashing(Download::variable_hashing_stopped);
 
   if (download->is_done() && download->download()->info()->is_meta_download())
     return process_meta_download(download);
@@ -521,17 +585,17 @@ DownloadList::hash_done(Download* download) {
 
     // If the download was previously completed but the files were
     // f.ex deleted, then we clear the state and complete.
-    if (rpc::call_command_value("d.complete", rpc::make_target(download)) && !download->is_done()) {
-      rpc::call_command("d.state.set", (int64_t)0, rpc::make_target(download));
+    if (download->complete() && !download->is_done()) {
+      download->set_state(0);
       download->set_message("Download registered as completed, but hash check returned unfinished chunks.");
     }
 
     // Save resume data so we update time-stamps and priorities if
     // they were invalid/changed while loading/hashing.
-    rpc::call_command("d.complete.set", (int64_t)download->is_done(), rpc::make_target(download));
+    download->set_complete(download->is_done());
     torrent::resume_save_progress(*download->download(), download->download()->bencode()->get_key("libtorrent_resume"));
 
-    if (rpc::call_command_value("d.state", rpc::make_target(download)) == 1)
+    if (download->state() == 1)
       resume(download, download->resume_flags());
 
     break;
@@ -565,7 +629,7 @@ DownloadList::hash_queue(Download* download, int type) {
 
   lt_log_print_info(torrent::LOG_TORRENT_INFO, download->info(), "download_list", "Hash queue.");
 
-  if (rpc::call_command_value("d.hashing", rpc::make_target(download)) != Download::variable_hashing_stopped)
+  if (download->hashing() != Download::variable_hashing_stopped)
     throw torrent::internal_error("DownloadList::hash_queue(...) hashing already queued.");
 
   // HACK
@@ -580,7 +644,7 @@ DownloadList::hash_queue(Download* download, int type) {
   torrent::resume_clear_progress(*download->download(), download->download()->bencode()->get_key("libtorrent_resume"));
 
   download->set_hash_failed(false);
-  rpc::call_command_set_value("d.hashing.set", type, rpc::make_target(download));
+  download->set_hashing(type);
 
   if (download->is_open())
     throw torrent::internal_error("DownloadList::hash_clear(...) download still open.");
@@ -614,7 +678,7 @@ DownloadList::confirm_finished(Download* download) {
   if (download->download()->info()->is_meta_download())
     return process_meta_download(download);
 
-  rpc::call_command("d.complete.set", (int64_t)1, rpc::make_target(download));
+  download->set_complete(1);
 
   // Clean up these settings:
   torrent::Object conn_current = rpc::call_command("d.connection_seed", torrent::Object(), rpc::make_target(download));
@@ -644,7 +708,7 @@ DownloadList::confirm_finished(Download* download) {
   //
   // Obsolete.
   if (!download->is_active() && rpc::call_command_value("session.on_completion") != 0)
-    session_thread::manager()->save_resume_download(download);
+    save_resume(download);
 
   // Send the completed request before resuming so we don't reset the
   // up/downloaded baseline.
@@ -671,7 +735,7 @@ DownloadList::confirm_finished(Download* download) {
   // being hashed.
   download->set_resume_flags(Download::default_resume_flags);
 
-  if (!download->is_active() && rpc::call_command_value("d.state", rpc::make_target(download)) == 1)
+  if (!download->is_active() && download->state() == 1)
     resume(download,
            torrent::Download::start_no_create |
            torrent::Download::start_skip_tracker |
@@ -694,11 +758,10 @@ DownloadList::process_meta_download(Download* download) {
     return;
   }
 
-  torrent::Object* bencode = new torrent::Object(torrent::Object::create_map());
-  file >> bencode->insert_key("info", torrent::Object());
+  torrent::Object bencode = torrent::Object::create_map();
+  file >> bencode.insert_key("info", torrent::Object());
 
   if (file.fail()) {
-    delete bencode;
     lt_log_print(torrent::LOG_TORRENT_ERROR, "Could not create download, the input is not a valid torrent.");
     return;
   }
@@ -706,15 +769,15 @@ DownloadList::process_meta_download(Download* download) {
   file.close();
 
   // Steal the keys we still need. The old download has no use for them.
-  bencode->insert_key("rtorrent_meta_download", torrent::Object()).swap(download->bencode()->get_key("rtorrent_meta_download"));
+  bencode.insert_key("rtorrent_meta_download", torrent::Object()).swap(download->bencode()->get_key("rtorrent_meta_download"));
   if (download->bencode()->has_key("announce"))
-    bencode->insert_key("announce", torrent::Object()).swap(download->bencode()->get_key("announce"));
+    bencode.insert_key("announce", torrent::Object()).swap(download->bencode()->get_key("announce"));
   if (download->bencode()->has_key("announce-list"))
-    bencode->insert_key("announce-list", torrent::Object()).swap(download->bencode()->get_key("announce-list"));
+    bencode.insert_key("announce-list", torrent::Object()).swap(download->bencode()->get_key("announce-list"));
 
   erase_ptr(download);
 
-  control->core()->try_create_download_from_meta_download(bencode, metafile);
+  control->core()->try_create_download_from_meta_download(std::move(bencode), metafile);
 }
 
 }
@@ -5,6 +5,10 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "core/download_batch.h"
 
 namespace torrent {
   class HashString;
@@ -46,6 +50,21 @@ public:
 
   void                session_save();
 
+  // Saves are deferred to the end of a batch, with a full save
+  // replacing any resume saves of the same download.
+  void                save_resume(Download* d);
+  void                save_full(Download* d);
+
+  // While a batch is open, view filtering triggered by events and
+  // session saves are deferred until the outermost batch ends. Use
+  // for commands that change many downloads at once.
+  bool                is_batching() const { return m_batch.is_active(); }
+  void                begin_batch()       { m_batch.begin(); }
+  void                end_batch()         { m_batch.end(); }
+
+  DownloadBatch*      batch()             { return &m_batch; }
+
+  // Downloads are indexed by info hash.
   iterator            find(const torrent::HashString& hash);
 
   iterator            find_hex(const char* hash);
@@ -138,6 +157,13 @@ private:
   void                confirm_finished(Download* d);
 
   void                process_meta_download(Download* d);
+
+  static std::string_view hash_key(const torrent::HashString& hash);
+
+  // Keys point to the info hash of the download.
+  std::unordered_map<std::string_view, iterator> m_index;
+
+  DownloadBatch       m_batch;
 };
 
 }
@@ -0,0 +1,89 @@
+#include "config.h"
+
+#include "core/event_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <torrent/hash_string.h>
+#include <torrent/system/thread.h>
+#include <torrent/utils/string_manip.h>
+
+#include "core/download.h"
+
+namespace core {
+
+void
+EventStream::push(const std::string& type, const std::string& hash, const std::string& message) {
+  m_events.push_back(event_type{m_next++, torrent::this_thread::cached_seconds().count(), type, hash, message});
+
+  if (m_events.size() > max_events)
+    m_events.pop_front();
+
+  if (m_slot_pushed)
+    m_slot_pushed();
+}
+
+void
+EventStream::push_download(Download* download, const char* event_name, const std::string& message) {
+  static constexpr char prefix[] = "event.download.";
+
+  if (std::strncmp(event_name, prefix, sizeof(prefix) - 1) == 0)
+    event_name += sizeof(prefix) - 1;
+
+  push(event_name, torrent::utils::transform_to_hex_str(download->info()->hash()), message);
+}
+
+bool
+EventStream::match_type(const event_type& event, const std::vector<std::string>& types) {
+  return types.empty() || std::find(types.begin(), types.end(), event.type) != types.end();
+}
+
+bool
+EventStream::has_events(uint64_t cursor, const std::vector<std::string>& types) const {
+  auto first = std::max(cursor, first_sequence());
+
+  if (first >= m_next)
+    return false;
+
+  return std::any_of(m_events.begin() + (first - first_sequence()), m_events.end(),
+                     [&types](const auto& event) { return match_type(event, types); });
+}
+
+// A cursor past the end, e.g. from before a restart, starts at the
+// current end.
+
+torrent::Object
+EventStream::events(uint64_t cursor, size_t max, const std::vector<std::string>& types) const {
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["dropped"] = (int64_t)(cursor < first_sequence() ? first_sequence() - cursor : 0);
+
+  cursor = std::min(std::max(cursor, first_sequence()), m_next);
+
+  auto& list = (result["events"] = torrent::Object::create_list()).as_list();
+  auto  itr  = m_events.begin() + (cursor - first_sequence());
+
+  for (; itr != m_events.end() && list.size() < max; ++itr) {
+    cursor = itr->sequence + 1;
+
+    if (!match_type(*itr, types))
+      continue;
+
+    auto& entry = list.insert(list.end(), torrent::Object::create_map())->as_map();
+
+    entry["sequence"] = (int64_t)itr->sequence;
+    entry["time"]     = itr->time;
+    entry["type"]     = itr->type;
+    entry["hash"]     = itr->hash;
+
+    if (!itr->message.empty())
+      entry["message"] = itr->message;
+  }
+
+  result["cursor"] = (int64_t)cursor;
+
+  return raw_result;
+}
+
+}
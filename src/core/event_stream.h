@@ -0,0 +1,66 @@
+// Records download events for 'system.events.wait'.
+//
+// Events are numbered in the order they happened and kept in a ring of
+// 'max_events', each subscriber holds its own cursor into the ring. If
+// a subscriber falls behind, the events it missed are reported as
+// dropped rather than growing the queue.
+//
+// The slot_pushed callback is used to wake up long-poll requests held
+// by the SCGI thread.
+
+#ifndef RTORRENT_CORE_EVENT_STREAM_H
+#define RTORRENT_CORE_EVENT_STREAM_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+#include <torrent/object.h>
+
+namespace core {
+
+class Download;
+
+class EventStream {
+public:
+  using slot_void = std::function<void()>;
+
+  static constexpr size_t max_events = 1024;
+
+  struct event_type {
+    uint64_t          sequence;
+    int64_t           time;
+    std::string       type;
+    std::string       hash;
+    std::string       message;
+  };
+
+  uint64_t            next_sequence() const                { return m_next; }
+
+  void                push(const std::string& type, const std::string& hash, const std::string& message = std::string());
+
+  // Strips the 'event.download.' prefix from 'event_name'.
+  void                push_download(Download* download, const char* event_name, const std::string& message = std::string());
+
+  // Events after 'cursor' with a type in 'types', or of any type if
+  // empty.
+  bool                has_events(uint64_t cursor, const std::vector<std::string>& types) const;
+  torrent::Object     events(uint64_t cursor, size_t max, const std::vector<std::string>& types) const;
+
+  slot_void&          slot_pushed()                        { return m_slot_pushed; }
+
+private:
+  static bool         match_type(const event_type& event, const std::vector<std::string>& types);
+
+  uint64_t            first_sequence() const               { return m_next - m_events.size(); }
+
+  std::deque<event_type> m_events;
+  uint64_t               m_next{};
+
+  slot_void              m_slot_pushed;
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "config.h"
+
+#include "core/file_tree_index.h"
+
+#include <torrent/exceptions.h>
+#include <torrent/data/file.h>
+#include <torrent/data/file_list.h>
+
+#include "utils/glob.h"
+
+namespace core {
+
+FileTreeIndex::FileTreeIndex() {
+  m_directories.push_back(directory_type{std::string(), std::string(), no_parent});
+  m_directory_map.emplace(std::string(), 0);
+}
+
+FileTreeIndex::FileTreeIndex(torrent::FileList* file_list) :
+  FileTreeIndex() {
+  m_files.reserve(file_list->size_files());
+
+  std::vector<std::string> components;
+
+  for (const auto& file : *file_list) {
+    auto path = file->path();
+
+    components.clear();
+
+    for (const auto& component : *path)
+      components.push_back(component.str());
+
+    insert_file(path->as_string(), components, file->size_bytes());
+  }
+}
+
+void
+FileTreeIndex::insert_file(std::string path, const std::vector<std::string>& components, uint64_t size_bytes) {
+  uint32_t    parent = 0;
+  std::string name;
+
+  if (!components.empty()) {
+    for (size_t depth = 0, last = components.size() - 1; depth != last; depth++)
+      parent = insert_directory(parent, components[depth]);
+
+    name = components.back();
+  }
+
+  uint32_t index = m_files.size();
+
+  m_files.push_back(file_type{std::move(path), std::move(name), size_bytes});
+  m_directories[parent].files.push_back(index);
+
+  for (uint32_t dir = parent; dir != no_parent; dir = m_directories[dir].parent) {
+    m_directories[dir].size_bytes += size_bytes;
+    m_directories[dir].size_files++;
+  }
+}
+
+const FileTreeIndex::directory_type*
+FileTreeIndex::find_directory(const std::string& path) const {
+  auto itr = m_directory_map.find(path);
+
+  if (itr == m_directory_map.end())
+    return nullptr;
+
+  return &m_directories[itr->second];
+}
+
+std::vector<uint32_t>
+FileTreeIndex::match_range(const utils::GlobList* patterns, int64_t offset, int64_t limit, int64_t& total) const {
+  std::vector<uint32_t> result;
+
+  if (patterns == nullptr) {
+    total = size_files();
+
+    // Without patterns we can skip straight to the requested range.
+    for (int64_t idx = offset; idx < total && idx - offset < limit; idx++)
+      result.push_back(idx);
+
+    return result;
+  }
+
+  total = 0;
+
+  for (uint32_t idx = 0, last = size_files(); idx != last; idx++) {
+    if (!patterns->match_any(path(idx)))
+      continue;
+
+    if (total++ < offset || (int64_t)result.size() >= limit)
+      continue;
+
+    result.push_back(idx);
+  }
+
+  return result;
+}
+
+torrent::Object
+FileTreeIndex::list_directory(std::string path, int64_t offset, int64_t limit) const {
+  path.erase(0, path.find_first_not_of('/'));
+  path.erase(path.find_last_not_of('/') + 1);
+
+  auto directory = find_directory(path);
+
+  if (directory == nullptr)
+    throw torrent::input_error("Could not find directory.");
+
+  auto  result  = torrent::Object::create_map();
+  auto& entries = result.insert_key("entries", torrent::Object::create_list()).as_list();
+
+  int64_t total = directory->directories.size() + directory->files.size();
+
+  for (int64_t pos = offset; pos < total && pos - offset < limit; pos++) {
+    auto& entry = entries.insert(entries.end(), torrent::Object::create_list())->as_list();
+
+    if (pos < (int64_t)directory->directories.size()) {
+      auto& child = m_directories[directory->directories[pos]];
+
+      entry.push_back(child.name);
+      entry.push_back(child.path);
+      entry.push_back((int64_t)1);
+      entry.push_back((int64_t)-1);
+      entry.push_back((int64_t)child.size_bytes);
+      entry.push_back((int64_t)child.size_files);
+
+    } else {
+      uint32_t file_index = directory->files[pos - directory->directories.size()];
+      auto&    child      = m_files[file_index];
+
+      entry.push_back(child.name);
+      entry.push_back(child.path);
+      entry.push_back((int64_t)0);
+      entry.push_back((int64_t)file_index);
+      entry.push_back((int64_t)child.size_bytes);
+      entry.push_back((int64_t)1);
+    }
+  }
+
+  result.insert_key("total", total);
+  return result;
+}
+
+uint32_t
+FileTreeIndex::insert_directory(uint32_t parent, const std::string& name) {
+  std::string path = parent == 0 ? name : m_directories[parent].path + '/' + name;
+
+  auto result = m_directory_map.emplace(path, m_directories.size());
+
+  if (!result.second)
+    return result.first->second;
+
+  m_directories.push_back(directory_type{name, path, parent});
+  m_directories[parent].directories.push_back(result.first->second);
+
+  return result.first->second;
+}
+
+}
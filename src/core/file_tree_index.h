@@ -0,0 +1,90 @@
+#ifndef RTORRENT_CORE_FILE_TREE_INDEX_H
+#define RTORRENT_CORE_FILE_TREE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <torrent/object.h>
+
+namespace torrent {
+  class FileList;
+}
+
+namespace utils {
+  class GlobList;
+}
+
+namespace core {
+
+// Index of a download's file paths grouped by directory, so file
+// browsing and pattern matching don't need to rebuild path strings
+// for every file on each call.
+//
+// The paths in a torrent's file list don't change once loaded, so
+// Download builds this lazily on first use and keeps it.
+
+class FileTreeIndex {
+public:
+  static constexpr uint32_t no_parent = ~uint32_t();
+
+  struct file_type {
+    std::string           path;
+    std::string           name;
+    uint64_t              size_bytes;
+  };
+
+  struct directory_type {
+    std::string           name;
+    std::string           path;
+    uint32_t              parent;
+
+    std::vector<uint32_t> directories;
+    std::vector<uint32_t> files;
+
+    // Totals include all subdirectories.
+    uint64_t              size_bytes{};
+    uint32_t              size_files{};
+  };
+
+  FileTreeIndex();
+  FileTreeIndex(torrent::FileList* file_list);
+
+  // The 'path' is the file's full path, 'components' the directories
+  // it is in followed by its name.
+  void                  insert_file(std::string path, const std::vector<std::string>& components, uint64_t size_bytes);
+
+  uint32_t              size_files() const                { return m_files.size(); }
+  uint32_t              size_directories() const          { return m_directories.size(); }
+
+  const file_type&      file(uint32_t index) const        { return m_files[index]; }
+  const std::string&    path(uint32_t index) const        { return m_files[index].path; }
+
+  const directory_type& root() const                      { return m_directories.front(); }
+  const directory_type& directory(uint32_t index) const   { return m_directories[index]; }
+
+  // Path without leading or trailing '/', the root directory is the
+  // empty string. Returns nullptr if not found.
+  const directory_type* find_directory(const std::string& path) const;
+
+  // Indices of the files matching 'patterns', or of all files if
+  // nullptr, skipping the first 'offset' and returning up to 'limit'.
+  // The number of matching files is stored in 'total'.
+  std::vector<uint32_t> match_range(const utils::GlobList* patterns, int64_t offset, int64_t limit, int64_t& total) const;
+
+  // Lists a single directory level as used by 'f.tree', leading and
+  // trailing '/' of 'path' are ignored. Throws input_error if the
+  // directory isn't found.
+  torrent::Object       list_directory(std::string path, int64_t offset, int64_t limit) const;
+
+private:
+  uint32_t              insert_directory(uint32_t parent, const std::string& name);
+
+  std::vector<file_type>                    m_files;
+  std::vector<directory_type>               m_directories;
+  std::unordered_map<std::string, uint32_t> m_directory_map;
+};
+
+}
+
+#endif
@@ -0,0 +1,263 @@
+#include "config.h"
+
+#include "core/filesystem_registry.h"
+
+#include <algorithm>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <torrent/data/file_list.h>
+#include <torrent/system/thread.h>
+#include <torrent/utils/log.h>
+
+#include "control.h"
+#include "globals.h"
+#include "core/download.h"
+#include "core/download_list.h"
+#include "core/manager.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print_subsystem(torrent::LOG_STORAGE_INFO, "filesystem_registry", log_fmt, __VA_ARGS__);
+
+namespace core {
+
+static bool
+statvfs_path(const std::string& path, uint64_t& free, uint64_t& total) {
+  struct statvfs st;
+
+  if (::statvfs(path.c_str(), &st) == -1)
+    return false;
+
+  free  = (uint64_t)st.f_bavail * st.f_frsize;
+  total = (uint64_t)st.f_blocks * st.f_frsize;
+  return true;
+}
+
+static bool
+parent_path(std::string& path) {
+  while (path.size() > 1 && path.back() == '/')
+    path.pop_back();
+
+  if (path == "/" || path == ".")
+    return false;
+
+  auto pos = path.rfind('/');
+
+  if (pos == std::string::npos)
+    path = ".";
+  else
+    path.erase(std::max<size_t>(pos, 1));
+
+  return true;
+}
+
+FilesystemRegistry::FilesystemRegistry() :
+  m_callback_id(torrent::system::make_callback_id()) {
+}
+
+FilesystemRegistry::filesystem_type*
+FilesystemRegistry::find(Download* download, bool current) {
+  return find_path(download->file_list()->root_dir(), current);
+}
+
+FilesystemRegistry::filesystem_type*
+FilesystemRegistry::find_path(const std::string& path, bool current) {
+  auto now      = torrent::this_thread::cached_time();
+  auto ttl      = std::chrono::microseconds(std::chrono::seconds(m_ttl));
+  auto path_itr = m_paths.find(path);
+
+  if (path_itr == m_paths.end() || (path_itr->second.resolved != path && path_itr->second.time_resolved + ttl <= now)) {
+    std::string resolved = path.empty() ? std::string(".") : path;
+    struct stat st;
+
+    while (::stat(resolved.c_str(), &st) == -1)
+      if (!parent_path(resolved))
+        return nullptr;
+
+    path_itr = m_paths.insert_or_assign(path, path_type{(uint64_t)st.st_dev, now, resolved}).first;
+  }
+
+  auto [fs_itr, inserted] = m_filesystems.try_emplace(path_itr->second.device);
+  auto& filesystem = fs_itr->second;
+
+  if (inserted) {
+    filesystem.device       = path_itr->second.device;
+    filesystem.path         = path_itr->second.resolved;
+    filesystem.time_updated = now;
+
+    if (!statvfs_path(filesystem.path, filesystem.free, filesystem.total)) {
+      m_filesystems.erase(fs_itr);
+      m_paths.erase(path_itr);
+      return nullptr;
+    }
+
+    LT_LOG("added filesystem (device:%llu path:%s free:%llu)",
+           (unsigned long long)filesystem.device, filesystem.path.c_str(), (unsigned long long)filesystem.free);
+
+  } else if (current && filesystem.time_updated + ttl <= now) {
+    // A refresh already pending will update the values again when it
+    // completes, which is harmless.
+    if (!statvfs_path(filesystem.path, filesystem.free, filesystem.total)) {
+      receive_refresh(filesystem.device, false, 0, 0);
+      return nullptr;
+    }
+
+    filesystem.time_updated = now;
+
+  } else if (!filesystem.is_pending && filesystem.time_updated + ttl <= now) {
+    refresh(filesystem);
+  }
+
+  return &filesystem;
+}
+
+uint64_t
+FilesystemRegistry::free_diskspace(Download* download) {
+  auto filesystem = find(download);
+
+  return filesystem != nullptr ? filesystem->free : 0;
+}
+
+// Filesystems and paths no longer used by any download are removed.
+
+void
+FilesystemRegistry::update_accounting(bool current) {
+  begin_accounting();
+
+  for (const auto& download : *control->core()->download_list())
+    add_accounting(download->file_list()->root_dir(), download->is_downloading(), download->file_list()->left_bytes(), current);
+
+  end_accounting();
+}
+
+void
+FilesystemRegistry::begin_accounting() {
+  for (auto& [device, filesystem] : m_filesystems) {
+    filesystem.bytes_left = 0;
+    filesystem.downloads  = 0;
+  }
+
+  m_used_paths.clear();
+}
+
+FilesystemRegistry::filesystem_type*
+FilesystemRegistry::add_accounting(const std::string& path, bool is_downloading, uint64_t bytes_left, bool current) {
+  auto filesystem = find_path(path, current);
+
+  if (filesystem == nullptr)
+    return nullptr;
+
+  m_used_paths.insert(path);
+  filesystem->downloads++;
+
+  if (is_downloading)
+    filesystem->bytes_left += bytes_left;
+
+  return filesystem;
+}
+
+void
+FilesystemRegistry::end_accounting() {
+  std::erase_if(m_paths, [this](const auto& itr) { return m_used_paths.find(itr.first) == m_used_paths.end(); });
+  std::erase_if(m_filesystems, [](const auto& itr) { return itr.second.downloads == 0; });
+
+  m_used_paths.clear();
+}
+
+std::vector<Download*>
+FilesystemRegistry::select_closing(std::vector<candidate_type> candidates, int64_t projected_free, int64_t min_free) {
+  std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+      if (a.priority != b.priority)
+        return a.priority < b.priority;
+
+      return a.bytes_left > b.bytes_left;
+    });
+
+  std::vector<Download*> result;
+
+  for (const auto& candidate : candidates) {
+    if (projected_free >= min_free)
+      break;
+
+    projected_free += candidate.bytes_left;
+    result.push_back(candidate.download);
+  }
+
+  return result;
+}
+
+torrent::Object
+FilesystemRegistry::filesystems() {
+  update_accounting();
+
+  auto  raw_result = torrent::Object::create_list();
+  auto& result     = raw_result.as_list();
+
+  for (const auto& [device, filesystem] : m_filesystems) {
+    auto& entry = result.insert(result.end(), torrent::Object::create_map())->as_map();
+
+    entry["device"]         = (int64_t)filesystem.device;
+    entry["path"]           = filesystem.path;
+    entry["free"]           = (int64_t)filesystem.free;
+    entry["total"]          = (int64_t)filesystem.total;
+    entry["bytes_left"]     = (int64_t)filesystem.bytes_left;
+    entry["projected_free"] = filesystem.projected_free();
+    entry["downloads"]      = (int64_t)filesystem.downloads;
+    entry["updated"]        = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(filesystem.time_updated).count();
+  }
+
+  return raw_result;
+}
+
+void
+FilesystemRegistry::shutdown() {
+  m_shutdown = true;
+
+  torrent::system::cancel_callback_and_wait(m_callback_id, session_thread::thread(), torrent::main_thread::thread());
+}
+
+// The stale values are used until the session thread has called
+// statvfs, which may block on slow or network filesystems.
+
+void
+FilesystemRegistry::refresh(filesystem_type& filesystem) {
+  if (m_shutdown)
+    return;
+
+  filesystem.is_pending = true;
+
+  session_thread::callback(m_callback_id, [this, device = filesystem.device, path = filesystem.path]() {
+      uint64_t free{};
+      uint64_t total{};
+      bool     success = statvfs_path(path, free, total);
+
+      torrent::main_thread::callback(m_callback_id, [this, device, success, free, total]() {
+          receive_refresh(device, success, free, total);
+        });
+    });
+}
+
+// If the filesystem's path is gone, drop it so the next lookup resolves
+// the download directories again.
+
+void
+FilesystemRegistry::receive_refresh(uint64_t device, bool success, uint64_t free, uint64_t total) {
+  auto itr = m_filesystems.find(device);
+
+  if (itr == m_filesystems.end())
+    return;
+
+  if (!success) {
+    LT_LOG("removed filesystem, statvfs failed (device:%llu path:%s)", (unsigned long long)device, itr->second.path.c_str());
+
+    std::erase_if(m_paths, [device](const auto& path_itr) { return path_itr.second.device == device; });
+    m_filesystems.erase(itr);
+    return;
+  }
+
+  itr->second.free         = free;
+  itr->second.total        = total;
+  itr->second.time_updated = torrent::this_thread::cached_time();
+  itr->second.is_pending   = false;
+}
+
+}
@@ -0,0 +1,113 @@
+// Caches free space per filesystem for the low diskspace checks.
+//
+// Each download's directory is mapped to the device it is on, so the
+// downloads sharing a filesystem share a single statvfs result. Results
+// older than 'ttl' are refreshed in the session thread while the stale
+// value keeps being used, only the first lookup of a filesystem calls
+// statvfs directly. Lookups that act on the result, such as closing
+// downloads on low diskspace, ask for a 'current' value and call
+// statvfs directly if the cached one is stale.
+//
+// 'update_accounting' sums the bytes left of downloading downloads per
+// filesystem, so the free space they will still need can be checked
+// before the disk actually fills up.
+
+#ifndef RTORRENT_CORE_FILESYSTEM_REGISTRY_H
+#define RTORRENT_CORE_FILESYSTEM_REGISTRY_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <torrent/object.h>
+#include <torrent/system/callbacks.h>
+
+namespace core {
+
+class Download;
+
+class FilesystemRegistry {
+public:
+  static constexpr uint32_t default_ttl = 10;
+
+  struct filesystem_type {
+    uint64_t                  device{};
+    std::string               path;
+
+    uint64_t                  free{};
+    uint64_t                  total{};
+    std::chrono::microseconds time_updated{};
+    bool                      is_pending{};
+
+    uint64_t                  bytes_left{};
+    uint32_t                  downloads{};
+
+    int64_t                   projected_free() const { return (int64_t)free - (int64_t)bytes_left; }
+  };
+
+  FilesystemRegistry();
+
+  uint32_t            ttl() const                          { return m_ttl; }
+  void                set_ttl(uint32_t seconds)            { m_ttl = seconds; }
+
+  struct candidate_type {
+    Download*                 download{};
+    uint32_t                  priority{};
+    uint64_t                  bytes_left{};
+  };
+
+  // Returns nullptr if the download's directory, or any of its
+  // parents, can't be stat'ed.
+  filesystem_type*    find(Download* download, bool current = false);
+  filesystem_type*    find_path(const std::string& path, bool current = false);
+
+  uint64_t            free_diskspace(Download* download);
+
+  size_t              size() const                         { return m_filesystems.size(); }
+
+  void                update_accounting(bool current = false);
+
+  // Accounting is done in passes, filesystems and paths not added
+  // since 'begin_accounting' are removed by 'end_accounting'.
+  void                begin_accounting();
+  filesystem_type*    add_accounting(const std::string& path, bool is_downloading, uint64_t bytes_left, bool current);
+  void                end_accounting();
+
+  // The lowest priority and then largest candidates, in the order they
+  // should be closed until 'projected_free' reaches 'min_free'.
+  static std::vector<Download*> select_closing(std::vector<candidate_type> candidates, int64_t projected_free, int64_t min_free);
+
+  torrent::Object     filesystems();
+
+  // Cancels refreshes in progress, called before the session thread
+  // is stopped.
+  void                shutdown();
+
+private:
+  struct path_type {
+    uint64_t                  device{};
+    std::chrono::microseconds time_resolved{};
+
+    // A parent directory is used if the path doesn't exist yet, in
+    // which case it is resolved again after 'ttl'.
+    std::string               resolved;
+  };
+
+  void                refresh(filesystem_type& filesystem);
+  void                receive_refresh(uint64_t device, bool success, uint64_t free, uint64_t total);
+
+  uint32_t            m_ttl{default_ttl};
+  bool                m_shutdown{};
+
+  std::map<std::string, path_type>       m_paths;
+  std::map<uint64_t, filesystem_type>    m_filesystems;
+  std::set<std::string>                  m_used_paths;
+
+  torrent::system::callback_id m_callback_id;
+};
+
+}
+
+#endif
@@ -2,16 +2,390 @@
 
 #include "http_queue.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <torrent/common.h>
+#include <torrent/object_stream.h>
 #include <torrent/net/http_get.h>
 #include <torrent/net/http_stack.h>
+#include <torrent/system/thread.h>
+#include <torrent/utils/log.h>
+
+#include "globals.h"
+#include "core/tracker_governor.h"
+
+#define LT_LOG(log_fmt, ...)                                            \
+  lt_log_print_subsystem(torrent::LOG_NOTICE, "http_queue", log_fmt, __VA_ARGS__);
 
 namespace core {
 
-HttpQueue::iterator
+namespace {
+
+// Called in the session thread.
+
+void
+write_cache_file(const std::string& path, const std::string& data) {
+  auto path_tmp = path + ".new";
+  auto file     = std::fstream(path_tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+  file.write(data.data(), data.size());
+  file.close();
+
+  if (file.fail() || ::rename(path_tmp.c_str(), path.c_str()) == -1)
+    ::unlink(path_tmp.c_str());
+}
+
+}
+
+void
+HttpHostQueue::push(const std::string& host, const std::string& url) {
+  m_queues[host].push_back(url);
+}
+
+std::vector<std::string>
+HttpHostQueue::pop_startable(const std::string& host, uint32_t max_per_host) {
+  auto queue_itr = m_queues.find(host);
+
+  if (queue_itr == m_queues.end())
+    return {};
+
+  std::vector<std::string> result;
+
+  auto& queue  = queue_itr->second;
+  auto& active = m_active[host];
+
+  while (!queue.empty() && (max_per_host == 0 || active < max_per_host)) {
+    result.push_back(std::move(queue.front()));
+    queue.pop_front();
+    active++;
+  }
+
+  if (queue.empty())
+    m_queues.erase(queue_itr);
+
+  if (active == 0)
+    m_active.erase(host);
+
+  return result;
+}
+
+void
+HttpHostQueue::release(const std::string& host) {
+  auto itr = m_active.find(host);
+
+  if (itr == m_active.end())
+    return;
+
+  if (--itr->second == 0)
+    m_active.erase(itr);
+}
+
+void
+HttpHostQueue::clear() {
+  m_queues.clear();
+  m_active.clear();
+}
+
+std::vector<std::string>
+HttpHostQueue::queued_hosts() const {
+  std::vector<std::string> result;
+
+  for (const auto& queue : m_queues)
+    result.push_back(queue.first);
+
+  return result;
+}
+
+uint32_t
+HttpHostQueue::size_active(const std::string& host) const {
+  auto itr = m_active.find(host);
+
+  return itr != m_active.end() ? itr->second : 0;
+}
+
+size_t
+HttpHostQueue::size_queued(const std::string& host) const {
+  auto itr = m_queues.find(host);
+
+  return itr != m_queues.end() ? itr->second.size() : 0;
+}
+
+HttpCacheIndex::entry_type*
+HttpCacheIndex::find(const std::string& url) {
+  auto itr = m_entries.find(url);
+
+  return itr != m_entries.end() ? &itr->second : nullptr;
+}
+
+const HttpCacheIndex::entry_type*
+HttpCacheIndex::find_fresh(const std::string& url, int64_t now, uint32_t ttl) const {
+  auto itr = m_entries.find(url);
+
+  if (ttl == 0 || itr == m_entries.end() || itr->second.time + ttl < now)
+    return nullptr;
+
+  return &itr->second;
+}
+
+std::vector<std::string>
+HttpCacheIndex::update(const std::string& url, int64_t now) {
+  auto& entry = m_entries[url];
+
+  if (entry.file.empty()) {
+    entry.file = file_name(url);
+
+    while (std::any_of(m_entries.begin(), m_entries.end(), [&](const auto& other) { return other.first != url && other.second.file == entry.file; }))
+      entry.file += '_';
+  }
+
+  entry.time = now;
+  entry.hash.clear();
+
+  std::vector<std::string> removed;
+
+  while (m_entries.size() > max_entries) {
+    auto oldest = std::min_element(m_entries.begin(), m_entries.end(), [&url](const auto& a, const auto& b) {
+        // Never evict the entry just updated.
+        if (a.first == url || b.first == url)
+          return b.first == url;
+
+        return a.second.time < b.second.time;
+      });
+
+    removed.push_back(oldest->second.file);
+    m_entries.erase(oldest);
+  }
+
+  return removed;
+}
+
+torrent::Object
+HttpCacheIndex::to_object() const {
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  for (const auto& [url, entry] : m_entries) {
+    auto& value = (result[url] = torrent::Object::create_map());
+
+    value.insert_key("file", entry.file);
+    value.insert_key("time", entry.time);
+    value.insert_key("hash", entry.hash);
+  }
+
+  return raw_result;
+}
+
+bool
+HttpCacheIndex::from_object(const torrent::Object& object) {
+  m_entries.clear();
+
+  if (!object.is_map())
+    return false;
+
+  for (const auto& [url, value] : object.as_map()) {
+    if (!value.is_map() || !value.has_key_string("file") || !value.has_key_value("time") || !value.has_key_string("hash"))
+      continue;
+
+    m_entries[url] = entry_type{value.get_key_string("file"), value.get_key_value("time"), value.get_key_string("hash")};
+  }
+
+  return true;
+}
+
+std::string
+HttpCacheIndex::file_name(const std::string& url) {
+  // FNV-1a, collisions are resolved by the caller.
+  uint64_t hash = 0xcbf29ce484222325;
+
+  for (auto c : url)
+    hash = (hash ^ (uint8_t)c) * 0x100000001b3;
+
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, hash);
+
+  return buffer;
+}
+
+void
 HttpQueue::insert(const std::string& url, std::shared_ptr<std::ostream> stream,
-                  std::function<void()> done_fn, std::function<void(const std::string&)> failed_fn) {
-  auto itr = base_type::insert(end(), torrent::net::HttpGet(url, stream));
+                  done_fn_type done_fn, failed_fn_type failed_fn) {
+  waiter_type waiter{std::move(stream), std::move(done_fn), std::move(failed_fn)};
+
+  if (insert_cached(url, waiter))
+    return;
+
+  auto [fetch_itr, inserted] = m_fetches.try_emplace(url);
+
+  fetch_itr->second.waiters.push_back(std::move(waiter));
+
+  if (!inserted) {
+    m_count_coalesced++;
+    return;
+  }
+
+  fetch_itr->second.host        = TrackerGovernor::url_host(url);
+  fetch_itr->second.time_queued = torrent::this_thread::cached_time();
+
+  m_hosts.push(fetch_itr->second.host, url);
+
+  start_host(fetch_itr->second.host);
+}
+
+void
+HttpQueue::clear() {
+  while (!base_type::empty())
+    erase_get(base_type::begin());
+
+  m_fetches.clear();
+  m_hosts.clear();
+}
+
+void
+HttpQueue::set_max_per_host(uint32_t max) {
+  m_max_per_host = max;
+
+  for (const auto& host : m_hosts.queued_hosts())
+    start_host(host);
+}
+
+void
+HttpQueue::set_cache_path(const std::string& path) {
+  m_cache.clear();
+  m_cache_path = path;
+
+  if (m_cache_path.empty())
+    return;
+
+  if (m_cache_path.back() != '/')
+    m_cache_path += '/';
+
+  if (::mkdir(m_cache_path.c_str(), 0755) == -1 && errno != EEXIST)
+    LT_LOG("could not create cache directory: %s", m_cache_path.c_str());
+
+  load_cache_index();
+}
+
+std::string
+HttpQueue::cached_hash(const std::string& url) const {
+  auto entry = m_cache.find_fresh(url, torrent::this_thread::cached_seconds().count(), m_cache_ttl);
+
+  return entry != nullptr ? entry->hash : std::string();
+}
+
+void
+HttpQueue::set_cached_hash(const std::string& url, const std::string& hash) {
+  auto entry = m_cache.find(url);
+
+  if (entry == nullptr || entry->hash == hash)
+    return;
+
+  entry->hash = hash;
+
+  session_thread::callback([path = m_cache_path + "index", index = m_cache.to_object()]() {
+      std::ostringstream stream;
+      stream << index;
+
+      write_cache_file(path, stream.str());
+    });
+}
+
+torrent::Object
+HttpQueue::status() const {
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["active"]        = (int64_t)size_active();
+  result["queued"]        = (int64_t)size_queued();
+  result["fetched"]       = (int64_t)m_count_fetched;
+  result["failed"]        = (int64_t)m_count_failed;
+  result["coalesced"]     = (int64_t)m_count_coalesced;
+  result["cache_hits"]    = (int64_t)m_count_cache_hits;
+  result["cache_size"]    = (int64_t)m_cache.size();
+  result["skipped"]       = (int64_t)m_count_skipped;
+  result["latency_last"]  = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(m_latency_last).count();
+  result["latency_avg"]   = (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(m_latency_average).count();
+
+  auto& hosts = (result["hosts"] = torrent::Object::create_map()).as_map();
+
+  auto host_entry = [&hosts](const std::string& host) -> torrent::Object& {
+      auto& entry = hosts[host];
+
+      if (!entry.is_map())
+        entry = torrent::Object::create_map();
+
+      return entry;
+    };
+
+  for (const auto& [host, active] : m_hosts.active())
+    host_entry(host).insert_key("active", (int64_t)active);
+
+  for (const auto& [host, queue] : m_hosts.queues())
+    host_entry(host).insert_key("queued", (int64_t)queue.size());
+
+  return raw_result;
+}
+
+bool
+HttpQueue::insert_cached(const std::string& url, waiter_type& waiter) {
+  if (m_cache_path.empty() || m_cache_ttl == 0)
+    return false;
+
+  auto entry = m_cache.find_fresh(url, torrent::this_thread::cached_seconds().count(), m_cache_ttl);
+
+  if (entry == nullptr)
+    return false;
+
+  auto file = std::ifstream(m_cache_path + entry->file, std::ios::in | std::ios::binary);
+
+  if (!file.is_open())
+    return false;
+
+  // Read into a buffer first, an empty or unreadable file must leave
+  // the waiter's stream untouched for the fetch that follows.
+  std::ostringstream buffer;
+  buffer << file.rdbuf();
+
+  if (buffer.fail() || file.bad() || buffer.str().empty())
+    return false;
+
+  *waiter.stream << buffer.str();
+
+  m_count_cache_hits++;
+
+  waiter.done_fn();
+  return true;
+}
+
+void
+HttpQueue::start_host(const std::string& host) {
+  for (const auto& url : m_hosts.pop_startable(host, m_max_per_host)) {
+    auto fetch_itr = m_fetches.find(url);
+
+    if (fetch_itr == m_fetches.end()) {
+      m_hosts.release(host);
+      continue;
+    }
+
+    start_fetch(fetch_itr);
+  }
+}
+
+void
+HttpQueue::start_fetch(fetch_map::iterator fetch_itr) {
+  const auto& url   = fetch_itr->first;
+  auto&       fetch = fetch_itr->second;
+
+  fetch.buffer    = std::make_shared<std::stringstream>();
+  fetch.get       = base_type::insert(base_type::end(), torrent::net::HttpGet(url, fetch.buffer));
+  fetch.is_active = true;
+
+  auto itr = fetch.get;
 
   itr->set_max_file_size(15 << 20);
   itr->set_redirect_only_http_https();
@@ -19,19 +393,59 @@ HttpQueue::insert(const std::string& url, std::shared_ptr<std::ostream> stream,
   for (auto& slot : m_signal_insert)
     slot(*itr);
 
-  itr->add_done_slot(torrent::this_thread::thread(),   std::move(done_fn));
-  itr->add_done_slot(torrent::this_thread::thread(),   [this, itr]() { erase(itr); });
-
-  itr->add_failed_slot(torrent::this_thread::thread(), std::move(failed_fn));
-  itr->add_failed_slot(torrent::this_thread::thread(), [this, itr](auto) { erase(itr); });
+  itr->add_done_slot(torrent::this_thread::thread(),   [this, url]() { finish_fetch(url, nullptr); });
+  itr->add_failed_slot(torrent::this_thread::thread(), [this, url](const auto& error) { finish_fetch(url, &error); });
 
   torrent::net_thread::http_stack()->start_get(*itr);
+}
+
+// The fetch is removed before calling the waiters, so that they may
+// insert the same url again.
+
+void
+HttpQueue::finish_fetch(const std::string& url, const std::string* error) {
+  auto fetch_itr = m_fetches.find(url);
+
+  // Callbacks already dispatched when the queue was cleared.
+  if (fetch_itr == m_fetches.end() || !fetch_itr->second.is_active)
+    return;
+
+  auto fetch     = std::move(fetch_itr->second);
+  auto error_msg = error != nullptr ? *error : std::string();
+
+  m_fetches.erase(fetch_itr);
+  erase_get(fetch.get);
 
-  return itr;
+  m_latency_last    = torrent::this_thread::cached_time() - fetch.time_queued;
+  m_latency_average = m_latency_average == std::chrono::microseconds() ? m_latency_last : (m_latency_average * 7 + m_latency_last) / 8;
+
+  m_hosts.release(fetch.host);
+  start_host(fetch.host);
+
+  if (error != nullptr) {
+    m_count_failed++;
+
+    for (auto& waiter : fetch.waiters)
+      waiter.failed_fn(error_msg);
+
+    return;
+  }
+
+  m_count_fetched++;
+
+  auto content = fetch.buffer->str();
+
+  if (!m_cache_path.empty() && m_cache_ttl != 0)
+    save_cache_entry(url, content);
+
+  for (auto& waiter : fetch.waiters) {
+    *waiter.stream << content;
+    waiter.done_fn();
+  }
 }
 
 void
-HttpQueue::erase(iterator signal_itr) {
+HttpQueue::erase_get(iterator signal_itr) {
   for (const auto& slot : m_signal_erase)
     slot(*signal_itr);
 
@@ -40,9 +454,40 @@ HttpQueue::erase(iterator signal_itr) {
 }
 
 void
-HttpQueue::clear() {
-  while (!empty())
-    erase(begin());
+HttpQueue::load_cache_index() {
+  auto stream = std::fstream((m_cache_path + "index").c_str(), std::ios::in | std::ios::binary);
+
+  if (!stream.is_open())
+    return;
+
+  torrent::Object index;
+  stream >> index;
+
+  if (stream.fail() || !m_cache.from_object(index)) {
+    LT_LOG("cache index corrupted, discarding: %s", m_cache_path.c_str());
+    m_cache.clear();
+    return;
+  }
+
+  LT_LOG("cache index loaded: %s (entries:%zu)", m_cache_path.c_str(), m_cache.size());
+}
+
+void
+HttpQueue::save_cache_entry(const std::string& url, std::string content) {
+  auto removed = m_cache.update(url, torrent::this_thread::cached_seconds().count());
+  auto file    = m_cache.find(url)->file;
+
+  session_thread::callback([path = m_cache_path, file, content = std::move(content), removed, index = m_cache.to_object()]() {
+      write_cache_file(path + file, content);
+
+      for (const auto& removed_file : removed)
+        ::unlink((path + removed_file).c_str());
+
+      std::ostringstream stream;
+      stream << index;
+
+      write_cache_file(path + "index", stream.str());
+    });
 }
 
 }
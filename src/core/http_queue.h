@@ -1,22 +1,108 @@
+// Fetches http urls for 'load.*', one request per url at a time.
+//
+// Concurrent inserts of the same url share a single HttpGet, and at
+// most 'max_per_host' requests per host are active at once, the rest
+// wait in a per-host queue.
+//
+// If a cache directory is set, fetched content is kept on disk keyed
+// by url and reused for 'cache_ttl' seconds. The info hash of the
+// download created from a url is remembered, so that reloading the
+// url while the download exists can be skipped without fetching or
+// decoding. Cache files are written in the session thread.
+
 #ifndef RTORRENT_CORE_HTTP_QUEUE_H
 #define RTORRENT_CORE_HTTP_QUEUE_H
 
+#include <chrono>
+#include <deque>
 #include <functional>
 #include <iosfwd>
+#include <map>
 #include <memory>
 #include <list>
 #include <string>
+#include <vector>
+#include <torrent/object.h>
 #include <torrent/net/http_get.h>
 
 namespace core {
 
-// TODO: Remove this.
+// Urls waiting for one of a host's request slots, kept apart from the
+// HttpGet handling so the scheduling can be tested without a network.
+class HttpHostQueue {
+public:
+  void        push(const std::string& host, const std::string& url);
+
+  // Takes a slot for each url returned, a 'max_per_host' of zero is
+  // unlimited.
+  std::vector<std::string> pop_startable(const std::string& host, uint32_t max_per_host);
+  void        release(const std::string& host);
+
+  void        clear();
+
+  std::vector<std::string> queued_hosts() const;
+
+  uint32_t    size_active(const std::string& host) const;
+  size_t      size_queued(const std::string& host) const;
+
+  const std::map<std::string, uint32_t>&                active() const { return m_active; }
+  const std::map<std::string, std::deque<std::string>>& queues() const { return m_queues; }
+
+private:
+  std::map<std::string, std::deque<std::string>> m_queues;
+  std::map<std::string, uint32_t>                m_active;
+};
+
+// The urls with content in the cache directory, when each was fetched
+// and the info hash of the download created from it. Times are in
+// seconds.
+class HttpCacheIndex {
+public:
+  struct entry_type {
+    std::string       file;
+    int64_t           time{};
+    std::string       hash;
+  };
+
+  using map_type = std::map<std::string, entry_type>;
+
+  static constexpr size_t max_entries = 128;
+
+  bool        empty() const                 { return m_entries.empty(); }
+  size_t      size() const                  { return m_entries.size(); }
+  void        clear()                       { m_entries.clear(); }
+
+  const map_type& entries() const           { return m_entries; }
+
+  entry_type*       find(const std::string& url);
+
+  // Returns nullptr if 'url' has no entry, or it is more than 'ttl'
+  // seconds old at 'now'.
+  const entry_type* find_fresh(const std::string& url, int64_t now, uint32_t ttl) const;
+
+  // Adds or refreshes the entry for 'url', the files of the oldest
+  // entries removed to stay within 'max_entries' are returned.
+  std::vector<std::string> update(const std::string& url, int64_t now);
+
+  torrent::Object to_object() const;
+
+  // Malformed entries are skipped, returns false if 'object' is not a
+  // map.
+  bool        from_object(const torrent::Object& object);
+
+  static std::string file_name(const std::string& url);
+
+private:
+  map_type    m_entries;
+};
 
 class HttpQueue : private std::list<torrent::net::HttpGet> {
 public:
   using base_type       = std::list<torrent::net::HttpGet>;
   using slot_curl_get   = std::function<void (torrent::net::HttpGet)>;
   using signal_curl_get = std::list<slot_curl_get>;
+  using done_fn_type    = std::function<void()>;
+  using failed_fn_type  = std::function<void(const std::string&)>;
 
   using base_type::iterator;
   using base_type::const_iterator;
@@ -28,29 +114,103 @@ public:
   using base_type::rbegin;
   using base_type::rend;
 
-  using base_type::empty;
-  using base_type::size;
+  static constexpr uint32_t default_max_per_host = 4;
+  static constexpr uint32_t default_cache_ttl    = 3600;
 
   HttpQueue() = default;
   ~HttpQueue() { clear(); }
 
+  // Includes requests waiting for a host slot.
+  bool        empty() const                 { return m_fetches.empty(); }
+  size_t      size() const                  { return m_fetches.size(); }
+
+  size_t      size_active() const           { return base_type::size(); }
+  size_t      size_queued() const           { return m_fetches.size() - base_type::size(); }
+
   // Note that any slots connected to the CurlGet signals must be
   // pushed in front of the erase slot added by HttpQueue::insert.
   //
-  // Consider adding a flag to indicate whetever HttpQueue should
-  // delete the stream.
-  iterator    insert(const std::string& url, std::shared_ptr<std::ostream> stream,
-                     std::function<void()> done_fn, std::function<void(const std::string&)> failed_fn);
-  void        erase(iterator itr);
+  // The callbacks may be called before insert returns if the url is
+  // cached.
+  void        insert(const std::string& url, std::shared_ptr<std::ostream> stream,
+                     done_fn_type done_fn, failed_fn_type failed_fn);
 
   void        clear();
 
+  uint32_t    max_per_host() const          { return m_max_per_host; }
+  void        set_max_per_host(uint32_t max);
+
+  const std::string& cache_path() const     { return m_cache_path; }
+  void        set_cache_path(const std::string& path);
+
+  uint32_t    cache_ttl() const             { return m_cache_ttl; }
+  void        set_cache_ttl(uint32_t seconds) { m_cache_ttl = seconds; }
+
+  size_t      cache_size() const            { return m_cache.size(); }
+
+  // The info hash of a download created from a fresh cache entry for
+  // 'url', or an empty string.
+  std::string cached_hash(const std::string& url) const;
+  void        set_cached_hash(const std::string& url, const std::string& hash);
+
+  void        record_skipped()              { m_count_skipped++; }
+
+  torrent::Object status() const;
+
   signal_curl_get& signal_insert() { return m_signal_insert; }
   signal_curl_get& signal_erase()  { return m_signal_erase; }
 
 private:
+  struct waiter_type {
+    std::shared_ptr<std::ostream> stream;
+    done_fn_type                  done_fn;
+    failed_fn_type                failed_fn;
+  };
+
+  struct fetch_type {
+    std::string                        host;
+    std::vector<waiter_type>           waiters;
+    std::shared_ptr<std::stringstream> buffer;
+
+    iterator                           get;
+    bool                               is_active{};
+
+    std::chrono::microseconds          time_queued{};
+  };
+
+  using fetch_map = std::map<std::string, fetch_type>;
+
+  bool        insert_cached(const std::string& url, waiter_type& waiter);
+
+  void        start_host(const std::string& host);
+  void        start_fetch(fetch_map::iterator fetch_itr);
+  void        finish_fetch(const std::string& url, const std::string* error);
+
+  void        erase_get(iterator itr);
+
+  void        load_cache_index();
+  void        save_cache_entry(const std::string& url, std::string content);
+
   signal_curl_get m_signal_insert;
   signal_curl_get m_signal_erase;
+
+  fetch_map                                      m_fetches;
+  HttpHostQueue                                  m_hosts;
+
+  uint32_t    m_max_per_host{default_max_per_host};
+
+  std::string m_cache_path;
+  uint32_t    m_cache_ttl{default_cache_ttl};
+  HttpCacheIndex m_cache;
+
+  uint64_t    m_count_fetched{};
+  uint64_t    m_count_failed{};
+  uint64_t    m_count_coalesced{};
+  uint64_t    m_count_cache_hits{};
+  uint64_t    m_count_skipped{};
+
+  std::chrono::microseconds m_latency_last{};
+  std::chrono::microseconds m_latency_average{};
 };
 
 }
@@ -0,0 +1,127 @@
+#include "config.h"
+
+#include "core/log_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <torrent/exceptions.h>
+#include <torrent/utils/log.h>
+#include <torrent/system/thread.h>
+
+namespace core {
+
+LogRing::LogRing(size_t size) {
+  set_size(size);
+}
+
+size_t
+LogRing::size() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  return m_entries.size();
+}
+
+// Keeps the newest entries that still fit.
+
+void
+LogRing::set_size(size_t size) {
+  if (size == 0 || size > max_size)
+    throw torrent::input_error("Invalid log ring size.");
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  std::vector<entry_type> entries(size);
+
+  uint64_t first = std::max(m_first, m_next - std::min<uint64_t>({m_next, m_entries.size(), size}));
+
+  for (uint64_t sequence = first; sequence != m_next; sequence++)
+    entries[sequence % size] = std::move(m_entries[sequence % m_entries.size()]);
+
+  m_entries.swap(entries);
+  m_first = first;
+}
+
+uint64_t
+LogRing::next_sequence() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  return m_next;
+}
+
+void
+LogRing::push(int group, int64_t time, const char* data, size_t length) {
+  // Negative groups are flush requests.
+  if (group < 0)
+    return;
+
+  while (length != 0 && data[length - 1] == '\n')
+    length--;
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto& entry = m_entries[m_next % m_entries.size()];
+
+  entry.sequence = m_next++;
+  entry.time     = time;
+  entry.group    = group;
+  entry.message.assign(data, length);
+}
+
+LogRing::tail_type
+LogRing::tail(uint64_t cursor, size_t max, const std::vector<bool>& groups) const {
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  tail_type result;
+  uint64_t  first = std::max(m_first, m_next - std::min<uint64_t>(m_next, m_entries.size()));
+
+  if (cursor < first) {
+    result.dropped = first - cursor;
+    cursor = first;
+  }
+
+  // A cursor from a previous run starts at the current end.
+  cursor = std::min(cursor, m_next);
+
+  while (cursor != m_next && result.entries.size() < max) {
+    const auto& entry = m_entries[cursor++ % m_entries.size()];
+
+    if (!groups.empty() && ((size_t)entry.group >= groups.size() || !groups[entry.group]))
+      continue;
+
+    result.entries.push_back(entry);
+  }
+
+  result.cursor = cursor;
+  return result;
+}
+
+// The slot is called with the log lock held, so the sequence counter
+// needs no further locking.
+
+void
+log_open_binary_file_output(const std::string& name, const std::string& path, bool append, bool flush) {
+  std::shared_ptr<std::FILE> file(std::fopen(path.c_str(), append ? "ab" : "wb"), [](std::FILE* f) { if (f != nullptr) std::fclose(f); });
+
+  if (file == nullptr)
+    throw torrent::input_error("Could not open log file: " + path);
+
+  auto sequence = std::make_shared<uint64_t>(0);
+
+  torrent::log_open_output(name.c_str(), [file, sequence, flush](const char* data, auto length, int group) {
+      if (group < 0) {
+        std::fflush(file.get());
+        return;
+      }
+
+      log_record_header header{(*sequence)++, torrent::this_thread::cached_time().count(), (uint32_t)group, (uint32_t)length};
+
+      std::fwrite(&header, sizeof(header), 1, file.get());
+      std::fwrite(data, 1, length, file.get());
+
+      if (flush)
+        std::fflush(file.get());
+    });
+}
+
+}
@@ -0,0 +1,74 @@
+// Structured log outputs for monitoring.
+//
+// LogRing keeps the last 'size' messages of the log groups connected
+// to its output, each tagged with a sequence number, time and group.
+// Readers pass the sequence number returned by the previous call, so
+// collecting the log only costs the new entries. Entries overwritten
+// before they were read are reported as dropped.
+//
+// The binary file output writes each message as a 'log_record_header'
+// in native byte order followed by the unterminated message.
+
+#ifndef RTORRENT_CORE_LOG_RING_H
+#define RTORRENT_CORE_LOG_RING_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace core {
+
+struct log_record_header {
+  uint64_t            sequence;
+  int64_t             time;
+  uint32_t            group;
+  uint32_t            length;
+};
+
+class LogRing {
+public:
+  struct entry_type {
+    uint64_t          sequence{};
+    int64_t           time{};
+    int               group{};
+    std::string       message;
+  };
+
+  struct tail_type {
+    uint64_t          cursor{};
+    uint64_t          dropped{};
+    std::vector<entry_type> entries;
+  };
+
+  static constexpr size_t default_size = 4096;
+  static constexpr size_t max_size     = 1 << 20;
+
+  LogRing(size_t size = default_size);
+
+  size_t              size() const;
+  void                set_size(size_t size);
+
+  // The sequence number the next entry will get.
+  uint64_t            next_sequence() const;
+
+  // Thread-safe, called from the torrent::log output slot.
+  void                push(int group, int64_t time, const char* data, size_t length);
+
+  // At most 'max' entries starting at 'cursor', skipping groups not
+  // set in 'groups' unless it is empty.
+  tail_type           tail(uint64_t cursor, size_t max, const std::vector<bool>& groups) const;
+
+private:
+  mutable std::mutex      m_lock;
+
+  std::vector<entry_type> m_entries;
+  uint64_t                m_first{};
+  uint64_t                m_next{};
+};
+
+void log_open_binary_file_output(const std::string& name, const std::string& path, bool append, bool flush);
+
+}
+
+#endif
@@ -18,11 +18,13 @@
 #include <torrent/net/socket_address.h>
 #include <torrent/runtime/network_config.h>
 #include <torrent/runtime/network_manager.h>
+#include <torrent/system/thread.h>
 #include <torrent/utils/log.h>
 #include <torrent/utils/string_manip.h>
 
 #include "rpc/parse_commands.h"
 #include "utils/directory.h"
+#include "utils/directory_cache.h"
 #include "utils/base64.h"
 #include "utils/file_status_cache.h"
 
@@ -31,6 +33,8 @@
 #include "core/download.h"
 #include "core/download_factory.h"
 #include "core/http_queue.h"
+#include "core/log_ring.h"
+#include "core/throttle_groups.h"
 #include "core/view.h"
 
 #include <torrent/runtime/client_config.h>
@@ -54,15 +58,25 @@ Manager::Manager()
 
   m_download_list     = std::make_unique<DownloadList>();
   m_file_status_cache = std::make_unique<FileStatusCache>();
+  m_directory_cache   = std::make_unique<DirectoryCache>();
   m_http_queue        = std::make_unique<HttpQueue>();
+  m_throttle_groups   = std::make_unique<ThrottleGroups>(&m_throttles);
+  m_log_ring          = std::make_unique<LogRing>();
+
+  torrent::log_open_output("ring", [ring = m_log_ring.get()](const char* data, auto length, int group) {
+      ring->push(group, torrent::this_thread::cached_time().count(), data, length);
+    });
 
   torrent::Throttle* unthrottled = torrent::Throttle::create_throttle();
   unthrottled->set_max_rate(0);
-  m_throttles["NULL"] = std::make_pair(unthrottled, unthrottled);
+  m_throttle_groups->insert_fixed("NULL", unthrottled, unthrottled);
 }
 
 Manager::~Manager() {
+  torrent::log_close_output("ring");
+
   torrent::Throttle::destroy_throttle(m_throttles["NULL"].first);
+  m_throttle_groups.reset();
 }
 
 bool
@@ -89,9 +103,11 @@ Manager::set_hashing_view(View* v) {
 }
 
 ThrottlePair
-Manager::get_throttle(const std::string& name) {
-  auto itr       = m_throttles.find(name);
-  auto throttles = (itr == m_throttles.end() ? ThrottlePair(nullptr, nullptr) : itr->second);
+Manager::get_throttle(uint32_t group_id) {
+  auto throttles = ThrottlePair(nullptr, nullptr);
+
+  if (group_id < m_throttle_groups->size())
+    throttles = ThrottlePair(m_throttle_groups->throttle(group_id, true), m_throttle_groups->throttle(group_id, false));
 
   if (throttles.first == nullptr)
     throttles.first = torrent::up_throttle_global();
@@ -104,30 +120,23 @@ Manager::get_throttle(const std::string& name) {
 
 int64_t
 Manager::retrieve_throttle_value(const torrent::Object::string_type& name, bool rate, bool up) {
-  ThrottleMap::iterator itr = throttles().find(name);
+  torrent::Throttle* throttle = m_throttle_groups->find_throttle(name, up);
 
-  if (itr == throttles().end()) {
+  // check whether the actual up/down throttle exist (one of the pair can be missing)
+  if (throttle == nullptr)
     return (int64_t)-1;
-  } else {
-    torrent::Throttle* throttle = up ? itr->second.first : itr->second.second;
-
-    // check whether the actual up/down throttle exist (one of the pair can be missing)
-    if (throttle == nullptr)
-      return (int64_t)-1;
-
-    int64_t throttle_max = (int64_t)throttle->max_rate();
 
-    if (rate) {
+  int64_t throttle_max = (int64_t)throttle->max_rate();
 
-      if (throttle_max > 0)
-        return (int64_t)throttle->rate()->rate();
-      else
-        return (int64_t)-1;
+  if (rate) {
 
-    } else {
-      return throttle_max;
-    }
+    if (throttle_max > 0)
+      return (int64_t)throttle->rate()->rate();
+    else
+      return (int64_t)-1;
 
+  } else {
+    return throttle_max;
   }
 }
 
@@ -219,13 +228,13 @@ Manager::try_create_download(const std::string& uri, int flags, const command_li
 }
 
 void
-Manager::try_create_download_from_meta_download(torrent::Object* bencode, const std::string& metafile) {
+Manager::try_create_download_from_meta_download(torrent::Object&& bencode, const std::string& metafile) {
   DownloadFactory* f = new DownloadFactory(this);
 
   f->variables()["tied_to_file"] = (int64_t)true;
   f->variables()["tied_file"] = metafile;
 
-  torrent::Object& meta = bencode->get_key("rtorrent_meta_download");
+  torrent::Object& meta = bencode.get_key("rtorrent_meta_download");
   torrent::Object::list_type& commands = meta.get_key_list("commands");
   for (const auto& command : commands)
     f->commands().insert(f->commands().end(), command.as_string());
@@ -234,125 +243,96 @@ Manager::try_create_download_from_meta_download(torrent::Object* bencode, const
   f->set_print_log(meta.get_key_value("print_log"));
   f->slot_finished([f]() { delete f; });
 
-  // Bit of a waste to create the bencode repesentation here
-  // only to have the DownloadFactory decode it.
-  std::stringstream s;
-  s.imbue(std::locale::classic());
-  s << *bencode;
-  f->load_raw_data(s.str());
+  f->load_object(std::move(bencode));
   f->commit();
 }
 
-utils::Directory
-path_expand_transform(std::string path, const utils::directory_entry& entry) {
-  return path + entry.s_name;
-}
-
-namespace {
-
-// Consider rewritting such that m_seq is replaced by first/last.
-template <typename Sequence>
-class split_iterator_t {
-public:
-  typedef typename Sequence::const_iterator const_iterator;
-  typedef typename Sequence::value_type     value_type;
-
-  split_iterator_t() {}
-
-  split_iterator_t(const Sequence& seq, value_type delim) :
-    m_seq(&seq),
-    m_delim(delim),
-    m_pos(seq.begin()),
-    m_next(std::find(seq.begin(), seq.end(), delim)) {
-  }
+// Move this somewhere better.
+//
+// Directory listings come from 'cache', and each path found is paired
+// with whether the listing of its directory was unchanged since the
+// last expansion.
+void
+path_expand(std::vector<std::pair<std::string, bool>>* paths, const std::string& pattern, utils::DirectoryCache* cache) {
+  std::vector<std::string> currentCache;
+  std::vector<std::string> nextCache;
+  std::vector<std::string> components;
 
-  Sequence operator * () { return Sequence(m_pos, m_next); }
+  if (pattern.empty())
+    return;
 
-  split_iterator_t& operator ++ () {
-    m_pos = m_next;
+  std::string::size_type pos = 0;
 
-    if (m_pos == m_seq->end())
-      return *this;
+  while (true) {
+    auto next = pattern.find('/', pos);
+    components.push_back(pattern.substr(pos, next == std::string::npos ? std::string::npos : next - pos));
 
-    m_pos++;
-    m_next = std::find(m_pos, m_seq->end(), m_delim);
+    if (next == std::string::npos)
+      break;
 
-    return *this;
+    pos = next + 1;
   }
 
-  bool operator == (const split_iterator_t&) const { return m_pos == m_seq->end(); }
-  bool operator != (const split_iterator_t&) const { return m_pos != m_seq->end(); }
-
-private:
-  const Sequence* m_seq;
-  value_type      m_delim;
-  const_iterator  m_pos;
-  const_iterator  m_next;
-};
-
-template <typename Sequence>
-inline split_iterator_t<Sequence>
-split_iterator(const Sequence& seq, typename Sequence::value_type delim) {
-  return split_iterator_t<Sequence>(seq, delim);
-}
-
-template <typename Sequence>
-inline split_iterator_t<Sequence>
-split_iterator(const Sequence&) {
-  return split_iterator_t<Sequence>();
-}
-
-}
-
-// Move this somewhere better.
-void
-path_expand(std::vector<std::string>* paths, const std::string& pattern) {
-  std::vector<utils::Directory> currentCache;
-  std::vector<utils::Directory> nextCache;
-
-  auto first = split_iterator(pattern, '/');
-  auto last  = split_iterator(pattern);
-
-  if (first == last)
-    return;
+  auto first = components.begin();
 
   // Check for initial '/' that indicates the root.
-  if ((*first).empty()) {
-    currentCache.push_back(utils::Directory("/"));
+  if (first->empty()) {
+    currentCache.push_back("/");
     ++first;
   } else if (torrent::utils::trim_spaces_str(*first) == "~") {
-    currentCache.push_back(utils::Directory("~"));
+    currentCache.push_back("~");
     ++first;
   } else {
-    currentCache.push_back(utils::Directory("."));
+    currentCache.push_back(".");
   }
 
+  // The erase may invalidate 'first' if every remaining component is
+  // empty, so restore it from its index.
+  auto offset = first - components.begin();
+
+  components.erase(std::remove(first, components.end(), std::string()), components.end());
+  first = components.begin() + offset;
+
   // Might be an idea to use depth-first search instead.
 
-  for (; first != last; ++first) {
+  for (; first != components.end(); ++first) {
     const std::string& pattern = *first;
-
-    if (pattern.empty())
-      continue;
+    bool               is_last = first + 1 == components.end();
 
     // Special case for ".."?
 
-    for (auto& itr : currentCache) {
-      // Only include filenames starting with '.' if the pattern
-      // starts with the same.
-      itr.update((pattern[0] != '.') ? utils::Directory::update_hide_dot : 0);
-      itr.erase(std::remove_if(itr.begin(), itr.end(), [&pattern](const utils::directory_entry& entry) { return fnmatch(pattern.c_str(), entry.s_name.c_str(), 0) != 0; }), itr.end());
+    for (const auto& path : currentCache) {
+      bool changed;
+      const utils::Directory* directory = cache->find(path, &changed);
+
+      if (directory == nullptr)
+        continue;
+
+      std::string prefix = path + (path == "/" ? "" : "/");
 
-      for (const auto& cache : itr)
-        nextCache.push_back(path_expand_transform(itr.path() + (itr.path() == "/" ? "" : "/"), cache));
+      for (const auto& entry : *directory) {
+        // Only include filenames starting with '.' if the pattern
+        // starts with the same.
+        if (pattern[0] != '.' && entry.s_name[0] == '.')
+          continue;
+
+        // Skip entries d_type says can't be descended into.
+        if (!is_last && !entry.may_be_directory())
+          continue;
+
+        if (fnmatch(pattern.c_str(), entry.s_name.c_str(), 0) != 0)
+          continue;
+
+        if (is_last)
+          paths->emplace_back(prefix + entry.s_name, !changed);
+        else
+          nextCache.push_back(prefix + entry.s_name);
+      }
     }
 
     currentCache.clear();
     currentCache.swap(nextCache);
   }
-
-  for (const auto& cache : currentCache)
-    paths->push_back(cache.path());
 }
 
 bool
@@ -367,17 +347,25 @@ Manager::try_create_download_expand(const std::string& uri, int flags, command_l
     return;
   }
 
-  std::vector<std::string> paths;
+  std::vector<std::pair<std::string, bool>> paths;
   paths.reserve(256);
 
-  path_expand(&paths, uri);
-
-  if (!paths.empty())
-    for (auto& path : paths)
-      try_create_download(path, flags, commands);
+  path_expand(&paths, uri, m_directory_cache.get());
 
-  else
+  if (paths.empty()) {
     try_create_download(uri, flags, commands);
+    return;
+  }
+
+  for (auto& [path, unchanged] : paths) {
+    // Tied files already in the file status cache are skipped by
+    // try_create_download, avoid the stat when the directory hasn't
+    // changed.
+    if (unchanged && (flags & create_tied) && file_status_cache()->touch(path))
+      continue;
+
+    try_create_download(path, flags, commands);
+  }
 }
 
 // DownloadList's hashing related functions don't actually start the
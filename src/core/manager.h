@@ -15,12 +15,15 @@ namespace torrent {
 }
 
 namespace utils {
+class DirectoryCache;
 class FileStatusCache;
 }
 
 namespace core {
 
 class HttpQueue;
+class LogRing;
+class ThrottleGroups;
 
 using ThrottlePair = std::pair<torrent::Throttle*, torrent::Throttle*>;
 using ThrottleMap  =  std::map<std::string, ThrottlePair>;
@@ -31,6 +34,7 @@ class Manager {
 public:
   typedef DownloadList::iterator                    DListItr;
   typedef utils::FileStatusCache                    FileStatusCache;
+  typedef utils::DirectoryCache                     DirectoryCache;
 
   Manager();
   ~Manager();
@@ -39,6 +43,7 @@ public:
 
   DownloadList*       download_list()                   { return m_download_list.get(); }
   FileStatusCache*    file_status_cache()               { return m_file_status_cache.get(); }
+  DirectoryCache*     directory_cache()                 { return m_directory_cache.get(); }
 
   HttpQueue*          http_queue()                      { return m_http_queue.get(); }
 
@@ -47,9 +52,13 @@ public:
 
   auto*               log_important()                   { return m_log_important.get(); }
   auto*               log_complete()                    { return m_log_complete.get(); }
+  LogRing*            log_ring()                        { return m_log_ring.get(); }
 
   ThrottleMap&        throttles()                       { return m_throttles; }
-  ThrottlePair        get_throttle(const std::string& name);
+  ThrottleGroups*     throttle_groups()                 { return m_throttle_groups.get(); }
+  // Falls back to the global throttles for missing groups or
+  // directions without a throttle.
+  ThrottlePair        get_throttle(uint32_t group_id);
 
   int64_t             retrieve_throttle_value(const torrent::Object::string_type& name, bool rate, bool up);
 
@@ -76,7 +85,7 @@ public:
   // Temporary, find a better place for this.
   void                try_create_download(const std::string& uri, int flags, const command_list_type& commands);
   void                try_create_download_expand(const std::string& uri, int flags, command_list_type commands = command_list_type());
-  void                try_create_download_from_meta_download(torrent::Object* bencode, const std::string& metafile);
+  void                try_create_download_from_meta_download(torrent::Object&& bencode, const std::string& metafile);
 
 private:
   void                create_http(const std::string& uri);
@@ -89,14 +98,17 @@ private:
 
   std::unique_ptr<DownloadList>    m_download_list;
   std::unique_ptr<FileStatusCache> m_file_status_cache;
+  std::unique_ptr<DirectoryCache>  m_directory_cache;
   std::unique_ptr<HttpQueue>       m_http_queue;
 
   View*               m_hashingView{};
 
   ThrottleMap         m_throttles;
+  std::unique_ptr<ThrottleGroups> m_throttle_groups;
 
   torrent::log_buffer_ptr m_log_important;
   torrent::log_buffer_ptr m_log_complete;
+  std::unique_ptr<LogRing> m_log_ring;
 
   std::string         m_magnet_path;
 };
@@ -0,0 +1,97 @@
+#include "config.h"
+
+#include "core/parallel_pool.h"
+
+#include <system_error>
+
+namespace core {
+
+ParallelPool::~ParallelPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_work_condition.notify_all();
+
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+void
+ParallelPool::run(unsigned count, const slot_index& func) {
+  if (count == 0)
+    return;
+
+  grow(count - 1);
+
+  unsigned started = std::min<size_t>(count - 1, m_workers.size());
+
+  if (started != 0) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_func    = &func;
+    m_count   = started + 1;
+    m_pending = m_workers.size();
+    m_generation++;
+  }
+
+  m_work_condition.notify_all();
+
+  func(0);
+
+  for (unsigned index = started + 1; index < count; index++)
+    func(index);
+
+  if (started == 0)
+    return;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done_condition.wait(lock, [this] { return m_pending == 0; });
+
+  m_func = nullptr;
+}
+
+void
+ParallelPool::grow(unsigned workers) {
+  while (m_workers.size() < workers) {
+    try {
+      m_workers.emplace_back(&ParallelPool::worker_loop, this, m_workers.size(), m_generation);
+    } catch (const std::system_error&) {
+      return;
+    }
+  }
+}
+
+// Every worker answers each generation, those without an index in the
+// current call only decrement 'm_pending'. Workers are given the
+// generation they were started in, as only 'run' changes it.
+void
+ParallelPool::worker_loop(unsigned index, uint64_t generation) {
+  while (true) {
+    const slot_index* func;
+    unsigned          count;
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_work_condition.wait(lock, [&] { return m_stop || m_generation != generation; });
+
+      if (m_stop)
+        return;
+
+      generation = m_generation;
+      func       = m_func;
+      count      = m_count;
+    }
+
+    if (index + 1 < count)
+      (*func)(index + 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (--m_pending == 0)
+      m_done_condition.notify_one();
+  }
+}
+
+}
@@ -0,0 +1,107 @@
+// Worker threads for splitting the filtering and sorting of large views.
+//
+// The threads are started the first time they are needed and kept
+// waiting for the next call, so a view filter doesn't pay for creating
+// and joining them each time. The pool only grows, up to the largest
+// number of threads asked for.
+//
+// 'run' must only be called from one thread at a time, the views use
+// it from the main thread.
+
+#ifndef RTORRENT_CORE_PARALLEL_POOL_H
+#define RTORRENT_CORE_PARALLEL_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+
+class ParallelPool {
+public:
+  typedef std::function<void(unsigned)> slot_index;
+
+  ParallelPool() = default;
+  ~ParallelPool();
+
+  // The number of worker threads started, not counting the caller.
+  size_t              size() const { return m_workers.size(); }
+
+  // Calls 'func(index)' for each index in [0, count), index zero in the
+  // calling thread, and returns once all calls are done. If threads
+  // can't be started, the remaining indices are called in the calling
+  // thread. 'func' must not throw.
+  void                run(unsigned count, const slot_index& func);
+
+private:
+  ParallelPool(const ParallelPool&) = delete;
+  ParallelPool& operator=(const ParallelPool&) = delete;
+
+  void                grow(unsigned workers);
+  void                worker_loop(unsigned index, uint64_t generation);
+
+  std::mutex              m_mutex;
+  std::condition_variable m_work_condition;
+  std::condition_variable m_done_condition;
+
+  std::vector<std::thread> m_workers;
+
+  const slot_index*       m_func{};
+  unsigned                m_count{};
+  uint64_t                m_generation{};
+  size_t                  m_pending{};
+  bool                    m_stop{};
+};
+
+inline size_t
+parallel_chunk_size(size_t size, unsigned threads) {
+  return (size + threads - 1) / threads;
+}
+
+// Calls 'func(index, first, last)' for each of the 'threads' chunks of
+// [0, size). Any exception is rethrown once all chunks are done.
+template <typename Func>
+void
+parallel_for(ParallelPool& pool, size_t size, unsigned threads, Func func) {
+  size_t                          chunk = parallel_chunk_size(size, threads);
+  std::vector<std::exception_ptr> exceptions(threads);
+
+  pool.run(threads, [&](unsigned index) {
+      try {
+        func(index, std::min(size, index * chunk), std::min(size, (index + 1) * chunk));
+      } catch (...) {
+        exceptions[index] = std::current_exception();
+      }
+    });
+
+  for (auto& exception : exceptions)
+    if (exception)
+      std::rethrow_exception(exception);
+}
+
+// Chunks are sorted in parallel with 'chunk_compare(index)' and then
+// merged pairwise in the calling thread with 'compare'. As both steps
+// are stable, the result is the same as that of a single stable sort.
+template <typename Iterator, typename ChunkCompare, typename Compare>
+void
+parallel_stable_sort(ParallelPool& pool, Iterator first, Iterator last, unsigned threads, ChunkCompare chunk_compare, Compare compare) {
+  size_t size = std::distance(first, last);
+
+  parallel_for(pool, size, threads, [&](unsigned index, size_t chunk_first, size_t chunk_last) {
+      std::stable_sort(first + chunk_first, first + chunk_last, chunk_compare(index));
+    });
+
+  for (size_t width = parallel_chunk_size(size, threads); width != 0 && width < size; width *= 2)
+    for (size_t merge_first = 0; merge_first + width < size; merge_first += 2 * width)
+      std::inplace_merge(first + merge_first, first + merge_first + width, first + std::min(size, merge_first + 2 * width), compare);
+}
+
+}
+
+#endif
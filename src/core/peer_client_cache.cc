@@ -0,0 +1,149 @@
+#include "config.h"
+
+#include "core/peer_client_cache.h"
+
+#include <netinet/in.h>
+#include <torrent/net/socket_address.h>
+#include <torrent/peer/client_info.h>
+#include <torrent/peer/connection_list.h>
+#include <torrent/peer/peer.h>
+#include <torrent/peer/peer_info.h>
+#include <torrent/utils/string_manip.h>
+
+#include "control.h"
+#include "core/download.h"
+#include "core/download_list.h"
+#include "core/manager.h"
+#include "display/utils.h"
+
+namespace core {
+
+void
+PeerClientCache::watch(Download* download) {
+  auto connection_list = download->download()->connection_list();
+
+  connection_list->signal_connected().insert(connection_list->signal_connected().end(), [this, download](torrent::Peer* peer) {
+      classify(peer->peer_info(), &insert_entry(peer->peer_info(), download, identity(peer->peer_info())));
+    });
+  connection_list->signal_disconnected().insert(connection_list->signal_disconnected().end(), [this](torrent::Peer* peer) {
+      erase_entry(peer->peer_info());
+    });
+}
+
+void
+PeerClientCache::erase(Download* download) {
+  std::erase_if(m_entries, [download](const auto& entry) { return entry.second.download == download; });
+}
+
+const PeerClientCache::entry_type&
+PeerClientCache::find(torrent::Peer* peer) {
+  auto entry = find_entry(peer->peer_info(), identity(peer->peer_info()));
+
+  if (entry != nullptr)
+    return *entry;
+
+  classify(peer->peer_info(), &m_scratch);
+  return m_scratch;
+}
+
+const PeerClientCache::entry_type*
+PeerClientCache::find_entry(const torrent::PeerInfo* peer_info, const identity_type& identity) const {
+  auto itr = m_entries.find(peer_info);
+
+  if (itr == m_entries.end() || itr->second.identity != identity)
+    return nullptr;
+
+  return &itr->second;
+}
+
+PeerClientCache::entry_type&
+PeerClientCache::insert_entry(const torrent::PeerInfo* peer_info, Download* download, const identity_type& identity) {
+  auto& entry = m_entries[peer_info];
+
+  entry          = entry_type{};
+  entry.download = download;
+  entry.identity = identity;
+
+  return entry;
+}
+
+void
+PeerClientCache::erase_entry(const torrent::PeerInfo* peer_info) {
+  m_entries.erase(peer_info);
+}
+
+torrent::Object
+PeerClientCache::clients() {
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  for (const auto& download : *control->core()->download_list()) {
+    for (auto peer : *download->download()->connection_list()) {
+      const auto& entry = find(peer);
+
+      auto& client = result[entry.client_name];
+
+      if (!client.is_map()) {
+        client = torrent::Object::create_map();
+        client.insert_key("total", int64_t());
+        client.insert_key("versions", torrent::Object::create_map());
+      }
+
+      client.get_key("total").as_value()++;
+
+      auto& version = client.get_key("versions").as_map()[entry.client_version];
+
+      version = version.is_value() ? version.as_value() + 1 : int64_t(1);
+    }
+  }
+
+  return raw_result;
+}
+
+void
+PeerClientCache::classify(const torrent::PeerInfo* peer_info, entry_type* entry) {
+  char buffer[128];
+  display::print_client_version(buffer, buffer + sizeof(buffer), peer_info->client_info());
+
+  entry->client_name    = peer_info->client_info().short_description();
+  entry->client_version = buffer;
+  entry->id_hex         = torrent::utils::transform_to_hex_str(peer_info->id());
+  entry->id_html        = torrent::utils::copy_escape_html_str(peer_info->id());
+
+  auto sa = peer_info->socket_address();
+
+  if (sa->sa_family == AF_INET6)
+    entry->address = "[" + torrent::sa_addr_str(sa) + "]";
+  else
+    entry->address = torrent::sa_addr_str(sa);
+}
+
+PeerClientCache::identity_type
+PeerClientCache::identity(const torrent::PeerInfo* peer_info) {
+  return make_identity(peer_info->id().data(), peer_info->socket_address());
+}
+
+PeerClientCache::identity_type
+PeerClientCache::make_identity(const char* id, const sockaddr* sa) {
+  identity_type result{};
+
+  std::memcpy(result.id, id, sizeof(result.id));
+  result.family = sa->sa_family;
+
+  if (sa->sa_family == AF_INET) {
+    auto sin = reinterpret_cast<const sockaddr_in*>(sa);
+
+    result.port = sin->sin_port;
+    std::memcpy(result.address, &sin->sin_addr, sizeof(sin->sin_addr));
+
+  } else if (sa->sa_family == AF_INET6) {
+    auto sin6 = reinterpret_cast<const sockaddr_in6*>(sa);
+
+    result.port = sin6->sin6_port;
+    std::memcpy(result.address, &sin6->sin6_addr, sizeof(sin6->sin6_addr));
+  }
+
+  return result;
+}
+
+}
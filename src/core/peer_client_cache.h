@@ -0,0 +1,84 @@
+// Keeps the formatted client version, peer id and address of each
+// connected peer, so that peer list pollers calling 'p.client_version',
+// 'p.id' and friends on every refresh don't format them again.
+//
+// Entries are created when a peer connects, which is after the
+// handshake so the id is known, and are dropped on disconnect or when
+// the download is closed or erased. A peer that isn't cached is
+// classified into a scratch entry.
+//
+// Entries are keyed by the PeerInfo pointer, which may be reused for a
+// different peer after a missed disconnect. Each entry also keeps the
+// raw peer id and address, which a lookup compares in place, and a
+// lookup that doesn't match them classifies the peer again.
+
+#ifndef RTORRENT_CORE_PEER_CLIENT_CACHE_H
+#define RTORRENT_CORE_PEER_CLIENT_CACHE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <torrent/common.h>
+#include <torrent/object.h>
+
+struct sockaddr;
+
+namespace core {
+
+class Download;
+
+class PeerClientCache {
+public:
+  // The peer id and the family, port and address of the socket
+  // address, zero filled so that entries compare with memcmp.
+  struct identity_type {
+    char              id[20];
+    uint16_t          family;
+    uint16_t          port;
+    char              address[16];
+
+    bool              operator==(const identity_type& rhs) const { return std::memcmp(this, &rhs, sizeof(identity_type)) == 0; }
+  };
+
+  struct entry_type {
+    Download*         download{};
+
+    std::string       client_name;
+    std::string       client_version;
+    std::string       id_hex;
+    std::string       id_html;
+    std::string       address;
+
+    identity_type     identity;
+  };
+
+  size_t              size() const                  { return m_entries.size(); }
+
+  void                watch(Download* download);
+  void                erase(Download* download);
+
+  const entry_type&   find(torrent::Peer* peer);
+
+  // The 'identity' of an entry must match for it to be returned.
+  const entry_type*   find_entry(const torrent::PeerInfo* peer_info, const identity_type& identity) const;
+  entry_type&         insert_entry(const torrent::PeerInfo* peer_info, Download* download, const identity_type& identity);
+  void                erase_entry(const torrent::PeerInfo* peer_info);
+
+  // Connected peers per client name, with counts per version:
+  // { name: { "total": n, "versions": { version: n } } }
+  torrent::Object     clients();
+
+  static void         classify(const torrent::PeerInfo* peer_info, entry_type* entry);
+  static identity_type identity(const torrent::PeerInfo* peer_info);
+  static identity_type make_identity(const char* id, const sockaddr* sa);
+
+private:
+  std::unordered_map<const torrent::PeerInfo*, entry_type> m_entries;
+
+  entry_type          m_scratch;
+};
+
+}
+
+#endif
@@ -0,0 +1,368 @@
+#include "config.h"
+
+#include "core/peer_filter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <torrent/download.h>
+#include <torrent/exceptions.h>
+#include <torrent/peer/connection_list.h>
+#include <torrent/peer/peer.h>
+#include <torrent/peer/peer_info.h>
+#include <torrent/peer/peer_list.h>
+#include <torrent/system/callbacks.h>
+#include <torrent/system/thread.h>
+#include <torrent/utils/log.h>
+#include <torrent/utils/option_strings.h>
+
+#include "control.h"
+#include "globals.h"
+#include "core/download.h"
+#include "core/manager.h"
+
+namespace core {
+
+namespace {
+
+class mapped_file {
+public:
+  mapped_file() = default;
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator = (const mapped_file&) = delete;
+
+  // Returns false with errno set on failure.
+  bool                open(const std::string& path);
+
+  std::string_view    data() const                  { return std::string_view(static_cast<const char*>(m_data), m_size); }
+
+private:
+  void*               m_data{nullptr};
+  size_t              m_size{};
+};
+
+mapped_file::~mapped_file() {
+  if (m_data != nullptr)
+    ::munmap(m_data, m_size);
+}
+
+bool
+mapped_file::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if (fd == -1)
+    return false;
+
+  struct stat st;
+  bool        success = ::fstat(fd, &st) == 0;
+
+  // Empty files can't be mapped.
+  if (success && st.st_size != 0) {
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED) {
+      m_data = data;
+      m_size = st.st_size;
+
+      ::madvise(m_data, m_size, MADV_SEQUENTIAL);
+
+    } else {
+      success = false;
+    }
+  }
+
+  int saved_errno = errno;
+  ::close(fd);
+  errno = saved_errno;
+
+  return success;
+}
+
+}
+
+struct PeerFilter::result_type {
+  std::shared_ptr<utils::AddressRangeTable> table;
+  torrent::ipv4_table::range_map_type       range_map;
+
+  size_t                                    lines{};
+  std::string                               error;
+};
+
+PeerFilter::PeerFilter() :
+  m_table(std::make_shared<const utils::AddressRangeTable>()),
+  m_callback_id(torrent::system::make_callback_id()) {
+}
+
+PeerFilter::~PeerFilter() = default;
+
+void
+PeerFilter::insert(std::string_view address, int value) {
+  job_type                             job{job_insert};
+  utils::AddressRangeTable::ipv4_range range4;
+  utils::AddressRangeTable::ipv6_range range6;
+
+  switch (utils::AddressRangeTable::parse_range(address, &range4, &range6)) {
+  case utils::AddressRangeTable::parse_ipv4:
+    range4.value = value;
+    job.ipv4.push_back(range4);
+    break;
+  case utils::AddressRangeTable::parse_ipv6:
+    range6.value = value;
+    job.ipv6.push_back(range6);
+    break;
+  case utils::AddressRangeTable::parse_none:
+    throw torrent::input_error("Invalid address format.");
+  }
+
+  push_job(std::move(job));
+}
+
+void
+PeerFilter::load(const std::string& path, int value) {
+  push_job(job_type{job_load, expand_path(path), value});
+}
+
+void
+PeerFilter::load_cache(const std::string& path) {
+  push_job(job_type{job_load_cache, expand_path(path)});
+}
+
+void
+PeerFilter::save_cache(const std::string& path) {
+  push_job(job_type{job_save_cache, expand_path(path)});
+}
+
+void
+PeerFilter::watch(core::Download* download) {
+  auto connection_list = download->download()->connection_list();
+
+  connection_list->signal_connected().insert(connection_list->signal_connected().end(),
+                                             [this](torrent::Peer* peer) { receive_peer_connected(peer); });
+}
+
+void
+PeerFilter::shutdown() {
+  m_active = false;
+
+  torrent::system::cancel_callback_and_wait(m_callback_id, session_thread::thread(), torrent::main_thread::thread());
+
+  m_pending.clear();
+  m_busy = false;
+}
+
+// Jobs that were handed to the session thread are canceled and run
+// again here, as canceling also drops a result not yet received.
+
+void
+PeerFilter::flush() {
+  torrent::system::cancel_callback_and_wait(m_callback_id, session_thread::thread(), torrent::main_thread::thread());
+
+  if (m_busy) {
+    m_pending.push_front(std::move(m_current));
+    m_busy = false;
+  }
+
+  while (m_active && !m_pending.empty()) {
+    job_type job = std::move(m_pending.front());
+    m_pending.pop_front();
+
+    if (job.kind == job_insert) {
+      apply_insert(job);
+      continue;
+    }
+
+    merge_inserts();
+
+    result_type result;
+    execute_job(job, m_table, &result);
+    apply_result(job, result);
+  }
+}
+
+// Consecutive inserts queued behind a load are combined into one job.
+
+void
+PeerFilter::push_job(job_type job) {
+  if (!m_active)
+    return;
+
+  if (job.kind == job_insert && !m_pending.empty() && m_pending.back().kind == job_insert) {
+    auto& back = m_pending.back();
+
+    back.ipv4.insert(back.ipv4.end(), job.ipv4.begin(), job.ipv4.end());
+    back.ipv6.insert(back.ipv6.end(), job.ipv6.begin(), job.ipv6.end());
+    return;
+  }
+
+  m_pending.push_back(std::move(job));
+
+  if (!m_busy)
+    process_next();
+}
+
+// Inserts are small enough to apply directly, everything else is
+// handed to the session thread along with the current table, which
+// is never modified once published.
+
+void
+PeerFilter::process_next() {
+  while (!m_pending.empty()) {
+    job_type job = std::move(m_pending.front());
+    m_pending.pop_front();
+
+    if (job.kind == job_insert) {
+      apply_insert(job);
+      continue;
+    }
+
+    merge_inserts();
+
+    m_busy    = true;
+    m_current = job;
+
+    session_thread::callback(m_callback_id, [this, job = std::move(job), table = m_table]() mutable {
+        auto result = std::make_shared<result_type>();
+        execute_job(job, table, result.get());
+
+        torrent::main_thread::callback(m_callback_id, [this, job = std::move(job), result]() {
+            receive_result(job, *result);
+          });
+      });
+
+    return;
+  }
+}
+
+void
+PeerFilter::apply_insert(const job_type& job) {
+  m_inserts_ipv4.insert(m_inserts_ipv4.end(), job.ipv4.begin(), job.ipv4.end());
+  m_inserts_ipv6.insert(m_inserts_ipv6.end(), job.ipv6.begin(), job.ipv6.end());
+
+  for (const auto& range : job.ipv4)
+    torrent::PeerList::ipv4_filter()->insert(range.first, range.last, range.value);
+}
+
+void
+PeerFilter::merge_inserts() {
+  if (m_inserts_ipv4.empty() && m_inserts_ipv6.empty())
+    return;
+
+  auto table = std::make_shared<utils::AddressRangeTable>(*m_table);
+  table->merge(std::move(m_inserts_ipv4), std::move(m_inserts_ipv6));
+
+  m_inserts_ipv4.clear();
+  m_inserts_ipv6.clear();
+
+  m_table = std::move(table);
+}
+
+// Called in the session thread.
+
+void
+PeerFilter::execute_job(const job_type& job, const table_ptr& table, result_type* result) {
+  if (job.kind == job_save_cache) {
+    auto path_tmp = job.path + ".new";
+    auto data     = table->serialize();
+    auto file     = std::fstream(path_tmp.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+    file.write(data.data(), data.size());
+    file.close();
+
+    if (file.fail())
+      result->error = "could not write '" + path_tmp + "'";
+    else if (::rename(path_tmp.c_str(), job.path.c_str()) == -1)
+      result->error = "could not rename '" + path_tmp + "': " + std::strerror(errno);
+
+    return;
+  }
+
+  mapped_file file;
+
+  if (!file.open(job.path)) {
+    result->error = "could not open '" + job.path + "': " + std::strerror(errno);
+    return;
+  }
+
+  if (job.kind == job_load_cache) {
+    result->table = std::make_shared<utils::AddressRangeTable>();
+
+    if (!utils::AddressRangeTable::deserialize(file.data(), result->table.get())) {
+      result->table.reset();
+      result->error = "invalid ip filter cache '" + job.path + "'";
+      return;
+    }
+
+  } else {
+    utils::AddressRangeTable::ipv4_list ipv4;
+    utils::AddressRangeTable::ipv6_list ipv6;
+
+    result->lines = utils::AddressRangeTable::parse_list(file.data(), job.value, &ipv4, &ipv6);
+
+    result->table = std::make_shared<utils::AddressRangeTable>(*table);
+    result->table->merge(std::move(ipv4), std::move(ipv6));
+  }
+
+  for (const auto& range : result->table->ipv4())
+    result->range_map.emplace_hint(result->range_map.end(), range.first, std::make_pair(range.last, range.value));
+}
+
+void
+PeerFilter::receive_result(const job_type& job, result_type& result) {
+  m_busy = false;
+
+  if (!m_active)
+    return;
+
+  apply_result(job, result);
+  process_next();
+}
+
+void
+PeerFilter::apply_result(const job_type& job, result_type& result) {
+  if (!result.error.empty()) {
+    lt_log_print(torrent::LOG_CONNECTION_FILTER, "ip filter: %s", result.error.c_str());
+    control->core()->push_log_std("Ip filter: " + result.error);
+
+  } else if (result.table) {
+    m_table = std::move(result.table);
+    torrent::PeerList::ipv4_filter()->range_map.swap(result.range_map);
+
+    if (job.kind == job_load)
+      lt_log_print(torrent::LOG_CONNECTION_FILTER, "loaded %zu %s address blocks from '%s', %zu ipv4 and %zu ipv6 ranges (%zu kb in-memory)",
+                   result.lines, torrent::option_to_c_str_or_throw(torrent::OPTION_IP_FILTER, job.value), job.path.c_str(),
+                   m_table->size_ipv4(), m_table->size_ipv6(), m_table->sizeof_data() / 1024);
+    else
+      lt_log_print(torrent::LOG_CONNECTION_FILTER, "loaded ip filter cache '%s', %zu ipv4 and %zu ipv6 ranges",
+                   job.path.c_str(), m_table->size_ipv4(), m_table->size_ipv6());
+
+  } else {
+    lt_log_print(torrent::LOG_CONNECTION_FILTER, "saved ip filter cache '%s'", job.path.c_str());
+  }
+}
+
+// Only IPv6 peers are checked, as libtorrent won't connect to IPv4
+// peers in its own filter.
+
+void
+PeerFilter::receive_peer_connected(torrent::Peer* peer) {
+  const sockaddr* sa = peer->peer_info()->socket_address();
+  int             value;
+
+  if (!m_active || sa->sa_family != AF_INET6 || !table()->find(sa, &value))
+    return;
+
+  if (!(value & torrent::PeerInfo::flag_unwanted))
+    return;
+
+  peer->set_banned(true);
+  peer->disconnect(torrent::ConnectionList::disconnect_delayed);
+}
+
+}
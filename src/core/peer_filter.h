@@ -0,0 +1,112 @@
+#ifndef RTORRENT_CORE_PEER_FILTER_H
+#define RTORRENT_CORE_PEER_FILTER_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <torrent/common.h>
+#include <torrent/system/scheduler.h>
+
+#include "utils/address_range_table.h"
+
+namespace core {
+
+class Download;
+
+// The IPv4 and IPv6 peer filter.
+//
+// Block lists are memory mapped and parsed in the session thread,
+// which also merges them into a copy of the current table. The new
+// table then replaces the old one, and libtorrent's IPv4 filter, in
+// the main thread.
+//
+// Loads, cache reads and writes, and inserts are done one at a time
+// in the order they were queued, so later entries override earlier
+// ones as when everything was loaded synchronously. Lookups see the
+// table as of the last completed entry.
+//
+// Inserts go into libtorrent's filter right away, but are only merged
+// into the table when it is next needed, so that a config with many
+// 'ip_filter.add_address' lines merges them all at once.
+//
+// Block lists loaded while reading the config are finished with
+// 'flush' before any downloads are started.
+//
+// As libtorrent only filters IPv4 addresses, 'unwanted' IPv6 peers
+// are banned as soon as they connect.
+
+class PeerFilter {
+public:
+  using table_ptr = std::shared_ptr<const utils::AddressRangeTable>;
+
+  PeerFilter();
+  ~PeerFilter();
+
+  const table_ptr&    table()                       { merge_inserts(); return m_table; }
+
+  bool                is_busy() const               { return m_busy; }
+  size_t              size_pending() const          { return m_pending.size(); }
+
+  // Throws input_error if 'address' isn't an address or range.
+  void                insert(std::string_view address, int value);
+
+  void                load(const std::string& path, int value);
+
+  void                load_cache(const std::string& path);
+  void                save_cache(const std::string& path);
+
+  // Waits for the queued jobs, running them in the calling thread.
+  void                flush();
+
+  // Called for each download inserted into DownloadList.
+  void                watch(core::Download* download);
+
+  void                shutdown();
+
+private:
+  enum job_kind {
+    job_insert,
+    job_load,
+    job_load_cache,
+    job_save_cache
+  };
+
+  struct job_type {
+    job_kind                            kind;
+    std::string                         path;
+    int                                 value{};
+    utils::AddressRangeTable::ipv4_list ipv4;
+    utils::AddressRangeTable::ipv6_list ipv6;
+  };
+
+  struct result_type;
+
+  void                push_job(job_type job);
+  void                process_next();
+
+  void                apply_insert(const job_type& job);
+  void                merge_inserts();
+
+  static void         execute_job(const job_type& job, const table_ptr& table, result_type* result);
+  void                receive_result(const job_type& job, result_type& result);
+  void                apply_result(const job_type& job, result_type& result);
+
+  void                receive_peer_connected(torrent::Peer* peer);
+
+  table_ptr           m_table;
+
+  utils::AddressRangeTable::ipv4_list m_inserts_ipv4;
+  utils::AddressRangeTable::ipv6_list m_inserts_ipv6;
+
+  std::deque<job_type> m_pending;
+  job_type            m_current{job_insert};
+  bool                m_busy{false};
+  bool                m_active{true};
+
+  torrent::system::callback_id m_callback_id;
+};
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include "config.h"
+
+#include "core/ratio_engine.h"
+
+#include <algorithm>
+#include <torrent/rate.h>
+
+#include "core/download.h"
+#include "core/view.h"
+
+namespace core {
+
+void
+RatioHeap::clear() {
+  m_entries.clear();
+  m_index.clear();
+}
+
+void
+RatioHeap::push(Download* download, int64_t key) {
+  auto [itr, inserted] = m_index.try_emplace(download, m_entries.size());
+
+  if (inserted) {
+    m_entries.push_back(entry_type{download, key});
+    sift_up(itr->second);
+    return;
+  }
+
+  auto pos = itr->second;
+  auto old_key = m_entries[pos].key;
+
+  m_entries[pos].key = key;
+
+  if (key < old_key)
+    sift_up(pos);
+  else
+    sift_down(pos);
+}
+
+std::vector<RatioHeap::entry_type>
+RatioHeap::pop_due(int64_t limit) {
+  std::vector<entry_type> result;
+
+  while (!m_entries.empty() && m_entries.front().key <= limit) {
+    result.push_back(m_entries.front());
+    erase(m_entries.front().download);
+  }
+
+  return result;
+}
+
+bool
+RatioHeap::erase(Download* download) {
+  auto itr = m_index.find(download);
+
+  if (itr == m_index.end())
+    return false;
+
+  auto pos = itr->second;
+  auto old_key = m_entries[pos].key;
+
+  m_index.erase(itr);
+
+  if (pos == m_entries.size() - 1) {
+    m_entries.pop_back();
+    return true;
+  }
+
+  place(pos, m_entries.back());
+  m_entries.pop_back();
+
+  if (m_entries[pos].key < old_key)
+    sift_up(pos);
+  else
+    sift_down(pos);
+
+  return true;
+}
+
+void
+RatioHeap::place(size_t pos, const entry_type& entry) {
+  m_entries[pos] = entry;
+  m_index[entry.download] = pos;
+}
+
+void
+RatioHeap::sift_up(size_t pos) {
+  auto entry = m_entries[pos];
+
+  while (pos != 0) {
+    auto parent = (pos - 1) / 2;
+
+    if (m_entries[parent].key <= entry.key)
+      break;
+
+    place(pos, m_entries[parent]);
+    pos = parent;
+  }
+
+  place(pos, entry);
+}
+
+void
+RatioHeap::sift_down(size_t pos) {
+  auto entry = m_entries[pos];
+
+  while (true) {
+    auto child = pos * 2 + 1;
+
+    if (child >= m_entries.size())
+      break;
+
+    if (child + 1 < m_entries.size() && m_entries[child + 1].key < m_entries[child].key)
+      child++;
+
+    if (entry.key <= m_entries[child].key)
+      break;
+
+    place(pos, m_entries[child]);
+    pos = child;
+  }
+
+  place(pos, entry);
+}
+
+void
+RatioEngine::process(const std::string& group_name, View* view, const settings_type& settings,
+                     int64_t global_upload, download_list* crossed) {
+  auto& group = m_groups[group_name];
+
+  m_global_upload = global_upload;
+
+  if (!group.built || group.view_id != view->id() || group.settings != settings) {
+    group.view_id = view->id();
+    group.settings = settings;
+
+    build(&group, view);
+  }
+
+  watch_view(view);
+  update(&group, global_upload, crossed);
+}
+
+void
+RatioEngine::update(Download* download) {
+  for (auto& [name, group] : m_groups)
+    if (group.heap.contains(download))
+      push(&group, download, m_global_upload);
+}
+
+void
+RatioEngine::erase(Download* download) {
+  for (auto& [name, group] : m_groups)
+    group.heap.erase(download);
+}
+
+bool
+RatioEngine::is_tracked(const std::string& group, Download* download) const {
+  auto itr = m_groups.find(group);
+
+  return itr != m_groups.end() && itr->second.heap.contains(download);
+}
+
+// Fires when either:
+//
+//   upload >= min_upload && upload * 100 >= done * min_ratio
+//   max_ratio > 0 && upload * 100 > done * max_ratio
+
+int64_t
+RatioEngine::upload_threshold(int64_t done, const settings_type& settings) {
+  int64_t min_threshold = std::max<int64_t>(settings.min_upload, 0);
+
+  if (settings.min_ratio > 0)
+    min_threshold = std::max(min_threshold, (done * settings.min_ratio + 99) / 100);
+
+  if (settings.max_ratio <= 0)
+    return min_threshold;
+
+  return std::min(min_threshold, done * settings.max_ratio / 100 + 1);
+}
+
+RatioEngine::evaluate_result
+RatioEngine::evaluate(Download* download, const settings_type& settings, int64_t* remaining) {
+  if (!download->is_seeding() || download->ignore_commands() != 0)
+    return result_ineligible;
+
+  int64_t total_done   = download->download()->bytes_done();
+  int64_t total_upload = download->info()->up_rate()->total();
+
+  *remaining = upload_threshold(total_done, settings) - total_upload;
+
+  return *remaining <= 0 ? result_crossed : result_pending;
+}
+
+RatioEngine::evaluate_result
+RatioEngine::push(group_type* group, Download* download, int64_t global_upload) {
+  int64_t remaining;
+  auto    result = evaluate(download, group->settings, &remaining);
+
+  switch (result) {
+  case result_crossed:
+    group->heap.push(download, global_upload);
+    break;
+  case result_pending:
+    group->heap.push(download, global_upload + remaining);
+    break;
+  case result_ineligible:
+    group->heap.push(download, RatioHeap::never);
+    break;
+  }
+
+  return result;
+}
+
+void
+RatioEngine::build(group_type* group, View* view) {
+  group->heap.clear();
+  group->built = true;
+
+  for (auto itr = view->begin_visible(), last = view->end_visible(); itr != last; itr++)
+    push(group, itr->get(), m_global_upload);
+}
+
+// Downloads that have crossed are kept in the heap with a key that
+// makes them be checked again on the next call, so the ratio command
+// keeps being called until it makes the download ineligible. This
+// matches the old behaviour of scanning the view.
+
+void
+RatioEngine::update(group_type* group, int64_t global_upload, download_list* crossed) {
+  for (const auto& entry : group->heap.pop_due(global_upload))
+    if (push(group, entry.download, global_upload) == result_crossed)
+      crossed->push_back(entry.download);
+}
+
+void
+RatioEngine::watch_view(View* view) {
+  if (std::find(m_watched_views.begin(), m_watched_views.end(), view->id()) != m_watched_views.end())
+    return;
+
+  m_watched_views.push_back(view->id());
+
+  view->signal_visibility().push_back([this, view_id = view->id()](Download* download, bool visible) {
+      receive_visibility(view_id, download, visible);
+    });
+}
+
+void
+RatioEngine::receive_visibility(uint32_t view_id, Download* download, bool visible) {
+  for (auto& [name, group] : m_groups) {
+    if (!group.built || group.view_id != view_id)
+      continue;
+
+    if (visible)
+      push(&group, download, m_global_upload);
+    else
+      group.heap.erase(download);
+  }
+}
+
+}
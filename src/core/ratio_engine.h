@@ -0,0 +1,137 @@
+// Keeps track of how far each seeding download in a ratio group is
+// from reaching its ratio, so that 'on_ratio' only needs to look at
+// downloads that could have crossed a threshold since the last call.
+//
+// Each group keeps a min-heap of the visible downloads of its view,
+// keyed on the value of the global upload total at which a download
+// could at the earliest reach its threshold. No download can upload
+// more than the client as a whole, so entries whose key is above the
+// current global total can safely be skipped. Downloads that aren't
+// seeding or ignore commands are kept with the key 'RatioHeap::never'.
+//
+// The heap is built from the view once, and again only when the
+// ratio settings change. After that it follows the view's visibility
+// signal, and 'update' moves a download whose state changed, which
+// is called on download events and when d.ignore_commands is set.
+//
+// The heaps hold plain pointers so they don't keep erased downloads
+// alive, 'DownloadList::erase' removes them with 'erase'.
+
+#ifndef RTORRENT_CORE_RATIO_ENGINE_H
+#define RTORRENT_CORE_RATIO_ENGINE_H
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace core {
+
+class Download;
+class View;
+
+class RatioHeap {
+public:
+  static constexpr int64_t never = std::numeric_limits<int64_t>::max();
+
+  struct entry_type {
+    Download*         download;
+    int64_t           key;
+  };
+
+  bool                empty() const                        { return m_entries.empty(); }
+  size_t              size() const                         { return m_entries.size(); }
+
+  bool                contains(Download* download) const   { return m_index.find(download) != m_index.end(); }
+
+  void                clear();
+
+  // Inserts the download, or moves it to 'key' if already present.
+  void                push(Download* download, int64_t key);
+
+  // Removes and returns the entries with a key at or below 'limit'.
+  std::vector<entry_type> pop_due(int64_t limit);
+
+  bool                erase(Download* download);
+
+private:
+  void                place(size_t pos, const entry_type& entry);
+  void                sift_up(size_t pos);
+  void                sift_down(size_t pos);
+
+  std::vector<entry_type>               m_entries;
+  std::unordered_map<Download*, size_t> m_index;
+};
+
+class RatioEngine {
+public:
+  using download_list = std::vector<Download*>;
+
+  struct settings_type {
+    int64_t min_ratio{};
+    int64_t max_ratio{};
+    int64_t min_upload{};
+
+    bool operator == (const settings_type&) const = default;
+  };
+
+  RatioEngine() = default;
+  ~RatioEngine() = default;
+
+  // Appends the downloads that reached their ratio to 'crossed',
+  // 'global_upload' is the client's total uploaded bytes.
+  void                process(const std::string& group, View* view, const settings_type& settings,
+                              int64_t global_upload, download_list* crossed);
+
+  // Moves the download in the heaps of the groups it is in, after its
+  // seeding state or d.ignore_commands changed.
+  void                update(Download* download);
+
+  void                erase(Download* download);
+
+  // False once 'download' has been erased, used as the ratio command
+  // of one download may erase others that crossed.
+  bool                is_tracked(const std::string& group, Download* download) const;
+
+  // Bytes uploaded needed for a download with 'done' bytes completed
+  // to reach its ratio.
+  static int64_t      upload_threshold(int64_t done, const settings_type& settings);
+
+private:
+  struct group_type {
+    uint32_t                view_id{};
+    settings_type           settings;
+    bool                    built{};
+    RatioHeap               heap;
+  };
+
+  enum evaluate_result {
+    result_ineligible,
+    result_crossed,
+    result_pending
+  };
+
+  static evaluate_result evaluate(Download* download, const settings_type& settings, int64_t* remaining);
+
+  // Crossed downloads get the key 'global_upload', so they are
+  // reported by the next call to 'process' of the group.
+  evaluate_result     push(group_type* group, Download* download, int64_t global_upload);
+
+  void                build(group_type* group, View* view);
+  void                update(group_type* group, int64_t global_upload, download_list* crossed);
+
+  void                watch_view(View* view);
+  void                receive_visibility(uint32_t view_id, Download* download, bool visible);
+
+  std::map<std::string, group_type> m_groups;
+  std::vector<uint32_t>             m_watched_views;
+
+  // The global upload total seen by the last call to 'process'.
+  int64_t                           m_global_upload{};
+};
+
+}
+
+#endif
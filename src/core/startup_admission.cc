@@ -0,0 +1,188 @@
+#include "config.h"
+
+#include "core/startup_admission.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <vector>
+#include <torrent/system/thread.h>
+#include <torrent/utils/log.h>
+
+namespace core {
+
+StartupAdmission::StartupAdmission() {
+  m_task_tick.slot() = [this]() { receive_tick(); };
+}
+
+StartupAdmission::~StartupAdmission() {
+  torrent::this_thread::scheduler()->erase(&m_task_tick);
+}
+
+std::chrono::seconds
+StartupAdmission::elapsed() const {
+  if (m_time_begin == std::chrono::microseconds())
+    return std::chrono::seconds();
+
+  auto last = m_active ? torrent::this_thread::cached_time() : m_time_end;
+
+  return std::chrono::duration_cast<std::chrono::seconds>(last - m_time_begin);
+}
+
+void
+StartupAdmission::begin() {
+  if (m_active)
+    return;
+
+  m_active = true;
+  m_tokens = m_resume_rate;
+
+  m_count_admitted = 0;
+  m_count_scrapes = 0;
+
+  m_time_begin = torrent::this_thread::cached_time();
+  m_time_last_queued = m_time_begin;
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_tick, std::chrono::seconds(1));
+}
+
+void
+StartupAdmission::shutdown() {
+  torrent::this_thread::scheduler()->erase(&m_task_tick);
+
+  m_queues.clear();
+  m_queued.clear();
+  m_admitted.clear();
+
+  if (m_active) {
+    m_active = false;
+    m_time_end = torrent::this_thread::cached_time();
+  }
+}
+
+bool
+StartupAdmission::admit(Download* download, int flags) {
+  if (!m_active || m_resume_rate == 0 || m_admitted.find(download) != m_admitted.end())
+    return true;
+
+  if (m_queued.find(download) == m_queued.end()) {
+    auto host = m_slot_download_host(download);
+
+    // Downloads of a host with a queue wait their turn behind it.
+    if (m_tokens != 0 && m_queues.find(host) == m_queues.end() && m_slot_try_acquire(download)) {
+      m_tokens--;
+      m_count_admitted++;
+      m_admitted.insert(download);
+      return true;
+    }
+
+    m_queues[host].emplace_back(download, flags);
+    m_queued.emplace(download, std::move(host));
+  }
+
+  m_time_last_queued = torrent::this_thread::cached_time();
+  return false;
+}
+
+void
+StartupAdmission::erase(Download* download) {
+  m_admitted.erase(download);
+
+  auto queued_itr = m_queued.find(download);
+
+  if (queued_itr == m_queued.end())
+    return;
+
+  auto  queue_itr = m_queues.find(queued_itr->second);
+  auto& queue     = queue_itr->second;
+
+  queue.erase(std::find_if(queue.begin(), queue.end(), [download](const auto& entry) { return entry.first == download; }));
+
+  if (queue.empty())
+    m_queues.erase(queue_itr);
+
+  m_queued.erase(queued_itr);
+}
+
+uint32_t
+StartupAdmission::scrape_delay(uint32_t base) {
+  if (!m_active || m_scrape_rate == 0)
+    return base;
+
+  uint32_t slot   = m_count_scrapes++ / m_scrape_rate;
+  uint32_t jitter = std::max<uint32_t>(base / 4, 1);
+
+  return base + slot + ::random() % (jitter + 1);
+}
+
+void
+StartupAdmission::receive_tick() {
+  m_tokens = m_resume_rate;
+
+  // Visit the hosts in turn starting after the one last admitted from,
+  // taking the first download of each. A host is skipped for the rest
+  // of the tick once the governor refuses it, so the tick only looks
+  // at the downloads it admits and one refused download per host.
+  std::vector<queue_map::iterator> hosts;
+  auto                             first_host = m_queues.upper_bound(m_last_host);
+
+  for (auto itr = first_host; itr != m_queues.end(); ++itr)
+    hosts.push_back(itr);
+
+  for (auto itr = m_queues.begin(); itr != first_host; ++itr)
+    hosts.push_back(itr);
+
+  queue_type ready;
+  auto       has_tokens = [this]() { return m_tokens != 0 || m_resume_rate == 0; };
+
+  while (!hosts.empty() && has_tokens()) {
+    for (auto host_itr = hosts.begin(); host_itr != hosts.end() && has_tokens(); ) {
+      auto& queue = (*host_itr)->second;
+      auto  entry = queue.front();
+
+      if (!m_slot_try_acquire(entry.first)) {
+        host_itr = hosts.erase(host_itr);
+        continue;
+      }
+
+      m_tokens -= (m_tokens != 0);
+      m_count_admitted++;
+      m_admitted.insert(entry.first);
+      m_queued.erase(entry.first);
+      m_last_host = (*host_itr)->first;
+
+      ready.push_back(entry);
+      queue.pop_front();
+
+      if (queue.empty())
+        host_itr = hosts.erase(host_itr);
+      else
+        ++host_itr;
+    }
+  }
+
+  std::erase_if(m_queues, [](const auto& itr) { return itr.second.empty(); });
+
+  // Resuming may erase or pause other admitted downloads, which
+  // removes them from 'm_admitted'.
+  for (auto [download, flags] : ready)
+    if (m_admitted.find(download) != m_admitted.end())
+      m_slot_resume_download(download, flags);
+
+  if (m_queued.empty() && torrent::this_thread::cached_time() >= m_time_last_queued + settle_time)
+    return finish();
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_tick, std::chrono::seconds(1));
+}
+
+void
+StartupAdmission::finish() {
+  m_active = false;
+  m_time_end = torrent::this_thread::cached_time();
+  m_admitted.clear();
+
+  lt_log_print(torrent::LOG_NOTICE, "startup: warm-up finished, admitted %" PRIu64 " downloads in %" PRIi64 " seconds",
+               m_count_admitted, (int64_t)elapsed().count());
+}
+
+}
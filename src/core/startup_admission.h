@@ -0,0 +1,122 @@
+// Ramps up the starting of downloads after the session has been
+// loaded, so that a large session doesn't open every file and send
+// every tracker announce and scrape at once.
+//
+// While warming up, 'DownloadList::resume' asks 'admit' whether a
+// download being loaded from the session may start, other resumes are
+// not gated. At most 'resume_rate' downloads are admitted
+// each second, the rest are queued per tracker host in the order they
+// were resumed. Once admitted, a download is let through until the
+// warm-up ends, as resuming may take several calls when hashing.
+// Downloads must also get a token from TrackerGovernor for their
+// tracker host.
+//
+// The hosts are admitted from in turn, one download at a time, so a
+// host the governor holds back doesn't stall the others.
+//
+// The warm-up ends once the queue has stayed empty for
+// 'settle_time'.
+
+#ifndef RTORRENT_CORE_STARTUP_ADMISSION_H
+#define RTORRENT_CORE_STARTUP_ADMISSION_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <torrent/system/scheduler.h>
+
+namespace core {
+
+class Download;
+
+class StartupAdmission {
+public:
+  using slot_host    = std::function<std::string (Download*)>;
+  using slot_acquire = std::function<bool (Download*)>;
+  using slot_resume  = std::function<void (Download*, int)>;
+
+  static constexpr uint32_t default_resume_rate = 100;
+  static constexpr uint32_t default_scrape_rate = 50;
+  static constexpr auto     settle_time         = std::chrono::seconds(5);
+
+  StartupAdmission();
+  ~StartupAdmission();
+
+  bool                is_active() const             { return m_active; }
+
+  // Zero disables the ramp.
+  uint32_t            resume_rate() const           { return m_resume_rate; }
+  void                set_resume_rate(uint32_t rate) { m_resume_rate = rate; }
+
+  uint32_t            scrape_rate() const           { return m_scrape_rate; }
+  void                set_scrape_rate(uint32_t rate) { m_scrape_rate = rate; }
+
+  size_t              size_queued() const           { return m_queued.size(); }
+  uint64_t            count_admitted() const        { return m_count_admitted; }
+  uint64_t            count_scrapes() const         { return m_count_scrapes; }
+
+  std::chrono::seconds elapsed() const;
+
+  // Control sets these to use TrackerGovernor and DownloadList.
+  slot_host&          slot_download_host()          { return m_slot_download_host; }
+  slot_acquire&       slot_try_acquire()            { return m_slot_try_acquire; }
+  slot_resume&        slot_resume_download()        { return m_slot_resume_download; }
+
+  void                begin();
+  void                shutdown();
+
+  // Returns false if the download was queued, it will be resumed
+  // with 'flags' once admitted.
+  bool                admit(Download* download, int flags);
+  void                erase(Download* download);
+
+  // The delay in seconds to use for the first scrape of a download
+  // instead of 'base'. While warming up the scrapes are spread out at
+  // 'scrape_rate' per second, plus a random jitter of up to a quarter
+  // of 'base' so that neighbouring slots overlap.
+  uint32_t            scrape_delay(uint32_t base);
+
+private:
+  using queue_type = std::deque<std::pair<Download*, int>>;
+  using queue_map  = std::map<std::string, queue_type>;
+
+  void                receive_tick();
+  void                finish();
+
+  bool                m_active{};
+
+  uint32_t            m_resume_rate{default_resume_rate};
+  uint32_t            m_scrape_rate{default_scrape_rate};
+  uint32_t            m_tokens{};
+
+  // The queue of each tracker host, and the host each queued download
+  // is in. 'm_last_host' is the host last admitted from.
+  queue_map                     m_queues;
+  std::unordered_map<Download*, std::string> m_queued;
+  std::string                   m_last_host;
+
+  std::unordered_set<Download*> m_admitted;
+
+  uint64_t            m_count_admitted{};
+  uint64_t            m_count_scrapes{};
+
+  std::chrono::microseconds m_time_begin{};
+  std::chrono::microseconds m_time_end{};
+  std::chrono::microseconds m_time_last_queued{};
+
+  slot_host           m_slot_download_host;
+  slot_acquire        m_slot_try_acquire;
+  slot_resume         m_slot_resume_download;
+
+  torrent::system::SchedulerEntry m_task_tick;
+};
+
+}
+
+#endif
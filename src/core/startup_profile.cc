@@ -0,0 +1,194 @@
+#include "config.h"
+
+#include "core/startup_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string_view>
+#include <unistd.h>
+#include <torrent/exceptions.h>
+
+#include "rpc/nlohmann/json.h"
+#include "globals.h"
+
+namespace core {
+
+StartupProfile::scope::scope(StartupProfile* profile, const char* category, std::string name) :
+  m_profile(profile->is_recording() ? profile : nullptr),
+  m_category(category) {
+
+  if (m_profile == nullptr)
+    return;
+
+  m_name  = std::move(name);
+  m_start = m_profile->m_now();
+}
+
+StartupProfile::scope::~scope() {
+  if (m_profile == nullptr || !m_profile->is_recording())
+    return;
+
+  m_profile->insert(m_category, std::move(m_name), m_start, m_profile->m_now());
+}
+
+StartupProfile::StartupProfile(time_func now) :
+  m_now(std::move(now)),
+  m_start(m_now()) {
+}
+
+std::chrono::microseconds
+StartupProfile::steady_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now().time_since_epoch());
+}
+
+std::chrono::microseconds
+StartupProfile::elapsed() const {
+  return (m_finished ? m_finish : m_now()) - m_start;
+}
+
+void
+StartupProfile::erase_pending_load() {
+  if (m_pending_loads == 0)
+    throw torrent::internal_error("StartupProfile::erase_pending_load() called with no pending loads.");
+
+  m_pending_loads--;
+  try_finish();
+}
+
+void
+StartupProfile::set_startup_done() {
+  m_startup_done = true;
+  try_finish();
+}
+
+void
+StartupProfile::insert(const char* category, std::string name, std::chrono::microseconds start, std::chrono::microseconds end) {
+  if (m_spans.size() >= max_spans) {
+    m_dropped++;
+    return;
+  }
+
+  m_spans.push_back(span_type{category, std::move(name), start - m_start, end - start});
+}
+
+void
+StartupProfile::try_finish() {
+  if (m_finished || !m_startup_done || m_pending_loads != 0)
+    return;
+
+  m_finished = true;
+  m_finish   = m_now();
+}
+
+// Phases are listed by name, everything else is totalled per category
+// with the slowest spans listed separately.
+
+torrent::Object
+StartupProfile::summary() const {
+  auto  result     = torrent::Object::create_map();
+  auto& phases     = result.insert_key("phases", torrent::Object::create_map()).as_map();
+  auto& categories = result.insert_key("categories", torrent::Object::create_map()).as_map();
+  auto& slowest    = result.insert_key("slowest", torrent::Object::create_list()).as_list();
+
+  result.insert_key("finished",     (int64_t)m_finished);
+  result.insert_key("elapsed_usec", (int64_t)elapsed().count());
+  result.insert_key("spans",        (int64_t)m_spans.size());
+  result.insert_key("dropped",      (int64_t)m_dropped);
+
+  struct category_type {
+    int64_t count{};
+    int64_t total{};
+    int64_t max{};
+  };
+
+  std::map<std::string, category_type> totals;
+  std::vector<const span_type*>        entries;
+
+  for (const auto& span : m_spans) {
+    if (std::string_view(span.category) == "phase") {
+      phases[span.name] = (int64_t)span.duration.count();
+      continue;
+    }
+
+    auto& category = totals[span.category];
+
+    category.count++;
+    category.total += span.duration.count();
+    category.max = std::max<int64_t>(category.max, span.duration.count());
+
+    entries.push_back(&span);
+  }
+
+  for (const auto& [name, category] : totals) {
+    auto& entry = (categories[name] = torrent::Object::create_map()).as_map();
+
+    entry["count"]      = category.count;
+    entry["total_usec"] = category.total;
+    entry["max_usec"]   = category.max;
+  }
+
+  auto middle = entries.begin() + std::min(summary_slowest, entries.size());
+
+  std::partial_sort(entries.begin(), middle, entries.end(), [](auto a, auto b) {
+      return a->duration > b->duration;
+    });
+
+  std::for_each(entries.begin(), middle, [&slowest](auto span) {
+      auto& entry = slowest.insert(slowest.end(), torrent::Object::create_map())->as_map();
+
+      entry["category"]      = std::string(span->category);
+      entry["name"]          = span->name;
+      entry["start_usec"]    = (int64_t)span->start.count();
+      entry["duration_usec"] = (int64_t)span->duration.count();
+    });
+
+  return result;
+}
+
+// Complete ("X") events in the Chrome trace event format, as everything
+// is recorded in the main thread they all share the same tid and nest
+// by time.
+
+std::string
+StartupProfile::trace_events() const {
+  auto events = nlohmann::json::array();
+  auto pid    = (int64_t)::getpid();
+
+  for (const auto& span : m_spans)
+    events.push_back({{"name", span.name},
+                      {"cat",  span.category},
+                      {"ph",   "X"},
+                      {"ts",   span.start.count()},
+                      {"dur",  span.duration.count()},
+                      {"pid",  pid},
+                      {"tid",  1}});
+
+  nlohmann::json trace = {{"traceEvents", std::move(events)},
+                          {"displayTimeUnit", "ms"}};
+
+  return trace.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+void
+StartupProfile::write_trace(const std::string& path) const {
+  auto filename     = expand_path(path);
+  auto filename_tmp = filename + ".new";
+  auto trace_file   = std::fstream(filename_tmp.c_str(), std::ios::out | std::ios::trunc);
+
+  if (!trace_file.is_open())
+    throw torrent::input_error("Could not open startup trace file: " + filename_tmp);
+
+  trace_file << trace_events();
+
+  if (!trace_file.good())
+    throw torrent::input_error("Could not write startup trace file: " + filename_tmp);
+
+  trace_file.close();
+
+  if (::rename(filename_tmp.c_str(), filename.c_str()) == -1)
+    throw torrent::input_error("Could not rename startup trace file: " + filename);
+}
+
+}
@@ -0,0 +1,108 @@
+// Records how long each part of startup takes, so that slow restarts
+// can be pinned on a phase, a config file, a session torrent or an
+// 'event.system.startup_done' handler.
+//
+// Spans are recorded from the creation of Control until startup is
+// done and every torrent queued for loading at startup has been
+// created, as those are loaded by the main loop. After that 'scope'
+// does nothing.
+//
+// The spans are summarized by 'system.startup.profile', and can be
+// written as Chrome trace events for chrome://tracing or Perfetto.
+//
+// Times are taken from a steady clock rather than the cached time, as
+// the latter isn't updated while the config is being loaded. Tests
+// pass their own time source.
+
+#ifndef RTORRENT_CORE_STARTUP_PROFILE_H
+#define RTORRENT_CORE_STARTUP_PROFILE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <torrent/object.h>
+
+namespace core {
+
+class StartupProfile {
+public:
+  using clock_type = std::chrono::steady_clock;
+  using time_func  = std::function<std::chrono::microseconds ()>;
+
+  struct span_type {
+    const char*               category;
+    std::string               name;
+    std::chrono::microseconds start;
+    std::chrono::microseconds duration;
+  };
+
+  using span_list = std::vector<span_type>;
+
+  // Large sessions create a couple of spans per torrent, spans past
+  // this are only counted.
+  static constexpr size_t max_spans = 1 << 17;
+
+  // The number of spans listed under 'slowest' in the summary.
+  static constexpr size_t summary_slowest = 10;
+
+  // Records a span for the lifetime of the object. The 'category'
+  // must be a string literal.
+  class scope {
+  public:
+    scope(StartupProfile* profile, const char* category, std::string name);
+    ~scope();
+
+    scope(const scope&) = delete;
+    scope& operator = (const scope&) = delete;
+
+  private:
+    StartupProfile*           m_profile;
+    const char*               m_category;
+    std::string               m_name;
+    std::chrono::microseconds m_start{};
+  };
+
+  StartupProfile(time_func now = &steady_time);
+
+  static std::chrono::microseconds steady_time();
+
+  bool                is_recording() const          { return !m_finished; }
+
+  const span_list&    spans() const                 { return m_spans; }
+  size_t              count_dropped() const         { return m_dropped; }
+
+  std::chrono::microseconds elapsed() const;
+
+  // Torrents loaded at startup are created by the main loop, so the
+  // profile is kept open until all of them have finished.
+  void                insert_pending_load()         { m_pending_loads++; }
+  void                erase_pending_load();
+
+  void                set_startup_done();
+
+  torrent::Object     summary() const;
+
+  std::string         trace_events() const;
+  void                write_trace(const std::string& path) const;
+
+private:
+  void                insert(const char* category, std::string name, std::chrono::microseconds start, std::chrono::microseconds end);
+  void                try_finish();
+
+  time_func                 m_now;
+  std::chrono::microseconds m_start;
+  std::chrono::microseconds m_finish{};
+
+  bool                m_startup_done{};
+  bool                m_finished{};
+  uint32_t            m_pending_loads{};
+
+  span_list           m_spans;
+  size_t              m_dropped{};
+};
+
+}
+
+#endif
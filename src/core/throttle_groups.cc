@@ -0,0 +1,233 @@
+#include "config.h"
+
+#include "core/throttle_groups.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <torrent/exceptions.h>
+#include <torrent/rate.h>
+#include <torrent/throttle.h>
+#include <torrent/torrent.h>
+
+namespace core {
+
+void
+ThrottleGroups::history_type::push(uint32_t rate) {
+  samples[next] = rate;
+  next = (next + 1) % history_size;
+  size = std::min(size + 1, history_size);
+}
+
+uint32_t
+ThrottleGroups::history_type::peak() const {
+  return size == 0 ? 0 : *std::max_element(samples.begin(), samples.begin() + size);
+}
+
+uint32_t
+ThrottleGroups::history_type::average() const {
+  return size == 0 ? 0 : std::accumulate(samples.begin(), samples.begin() + size, uint64_t()) / size;
+}
+
+// Oldest sample first.
+
+torrent::Object
+ThrottleGroups::history_type::to_list() const {
+  auto  raw_result = torrent::Object::create_list();
+  auto& result     = raw_result.as_list();
+
+  for (size_t i = 0; i != size; i++)
+    result.push_back((int64_t)samples[(next + history_size - size + i) % history_size]);
+
+  return raw_result;
+}
+
+ThrottleGroups::ThrottleGroups(throttle_map* throttles) :
+  m_throttles(throttles) {
+
+  m_task_sample.slot() = [this]() { receive_sample(); };
+}
+
+ThrottleGroups::~ThrottleGroups() {
+  torrent::this_thread::scheduler()->erase(&m_task_sample);
+}
+
+ThrottleGroups::id_type
+ThrottleGroups::find(const std::string& name) const {
+  auto itr = m_index.find(name);
+
+  return itr != m_index.end() ? itr->second : invalid_id;
+}
+
+ThrottleGroups::id_type
+ThrottleGroups::find_throw(const std::string& name) const {
+  auto id = find(name);
+
+  if (id == invalid_id)
+    throw torrent::input_error("Could not find throttle group '" + name + "'.");
+
+  return id;
+}
+
+ThrottleGroups::id_type
+ThrottleGroups::insert_fixed(const std::string& name, torrent::Throttle* up, torrent::Throttle* down) {
+  if (m_index.find(name) != m_index.end())
+    throw torrent::internal_error("ThrottleGroups::insert_fixed(...) group already exists.");
+
+  id_type id = m_groups.size();
+
+  m_groups.push_back(group_type{name, invalid_id, 0, true, up, down});
+  m_index.emplace(name, id);
+
+  update_map(id);
+  return id;
+}
+
+ThrottleGroups::id_type
+ThrottleGroups::insert(const std::string& name, id_type parent) {
+  if (name.empty() || m_index.find(name) != m_index.end())
+    throw torrent::input_error("Invalid or duplicate throttle group name '" + name + "'.");
+
+  uint32_t depth = 0;
+
+  if (parent != invalid_id) {
+    if (parent >= m_groups.size() || m_groups[parent].fixed)
+      throw torrent::input_error("Invalid parent for throttle group '" + name + "'.");
+
+    depth = m_groups[parent].depth + 1;
+
+    if (depth >= max_depth)
+      throw torrent::input_error("Throttle group '" + name + "' is nested too deep.");
+  }
+
+  id_type id = m_groups.size();
+
+  m_groups.push_back(group_type{name, parent, depth});
+  m_index.emplace(name, id);
+
+  update_map(id);
+
+  if (!m_task_sample.is_scheduled())
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_sample, history_interval);
+
+  return id;
+}
+
+ThrottleGroups::id_type
+ThrottleGroups::find_or_insert(const std::string& name) {
+  auto id = find(name);
+
+  return id != invalid_id ? id : insert(name, invalid_id);
+}
+
+torrent::Throttle*
+ThrottleGroups::throttle(id_type id, bool up) const {
+  const auto& group = m_groups.at(id);
+
+  return up ? group.up : group.down;
+}
+
+torrent::Throttle*
+ThrottleGroups::find_throttle(const std::string& name, bool up) const {
+  auto id = find(name);
+
+  return id != invalid_id ? throttle(id, up) : nullptr;
+}
+
+torrent::Throttle*
+ThrottleGroups::create_throttle(id_type id, bool up) {
+  auto& group    = m_groups.at(id);
+  auto& throttle = up ? group.up : group.down;
+
+  if (throttle != nullptr)
+    return throttle;
+
+  torrent::Throttle* parent;
+
+  if (group.parent != invalid_id)
+    parent = create_throttle(group.parent, up);
+  else
+    parent = up ? torrent::up_throttle_global() : torrent::down_throttle_global();
+
+  // Parents that only exist for their children don't limit anything.
+  throttle = parent->create_slave();
+  throttle->set_max_rate(0);
+
+  update_map(id);
+  return throttle;
+}
+
+torrent::Object
+ThrottleGroups::group_info(id_type id) const {
+  const auto& group = m_groups.at(id);
+
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["id"]        = (int64_t)id;
+  result["name"]      = group.name;
+  result["parent"]    = group.parent != invalid_id ? m_groups[group.parent].name : std::string();
+  result["parent_id"] = group.parent != invalid_id ? (int64_t)group.parent : (int64_t)-1;
+  result["depth"]     = (int64_t)group.depth;
+
+  result["up_max"]    = group.up != nullptr ? (int64_t)group.up->max_rate() : (int64_t)-1;
+  result["up_rate"]   = group.up != nullptr ? (int64_t)group.up->rate()->rate() : (int64_t)0;
+  result["down_max"]  = group.down != nullptr ? (int64_t)group.down->max_rate() : (int64_t)-1;
+  result["down_rate"] = group.down != nullptr ? (int64_t)group.down->rate()->rate() : (int64_t)0;
+
+  return raw_result;
+}
+
+torrent::Object
+ThrottleGroups::group_stats(id_type id) const {
+  const auto& group = m_groups.at(id);
+
+  auto  raw_result = torrent::Object::create_map();
+  auto& result     = raw_result.as_map();
+
+  result["id"]       = (int64_t)id;
+  result["name"]     = group.name;
+  result["interval"] = (int64_t)history_interval.count();
+
+  for (auto [key, history, throttle] : {std::make_tuple("up", &group.up_history, group.up),
+                                        std::make_tuple("down", &group.down_history, group.down)}) {
+    auto& entry = (result[key] = torrent::Object::create_map()).as_map();
+
+    entry["current"] = throttle != nullptr ? (int64_t)throttle->rate()->rate() : (int64_t)0;
+    entry["average"] = (int64_t)history->average();
+    entry["peak"]    = (int64_t)history->peak();
+    entry["samples"] = history->to_list();
+  }
+
+  return raw_result;
+}
+
+// Groups without throttles would otherwise show up as unthrottled
+// entries when cycling through the throttles in the UI.
+
+void
+ThrottleGroups::update_map(id_type id) {
+  const auto& group = m_groups[id];
+
+  if (group.up == nullptr && group.down == nullptr) {
+    m_throttles->erase(group.name);
+    return;
+  }
+
+  (*m_throttles)[group.name] = std::make_pair(group.up, group.down);
+}
+
+void
+ThrottleGroups::receive_sample() {
+  for (auto& group : m_groups) {
+    if (group.fixed)
+      continue;
+
+    group.up_history.push(group.up != nullptr ? group.up->rate()->rate() : 0);
+    group.down_history.push(group.down != nullptr ? group.down->rate()->rate() : 0);
+  }
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_sample, history_interval);
+}
+
+}
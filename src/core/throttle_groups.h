@@ -0,0 +1,116 @@
+// Named throttle groups, which may be nested. A group's throttles are
+// slaves of its parent's throttles, or of the global throttles for
+// top-level groups, so a site can be limited as a whole while tracker
+// classes and labels under it get their own limits.
+//
+// Groups are given a stable id when created, which downloads keep so
+// that per-group lookups don't need the name. The throttles of a
+// group are created once a rate is first set, creating any missing
+// parent throttles as unlimited.
+//
+// Every 'history_interval' the current up and down rates of each
+// group are recorded, keeping the last 'history_size' samples.
+
+#ifndef RTORRENT_CORE_THROTTLE_GROUPS_H
+#define RTORRENT_CORE_THROTTLE_GROUPS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <torrent/common.h>
+#include <torrent/object.h>
+#include <torrent/system/scheduler.h>
+
+namespace core {
+
+class ThrottleGroups {
+public:
+  using id_type = uint32_t;
+
+  static constexpr id_type invalid_id       = ~id_type();
+  static constexpr size_t  history_size     = 60;
+  static constexpr auto    history_interval = std::chrono::seconds(10);
+
+  struct history_type {
+    std::array<uint32_t, history_size> samples{};
+
+    size_t            next{};
+    size_t            size{};
+
+    void              push(uint32_t rate);
+
+    uint32_t          peak() const;
+    uint32_t          average() const;
+    torrent::Object   to_list() const;
+  };
+
+  struct group_type {
+    std::string        name;
+    id_type            parent{invalid_id};
+    uint32_t           depth{};
+    bool               fixed{};
+
+    torrent::Throttle* up{};
+    torrent::Throttle* down{};
+
+    history_type       up_history;
+    history_type       down_history;
+  };
+
+  using throttle_map = std::map<std::string, std::pair<torrent::Throttle*, torrent::Throttle*>>;
+
+  // Nesting is limited to keep throttle updates cheap.
+  static constexpr uint32_t max_depth = 8;
+
+  // The throttle map is kept in sync with the groups that have
+  // throttles, for the UI code that looks throttles up by name.
+  ThrottleGroups(throttle_map* throttles);
+  ~ThrottleGroups();
+
+  size_t              size() const                  { return m_groups.size(); }
+
+  id_type             find(const std::string& name) const;
+  id_type             find_throw(const std::string& name) const;
+
+  const group_type&   at(id_type id) const          { return m_groups.at(id); }
+
+  // Inserts a group with fixed throttles, such as the unthrottled
+  // 'NULL' group, that can't be a parent.
+  id_type             insert_fixed(const std::string& name, torrent::Throttle* up, torrent::Throttle* down);
+
+  // Throws input_error if the name is taken or the parent is invalid.
+  id_type             insert(const std::string& name, id_type parent);
+
+  // Inserts a top-level group if none exists with the name.
+  id_type             find_or_insert(const std::string& name);
+
+  torrent::Throttle*  throttle(id_type id, bool up) const;
+
+  // Returns nullptr if there is no such group or it has no throttle.
+  torrent::Throttle*  find_throttle(const std::string& name, bool up) const;
+  torrent::Throttle*  create_throttle(id_type id, bool up);
+
+  torrent::Object     group_info(id_type id) const;
+  torrent::Object     group_stats(id_type id) const;
+
+private:
+  void                update_map(id_type id);
+
+  void                receive_sample();
+
+  throttle_map*       m_throttles;
+
+  std::vector<group_type>                  m_groups;
+  std::unordered_map<std::string, id_type> m_index;
+
+  torrent::system::SchedulerEntry m_task_sample;
+};
+
+}
+
+#endif
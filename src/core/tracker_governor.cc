@@ -0,0 +1,350 @@
+#include "config.h"
+
+#include "core/tracker_governor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <torrent/tracker/tracker.h>
+
+#include "core/download.h"
+
+namespace core {
+
+TrackerGovernor::TrackerGovernor() {
+  m_task_tick.slot() = [this]() { receive_tick(); };
+}
+
+TrackerGovernor::~TrackerGovernor() {
+  torrent::this_thread::scheduler()->erase(&m_task_tick);
+}
+
+size_t
+TrackerGovernor::size_queued() const {
+  size_t result = 0;
+
+  for (const auto& [host, entry] : m_hosts)
+    result += entry.queue.size();
+
+  return result;
+}
+
+size_t
+TrackerGovernor::size_queued(const std::string& host) const {
+  auto itr = m_hosts.find(host);
+
+  return itr != m_hosts.end() ? itr->second.queue.size() : 0;
+}
+
+size_t
+TrackerGovernor::size_active(const std::string& host) const {
+  auto itr = m_hosts.find(host);
+
+  return itr != m_hosts.end() ? itr->second.active.size() : 0;
+}
+
+std::string
+TrackerGovernor::url_host(const std::string& url) {
+  auto scheme_end = url.find("://");
+
+  if (scheme_end == std::string::npos)
+    return std::string();
+
+  auto scheme = url.substr(0, scheme_end);
+
+  if (scheme != "http" && scheme != "https" && scheme != "udp")
+    return std::string();
+
+  auto first = scheme_end + 3;
+  auto last  = std::min(url.find_first_of("/?#", first), url.size());
+  auto at    = url.rfind('@', last);
+
+  if (at != std::string::npos && at >= first)
+    first = at + 1;
+
+  if (first < last && url[first] == '[')
+    last = std::min(url.find(']', first) + 1, last);
+  else
+    last = std::min(url.find(':', first), last);
+
+  std::string result = url.substr(first, last - first);
+  std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return std::tolower(c); });
+
+  return result;
+}
+
+std::string
+TrackerGovernor::download_host(Download* download) {
+  auto tracker = download->tracker_controller().find_if([](const auto& t) {
+      return t.is_usable() && !url_host(t.url()).empty();
+    });
+
+  return tracker.is_valid() ? url_host(tracker.url()) : std::string();
+}
+
+bool
+TrackerGovernor::try_acquire(Download* download) {
+  if (!m_active || !is_governed())
+    return true;
+
+  auto host = download_host(download);
+
+  if (host.empty())
+    return true;
+
+  auto& entry = host_entry(host);
+  auto  now   = torrent::this_thread::cached_time();
+
+  update_active(host, &entry);
+  entry.refill(now, m_rate);
+
+  if (!entry.has_capacity(request_resume, m_rate, m_max_active))
+    return false;
+
+  entry.take_token(request_type{download, request_resume, 0}, now);
+  schedule_tick();
+  return true;
+}
+
+// Each host gets its own request, which only enables the trackers on
+// that host. Trackers without a governed host, such as DHT, are
+// enabled right away.
+
+void
+TrackerGovernor::enable(Download* download) {
+  std::set<std::string> hosts;
+
+  download->tracker_controller().for_each([&hosts](auto& tracker) {
+      hosts.insert(url_host(tracker.url()));
+    });
+
+  for (const auto& host : hosts)
+    push(host, request_type{download, request_enable, 0});
+}
+
+void
+TrackerGovernor::disable(Download* download) {
+  for (auto& [host, entry] : m_hosts)
+    entry.queue.erase(std::remove_if(entry.queue.begin(), entry.queue.end(), [download](const auto& request) {
+        return request.download == download && request.kind == request_enable;
+      }), entry.queue.end());
+
+  download->tracker_controller().for_each([](auto& tracker) { tracker.disable(); });
+}
+
+void
+TrackerGovernor::scrape(Download* download, uint32_t delay) {
+  push(download_host(download), request_type{download, request_scrape, delay});
+}
+
+void
+TrackerGovernor::erase(Download* download) {
+  for (auto& [host, entry] : m_hosts) {
+    entry.queue.erase(std::remove_if(entry.queue.begin(), entry.queue.end(), [download](const auto& request) {
+        return request.download == download;
+      }), entry.queue.end());
+
+    entry.active.erase(std::remove_if(entry.active.begin(), entry.active.end(), [download](const auto& active) {
+        return active.download == download;
+      }), entry.active.end());
+  }
+}
+
+void
+TrackerGovernor::shutdown() {
+  m_active = false;
+
+  torrent::this_thread::scheduler()->erase(&m_task_tick);
+  m_hosts.clear();
+}
+
+torrent::Object
+TrackerGovernor::hosts() const {
+  auto  raw_result = torrent::Object::create_list();
+  auto& result     = raw_result.as_list();
+
+  for (const auto& [host, entry] : m_hosts) {
+    auto& map = result.insert(result.end(), torrent::Object::create_map())->as_map();
+
+    map["host"]    = host;
+    map["queued"]  = (int64_t)entry.queue.size();
+    map["active"]  = (int64_t)entry.active.size();
+    map["sent"]    = (int64_t)entry.count_sent;
+    map["delayed"] = (int64_t)entry.count_queued;
+  }
+
+  return raw_result;
+}
+
+void
+TrackerGovernor::host_type::refill(std::chrono::microseconds now, uint32_t rate) {
+  if (refill_time != std::chrono::microseconds() && now < refill_time + std::chrono::seconds(1))
+    return;
+
+  tokens      = rate;
+  refill_time = now;
+}
+
+bool
+TrackerGovernor::host_type::has_capacity(request_kind kind, uint32_t rate, uint32_t max_active) const {
+  if (rate != 0 && tokens == 0)
+    return false;
+
+  return kind == request_scrape || max_active == 0 || active.size() < max_active;
+}
+
+void
+TrackerGovernor::host_type::take_token(const request_type& request, std::chrono::microseconds now) {
+  tokens -= (tokens != 0);
+  count_sent++;
+
+  if (request.kind != request_scrape)
+    active.push_back(active_type{request.download, now});
+}
+
+bool
+TrackerGovernor::host_type::push(const request_type& request) {
+  auto itr = std::find_if(queue.begin(), queue.end(), [&request](const auto& queued) {
+      return queued.download == request.download && queued.kind == request.kind;
+    });
+
+  if (itr != queue.end()) {
+    itr->delay = request.delay;
+    return false;
+  }
+
+  queue.push_back(request);
+  count_queued++;
+  return true;
+}
+
+std::vector<TrackerGovernor::request_type>
+TrackerGovernor::host_type::pop_ready(std::chrono::microseconds now, uint32_t rate, uint32_t max_active) {
+  std::vector<request_type> result;
+
+  while (!queue.empty() && has_capacity(queue.front().kind, rate, max_active)) {
+    result.push_back(queue.front());
+    queue.pop_front();
+
+    take_token(result.back(), now);
+  }
+
+  return result;
+}
+
+bool
+TrackerGovernor::host_type::is_idle(std::chrono::microseconds now) const {
+  return queue.empty() && active.empty() && now >= refill_time + std::chrono::seconds(1);
+}
+
+TrackerGovernor::host_type&
+TrackerGovernor::host_entry(const std::string& host) {
+  auto [itr, inserted] = m_hosts.try_emplace(host);
+
+  if (inserted)
+    itr->second.refill(torrent::this_thread::cached_time(), m_rate);
+
+  return itr->second;
+}
+
+void
+TrackerGovernor::push(const std::string& host, request_type request) {
+  if (!m_active)
+    return;
+
+  if (host.empty() || !is_governed()) {
+    send(host, request);
+    return;
+  }
+
+  auto& entry = host_entry(host);
+  auto  now   = torrent::this_thread::cached_time();
+
+  update_active(host, &entry);
+  entry.refill(now, m_rate);
+
+  if (entry.queue.empty() && entry.has_capacity(request.kind, m_rate, m_max_active)) {
+    entry.take_token(request, now);
+    send(host, request);
+    schedule_tick();
+    return;
+  }
+
+  if (entry.push(request))
+    schedule_tick();
+}
+
+void
+TrackerGovernor::send(const std::string& host, const request_type& request) {
+  switch (request.kind) {
+  case request_enable:
+    request.download->tracker_controller().for_each([&host](auto& tracker) {
+        if (url_host(tracker.url()) == host)
+          tracker.enable();
+      });
+    break;
+  case request_scrape:
+    request.download->tracker_controller().scrape_request(request.delay);
+    break;
+  case request_resume:
+    break;
+  }
+}
+
+// A request stays active until none of the download's trackers on the
+// host are busy, giving the tracker a second to start the request.
+
+void
+TrackerGovernor::update_active(const std::string& host, host_type* entry) {
+  auto now = torrent::this_thread::cached_time();
+
+  entry->active.erase(std::remove_if(entry->active.begin(), entry->active.end(), [&host, now](const auto& active) {
+      if (now >= active.time + active_timeout)
+        return true;
+
+      if (now < active.time + std::chrono::seconds(1))
+        return false;
+
+      auto tracker = active.download->tracker_controller().find_if([&host](const auto& t) {
+          return t.is_requesting() && url_host(t.url()) == host;
+        });
+
+      return !tracker.is_valid();
+    }), entry->active.end());
+}
+
+void
+TrackerGovernor::receive_tick() {
+  auto now = torrent::this_thread::cached_time();
+
+  for (auto& [host, entry] : m_hosts) {
+    update_active(host, &entry);
+
+    if (entry.queue.empty())
+      continue;
+
+    entry.refill(now, m_rate);
+
+    // Sending may not erase downloads, so the queue is only modified
+    // here.
+    for (const auto& request : entry.pop_ready(now, m_rate, m_max_active))
+      send(host, request);
+  }
+
+  std::erase_if(m_hosts, [now](const auto& itr) { return itr.second.is_idle(now); });
+
+  schedule_tick();
+}
+
+// Ticks continue while any host is known, so that idle hosts are
+// pruned.
+
+void
+TrackerGovernor::schedule_tick() {
+  if (!m_active || m_task_tick.is_scheduled() || m_hosts.empty())
+    return;
+
+  torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_tick, std::chrono::seconds(1));
+}
+
+}
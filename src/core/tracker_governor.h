@@ -0,0 +1,155 @@
+// Limits how fast tracker requests rtorrent initiates are sent to
+// each tracker host, so that mass enables and the scrapes and resumes
+// done at startup don't hit a tracker with thousands of requests at
+// once.
+//
+// Each host has a token bucket refilled with 'rate' tokens every
+// second, and at most 'max_active' downloads may have requests to the
+// host in progress. Requests that can't be sent right away are queued
+// per host in the order they were made, with at most one request of
+// each kind per download, and are sent as tokens become available.
+//
+// Only enables and resumes, which trigger announces, count towards
+// 'max_active'. Scrapes are usually delayed and only use tokens.
+//
+// Announces libtorrent schedules itself, such as the regular
+// interval announces, are not governed. Both limits are off by default.
+//
+// Hosts with nothing queued or active are forgotten once their bucket
+// would be full again.
+
+#ifndef RTORRENT_CORE_TRACKER_GOVERNOR_H
+#define RTORRENT_CORE_TRACKER_GOVERNOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <torrent/object.h>
+#include <torrent/system/scheduler.h>
+
+namespace core {
+
+class Download;
+
+class TrackerGovernor {
+public:
+  static constexpr uint32_t default_rate       = 0;
+  static constexpr uint32_t default_max_active = 0;
+
+  // Active requests are forgotten after this long, in case the
+  // tracker never reports being busy.
+  static constexpr auto     active_timeout     = std::chrono::seconds(60);
+
+  enum request_kind {
+    request_enable,
+    request_resume,
+    request_scrape
+  };
+
+  struct request_type {
+    Download*         download;
+    request_kind      kind;
+    uint32_t          delay;
+  };
+
+  struct active_type {
+    Download*                 download;
+    std::chrono::microseconds time;
+  };
+
+  // The token bucket and queue of a host. Downloads are only used as
+  // keys here, so this can be tested on its own.
+  struct host_type {
+    std::deque<request_type> queue;
+    std::vector<active_type> active;
+
+    uint32_t                  tokens{};
+    std::chrono::microseconds refill_time{};
+
+    uint64_t                  count_sent{};
+    uint64_t                  count_queued{};
+
+    void              refill(std::chrono::microseconds now, uint32_t rate);
+    bool              has_capacity(request_kind kind, uint32_t rate, uint32_t max_active) const;
+    void              take_token(const request_type& request, std::chrono::microseconds now);
+
+    // Returns false if the download already has a request of the same
+    // kind queued, which then gets the new delay.
+    bool              push(const request_type& request);
+
+    // Takes a token for each queued request in order, stopping at the
+    // first one there is no capacity for.
+    std::vector<request_type> pop_ready(std::chrono::microseconds now, uint32_t rate, uint32_t max_active);
+
+    bool              is_idle(std::chrono::microseconds now) const;
+  };
+
+  TrackerGovernor();
+  ~TrackerGovernor();
+
+  // Zero disables the limit.
+  uint32_t            rate() const                  { return m_rate; }
+  void                set_rate(uint32_t rate)       { m_rate = rate; }
+
+  uint32_t            max_active() const            { return m_max_active; }
+  void                set_max_active(uint32_t max)  { m_max_active = max; }
+
+  size_t              size_queued() const;
+  size_t              size_queued(const std::string& host) const;
+  size_t              size_active(const std::string& host) const;
+
+  // Returns the lowercase host name of http and udp tracker urls, or
+  // an empty string for anything else.
+  static std::string  url_host(const std::string& url);
+
+  // The host of the first usable tracker of the download.
+  static std::string  download_host(Download* download);
+
+  // Takes a token for the download's host, returns false if there is
+  // none available. Used for resumes, which are queued elsewhere.
+  bool                try_acquire(Download* download);
+
+  // Enables the download's trackers, host by host as permitted.
+  void                enable(Download* download);
+  void                disable(Download* download);
+
+  // Calls 'scrape_request(delay)' once permitted, the delay still
+  // applies after that.
+  void                scrape(Download* download, uint32_t delay);
+
+  void                erase(Download* download);
+  void                shutdown();
+
+  torrent::Object     hosts() const;
+
+private:
+  using host_map = std::map<std::string, host_type>;
+
+  bool                is_governed() const           { return m_rate != 0 || m_max_active != 0; }
+
+  host_type&          host_entry(const std::string& host);
+
+  void                push(const std::string& host, request_type request);
+  void                send(const std::string& host, const request_type& request);
+
+  void                update_active(const std::string& host, host_type* entry);
+
+  void                receive_tick();
+  void                schedule_tick();
+
+  uint32_t            m_rate{default_rate};
+  uint32_t            m_max_active{default_max_active};
+
+  bool                m_active{true};
+
+  host_map            m_hosts;
+
+  torrent::system::SchedulerEntry m_task_tick;
+};
+
+}
+
+#endif
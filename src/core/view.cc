@@ -2,13 +2,17 @@
 
 #include <algorithm>
 #include <functional>
+#include <thread>
 #include <torrent/download.h>
+#include <torrent/rate.h>
+#include <torrent/data/file_list.h>
 #include <torrent/exceptions.h>
 
 #include "control.h"
 #include "download.h"
 #include "download_list.h"
 #include "manager.h"
+#include "parallel_pool.h"
 #include "rpc/object_storage.h"
 #include "rpc/parse_commands.h"
 #include "view.h"
@@ -22,9 +26,11 @@ entry_is(Download* download) {
   return [download](const std::shared_ptr<Download>& entry) { return entry.get() == download; };
 }
 
+// When 'errors' is set, error messages are stored there instead of
+// being logged, as the log is only written to from the main thread.
 struct view_downloads_compare {
-  view_downloads_compare(const torrent::Object& cmd) :
-      m_command(cmd) {}
+  view_downloads_compare(const torrent::Object& cmd, std::vector<std::string>* errors = nullptr) :
+      m_command(cmd), m_errors(errors) {}
 
   bool operator()(const std::shared_ptr<Download>& d1, const std::shared_ptr<Download>& d2) const {
     return (*this)(d1.get(), d2.get());
@@ -51,18 +57,22 @@ struct view_downloads_compare {
       return rpc::commands.call_command(m_command.as_dict_key().c_str(), m_command.as_dict_obj(), rpc::make_target_pair(d1, d2)).as_value();
 
     } catch (torrent::input_error& e) {
-      control->core()->push_log(e.what());
+      if (m_errors != nullptr)
+        m_errors->push_back(e.what());
+      else
+        control->core()->push_log(e.what());
 
       return false;
     }
   }
 
-  const torrent::Object& m_command;
+  const torrent::Object&    m_command;
+  std::vector<std::string>* m_errors;
 };
 
 struct view_downloads_filter {
-  view_downloads_filter(const torrent::Object& cmd, const torrent::Object& cmd2) :
-      m_command(cmd), m_command2(cmd2) {}
+  view_downloads_filter(const torrent::Object& cmd, const torrent::Object& cmd2, std::vector<std::string>* errors = nullptr) :
+      m_command(cmd), m_command2(cmd2), m_errors(errors) {}
 
   bool operator()(const std::shared_ptr<Download>& d1) const {
     return (*this)(d1.get());
@@ -115,16 +125,132 @@ struct view_downloads_filter {
       return true;
 
     } catch (torrent::input_error& e) {
-      control->core()->push_log(e.what());
+      if (m_errors != nullptr)
+        m_errors->push_back(e.what());
+      else
+        control->core()->push_log(e.what());
 
       return false;
     }
   }
 
-  const torrent::Object& m_command;
-  const torrent::Object& m_command2;
+  const torrent::Object&    m_command;
+  const torrent::Object&    m_command2;
+  std::vector<std::string>* m_errors;
 };
 
+// Views smaller than this are always filtered and sorted in the main
+// thread, as handing the chunks to the pool would cost more than it
+// saves.
+constexpr size_t view_parallel_min_size = 1024;
+constexpr size_t view_parallel_min_chunk = 256;
+
+unsigned View::m_parallel_threads = 1;
+
+// Returns the number of threads to use for evaluating 'cmd' and
+// 'cmd2' on 'size' downloads, or one if it must be done serially.
+// Profiling is not thread safe and so also disables threading.
+static unsigned
+view_parallel_threads(size_t size, const torrent::Object& cmd, const torrent::Object& cmd2) {
+  unsigned threads = View::parallel_threads();
+
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  threads = static_cast<unsigned>(std::min<size_t>(threads, size / view_parallel_min_chunk));
+
+  if (threads <= 1 || size < view_parallel_min_size || rpc::commands.is_profiling())
+    return 1;
+
+  if (!rpc::is_parallel_safe(cmd) || !rpc::is_parallel_safe(cmd2))
+    return 1;
+
+  return threads;
+}
+
+// Kept for the lifetime of the process so the threads are reused.
+static ParallelPool&
+view_parallel_pool() {
+  static ParallelPool pool;
+  return pool;
+}
+
+static void
+view_log_errors(const std::vector<std::vector<std::string>>& errors) {
+  for (const auto& list : errors)
+    for (const auto& msg : list)
+      control->core()->push_log(msg.c_str());
+}
+
+// Evaluates the filter for each download in [first, last), the result
+// is the same whether or not it is done in parallel.
+static std::vector<char>
+view_evaluate_filter(View::iterator first, View::iterator last, const torrent::Object& cmd, const torrent::Object& cmd2) {
+  size_t            size = std::distance(first, last);
+  unsigned          threads = view_parallel_threads(size, cmd, cmd2);
+  std::vector<char> matches(size);
+
+  if (threads == 1) {
+    std::transform(first, last, matches.begin(), view_downloads_filter(cmd, cmd2));
+    return matches;
+  }
+
+  std::vector<std::vector<std::string>> errors(threads);
+
+  parallel_for(view_parallel_pool(), size, threads, [&](unsigned index, size_t chunk_first, size_t chunk_last) {
+      view_downloads_filter filter(cmd, cmd2, &errors[index]);
+
+      for (size_t i = chunk_first; i != chunk_last; i++)
+        matches[i] = filter(first[i].get());
+    });
+
+  view_log_errors(errors);
+  return matches;
+}
+
+// Stable partition on already evaluated matches.
+static View::iterator
+view_partition(View::iterator first, View::iterator last, std::vector<char>::const_iterator matches) {
+  View::base_type rejected;
+  View::iterator  split = first;
+
+  for (; first != last; ++first, ++matches) {
+    if (!*matches) {
+      rejected.push_back(std::move(*first));
+      continue;
+    }
+
+    if (split != first)
+      *split = std::move(*first);
+
+    ++split;
+  }
+
+  std::move(rejected.begin(), rejected.end(), split);
+  return split;
+}
+
+// See parallel_stable_sort, the result is the same as that of a
+// single stable sort.
+static void
+view_sort(View::iterator first, View::iterator last, const torrent::Object& cmd) {
+  size_t   size = std::distance(first, last);
+  unsigned threads = view_parallel_threads(size, cmd, torrent::Object());
+
+  if (threads == 1) {
+    std::stable_sort(first, last, view_downloads_compare(cmd));
+    return;
+  }
+
+  std::vector<std::vector<std::string>> errors(threads);
+
+  parallel_stable_sort(view_parallel_pool(), first, last, threads,
+                       [&](unsigned index) { return view_downloads_compare(cmd, &errors[index]); },
+                       view_downloads_compare(cmd));
+
+  view_log_errors(errors);
+}
+
 void
 View::emit_changed() {
   torrent::this_thread::scheduler()->update_wait_for(&m_delay_changed, 0ms);
@@ -145,7 +271,7 @@ View::~View() {
 }
 
 void
-View::initialize(const std::string& name) {
+View::initialize(const std::string& name, uint32_t id) {
   if (!m_name.empty())
     throw torrent::internal_error("View::initialize(...) called on an already initialized view.");
 
@@ -153,6 +279,14 @@ View::initialize(const std::string& name) {
     throw torrent::internal_error("View::initialize(...) called with an empty name.");
 
   m_name = name;
+  m_id   = id;
+
+  // The filter_on command refers to the view by id, so the events
+  // don't need to parse the command nor look up the view by name.
+  m_filter_on_key = "!view." + m_name;
+  m_filter_on_command = torrent::Object::create_dict_key();
+  m_filter_on_command.as_dict_key() = "view.filter_download.id";
+  m_filter_on_command.as_dict_obj() = (int64_t)m_id;
 
   // Urgh, wrong. No filtering being done.
   for (const auto& d : *control->core()->download_list())
@@ -166,6 +300,8 @@ View::initialize(const std::string& name) {
 
 void
 View::erase(Download* download) {
+  m_filter_pending.erase(download);
+
   iterator itr = std::find_if(base_type::begin(), base_type::end(), entry_is(download));
 
   if (itr >= end_visible()) {
@@ -204,6 +340,8 @@ View::set_not_visible(Download* download) {
   m_size--;
   m_focus -= (m_focus > position(itr));
 
+  notify_not_visible(download);
+
   // Don't optimize erase since we want to keep the order of the
   // non-visible elements.
   auto entry = *itr;
@@ -262,7 +400,7 @@ View::sort() {
   Download* curFocus = focus() != end_visible() ? focus()->get() : NULL;
 
   // Don't go randomly switching around equivalent elements.
-  std::stable_sort(begin(), end_visible(), view_downloads_compare(m_sortCurrent));
+  view_sort(begin(), end_visible(), m_sortCurrent);
 
   m_focus = position(std::find_if(begin(), end_visible(), entry_is(curFocus)));
   emit_changed();
@@ -275,8 +413,9 @@ View::filter() {
     return;
 
   // Parition the list in two steps so we know which elements changed.
-  iterator  splitVisible  = std::stable_partition(begin_visible(), end_visible(), view_downloads_filter(m_filter, m_temp_filter));
-  iterator  splitFiltered = std::stable_partition(begin_filtered(), end_filtered(), view_downloads_filter(m_filter, m_temp_filter));
+  auto      matches       = view_evaluate_filter(begin(), end_filtered(), m_filter, m_temp_filter);
+  iterator  splitVisible  = view_partition(begin_visible(), end_visible(), matches.begin());
+  iterator  splitFiltered = view_partition(begin_filtered(), end_filtered(), matches.begin() + m_size);
 
   base_type changed(splitVisible, splitFiltered);
   iterator  splitChanged = changed.begin() + std::distance(splitVisible, end_visible());
@@ -287,6 +426,9 @@ View::filter() {
   // Fix this...
   m_focus = std::min(m_focus, m_size);
 
+  std::for_each(changed.begin(), splitChanged, [this](const auto& d) { notify_not_visible(d.get()); });
+  std::for_each(splitChanged, changed.end(), [this](const auto& d) { notify_visible(d.get()); });
+
   // The commands are allowed to remove itself from or change View
   // sorting since the commands are being called on the 'changed'
   // vector. But this will cause undefined behavior if elements are
@@ -308,16 +450,20 @@ View::filter() {
 
 void
 View::filter_by(const torrent::Object& condition, View::base_type& result) {
-  // std::copy_if(begin_visible(), end_visible(), result.begin(), view_downloads_filter(condition));
-  view_downloads_filter matches = view_downloads_filter(condition, m_temp_filter);
+  auto matches = view_evaluate_filter(begin_visible(), end_visible(), condition, m_temp_filter);
 
   for (iterator itr = begin_visible(); itr != end_visible(); ++itr)
-    if (matches(itr->get()))
+    if (matches[position(itr)])
       result.push_back(*itr);
 }
 
 void
 View::filter_download(core::Download* download) {
+  if (m_filter_deferred) {
+    m_filter_pending.insert(download);
+    return;
+  }
+
   iterator itr = std::find_if(base_type::begin(), base_type::end(), entry_is(download));
 
   if (itr == base_type::end())
@@ -358,14 +504,182 @@ View::filter_download(core::Download* download) {
   emit_changed();
 }
 
+void
+View::set_filter_deferred(bool state) {
+  m_filter_deferred = state;
+
+  if (!m_filter_deferred)
+    filter_pending();
+}
+
+// Gives the same result as calling 'filter_download' on each pending
+// download in view order, but evaluates the filter once per download
+// and rebuilds the vector once.
+//
+// Pending downloads that match are sorted with 'sort_new' and merged
+// into the visible downloads the same way 'insert_visible' places
+// them, newly filtered downloads go to the end.
+void
+View::filter_pending() {
+  if (m_filter_pending.empty())
+    return;
+
+  auto pending = std::move(m_filter_pending);
+  m_filter_pending.clear();
+
+  view_downloads_filter matches(m_filter, m_temp_filter);
+  Download* cur_focus = focus() != end_visible() ? focus()->get() : NULL;
+
+  base_type visible;
+  base_type filtered;
+  base_type matched;
+  base_type added;
+  base_type removed;
+
+  for (iterator itr = begin(), last = end_filtered(); itr != last; itr++) {
+    bool was_visible = itr < end_visible();
+
+    if (pending.find(itr->get()) == pending.end()) {
+      (was_visible ? visible : filtered).push_back(*itr);
+
+    } else if (matches(itr->get())) {
+      matched.push_back(*itr);
+
+      if (!was_visible)
+        added.push_back(*itr);
+
+    } else if (was_visible) {
+      removed.push_back(*itr);
+
+    } else {
+      filtered.push_back(*itr);
+    }
+  }
+
+  std::stable_sort(matched.begin(), matched.end(), view_downloads_compare(m_sortNew));
+
+  base_type result;
+  result.reserve(base_type::size());
+
+  auto matched_itr = matched.begin();
+  view_downloads_compare compare(m_sortNew);
+
+  for (const auto& d : visible) {
+    while (matched_itr != matched.end() && compare(matched_itr->get(), d.get()))
+      result.push_back(*matched_itr++);
+
+    result.push_back(d);
+  }
+
+  result.insert(result.end(), matched_itr, matched.end());
+  m_size = result.size();
+
+  result.insert(result.end(), filtered.begin(), filtered.end());
+  result.insert(result.end(), removed.begin(), removed.end());
+
+  base_type::swap(result);
+
+  m_focus = position(std::find_if(begin(), end_visible(), entry_is(cur_focus)));
+
+  std::for_each(removed.begin(), removed.end(), [this](const auto& d) { notify_not_visible(d.get()); });
+  std::for_each(matched.begin(), matched.end(), [this](const auto& d) { notify_visible(d.get()); });
+
+  if (!m_event_removed.is_empty())
+    std::for_each(removed.begin(), removed.end(), [this](const auto& d) { rpc::call_object_d_nothrow(m_event_removed, d.get()); });
+
+  if (!m_event_added.is_empty())
+    std::for_each(added.begin(), added.end(), [this](const auto& d) { rpc::call_object_d_nothrow(m_event_added, d.get()); });
+
+  emit_changed();
+}
+
+void
+View::set_stats_enabled(bool state) {
+  if (m_stats_enabled == state)
+    return;
+
+  m_stats_enabled = state;
+
+  if (m_stats_enabled)
+    stats_insert_all();
+  else
+    m_stats.clear();
+}
+
+void
+View::update_stats(Download* download) {
+  if (m_stats_enabled && m_stats.contains(download))
+    m_stats.update(download, download_stats(download));
+}
+
+void
+View::update_stats_live() {
+  if (m_stats_enabled)
+    m_stats.update_live(&View::download_stats);
+}
+
+View::stats_type
+View::download_stats(Download* download) {
+  stats_type stats;
+
+  stats.size            = 1;
+  stats.complete        = download->is_done();
+  stats.active          = download->is_active();
+  stats.hashing         = download->is_hash_checking();
+  stats.size_bytes      = download->file_list()->size_bytes();
+  stats.completed_bytes = download->file_list()->completed_bytes();
+  stats.left_bytes      = download->file_list()->left_bytes();
+  stats.up_rate         = download->info()->up_rate()->rate();
+  stats.down_rate       = download->info()->down_rate()->rate();
+
+  return stats;
+}
+
+void
+View::stats_insert(Download* download) {
+  if (m_stats_enabled)
+    m_stats.insert(download, download_stats(download));
+}
+
+void
+View::stats_insert_all() {
+  m_stats.clear();
+  m_stats.reserve(m_size);
+
+  for (auto itr = begin_visible(), last = end_visible(); itr != last; itr++)
+    stats_insert(itr->get());
+}
+
+void
+View::stats_erase(Download* download) {
+  if (m_stats_enabled)
+    m_stats.erase(download);
+}
+
+void
+View::notify_visible(Download* download) {
+  stats_insert(download);
+
+  for (auto& slot : m_signal_visibility)
+    slot(download, true);
+}
+
+void
+View::notify_not_visible(Download* download) {
+  stats_erase(download);
+
+  for (auto& slot : m_signal_visibility)
+    slot(download, false);
+}
+
 void
 View::set_filter_on_event(const std::string& event) {
-  control->object_storage()->set_str_multi_key(event, "!view." + m_name, "view.filter_download=" + m_name);
+  control->object_storage()->set_str_multi_key_obj(event, m_filter_on_key, m_filter_on_command);
 }
 
 void
 View::clear_filter_on() {
-  control->object_storage()->rlookup_clear("!view." + m_name);
+  control->object_storage()->rlookup_clear(m_filter_on_key);
 }
 
 inline void
@@ -375,6 +689,8 @@ View::insert_visible(const std::shared_ptr<Download>& d) {
   m_size++;
   m_focus += (m_focus >= position(itr));
 
+  notify_visible(d.get());
+
   base_type::insert(itr, d);
 }
 
@@ -383,7 +699,11 @@ View::erase_internal(iterator itr) {
   if (itr == end_filtered())
     throw torrent::internal_error("View::erase_visible(...) iterator out of range.");
 
-  m_size -= (itr < end_visible());
+  if (itr < end_visible()) {
+    m_size--;
+    notify_not_visible(itr->get());
+  }
+
   m_focus -= (m_focus > position(itr));
 
   base_type::erase(itr);
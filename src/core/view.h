@@ -17,11 +17,13 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <torrent/object.h>
 #include <torrent/system/scheduler.h>
 
 #include "globals.h"
+#include "view_stats.h"
 
 namespace core {
 
@@ -33,6 +35,9 @@ public:
   typedef std::function<void()>  slot_void;
   typedef std::list<slot_void>   signal_void;
 
+  typedef std::function<void(Download*, bool)> slot_visibility;
+  typedef std::list<slot_visibility>           signal_visibility_type;
+
   using base_type::const_iterator;
   using base_type::const_reverse_iterator;
   using base_type::iterator;
@@ -43,9 +48,14 @@ public:
   View() = default;
   ~View();
 
-  void               initialize(const std::string& name);
+  typedef ViewStats::stats_type stats_type;
+
+  // The id is the view's index in ViewManager, which never erases
+  // views, and can be used to refer to it without a name lookup.
+  void               initialize(const std::string& name, uint32_t id);
 
   const std::string& name() const { return m_name; }
+  uint32_t           id() const { return m_id; }
 
   bool               empty_visible() const { return m_size == 0; }
 
@@ -90,6 +100,12 @@ public:
   void set_sort_new(const torrent::Object& s) { m_sortNew = s; }
   void set_sort_current(const torrent::Object& s) { m_sortCurrent = s; }
 
+  // Filtering and sorting large views is split across this many
+  // threads when all the commands involved are parallel safe, where
+  // zero uses one thread per core and one disables it.
+  static unsigned parallel_threads()                { return m_parallel_threads; }
+  static void     set_parallel_threads(unsigned threads) { m_parallel_threads = threads; }
+
   // Need to explicity trigger filtering.
   void                   filter();
   void                   filter_by(const torrent::Object& condition, base_type& result);
@@ -103,6 +119,12 @@ public:
 
   void                   clear_filter_on();
 
+  // While deferred, 'filter_download' only records the download, and
+  // all recorded downloads are filtered in a single pass when the
+  // deferral is cleared.
+  bool                   is_filter_deferred() const { return m_filter_deferred; }
+  void                   set_filter_deferred(bool state);
+
   const torrent::Object& event_added() const { return m_event_added; }
   const torrent::Object& event_removed() const { return m_event_removed; }
   void                   set_event_added(const torrent::Object& cmd) { m_event_added = cmd; }
@@ -117,10 +139,28 @@ public:
   auto                last_changed() const { return m_last_changed; }
   void                set_last_changed(std::chrono::microseconds t = torrent::this_thread::cached_time()) { m_last_changed = t; }
 
+  // Stats are only kept once enabled. Membership changes and download
+  // events update the stats of the downloads involved, and
+  // 'update_stats_live' samples the downloads whose rates may have
+  // changed, see ViewStats.
+  bool                is_stats_enabled() const { return m_stats_enabled; }
+  void                set_stats_enabled(bool state);
+
+  const stats_type&   stats() const { return m_stats.totals(); }
+  void                update_stats(Download* download);
+  void                update_stats_live();
+
+  static stats_type   download_stats(Download* download);
+
   // Don't connect any slots until after initialize else it get's
   // triggered when adding the Download's in DownloadList.
   signal_void& signal_changed() { return m_signal_changed; }
 
+  // Called right away for each download that becomes visible or not
+  // visible, including when a visible download is moved. The slots
+  // must not change the view.
+  signal_visibility_type& signal_visibility() { return m_signal_visibility; }
+
 private:
   View(const View&);
   void        operator=(const View&);
@@ -130,6 +170,15 @@ private:
   inline void insert_visible(const std::shared_ptr<Download>& d);
   inline void erase_internal(iterator itr);
 
+  void        filter_pending();
+
+  void        stats_insert(Download* download);
+  void        stats_insert_all();
+  void        stats_erase(Download* download);
+
+  void        notify_visible(Download* download);
+  void        notify_not_visible(Download* download);
+
   void        emit_changed();
   void        emit_changed_now();
 
@@ -138,6 +187,11 @@ private:
   // An received thing for changed status so we can sort and filter.
 
   std::string m_name;
+  uint32_t    m_id{};
+
+  // Prebuilt as they're used whenever 'view.filter_on' is changed.
+  std::string      m_filter_on_key;
+  torrent::Object  m_filter_on_command;
 
   size_type   m_size;
   size_type   m_focus;
@@ -154,8 +208,17 @@ private:
 
   std::chrono::microseconds m_last_changed{};
 
+  bool                m_stats_enabled{};
+  ViewStats           m_stats;
+
+  bool                          m_filter_deferred{};
+  std::unordered_set<Download*> m_filter_pending;
+
   signal_void                     m_signal_changed;
+  signal_visibility_type          m_signal_visibility;
   torrent::system::SchedulerEntry m_delay_changed;
+
+  static unsigned                 m_parallel_threads;
 };
 
 } // namespace core
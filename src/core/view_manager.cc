@@ -16,12 +16,22 @@
 
 namespace core {
 
+ViewManager::ViewManager() {
+  m_task_update_stats.slot() = [this]() { receive_update_stats(); };
+}
+
+ViewManager::~ViewManager() {
+  torrent::this_thread::scheduler()->erase(&m_task_update_stats);
+  clear();
+}
+
 void
 ViewManager::clear() {
   for (auto v : *this)
     delete v;
 
   base_type::clear();
+  m_index.clear();
 }
 
 ViewManager::iterator
@@ -33,20 +43,28 @@ ViewManager::insert(const std::string& name) {
     throw torrent::input_error("View with same name already inserted.");
 
   View* view = new View();
-  view->initialize(name);
+  view->initialize(name, size());
+  view->set_filter_deferred(m_filter_deferred);
 
   base_type::push_back(view);
+  m_index.emplace(name, size() - 1);
+
   return --end();
 }
 
 ViewManager::iterator
 ViewManager::find(const std::string& name) {
-  return std::find_if(begin(), end(), [name](View* v){ return name == v->name(); });
+  auto itr = m_index.find(name);
+
+  if (itr == m_index.end())
+    return end();
+
+  return begin() + itr->second;
 }
 
 ViewManager::iterator
 ViewManager::find_throw(const std::string& name) {
-  iterator itr = std::find_if(begin(), end(), [name](View* v){ return name == v->name(); });
+  iterator itr = find(name);
 
   if (itr == end())
     throw torrent::input_error("Could not find view: " + name);
@@ -54,6 +72,14 @@ ViewManager::find_throw(const std::string& name) {
   return itr;
 }
 
+View*
+ViewManager::find_id_throw(uint64_t id) {
+  if (id >= size())
+    throw torrent::input_error("Could not find view id: " + std::to_string(id));
+
+  return *(begin() + id);
+}
+
 void
 ViewManager::sort(const std::string& name, uint32_t timeout) {
   iterator viewItr = find_throw(name);
@@ -66,6 +92,52 @@ ViewManager::sort(const std::string& name, uint32_t timeout) {
   (*viewItr)->sort();
 }
 
+void
+ViewManager::set_filter_deferred(bool state) {
+  m_filter_deferred = state;
+
+  // Use an index as the view events may insert new views.
+  for (size_type i = 0; i != size(); i++)
+    (*(begin() + i))->set_filter_deferred(state);
+}
+
+void
+ViewManager::set_stats_enabled(const std::string& name, bool state) {
+  (*find_throw(name))->set_stats_enabled(state);
+
+  if (state && !m_task_update_stats.is_scheduled())
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_update_stats, stats_interval);
+}
+
+const View::stats_type&
+ViewManager::stats(const std::string& name) {
+  View* view = *find_throw(name);
+
+  if (!view->is_stats_enabled())
+    throw torrent::input_error("Stats are not enabled for view: " + name);
+
+  return view->stats();
+}
+
+void
+ViewManager::update_stats(Download* download) {
+  for (auto view : *this)
+    view->update_stats(download);
+}
+
+void
+ViewManager::receive_update_stats() {
+  bool enabled = false;
+
+  for (auto view : *this) {
+    view->update_stats_live();
+    enabled = enabled || view->is_stats_enabled();
+  }
+
+  if (enabled)
+    torrent::this_thread::scheduler()->wait_for_ceil_seconds(&m_task_update_stats, stats_interval);
+}
+
 void
 ViewManager::set_filter(const std::string& name, const torrent::Object& cmd) {
   iterator viewItr = find_throw(name);
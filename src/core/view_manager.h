@@ -2,6 +2,8 @@
 #define RTORRENT_CORE_VIEW_MANAGER_H
 
 #include <string>
+#include <unordered_map>
+#include <torrent/system/scheduler.h>
 #include <torrent/utils/unordered_vector.h>
 
 #include "view.h"
@@ -28,8 +30,8 @@ public:
   using base_type::empty;
   using base_type::size;
 
-  ViewManager() = default;
-  ~ViewManager() { clear(); }
+  ViewManager();
+  ~ViewManager();
 
   // Ffff... Just throwing together an interface, need to think some
   // more on this.
@@ -46,6 +48,8 @@ public:
   iterator            find_throw(const std::string& name);
   View*               find_ptr_throw(const std::string& name) { return *find_throw(name); }
 
+  View*               find_id_throw(uint64_t id);
+
   // If View::last_changed() is less than 'timeout' seconds ago, don't
   // sort.
   //
@@ -60,8 +64,36 @@ public:
   void                set_filter_temp(const std::string& name, const torrent::Object& cmd);
   void                set_filter_on(const std::string& name, const filter_args& args);
 
+  // See View::set_filter_deferred, views inserted while deferred
+  // start out deferred.
+  bool                is_filter_deferred() const { return m_filter_deferred; }
+  void                set_filter_deferred(bool state);
+
+  // Stats are kept only for the views they are enabled on, and the
+  // live downloads of those views are sampled every 'stats_interval'
+  // to pick up rate and progress changes. Download events update the
+  // download's stats in each of them.
+  bool                is_stats_enabled(const std::string& name) { return (*find_throw(name))->is_stats_enabled(); }
+  void                set_stats_enabled(const std::string& name, bool state);
+
+  // Throws if stats aren't enabled on the view.
+  const View::stats_type& stats(const std::string& name);
+
+  void                update_stats(Download* download);
+
+  static constexpr auto stats_interval = std::chrono::seconds(1);
+
   void                set_event_added(const std::string& name, const torrent::Object& cmd)   { (*find_throw(name))->set_event_added(cmd); }
   void                set_event_removed(const std::string& name, const torrent::Object& cmd) { (*find_throw(name))->set_event_removed(cmd); }
+
+private:
+  void                receive_update_stats();
+
+  std::unordered_map<std::string, size_type> m_index;
+
+  bool                m_filter_deferred{};
+
+  torrent::system::SchedulerEntry m_task_update_stats;
 };
 
 }
@@ -0,0 +1,77 @@
+#include "config.h"
+
+#include "core/view_stats.h"
+
+namespace core {
+
+ViewStats::stats_type&
+ViewStats::stats_type::operator += (const stats_type& rhs) {
+  size            += rhs.size;
+  complete        += rhs.complete;
+  active          += rhs.active;
+  hashing         += rhs.hashing;
+  size_bytes      += rhs.size_bytes;
+  completed_bytes += rhs.completed_bytes;
+  left_bytes      += rhs.left_bytes;
+  up_rate         += rhs.up_rate;
+  down_rate       += rhs.down_rate;
+  return *this;
+}
+
+ViewStats::stats_type&
+ViewStats::stats_type::operator -= (const stats_type& rhs) {
+  size            -= rhs.size;
+  complete        -= rhs.complete;
+  active          -= rhs.active;
+  hashing         -= rhs.hashing;
+  size_bytes      -= rhs.size_bytes;
+  completed_bytes -= rhs.completed_bytes;
+  left_bytes      -= rhs.left_bytes;
+  up_rate         -= rhs.up_rate;
+  down_rate       -= rhs.down_rate;
+  return *this;
+}
+
+void
+ViewStats::insert(Download* download, const stats_type& stats) {
+  auto& entry = m_entries[download];
+
+  m_totals -= entry;
+  entry = stats;
+  m_totals += entry;
+
+  if (stats.is_live())
+    m_live.insert(download);
+  else
+    m_live.erase(download);
+}
+
+bool
+ViewStats::update(Download* download, const stats_type& stats) {
+  if (!contains(download))
+    return false;
+
+  insert(download, stats);
+  return true;
+}
+
+void
+ViewStats::erase(Download* download) {
+  auto itr = m_entries.find(download);
+
+  if (itr == m_entries.end())
+    return;
+
+  m_totals -= itr->second;
+  m_entries.erase(itr);
+  m_live.erase(download);
+}
+
+void
+ViewStats::clear() {
+  m_totals = stats_type();
+  m_entries.clear();
+  m_live.clear();
+}
+
+}
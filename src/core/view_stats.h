@@ -0,0 +1,88 @@
+// Totals over the visible downloads of a view.
+//
+// Each download's contribution is kept, so downloads entering or
+// leaving the view, or changing state, only subtract their old
+// contribution and add the new one. Downloads that are active, hashing
+// or still have a transfer rate are 'live', their rates and progress
+// change without any event and are sampled periodically by
+// 'update_live'.
+//
+// Downloads are only used as keys and never dereferenced.
+
+#ifndef RTORRENT_CORE_VIEW_STATS_H
+#define RTORRENT_CORE_VIEW_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace core {
+
+class Download;
+
+class ViewStats {
+public:
+  // Counting 'size' as one for a single download, a view's stats are
+  // the sum of its downloads'.
+  struct stats_type {
+    int64_t  size{};
+    int64_t  complete{};
+    int64_t  active{};
+    int64_t  hashing{};
+    uint64_t size_bytes{};
+    uint64_t completed_bytes{};
+    uint64_t left_bytes{};
+    uint64_t up_rate{};
+    uint64_t down_rate{};
+
+    bool        is_live() const { return active != 0 || hashing != 0 || up_rate != 0 || down_rate != 0; }
+
+    stats_type& operator += (const stats_type& rhs);
+    stats_type& operator -= (const stats_type& rhs);
+  };
+
+  const stats_type&   totals() const     { return m_totals; }
+
+  size_t              size() const       { return m_entries.size(); }
+  size_t              size_live() const  { return m_live.size(); }
+
+  bool                contains(Download* download) const { return m_entries.find(download) != m_entries.end(); }
+
+  // Inserts or replaces the download's contribution.
+  void                insert(Download* download, const stats_type& stats);
+
+  // Replaces the contribution of a download already counted, returns
+  // false if it isn't.
+  bool                update(Download* download, const stats_type& stats);
+
+  void                erase(Download* download);
+  void                clear();
+
+  void                reserve(size_t count) { m_entries.reserve(count); }
+
+  // Calls 'sample(download)' for each live download and updates its
+  // contribution.
+  template <typename Func>
+  void                update_live(Func sample);
+
+private:
+  stats_type                                m_totals;
+  std::unordered_map<Download*, stats_type> m_entries;
+  std::unordered_set<Download*>             m_live;
+};
+
+template <typename Func>
+void
+ViewStats::update_live(Func sample) {
+  // Updating may remove downloads from the live set.
+  std::vector<Download*> live(m_live.begin(), m_live.end());
+
+  for (auto download : live)
+    update(download, sample(download));
+}
+
+}
+
+#endif
@@ -122,8 +122,8 @@ print_download_info_full(char* first, char* last, core::Download* d) {
   }
 
   first = print_buffer(first, last, " [%c%c R: %4.2f",
-                       rpc::call_command_string("d.tied_to_file", rpc::make_target(d)).empty() ? ' ' : 'T',
-                       rpc::call_command_value("d.ignore_commands", rpc::make_target(d)) == 0 ? ' ' : 'I',
+                       d->tied_to_file().empty() ? ' ' : 'T',
+                       d->ignore_commands() == 0 ? ' ' : 'I',
                        (double)rpc::call_command_value("d.ratio", rpc::make_target(d)) / 1000.0);
 
   if (d->priority() != 2)
@@ -144,7 +144,7 @@ char*
 print_download_status(char* first, char* last, core::Download* d) {
   if (d->is_active())
     ;
-  else if (rpc::call_command_value("d.hashing", rpc::make_target(d)) != 0)
+  else if (d->hashing() != 0)
     first = print_buffer(first, last, "Hashing: ");
   else if (!d->is_active())
     first = print_buffer(first, last, "Inactive: ");
@@ -227,8 +227,8 @@ print_download_info_compact(char* first, char* last, core::Download* d) {
 
   first = print_buffer(first, last, "| %5.2f ", (double)rpc::call_command_value("d.ratio", rpc::make_target(d)) / 1000.0);
   first = print_buffer(first, last, "| %c%c",
-                       rpc::call_command_string("d.tied_to_file", rpc::make_target(d)).empty() ? ' ' : 'T',
-                       rpc::call_command_value("d.ignore_commands", rpc::make_target(d)) == 0 ? ' ' : 'I',
+                       d->tied_to_file().empty() ? ' ' : 'T',
+                       d->ignore_commands() == 0 ? ' ' : 'I',
                        (double)rpc::call_command_value("d.ratio", rpc::make_target(d)) / 1000.0);
 
   if (d->priority() != 2)
@@ -2,6 +2,8 @@
 
 #include "display/window_http_queue.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <stdexcept>
 #include <torrent/net/http_get.h>
 
@@ -50,9 +52,17 @@ WindowHttpQueue::redraw() {
     torrent::this_thread::scheduler()->update_wait_for(&m_task_deactivate, 5s);
 
   m_canvas->erase();
-  m_canvas->print(0, 0, "Http [%i]", m_queue->size());
+  char header[64];
+  int  header_size;
 
-  unsigned int pos = 10;
+  if (m_queue->size_queued() != 0)
+    header_size = std::snprintf(header, sizeof(header), "Http [%zu+%zu]", m_queue->size_active(), m_queue->size_queued());
+  else
+    header_size = std::snprintf(header, sizeof(header), "Http [%zu]", m_queue->size_active());
+
+  m_canvas->print(0, 0, "%s", header);
+
+  unsigned int pos = std::max(header_size + 1, 10);
   Container::iterator itr = m_container.begin();
 
   while (itr != m_container.end() && pos + 10 < m_canvas->width()) {
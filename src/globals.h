@@ -32,6 +32,7 @@ void                     callback_interrupt(torrent::system::callback_id& id, st
 rpc::SCgi*               scgi();
 void                     set_scgi(rpc::SCgi* scgi);
 void                     set_rpc_log(const std::string& filename);
+void                     wake_parked();
 
 } // namespace torrent::scgi_thread
 
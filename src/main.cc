@@ -24,12 +24,15 @@
 #include "core/dht_manager.h"
 #include "core/download.h"
 #include "core/manager.h"
+#include "core/peer_filter.h"
+#include "core/startup_profile.h"
 #include "display/canvas.h"
 #include "display/window.h"
 #include "display/manager.h"
 #include "input/bindings.h"
 #include "rpc/command_scheduler.h"
 #include "rpc/command_scheduler_item.h"
+#include "rpc/object_storage.h"
 #include "rpc/parse_commands.h"
 #include "scgi/thread_scgi.h"
 #include "session/session_manager.h"
@@ -52,6 +55,32 @@ void do_panic(int signum);
 void print_help();
 void initialize_commands();
 
+// Calls each startup_done handler separately so that they get their
+// own span in the startup profile. As with calling the multi command,
+// a handler throwing stops the remaining handlers.
+//
+// Errors are only logged, a bad setting mustn't abort startup.
+static void
+call_startup_done() {
+  auto* profile = control->startup_profile();
+
+  try {
+    auto handlers = control->object_storage()->get_str("event.system.startup_done");
+
+    if (!handlers.is_map())
+      throw torrent::input_error("Not a multi command.");
+
+    for (const auto& [key, handler] : handlers.as_map()) {
+      core::StartupProfile::scope span(profile, "startup_done", key);
+
+      rpc::command_function_call_object(handler, rpc::make_target(), torrent::Object("startup_done"));
+    }
+
+  } catch (torrent::local_error& e) {
+    control->core()->push_log_std("System startup_done event action failed: " + std::string(e.what()));
+  }
+}
+
 void
 initialize_rpc_slots() {
   rpc::rpc.slot_find_download() = [](const char* hash) {
@@ -159,6 +188,8 @@ main(int argc, char** argv) {
     torrent::log_add_group_output(torrent::LOG_DHT_ERROR,      "complete");
     torrent::log_add_group_output(torrent::LOG_DHT_CONTROLLER, "complete");
 
+    torrent::log_add_group_output(torrent::LOG_INFO,           "ring");
+
     initialize_rpc_slots();
 
     torrent::initialize();
@@ -169,9 +200,14 @@ main(int argc, char** argv) {
 
     SignalHandler::set_unblock(SIGCHLD);
 
+    auto* profile = control->startup_profile();
+
     // Initialize option handlers after libtorrent to ensure
     // torrent::ConnectionManager* are valid etc.
-    initialize_commands();
+    {
+      core::StartupProfile::scope span(profile, "phase", "initialize_commands");
+      initialize_commands();
+    }
 
     if (OptionParser::has_flag('D', argc, argv)) {
       rpc::call_command_set_value("method.use_deprecated.set", true);
@@ -212,7 +248,7 @@ main(int argc, char** argv) {
        "method.insert = event.download.hash_removed,multi|rlookup|static\n"
        "method.insert = event.download.hash_queued,multi|rlookup|static\n"
 
-       "method.set_key = event.download.inserted,         1_send_scrape, ((d.tracker.send_scrape,30))\n"
+       "method.set_key = event.download.inserted,         1_send_scrape, ((d.tracker.send_scrape,((system.startup.scrape_delay,30))))\n"
        "method.set_key = event.download.inserted_new,     1_prepare,   {(branch,((d.state)),((view.set_visible,started)),((view.set_visible,stopped)) )}\n"
        // d.save_full_session runs LAST (~ prefix is ASCII 0x7E, sorts after all alphanumerics,
        // matching the existing ~_delete_tied precedent on event.download.erased) so the on-disk
@@ -447,38 +483,78 @@ main(int argc, char** argv) {
 
     int firstArg = parse_main_options(argc, argv);
 
-    parse_config_file(argc, argv, [](auto& path) {
-        if (path.empty()) {
-          lt_log_print(torrent::LOG_WARN, "Ignoring rtorrent.rc.");
-          return;
-        }
+    {
+      core::StartupProfile::scope span(profile, "phase", "config");
 
-        rpc::parse_command_single(rpc::make_target(), "try_import=" + path);
-      });
+      parse_config_file(argc, argv, [](auto& path) {
+          if (path.empty()) {
+            lt_log_print(torrent::LOG_WARN, "Ignoring rtorrent.rc.");
+            return;
+          }
+
+          rpc::parse_command_single(rpc::make_target(), "try_import=" + path);
+        });
+    }
 
     LT_LOG("seeded srandom and srand48 (seed:%u)", random_seed);
     LT_LOG("max memory usage: %" PRIu64, torrent::runtime::memory_manager()->max_memory_usage());
 
-    control->initialize();
-    control->ui()->load_input_history();
+    {
+      core::StartupProfile::scope span(profile, "phase", "initialize");
+
+      control->initialize();
+      control->ui()->load_input_history();
+    }
 
-    torrent::net_thread::http_stack()->set_user_agent(USER_AGENT);
-    torrent::runtime::initialize_network();
+    // Block lists from the config must be in effect before any
+    // downloads are started.
+    {
+      core::StartupProfile::scope span(profile, "phase", "ip_filter");
+      control->peer_filter()->flush();
+    }
+
+    {
+      core::StartupProfile::scope span(profile, "phase", "initialize_network");
+
+      torrent::net_thread::http_stack()->set_user_agent(USER_AGENT);
+      torrent::runtime::initialize_network();
+    }
 
     // Load session torrents and perform scheduled tasks to ensure session torrents are loaded
     // before arg torrents.
-    control->dht_manager()->set_auto_if_untouched_and_has_session();
-    control->dht_manager()->load_dht_cache();
+    {
+      core::StartupProfile::scope span(profile, "phase", "dht_cache");
 
-    load_session_torrents(session_thread::manager()->path());
-    load_arg_torrents(argv + firstArg, argv + argc);
+      control->dht_manager()->set_auto_if_untouched_and_has_session();
+      control->dht_manager()->load_dht_cache();
+    }
+
+    // Session downloads are resumed gradually, see core::StartupAdmission.
+    control->startup_admission()->begin();
+
+    // The torrents are only queued here, each is loaded and created
+    // by the main loop in its own span.
+    {
+      core::StartupProfile::scope span(profile, "phase", "session_torrents");
+      load_session_torrents(session_thread::manager()->path());
+    }
+
+    {
+      core::StartupProfile::scope span(profile, "phase", "arg_torrents");
+      load_arg_torrents(argv + firstArg, argv + argc);
+    }
 
     // Make sure we update the display before any scheduled tasks can run, so that loading of
     // torrents doesn't look like it hangs on startup.
     control->display()->adjust_layout();
     control->display()->receive_update();
 
-    rpc::commands.call_catch("event.system.startup_done", rpc::make_target(), "startup_done", "System startup_done event action failed: ");
+    {
+      core::StartupProfile::scope span(profile, "phase", "startup_done");
+      call_startup_done();
+    }
+
+    profile->set_startup_done();
 
     torrent::system::Thread::self()->event_loop();
 
@@ -157,7 +157,9 @@ public:
   static torrent::Object* argument(unsigned int index) { return current_stack.begin() + index; }
   static torrent::Object& argument_ref(unsigned int index) { return *(current_stack.begin() + index); }
 
-  static stack_type current_stack;
+  // Thread local so that commands marked parallel safe can be called
+  // from worker threads, see rpc::is_parallel_safe.
+  static thread_local stack_type current_stack;
 
   static torrent::Object* stack_begin() { return current_stack.begin(); }
   static torrent::Object* stack_end()   { return current_stack.end(); }
@@ -1,5 +1,8 @@
 #include "config.h"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <torrent/exceptions.h>
 #include <torrent/object.h>
 #include <torrent/data/file_list_iterator.h>
@@ -14,10 +17,56 @@
 
 #include "rpc_manager.h"
 #include "parse_commands.h"
+#include "utils/functional.h"
 
 namespace rpc {
 
-command_base::stack_type command_base::current_stack;
+thread_local command_base::stack_type command_base::current_stack;
+
+namespace {
+
+// Active profiled calls, kept alongside command_base::current_stack so
+// that a nested call can subtract its time from the caller's self
+// time. Unwinds correctly when a command throws.
+
+struct command_profile_frame {
+  command_profile_frame(command_profile_type* profile);
+  ~command_profile_frame();
+
+  command_profile_type*                 m_profile;
+  command_profile_frame*                m_parent;
+  std::chrono::steady_clock::time_point m_start;
+  uint64_t                              m_child_time{};
+
+  static thread_local command_profile_frame* current;
+};
+
+thread_local command_profile_frame* command_profile_frame::current = nullptr;
+
+command_profile_frame::command_profile_frame(command_profile_type* profile) :
+  m_profile(profile),
+  m_parent(current),
+  m_start(std::chrono::steady_clock::now()) {
+
+  current = this;
+}
+
+command_profile_frame::~command_profile_frame() {
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+  auto time    = static_cast<uint64_t>(elapsed);
+
+  m_profile->calls++;
+  m_profile->inclusive_time += time;
+  m_profile->self_time += time - std::min(time, m_child_time);
+  m_profile->histogram[CommandMap::profile_bucket(time)]++;
+
+  if (m_parent != nullptr)
+    m_parent->m_child_time += time;
+
+  current = m_parent;
+}
+
+}
 
 CommandMap::iterator
 CommandMap::insert(const key_type& key, int flags, const char* parm, const char* doc) {
@@ -81,6 +130,34 @@ CommandMap::create_redirect(const key_type& key_new, const key_type& key_dest, i
   itr->second.m_anySlot = dest_itr->second.m_anySlot;
 }
 
+void
+CommandMap::mark_parallel_safe(const key_type& key) {
+  iterator itr = base_type::find(key);
+
+  if (itr == base_type::end())
+    return;
+
+  itr->second.m_flags |= flag_parallel_safe;
+}
+
+bool
+CommandMap::is_parallel_safe(const key_type& key) const {
+  const_iterator itr = base_type::find(key);
+
+  return itr != base_type::end() && (itr->second.m_flags & flag_parallel_safe);
+}
+
+void
+CommandMap::reset_profile() {
+  for (auto& itr : *this)
+    itr.second.m_profile = command_profile_type();
+}
+
+unsigned
+CommandMap::profile_bucket(uint64_t nanoseconds) {
+  return std::min<unsigned>(std::bit_width(nanoseconds / 1000), command_profile_type::histogram_size - 1);
+}
+
 const CommandMap::mapped_type
 CommandMap::call_catch(const key_type& key, const target_type& target, const mapped_type& args, const char* err) {
   try {
@@ -101,7 +178,7 @@ CommandMap::call_command(const key_type& key, const mapped_type& arg, const targ
   if (!rpc.is_trusted() && !(itr->second.m_flags & flag_untrusted_safe))
     throw untrusted_error("Command \"" + std::string(key) + "\" is not allowed for untrusted connections.");
 
-  return itr->second.m_anySlot(&itr->second.m_variable, target, arg);
+  return call_slot(itr, arg, target);
 }
 
 const CommandMap::mapped_type
@@ -109,6 +186,38 @@ CommandMap::call_command(iterator itr, const mapped_type& arg, const target_type
   if (!rpc.is_trusted() && !(itr->second.m_flags & flag_untrusted_safe))
     throw untrusted_error("Command \"" + itr->first + "\" is not allowed for untrusted connections.");
 
+  return call_slot(itr, arg, target);
+}
+
+inline const CommandMap::mapped_type
+CommandMap::call_slot(iterator itr, const mapped_type& arg, const target_type& target) {
+  if (rpc.is_park_enabled())
+    return call_slot_parkable(itr, arg, target);
+
+  if (m_profiling)
+    return call_slot_profiled(itr, arg, target);
+
+  return itr->second.m_anySlot(&itr->second.m_variable, target, arg);
+}
+
+const CommandMap::mapped_type
+CommandMap::call_slot_profiled(iterator itr, const mapped_type& arg, const target_type& target) {
+  command_profile_frame frame(&itr->second.m_profile);
+
+  return itr->second.m_anySlot(&itr->second.m_variable, target, arg);
+}
+
+// Tracks the call depth so that only the first top-level command of a
+// request may park, see RpcManager::is_park_allowed.
+
+const CommandMap::mapped_type
+CommandMap::call_slot_parkable(iterator itr, const mapped_type& arg, const target_type& target) {
+  rpc.enter_park_call();
+  utils::scope_guard guard([]() { rpc.leave_park_call(); });
+
+  if (m_profiling)
+    return call_slot_profiled(itr, arg, target);
+
   return itr->second.m_anySlot(&itr->second.m_variable, target, arg);
 }
 
@@ -1,6 +1,8 @@
 #ifndef RTORRENT_RPC_COMMAND_MAP_H
 #define RTORRENT_RPC_COMMAND_MAP_H
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <map>
 #include <string>
@@ -11,6 +13,23 @@
 
 namespace rpc {
 
+// Call statistics collected while CommandMap profiling is enabled,
+// times are in nanoseconds. Self time excludes the time spent in
+// commands called from within this command.
+//
+// Histogram bucket 0 counts calls below 1 usec, bucket i calls
+// taking [2^(i-1), 2^i) usec, and the last bucket anything slower.
+
+struct command_profile_type {
+  static constexpr unsigned histogram_size = 24;
+
+  uint64_t      calls{};
+  uint64_t      inclusive_time{};
+  uint64_t      self_time{};
+
+  std::array<uint64_t, histogram_size> histogram{};
+};
+
 struct command_map_data_type {
   // Some commands will need to share data, like get/set a variable. So
   // instead of using a single virtual member function, each command
@@ -30,6 +49,8 @@ struct command_map_data_type {
 
   const char*   m_parm;
   const char*   m_doc;
+
+  command_profile_type m_profile;
 };
 
 class CommandMap : public std::map<std::string, command_map_data_type> {
@@ -59,6 +80,11 @@ public:
 
   static const int flag_untrusted_safe = 0x400;
 
+  // Read-only commands that touch no state shared with other threads
+  // besides the target, and may be called concurrently from multiple
+  // threads while the main thread is blocked.
+  static const int flag_parallel_safe  = 0x800;
+
   CommandMap() = default;
 
   bool                has(const std::string& key) const { return base_type::find(key) != base_type::end(); }
@@ -79,6 +105,15 @@ public:
 
   void                create_redirect(const key_type& key_new, const key_type& key_dest, int flags);
 
+  void                mark_parallel_safe(const key_type& key);
+  bool                is_parallel_safe(const key_type& key) const;
+
+  bool                is_profiling() const        { return m_profiling; }
+  void                set_profiling(bool state)   { m_profiling = state; }
+  void                reset_profile();
+
+  static unsigned     profile_bucket(uint64_t nanoseconds);
+
   const mapped_type   call(const key_type& key, const mapped_type& args = mapped_type());
   const mapped_type   call(const key_type& key, const target_type& target, const mapped_type& args = mapped_type()) { return call_command(key, args, target); }
   const mapped_type   call_catch(const key_type& key, const target_type& target, const mapped_type& args = mapped_type(), const char* err = "Command failed: ");
@@ -94,6 +129,12 @@ public:
 private:
   CommandMap(const CommandMap&);
   void operator = (const CommandMap&);
+
+  const mapped_type   call_slot(iterator itr, const mapped_type& arg, const target_type& target);
+  const mapped_type   call_slot_profiled(iterator itr, const mapped_type& arg, const target_type& target);
+  const mapped_type   call_slot_parkable(iterator itr, const mapped_type& arg, const target_type& target);
+
+  bool                m_profiling{false};
 };
 
 inline target_type make_target()                                  { return target_type((int)command_base::target_generic, NULL); }
@@ -39,15 +39,14 @@
 #include <functional>
 #include <string>
 #include <vector>
-#include <torrent/utils/extents.h>
 
-namespace rpc {
+#include "utils/address_range_table.h"
 
-typedef torrent::extents<uint32_t, int> ipv4_table;
+namespace rpc {
 
 struct ip_table_node {
-  std::string name;
-  ipv4_table  table;
+  std::string              name;
+  utils::AddressRangeTable table;
 
   bool equal_name(const std::string& str) const { return str == name; }
 };
@@ -245,6 +245,9 @@ JsonRpc::process(const char* in_buffer, uint32_t length, slot_write callback) {
         response = json_error(JSONRPC_INVALID_REQUEST_ERROR, "invalid request: empty batch", nullptr);
         break;
       }
+      // Parking would process the whole batch again.
+      rpc.set_park_allowed(false);
+
       response = json::array();
       for (const auto& sub_body : body) {
         if (!sub_body.contains("id"))
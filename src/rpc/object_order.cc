@@ -0,0 +1,45 @@
+#include "config.h"
+
+#include "rpc/object_order.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace rpc {
+
+int
+object_order_compare(const torrent::Object& left, const torrent::Object& right) {
+  if (left.type() != right.type())
+    return left.type() < right.type() ? -1 : 1;
+
+  switch (left.type()) {
+  case torrent::Object::TYPE_VALUE:
+    return left.as_value() < right.as_value() ? -1 : left.as_value() > right.as_value();
+  case torrent::Object::TYPE_STRING:
+    return left.as_string().compare(right.as_string());
+  default:
+    return 0;
+  }
+}
+
+std::vector<size_t>
+object_order_range(const std::vector<torrent::Object>& keys, bool descending, size_t first, size_t last) {
+  last  = std::min(last, keys.size());
+  first = std::min(first, last);
+
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+
+  std::partial_sort(order.begin(), order.begin() + last, order.end(), [&](size_t a, size_t b) {
+      int result = object_order_compare(keys[a], keys[b]);
+
+      if (result == 0)
+        return a < b;
+
+      return descending ? result > 0 : result < 0;
+    });
+
+  return std::vector<size_t>(order.begin() + first, order.begin() + last);
+}
+
+}
@@ -0,0 +1,21 @@
+#ifndef RTORRENT_RPC_OBJECT_ORDER_H
+#define RTORRENT_RPC_OBJECT_ORDER_H
+
+#include <cstddef>
+#include <vector>
+#include <torrent/object.h>
+
+namespace rpc {
+
+// Values sort before strings, objects of any other type only sort by
+// type and so compare equal to each other.
+int                 object_order_compare(const torrent::Object& left, const torrent::Object& right);
+
+// Returns the indices of 'keys' at positions [first, last) of the
+// stable sort of 'keys', without sorting past 'last'. Ties keep the
+// order of 'keys' also when 'descending'.
+std::vector<size_t> object_order_range(const std::vector<torrent::Object>& keys, bool descending, size_t first, size_t last);
+
+}
+
+#endif
@@ -235,6 +235,50 @@ call_object(const torrent::Object& command, target_type target) {
   }
 }
 
+// Strings are only accepted if they either can't be a command, or
+// are a single command with plain arguments. Anything that could make
+// the parser call other commands, like '$' or nested lists, is left
+// to the caller's serial fallback rather than parsed here.
+
+static bool
+is_parallel_safe_string(const std::string& str) {
+  if (str.find_first_of("$;\n") != std::string::npos)
+    return false;
+
+  auto split = str.find('=');
+
+  if (split == std::string::npos)
+    return true;
+
+  if (str.find_first_of("=({", split + 1) != std::string::npos)
+    return false;
+
+  auto first = str.find_first_not_of(" \t");
+  auto last  = str.find_last_not_of(" \t", split - 1);
+
+  if (first == std::string::npos || first >= split)
+    return false;
+
+  return commands.is_parallel_safe(str.substr(first, last - first + 1));
+}
+
+bool
+is_parallel_safe(const torrent::Object& command) {
+  switch (command.type()) {
+  case torrent::Object::TYPE_NONE:
+  case torrent::Object::TYPE_VALUE:
+    return true;
+  case torrent::Object::TYPE_STRING:
+    return is_parallel_safe_string(command.as_string());
+  case torrent::Object::TYPE_LIST:
+    return std::all_of(command.as_list().begin(), command.as_list().end(), [](const auto& obj) { return is_parallel_safe(obj); });
+  case torrent::Object::TYPE_DICT_KEY:
+    return commands.is_parallel_safe(command.as_dict_key()) && is_parallel_safe(command.as_dict_obj());
+  default:
+    return false;
+  }
+}
+
 //
 //
 //
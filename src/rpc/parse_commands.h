@@ -109,6 +109,11 @@ call_command_d_range(const char* key, core::Download* download, torrent::Object:
 
 torrent::Object call_object(const torrent::Object& command, target_type target = make_target());
 
+// Returns true if calling 'command' only calls commands marked with
+// CommandMap::flag_parallel_safe, and so may be called from multiple
+// threads at once. Errs on the side of false.
+bool            is_parallel_safe(const torrent::Object& command);
+
 inline torrent::Object
 call_object_nothrow(const torrent::Object& command, target_type target = make_target()) {
   try { return call_object(command, target); } catch (torrent::input_error& e) { return torrent::Object(); }
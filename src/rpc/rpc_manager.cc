@@ -1,5 +1,6 @@
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <torrent/exceptions.h>
@@ -148,6 +149,14 @@ RpcManager::process_untrusted(RPCType type, const char* in_buffer, uint32_t leng
   }
 }
 
+void
+RpcManager::request_park(std::chrono::milliseconds timeout) {
+  if (!is_park_allowed())
+    throw torrent::internal_error("RpcManager::request_park(...) called while parking is not allowed.");
+
+  m_park_timeout = std::max(timeout, std::chrono::milliseconds(1));
+}
+
 void
 RpcManager::initialize_handlers() {
   if (m_handlers_initialized)
@@ -2,8 +2,10 @@
 #define RTORRENT_RPC_MANAGER_H
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <utility>
 #include <torrent/common.h>
 #include <torrent/exceptions.h>
 
@@ -96,11 +98,35 @@ public:
   // commands without flag_untrusted_safe are blocked.
   bool                is_trusted() const;
 
+  // Long-poll support, see SCgiTask::receive_call.
+  //
+  // While parking is allowed, a command may ask the transport to hold
+  // the response and process the same call again when woken or after
+  // 'timeout'. The command must not park once it has a result.
+  //
+  // As the whole request is processed again, only a request that is a
+  // single call may park. The transports disable parking for batches
+  // and system.multicall, and CommandMap disables it for commands
+  // called by other commands and once the first command returns.
+  bool                is_park_enabled() const                      { return m_park_enabled; }
+  bool                is_park_allowed() const                      { return m_park_enabled && m_park_depth == 1; }
+  void                set_park_allowed(bool allowed)               { m_park_enabled = allowed; m_park_depth = 0; }
+
+  void                enter_park_call()                            { m_park_depth++; }
+  void                leave_park_call()                            { if (--m_park_depth == 0) m_park_enabled = false; }
+
+  void                request_park(std::chrono::milliseconds timeout);
+  std::chrono::milliseconds take_park_request()                    { return std::exchange(m_park_timeout, std::chrono::milliseconds()); }
+
   static void         object_to_target(const torrent::Object& obj, int callFlags, rpc::target_type* target, std::function<void()>* deleter);
 
 private:
   bool          m_trusted{true};
 
+  bool                      m_park_enabled{};
+  unsigned int              m_park_depth{};
+  std::chrono::milliseconds m_park_timeout{};
+
   XmlRpc        m_xmlrpc;
   JsonRpc       m_jsonrpc;
 
@@ -137,6 +137,24 @@ SCgi::stop() {
     ::unlink(m_path.c_str());
 }
 
+// Returns true if there are parked tasks to wake.
+
+bool
+SCgi::signal_wake() {
+  m_wake_generation++;
+
+  return has_parked();
+}
+
+void
+SCgi::wake_parked() {
+  assert(torrent::this_thread::thread() == scgi_thread::thread());
+
+  for (auto& task : m_tasks)
+    if (task->is_parked())
+      task->resume(true);
+}
+
 void
 SCgi::event_read() {
   if (m_current < m_tasks.begin() || m_current >= m_tasks.end())
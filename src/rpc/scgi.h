@@ -2,6 +2,7 @@
 #define RTORRENT_RPC_SCGI_H
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <torrent/system/event.h>
 
@@ -13,6 +14,10 @@ class SCgi : public torrent::system::Event {
 public:
   static const int max_tasks = 100;
 
+  // Long-polls may not hold more than a quarter of the tasks, further
+  // requests get their response without waiting.
+  static const int max_parked = max_tasks / 4;
+
   SCgi();
   ~SCgi() override;
 
@@ -28,6 +33,19 @@ public:
 
   const std::string&  path() const                             { return m_path; }
 
+  // Tasks holding a long-poll request, see SCgiTask::park(). The wake
+  // generation is incremented by 'signal_wake' from any thread, tasks
+  // that parked after a wake was signaled resume immediately.
+  bool                has_parked() const                       { return m_parked_size != 0; }
+  bool                can_park() const                         { return m_parked_size < max_parked; }
+  uint64_t            wake_generation() const                  { return m_wake_generation; }
+
+  void                insert_parked()                          { m_parked_size++; }
+  void                erase_parked()                           { m_parked_size--; }
+
+  bool                signal_wake();
+  void                wake_parked();
+
   int                 log_fd() const                           { return m_logFd; }
   void                set_log_fd(int fd)                       { m_logFd = fd; }
 
@@ -45,6 +63,9 @@ private:
 
   task_list           m_tasks;
   task_list::iterator m_current;
+
+  std::atomic<int>      m_parked_size{};
+  std::atomic<uint64_t> m_wake_generation{};
 };
 
 }
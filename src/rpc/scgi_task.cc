@@ -2,6 +2,7 @@
 
 #include "rpc/scgi_task.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <charconv>
@@ -28,7 +29,12 @@ namespace rpc {
 SCgiTask::SCgiTask()
   : m_callback_id(torrent::system::make_callback_id()) {
 
-  m_task_timeout.slot() = [this]() { close(); };
+  m_task_timeout.slot() = [this]() {
+      if (m_parked)
+        resume(false);
+      else
+        close();
+    };
 
   reset_file_descriptor();
 }
@@ -45,6 +51,8 @@ SCgiTask::open(SCgi* parent, int fd) {
   m_content_type        = XML;
   m_content_type_set    = false;
   m_accepts_compression = false;
+  m_parked              = false;
+  m_park_deadline       = std::chrono::microseconds();
   m_trusted             = true;  // SCgiTask is pooled and reused; reset trust to default
                                  // so a prior untrusted connection does not leak its
                                  // m_trusted=false into the next reuse, given that the
@@ -81,6 +89,11 @@ SCgiTask::close() {
 
   torrent::this_thread::scheduler()->erase(&m_task_timeout);
 
+  if (m_parked) {
+    m_parked = false;
+    m_parent->erase_parked();
+  }
+
   torrent::system::cancel_callback_and_wait(m_callback_id, scgi_thread::thread(), torrent::main_thread::thread());
 
   torrent::runtime::socket_manager()->close_event_or_throw(this, [this]() {
@@ -98,6 +111,17 @@ SCgiTask::close() {
 
 void
 SCgiTask::event_read() {
+  // The request has been read in full, so a parked task is only
+  // readable if the client closed the connection or sent garbage.
+  if (m_parked) {
+    char c;
+
+    if (::recv(file_descriptor(), &c, 1, MSG_PEEK) == -1 && (errno == EAGAIN || errno == EINTR))
+      return;
+
+    return close();
+  }
+
   int read_length = m_buffer.size() - m_position;
 
   if (m_content_length == 0)
@@ -185,7 +209,7 @@ SCgiTask::event_read() {
       m_content_type = ContentType::JSON;
   }
 
-  receive_call(m_buffer.data() + m_body, m_content_length);
+  receive_call(m_buffer.data() + m_body, m_content_length, m_parent->can_park());
   return;
 
 event_read_failed:
@@ -215,6 +239,26 @@ SCgiTask::event_error() {
   close();
 }
 
+void
+SCgiTask::resume(bool allow_park) {
+  if (!m_parked)
+    return;
+
+  m_parked = false;
+  m_parent->erase_parked();
+
+  torrent::this_thread::poll()->remove_read(this);
+
+  process_again(allow_park);
+}
+
+void
+SCgiTask::process_again(bool allow_park) {
+  torrent::this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_timeout, timeout_request);
+
+  receive_call(m_buffer.data() + m_body, m_content_length, allow_park);
+}
+
 bool
 SCgiTask::parse_headers(const char* current, unsigned int header_length) {
   std::string content_type;
@@ -338,8 +382,14 @@ SCgiTask::detect_content_type(const std::string& content_type) {
   return true;
 }
 
+// A command may ask to park the request instead of responding, see
+// RpcManager::request_park(). The request buffer is kept as is and the
+// call is processed again when SCgi::wake_parked() is called, or with
+// parking disallowed once the deadline is reached. The deadline is set
+// by the first park and capped below the request timeout.
+
 void
-SCgiTask::receive_call(const char* buffer, uint32_t length) {
+SCgiTask::receive_call(const char* buffer, uint32_t length, bool allow_park) {
   assert(torrent::this_thread::thread() == scgi_thread::thread());
 
   RpcManager::RPCType rpc_type;
@@ -360,6 +410,17 @@ SCgiTask::receive_call(const char* buffer, uint32_t length) {
   // TODO: Completely remove the mutex, and align m_buffer?
 
   auto result_callback = [this](const char* b, uint32_t l) {
+      auto park_timeout = rpc.take_park_request();
+
+      if (park_timeout != std::chrono::milliseconds()) {
+        scgi_thread::callback_interrupt(m_callback_id, [this, park_timeout, generation = m_park_generation]() {
+            if (is_open())
+              park(park_timeout, generation);
+          });
+
+        return true;
+      }
+
       receive_write(b, l);
 
       // Memory barrier for the result data.
@@ -387,19 +448,55 @@ SCgiTask::receive_call(const char* buffer, uint32_t length) {
   m_result_mutex.lock();
   m_result_mutex.unlock();
 
-  torrent::main_thread::callback_interrupt(m_callback_id, [this, rpc_type, buffer, length, result_callback]() {
+  torrent::main_thread::callback_interrupt(m_callback_id, [this, rpc_type, buffer, length, result_callback, allow_park]() {
       // Memory barrier for the input data.
       // std::atomic_thread_fence(std::memory_order_acquire);
       m_result_mutex.lock();
       m_result_mutex.unlock();
 
+      // Events signaled while processing the call must wake it.
+      m_park_generation = m_parent->wake_generation();
+      rpc.set_park_allowed(allow_park);
+
       if (m_trusted)
         rpc.process(rpc_type, buffer, length, result_callback);
       else
         rpc.process_untrusted(rpc_type, buffer, length, result_callback);
+
+      rpc.set_park_allowed(false);
+      rpc.take_park_request();
     });
 }
 
+void
+SCgiTask::park(std::chrono::milliseconds timeout, uint64_t generation) {
+  assert(torrent::this_thread::thread() == scgi_thread::thread());
+
+  auto now = torrent::this_thread::cached_time();
+
+  if (m_park_deadline == std::chrono::microseconds())
+    m_park_deadline = now + std::min<std::chrono::microseconds>(timeout, max_park_timeout);
+
+  if (m_park_deadline <= now || !m_parent->can_park())
+    return process_again(false);
+
+  m_parked = true;
+  m_parent->insert_parked();
+
+  // Events may have been signaled after the call was processed but
+  // before the task was counted as parked.
+  if (m_parent->wake_generation() != generation) {
+    m_parked = false;
+    m_parent->erase_parked();
+
+    return process_again(true);
+  }
+
+  // Watch the socket so that a client that disconnects frees the task.
+  torrent::this_thread::poll()->insert_read(this);
+  torrent::this_thread::scheduler()->update_wait_for(&m_task_timeout, m_park_deadline - now);
+}
+
 void
 SCgiTask::receive_write(const char* buffer, uint32_t length) {
   assert(torrent::this_thread::thread() == torrent::main_thread::thread());
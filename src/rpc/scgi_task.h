@@ -18,7 +18,8 @@ public:
   static constexpr int max_header_size     = 2000;
   static constexpr int max_content_size    = (2 << 23);
 
-  static constexpr auto timeout_request = std::chrono::seconds(60);
+  static constexpr auto timeout_request  = std::chrono::seconds(60);
+  static constexpr auto max_park_timeout = std::chrono::seconds(50);
 
   enum ContentType { XML, JSON };
 
@@ -28,12 +29,16 @@ public:
 
   bool                is_open() const      { return file_descriptor() != -1; }
   bool                is_available() const { return file_descriptor() == -1; }
+  bool                is_parked() const    { return m_parked; }
 
   void                open(SCgi* parent, int fd);
   void                cancel_open();
 
   void                close();
 
+  // Processes a parked request again, see receive_call.
+  void                resume(bool allow_park);
+
   ContentType         content_type() const { return m_content_type; }
 
   void                event_read() override;
@@ -52,7 +57,9 @@ private:
   bool                parse_headers(const char* current, unsigned int header_length);
   bool                detect_content_type(const std::string& content_type);
 
-  void                receive_call(const char* buffer, uint32_t length);
+  void                receive_call(const char* buffer, uint32_t length, bool allow_park);
+  void                park(std::chrono::milliseconds timeout, uint64_t generation);
+  void                process_again(bool allow_park);
   void                receive_write(const char* buffer, uint32_t length);
 
   void                plaintext_response(const char* buffer, uint32_t content_length);
@@ -74,6 +81,10 @@ private:
   bool                m_accepts_compression{};
   bool                m_trusted{true};
   bool                m_content_type_set{false};
+
+  bool                      m_parked{};
+  std::chrono::microseconds m_park_deadline{};
+  uint64_t                  m_park_generation{};
 };
 
 }
@@ -6,6 +6,7 @@
 #endif
 
 #include <cctype>
+#include <cstring>
 #include <string>
 #include <stdlib.h>
 #include <torrent/object.h>
@@ -370,6 +371,15 @@ object_to_xmlrpc(xmlrpc_env* env, const torrent::Object& object) {
   }
 }
 
+// The built-in system.multicall calls our methods directly, parking
+// would process every call again.
+
+void
+xmlrpc_preinvoke(xmlrpc_env*, const char* method_name, xmlrpc_value*, void*) {
+  if (std::strcmp(method_name, "system.multicall") == 0)
+    rpc.set_park_allowed(false);
+}
+
 xmlrpc_value*
 xmlrpc_call_command(xmlrpc_env* env, xmlrpc_value* args, void* voidServerInfo) {
   auto server_info = static_cast<const char*>(voidServerInfo);
@@ -429,6 +439,8 @@ XmlRpc::initialize() {
 
   xmlrpc_env_init((xmlrpc_env*)m_env);
   m_registry = xmlrpc_registry_new((xmlrpc_env*)m_env);
+
+  xmlrpc_registry_set_preinvoke_method((xmlrpc_env*)m_env, (xmlrpc_registry*)m_registry, &xmlrpc_preinvoke, nullptr);
 }
 
 void
@@ -323,6 +323,9 @@ process_document(const tinyxml2::XMLDocument* doc, tinyxml2::XMLPrinter* printer
   // Add a shim here for system.multicall to allow better code reuse, and
   // because system.multicall is one of the few methods that doesn't take a target
   if (method_name == std::string("system.multicall")) {
+    // Parking would process every call again.
+    rpc.set_park_allowed(false);
+
     result                = torrent::Object::create_list();
     auto& result_list     = result.as_list();
     auto  parent_elements = element_access(doc->RootElement(), {"params", "param", "value", "array", "data"});
@@ -73,6 +73,16 @@ ThreadScgi::set_rpc_log(const std::string& filename) {
     });
 }
 
+void
+ThreadScgi::wake_parked() {
+  auto scgi = m_scgi.load();
+
+  if (scgi == nullptr || !scgi->signal_wake())
+    return;
+
+  callback([this]() { m_scgi.load()->wake_parked(); });
+}
+
 void
 ThreadScgi::change_rpc_log() {
   if (scgi() == nullptr)
@@ -131,4 +141,10 @@ rpc::SCgi*  scgi()                                       { return scgi::ThreadSc
 void        set_scgi(rpc::SCgi* scgi)                    { scgi::ThreadScgi::thread_scgi()->set_scgi(scgi); }
 void        set_rpc_log(const std::string& filename)     { scgi::ThreadScgi::thread_scgi()->set_rpc_log(filename); }
 
+void
+wake_parked() {
+  if (scgi::ThreadScgi::thread_scgi() != nullptr)
+    scgi::ThreadScgi::thread_scgi()->wake_parked();
+}
+
 } // namespace scgi_thread
@@ -25,6 +25,9 @@ public:
 
   void                set_rpc_log(const std::string& filename);
 
+  // Thread-safe, wakes long-poll requests parked by SCgiTask.
+  void                wake_parked();
+
 protected:
   ThreadScgi() = default;
 
@@ -29,6 +29,8 @@ DownloadStorer::build_streams(bool skip_static) {
   auto& resume_base   = download->bencode()->get_key("libtorrent_resume");
   auto& rtorrent_base = download->bencode()->get_key("rtorrent");
 
+  m_download->save_variables(&rtorrent_base);
+
   rtorrent_base.insert_key("chunks_done",      download->file_list()->completed_chunks());
   rtorrent_base.insert_key("chunks_wanted",    download->data()->wanted_chunks());
   rtorrent_base.insert_key("total_uploaded",   m_download->info()->up_rate()->total());
@@ -12,6 +12,8 @@
 #include "globals.h"
 #include "option_parser.h"
 #include "core/download_factory.h"
+#include "core/log_ring.h"
+#include "core/startup_profile.h"
 #include "rpc/parse_commands.h"
 #include "session/download_storer.h"
 #include "utils/directory.h"
@@ -104,6 +106,10 @@ config_comment_log(const std::string& command, const std::string& raw_args) {
     apply_log_open_str(log_flag_append_file | log_flag_flush, args);
   else if (command == "log.append_gz_file")
     apply_log_open_str(log_flag_append_file | log_flag_use_gz, args);
+  else if (command == "log.open_binary_file")
+    apply_log_open_str(log_flag_binary, args);
+  else if (command == "log.append_binary_file")
+    apply_log_open_str(log_flag_append_file | log_flag_binary, args);
   else
     throw torrent::input_error("Unknown log command: " + command);
 }
@@ -148,7 +154,8 @@ parse_config_file_comments(const std::string& path) {
 
 void
 load_session_torrents(const std::string& path) {
-  auto entries = session::DownloadStorer::get_formated_entries(path);
+  auto* profile = control->startup_profile();
+  auto  entries = session::DownloadStorer::get_formated_entries(path);
 
   for (const auto& entry : entries) {
     // We don't really support session torrents that are links. These
@@ -159,9 +166,11 @@ load_session_torrents(const std::string& path) {
 
     auto* f = new core::DownloadFactory(control->core());
 
+    profile->insert_pending_load();
+
     f->set_session(true);
     f->set_init_load(true);
-    f->slot_finished([f](){ delete f; });
+    f->slot_finished([f, profile](){ profile->erase_pending_load(); delete f; });
     f->load(entries.path() + entry.s_name);
     f->commit();
   }
@@ -169,12 +178,16 @@ load_session_torrents(const std::string& path) {
 
 void
 load_arg_torrents(char** first, char** last) {
+  auto* profile = control->startup_profile();
+
   for (; first != last; ++first) {
     auto* f = new core::DownloadFactory(control->core());
 
+    profile->insert_pending_load();
+
     f->set_start(true);
     f->set_init_load(true);
-    f->slot_finished([f](){ delete f; });
+    f->slot_finished([f, profile](){ profile->erase_pending_load(); delete f; });
     f->load(*first);
     f->commit();
   }
@@ -209,7 +222,9 @@ apply_log_open_str(int output_flags, const std::vector<std::string>& args) {
   bool append = (output_flags & log_flag_append_file);
   bool flush = (output_flags & log_flag_flush);
 
-  if ((output_flags & log_flag_use_gz))
+  if ((output_flags & log_flag_binary))
+    core::log_open_binary_file_output(output_id, file_name, append, flush);
+  else if ((output_flags & log_flag_use_gz))
     torrent::log_open_gz_file_output(output_id.c_str(), file_name.c_str(), append);
   else
     torrent::log_open_file_output(output_id.c_str(), file_name.c_str(), append, flush);
@@ -15,6 +15,7 @@ static constexpr int log_flag_use_gz      = 0x1;
 static constexpr int log_flag_append_pid  = 0x2;
 static constexpr int log_flag_append_file = 0x4;
 static constexpr int log_flag_flush       = 0x8;
+static constexpr int log_flag_binary      = 0x10;
 
 void log_add_group_output_str(const std::string& group_name, const std::string& output_id);
 void apply_log_open_str(int output_flags, const std::vector<std::string>& args);
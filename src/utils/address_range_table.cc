@@ -0,0 +1,510 @@
+#include "config.h"
+
+#include "utils/address_range_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace utils {
+
+namespace {
+
+constexpr char cache_magic[8] = {'r', 't', 'i', 'p', 'f', 'l', 't', '1'};
+
+constexpr size_t cache_header_size = sizeof(cache_magic) + 2 * sizeof(uint64_t);
+constexpr size_t cache_ipv4_size   = 2 * sizeof(uint32_t) + sizeof(int32_t);
+constexpr size_t cache_ipv6_size   = 2 * 16 + sizeof(int32_t);
+
+const AddressRangeTable::ipv6_address ipv4_mapped_prefix = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+bool     address_is_max(uint32_t address) { return address == std::numeric_limits<uint32_t>::max(); }
+uint32_t address_next(uint32_t address)   { return address + 1; }
+uint32_t address_prev(uint32_t address)   { return address - 1; }
+
+bool
+address_is_max(const AddressRangeTable::ipv6_address& address) {
+  return std::all_of(address.begin(), address.end(), [](uint8_t b) { return b == 0xff; });
+}
+
+AddressRangeTable::ipv6_address
+address_next(AddressRangeTable::ipv6_address address) {
+  for (auto itr = address.rbegin(); itr != address.rend() && ++(*itr) == 0; itr++)
+    ;
+  return address;
+}
+
+AddressRangeTable::ipv6_address
+address_prev(AddressRangeTable::ipv6_address address) {
+  for (auto itr = address.rbegin(); itr != address.rend() && (*itr)-- == 0; itr++)
+    ;
+  return address;
+}
+
+bool
+address_is_ipv4_mapped(const AddressRangeTable::ipv6_address& address) {
+  return std::equal(ipv4_mapped_prefix.begin(), ipv4_mapped_prefix.begin() + 12, address.begin());
+}
+
+uint32_t
+address_to_ipv4(const AddressRangeTable::ipv6_address& address) {
+  return (uint32_t)address[12] << 24 | (uint32_t)address[13] << 16 | (uint32_t)address[14] << 8 | address[15];
+}
+
+// Overlays 'ranges' onto 'current', later ranges taking precedence.
+//
+// Each range gets a priority, with the current ranges lowest, and the
+// address space is swept in order while keeping the ranges covering
+// the current position in a max-heap on priority. Adjacent results
+// with the same value are joined.
+
+template <typename Range>
+std::vector<Range>
+merge_ranges(const std::vector<Range>& current, const std::vector<Range>& ranges) {
+  struct entry_type {
+    const Range* range;
+    size_t       priority;
+  };
+
+  auto compare_first    = [](const entry_type& a, const entry_type& b) { return a.range->first < b.range->first; };
+  auto compare_priority = [](const entry_type& a, const entry_type& b) { return a.priority < b.priority; };
+
+  std::vector<entry_type> existing;
+  std::vector<entry_type> added;
+  std::vector<entry_type> entries;
+
+  existing.reserve(current.size());
+  added.reserve(ranges.size());
+  entries.reserve(current.size() + ranges.size());
+
+  for (const auto& range : current)
+    existing.push_back(entry_type{&range, 0});
+
+  for (size_t i = 0; i != ranges.size(); i++)
+    if (!(ranges[i].last < ranges[i].first))
+      added.push_back(entry_type{&ranges[i], i + 1});
+
+  std::stable_sort(added.begin(), added.end(), compare_first);
+  std::merge(existing.begin(), existing.end(), added.begin(), added.end(), std::back_inserter(entries), compare_first);
+
+  std::vector<Range>      result;
+  std::vector<entry_type> active;
+  auto                    next = entries.begin();
+  decltype(Range::first)  position{};
+
+  while (next != entries.end() || !active.empty()) {
+    if (active.empty())
+      position = next->range->first;
+
+    for (; next != entries.end() && !(position < next->range->first); next++) {
+      active.push_back(*next);
+      std::push_heap(active.begin(), active.end(), compare_priority);
+    }
+
+    while (!active.empty() && active.front().range->last < position) {
+      std::pop_heap(active.begin(), active.end(), compare_priority);
+      active.pop_back();
+    }
+
+    if (active.empty())
+      continue;
+
+    const Range* top = active.front().range;
+    auto         end = top->last;
+
+    if (next != entries.end() && !(end < next->range->first))
+      end = address_prev(next->range->first);
+
+    if (!result.empty() && result.back().value == top->value && address_next(result.back().last) == position)
+      result.back().last = end;
+    else
+      result.push_back(Range{position, end, top->value});
+
+    if (address_is_max(end))
+      break;
+
+    position = address_next(end);
+  }
+
+  return result;
+}
+
+template <typename Range, typename Address>
+bool
+find_range(const std::vector<Range>& ranges, const Address& first, const Address& last, int* value) {
+  auto itr = std::upper_bound(ranges.begin(), ranges.end(), first, [](const Address& address, const Range& range) {
+      return address < range.first;
+    });
+
+  if (itr == ranges.begin())
+    return false;
+
+  itr--;
+
+  if (itr->last < last)
+    return false;
+
+  *value = itr->value;
+  return true;
+}
+
+template <typename Range>
+bool
+is_valid_list(const std::vector<Range>& ranges) {
+  for (auto itr = ranges.begin(); itr != ranges.end(); itr++) {
+    if (itr->last < itr->first)
+      return false;
+
+    if (itr != ranges.begin() && !(std::prev(itr)->last < itr->first))
+      return false;
+  }
+
+  return true;
+}
+
+std::string_view
+trim(std::string_view str) {
+  auto first = str.find_first_not_of(" \t");
+
+  if (first == std::string_view::npos)
+    return std::string_view();
+
+  return str.substr(first, str.find_last_not_of(" \t") - first + 1);
+}
+
+template <int Family, typename Address>
+bool
+parse_address(std::string_view str, Address* address) {
+  char buffer[INET6_ADDRSTRLEN + 1];
+
+  if (str.empty() || str.size() >= sizeof(buffer))
+    return false;
+
+  std::memcpy(buffer, str.data(), str.size());
+  buffer[str.size()] = '\0';
+
+  if (inet_pton(Family, buffer, address) != 1)
+    return false;
+
+  if constexpr (Family == AF_INET)
+    *address = ntohl(*address);
+
+  return true;
+}
+
+bool
+parse_prefix(std::string_view str, unsigned int max, unsigned int* prefix) {
+  str = trim(str);
+
+  if (str.empty() || str.size() > 3 || str.find_first_not_of("0123456789") != std::string_view::npos)
+    return false;
+
+  *prefix = 0;
+
+  for (char c : str)
+    *prefix = *prefix * 10 + (c - '0');
+
+  return *prefix <= max;
+}
+
+// Follows the old ipv4_range_parse: the range starts after the last
+// ':', and anything after the addresses is ignored.
+
+bool
+parse_ipv4_range(std::string_view line, AddressRangeTable::ipv4_range* range) {
+  auto colon = line.rfind(':');
+
+  if (colon != std::string_view::npos)
+    line.remove_prefix(colon + 1);
+
+  auto take_address = [&line]() {
+      auto first = line.find_first_not_of(" \t");
+      line.remove_prefix(first == std::string_view::npos ? line.size() : first);
+
+      auto last = std::min(line.find_first_not_of("0123456789."), line.size());
+      auto address = line.substr(0, last);
+
+      line.remove_prefix(last);
+      return address;
+    };
+
+  auto start = take_address();
+
+  if (!parse_address<AF_INET>(start, &range->first))
+    return false;
+
+  if (line.find('-') != std::string_view::npos) {
+    line.remove_prefix(std::min(line.find_first_not_of("- \t"), line.size()));
+
+    if (!parse_address<AF_INET>(take_address(), &range->last))
+      return false;
+
+    return range->first <= range->last;
+  }
+
+  if (line.find('/') != std::string_view::npos) {
+    line.remove_prefix(std::min(line.find_first_not_of("/ \t"), line.size()));
+
+    unsigned int bits;
+
+    if (!parse_prefix(line.substr(0, std::min(line.find_first_not_of("0123456789"), line.size())), 32, &bits))
+      return false;
+
+    uint32_t mask = bits == 0 ? 0 : ~uint32_t() << (32 - bits);
+
+    range->first &= mask;
+    range->last = range->first | ~mask;
+    return true;
+  }
+
+  range->last = range->first;
+  return true;
+}
+
+bool
+parse_ipv6_candidate(std::string_view str, AddressRangeTable::ipv6_range* range) {
+  str = trim(str);
+
+  if (auto dash = str.find('-'); dash != std::string_view::npos)
+    return parse_address<AF_INET6>(trim(str.substr(0, dash)), &range->first) &&
+      parse_address<AF_INET6>(trim(str.substr(dash + 1)), &range->last) &&
+      !(range->last < range->first);
+
+  if (auto slash = str.find('/'); slash != std::string_view::npos) {
+    unsigned int bits;
+
+    if (!parse_address<AF_INET6>(trim(str.substr(0, slash)), &range->first) || !parse_prefix(str.substr(slash + 1), 128, &bits))
+      return false;
+
+    range->last = range->first;
+
+    for (unsigned int i = 0; i != 16; i++) {
+      unsigned int keep = std::min(8u, bits - std::min(bits, i * 8));
+      uint8_t      mask = keep == 0 ? 0 : 0xff << (8 - keep);
+
+      range->first[i] &= mask;
+      range->last[i] = range->first[i] | uint8_t(~mask);
+    }
+
+    return true;
+  }
+
+  if (!parse_address<AF_INET6>(str, &range->first))
+    return false;
+
+  range->last = range->first;
+  return true;
+}
+
+// As IPv6 addresses contain ':', a label can't be told apart from the
+// address by the last ':'. Instead the whole line is tried first, and
+// then the text after each ':' in turn.
+
+bool
+parse_ipv6_range(std::string_view line, AddressRangeTable::ipv6_range* range) {
+  if (std::count(line.begin(), line.end(), ':') < 2)
+    return false;
+
+  if (parse_ipv6_candidate(line, range))
+    return true;
+
+  for (auto pos = line.find(':'); pos != std::string_view::npos; pos = line.find(':', pos + 1))
+    if (parse_ipv6_candidate(line.substr(pos + 1), range))
+      return true;
+
+  return false;
+}
+
+template <typename T>
+void
+append_raw(std::string* str, const T& value) {
+  str->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T
+read_raw(const char*& data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  data += sizeof(value);
+  return value;
+}
+
+}
+
+size_t
+AddressRangeTable::sizeof_data() const {
+  return m_ipv4.size() * sizeof(ipv4_range) + m_ipv6.size() * sizeof(ipv6_range);
+}
+
+bool
+AddressRangeTable::find(uint32_t first, uint32_t last, int* value) const {
+  return find_range(m_ipv4, first, last, value);
+}
+
+bool
+AddressRangeTable::find(const ipv6_address& first, const ipv6_address& last, int* value) const {
+  if (address_is_ipv4_mapped(first) && address_is_ipv4_mapped(last))
+    return find(address_to_ipv4(first), address_to_ipv4(last), value);
+
+  return find_range(m_ipv6, first, last, value);
+}
+
+bool
+AddressRangeTable::find(const sockaddr* sa, int* value) const {
+  switch (sa->sa_family) {
+  case AF_INET: {
+    uint32_t address = ntohl(reinterpret_cast<const sockaddr_in*>(sa)->sin_addr.s_addr);
+    return find(address, address, value);
+  }
+  case AF_INET6: {
+    ipv6_address address;
+    std::memcpy(address.data(), &reinterpret_cast<const sockaddr_in6*>(sa)->sin6_addr, address.size());
+    return find(address, address, value);
+  }
+  default:
+    return false;
+  }
+}
+
+void
+AddressRangeTable::merge(ipv4_list ipv4, ipv6_list ipv6) {
+  // IPv4-mapped ranges are moved to the IPv4 list, keeping the order
+  // they were given in as it decides which range wins.
+  auto mapped = std::stable_partition(ipv6.begin(), ipv6.end(), [](const ipv6_range& range) {
+      return !address_is_ipv4_mapped(range.first) || !address_is_ipv4_mapped(range.last);
+    });
+
+  for (auto itr = mapped; itr != ipv6.end(); itr++)
+    ipv4.push_back(ipv4_range{address_to_ipv4(itr->first), address_to_ipv4(itr->last), itr->value});
+
+  ipv6.erase(mapped, ipv6.end());
+
+  if (!ipv4.empty())
+    m_ipv4 = merge_ranges(m_ipv4, ipv4);
+
+  if (!ipv6.empty())
+    m_ipv6 = merge_ranges(m_ipv6, ipv6);
+}
+
+void
+AddressRangeTable::clear() {
+  m_ipv4 = ipv4_list();
+  m_ipv6 = ipv6_list();
+}
+
+AddressRangeTable::parse_result
+AddressRangeTable::parse_range(std::string_view line, ipv4_range* ipv4, ipv6_range* ipv6) {
+  line = line.substr(0, line.find_first_of("#\r\n"));
+
+  if (parse_ipv6_range(line, ipv6)) {
+    if (!address_is_ipv4_mapped(ipv6->first) || !address_is_ipv4_mapped(ipv6->last))
+      return parse_ipv6;
+
+    *ipv4 = ipv4_range{address_to_ipv4(ipv6->first), address_to_ipv4(ipv6->last), 0};
+    return parse_ipv4;
+  }
+
+  if (parse_ipv4_range(line, ipv4))
+    return parse_ipv4;
+
+  return parse_none;
+}
+
+size_t
+AddressRangeTable::parse_list(std::string_view data, int value, ipv4_list* ipv4, ipv6_list* ipv6) {
+  size_t count = 0;
+
+  while (!data.empty()) {
+    auto line = data.substr(0, data.find('\n'));
+    data.remove_prefix(std::min(line.size() + 1, data.size()));
+
+    if (line.empty() || line.front() == '#')
+      continue;
+
+    ipv4_range range4;
+    ipv6_range range6;
+
+    switch (parse_range(line, &range4, &range6)) {
+    case parse_ipv4:
+      range4.value = value;
+      ipv4->push_back(range4);
+      break;
+    case parse_ipv6:
+      range6.value = value;
+      ipv6->push_back(range6);
+      break;
+    case parse_none:
+      continue;
+    }
+
+    count++;
+  }
+
+  return count;
+}
+
+std::string
+AddressRangeTable::serialize() const {
+  std::string result;
+  result.reserve(cache_header_size + m_ipv4.size() * cache_ipv4_size + m_ipv6.size() * cache_ipv6_size);
+
+  result.append(cache_magic, sizeof(cache_magic));
+  append_raw(&result, (uint64_t)m_ipv4.size());
+  append_raw(&result, (uint64_t)m_ipv6.size());
+
+  for (const auto& range : m_ipv4) {
+    append_raw(&result, range.first);
+    append_raw(&result, range.last);
+    append_raw(&result, (int32_t)range.value);
+  }
+
+  for (const auto& range : m_ipv6) {
+    append_raw(&result, range.first);
+    append_raw(&result, range.last);
+    append_raw(&result, (int32_t)range.value);
+  }
+
+  return result;
+}
+
+bool
+AddressRangeTable::deserialize(std::string_view data, AddressRangeTable* table) {
+  if (data.size() < cache_header_size || std::memcmp(data.data(), cache_magic, sizeof(cache_magic)) != 0)
+    return false;
+
+  const char* itr       = data.data() + sizeof(cache_magic);
+  auto        size_ipv4 = read_raw<uint64_t>(itr);
+  auto        size_ipv6 = read_raw<uint64_t>(itr);
+
+  if (size_ipv4 > data.size() / cache_ipv4_size || size_ipv6 > data.size() / cache_ipv6_size ||
+      data.size() != cache_header_size + size_ipv4 * cache_ipv4_size + size_ipv6 * cache_ipv6_size)
+    return false;
+
+  ipv4_list ipv4(size_ipv4);
+  ipv6_list ipv6(size_ipv6);
+
+  for (auto& range : ipv4) {
+    range.first = read_raw<uint32_t>(itr);
+    range.last  = read_raw<uint32_t>(itr);
+    range.value = read_raw<int32_t>(itr);
+  }
+
+  for (auto& range : ipv6) {
+    range.first = read_raw<ipv6_address>(itr);
+    range.last  = read_raw<ipv6_address>(itr);
+    range.value = read_raw<int32_t>(itr);
+  }
+
+  if (!is_valid_list(ipv4) || !is_valid_list(ipv6))
+    return false;
+
+  table->m_ipv4 = std::move(ipv4);
+  table->m_ipv6 = std::move(ipv6);
+  return true;
+}
+
+}
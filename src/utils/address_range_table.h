@@ -0,0 +1,91 @@
+#ifndef RTORRENT_UTILS_ADDRESS_RANGE_TABLE_H
+#define RTORRENT_UTILS_ADDRESS_RANGE_TABLE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct sockaddr;
+
+namespace utils {
+
+// Sorted, non-overlapping IPv4 and IPv6 address ranges with a value
+// each, looked up with a binary search.
+//
+// Ranges are added in bulk with 'merge', where later ranges override
+// earlier ones and the table's own where they overlap. The table has
+// no shared state, so a new one can be built in another thread and
+// swapped in once done.
+//
+// IPv4 addresses are in host byte order, IPv6 addresses in network
+// byte order. IPv4-mapped IPv6 addresses are stored and looked up as
+// IPv4.
+
+class AddressRangeTable {
+public:
+  using ipv6_address = std::array<uint8_t, 16>;
+
+  template <typename Address>
+  struct range_type {
+    Address first;
+    Address last;
+    int     value;
+
+    bool operator == (const range_type&) const = default;
+  };
+
+  using ipv4_range = range_type<uint32_t>;
+  using ipv6_range = range_type<ipv6_address>;
+  using ipv4_list  = std::vector<ipv4_range>;
+  using ipv6_list  = std::vector<ipv6_range>;
+
+  enum parse_result {
+    parse_none,
+    parse_ipv4,
+    parse_ipv6
+  };
+
+  bool                empty() const                 { return m_ipv4.empty() && m_ipv6.empty(); }
+  size_t              size_ipv4() const             { return m_ipv4.size(); }
+  size_t              size_ipv6() const             { return m_ipv6.size(); }
+  size_t              sizeof_data() const;
+
+  const ipv4_list&    ipv4() const                  { return m_ipv4; }
+  const ipv6_list&    ipv6() const                  { return m_ipv6; }
+
+  // Returns true if the whole range is within a single entry.
+  bool                find(uint32_t first, uint32_t last, int* value) const;
+  bool                find(const ipv6_address& first, const ipv6_address& last, int* value) const;
+  bool                find(const sockaddr* sa, int* value) const;
+
+  void                merge(ipv4_list ipv4, ipv6_list ipv6);
+
+  void                insert(const ipv4_range& range)  { merge(ipv4_list{range}, ipv6_list()); }
+  void                insert(const ipv6_range& range)  { merge(ipv4_list(), ipv6_list{range}); }
+
+  void                clear();
+
+  // Parses a single address, a CIDR block or an explicit 'first-last'
+  // range. Anything after '#' is a comment, and as in p2p files a
+  // label ending with ':' may come before the range.
+  static parse_result parse_range(std::string_view line, ipv4_range* ipv4, ipv6_range* ipv6);
+
+  // Parses a block list, one range per line, returning the number of
+  // lines with a range.
+  static size_t       parse_list(std::string_view data, int value, ipv4_list* ipv4, ipv6_list* ipv6);
+
+  // A dump of the ranges in native byte order, for caching a table
+  // on the local machine only.
+  std::string         serialize() const;
+  static bool         deserialize(std::string_view data, AddressRangeTable* table);
+
+private:
+  ipv4_list           m_ipv4;
+  ipv6_list           m_ipv6;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define RTORRENT_UTILS_DIRECTORY_H
 
 #include <cstdint>
+#include <dirent.h>
 #include <string>
 #include <vector>
 
@@ -11,6 +12,14 @@ struct directory_entry {
   // Fix.
   bool is_file() const { return true; }
 
+  // False only if d_type says the entry is neither a directory nor
+  // something that could point to one.
+#ifdef __sun__
+  bool may_be_directory() const { return true; }
+#else
+  bool may_be_directory() const { return s_type == DT_DIR || s_type == DT_LNK || s_type == DT_UNKNOWN; }
+#endif
+
   // The name and types should match POSIX.
   uint32_t            s_fileno;
   uint32_t            s_reclen; //Not used. Messes with Solaris.
@@ -55,6 +64,9 @@ public:
   bool                update(int flags);
 
 private:
+  bool                update_getdents(int flags);
+  bool                update_readdir(int flags);
+
   std::string         m_path;
 };
 
@@ -0,0 +1,65 @@
+#include "config.h"
+
+#include "utils/directory_cache.h"
+
+#include <sys/stat.h>
+
+#include "globals.h"
+
+namespace utils {
+
+const Directory*
+DirectoryCache::find(const std::string& path, bool* changed) {
+  struct stat st;
+
+  if (::stat(expand_path(path).c_str(), &st) == -1 || !S_ISDIR(st.st_mode)) {
+    m_entries.erase(path);
+    return nullptr;
+  }
+
+  time_t now = std::time(nullptr);
+  auto   result = m_entries.try_emplace(path);
+  auto&  entry = result.first->second;
+
+  entry.generation = m_generation;
+
+  if (!result.second &&
+      entry.mtime == st.st_mtime && entry.inode == st.st_ino && entry.device == st.st_dev &&
+      entry.mtime + 1 < entry.listed_at && now < entry.listed_at + refresh_interval) {
+    if (changed != nullptr)
+      *changed = now < entry.mtime + settle_time;
+
+    return &entry.directory;
+  }
+
+  entry.directory = Directory(path);
+
+  if (!entry.directory.update(0)) {
+    m_entries.erase(result.first);
+    return nullptr;
+  }
+
+  entry.mtime     = st.st_mtime;
+  entry.inode     = st.st_ino;
+  entry.device    = st.st_dev;
+  entry.listed_at = now;
+
+  if (changed != nullptr)
+    *changed = true;
+
+  return &entry.directory;
+}
+
+void
+DirectoryCache::prune() {
+  for (auto itr = m_entries.begin(); itr != m_entries.end(); ) {
+    if (itr->second.generation != m_generation)
+      itr = m_entries.erase(itr);
+    else
+      ++itr;
+  }
+
+  m_generation++;
+}
+
+}
@@ -0,0 +1,60 @@
+#ifndef RTORRENT_UTILS_DIRECTORY_CACHE_H
+#define RTORRENT_UTILS_DIRECTORY_CACHE_H
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+
+#include "utils/directory.h"
+
+namespace utils {
+
+// Caches directory listings used when expanding load.* globs, keyed
+// on the unexpanded path. A listing is reused as long as the
+// directory's mtime, inode and device are unchanged, so polling a
+// watch directory costs a single stat.
+//
+// Directory mtimes may have a granularity of a second, so a listing
+// read within a second of the last modification is re-read on the
+// next lookup. Listings are also re-read after 'refresh_interval'
+// seconds regardless, which bounds how long changes the mtime misses
+// can go unnoticed.
+//
+// Writing to a file doesn't touch the directory's mtime, so listings
+// of directories modified within 'settle_time' seconds are reported
+// as changed to let callers check files that are still being written.
+
+class DirectoryCache {
+public:
+  static constexpr time_t refresh_interval = 60;
+  static constexpr time_t settle_time      = 10;
+
+  // Returns nullptr if the path is not a readable directory. If
+  // 'changed' is non-null it is set to false when the listing was
+  // served unchanged from the cache and the directory has settled.
+  const Directory*    find(const std::string& path, bool* changed);
+
+  size_t              size() const { return m_entries.size(); }
+
+  // Remove listings that haven't been used since the last call.
+  void                prune();
+
+private:
+  struct entry_type {
+    Directory directory;
+    time_t    mtime{};
+    ino_t     inode{};
+    dev_t     device{};
+    time_t    listed_at{};
+    uint64_t  generation{};
+  };
+
+  std::unordered_map<std::string, entry_type> m_entries;
+  uint64_t                                    m_generation{};
+};
+
+}
+
+#endif
@@ -26,13 +26,27 @@ FileStatusCache::insert(const std::string& path) {
   // been replaced by another file, and thus should be re-tried.
   if (!result.second &&
       result.first->second.m_mtime == (uint32_t)fs.modified_time() &&
-      result.first->second.m_size == (int64_t)fs.size())
+      result.first->second.m_size == (int64_t)fs.size()) {
+    result.first->second.m_generation = m_generation;
     return false;
+  }
 
   result.first->second.m_flags = 0;
   result.first->second.m_size  = (int64_t)fs.size();
   result.first->second.m_mtime = fs.modified_time();
+  result.first->second.m_generation = m_generation;
+
+  return true;
+}
+
+bool
+FileStatusCache::touch(const std::string& path) {
+  iterator itr = base_type::find(path);
+
+  if (itr == end())
+    return false;
 
+  itr->second.m_generation = m_generation;
   return true;
 }
 
@@ -42,13 +56,21 @@ FileStatusCache::prune() {
 
   while (itr != end()) {
     torrent::utils::FileStat fs;
-    iterator tmp = itr++;
 
-    if (!fs.update(expand_path(tmp->first)) ||
-        tmp->second.m_mtime != (uint32_t)fs.modified_time() ||
-        tmp->second.m_size != (int64_t)fs.size())
-      base_type::erase(tmp);
+    if (itr->second.m_generation == m_generation) {
+      ++itr;
+      continue;
+    }
+
+    if (!fs.update(expand_path(itr->first)) ||
+        itr->second.m_mtime != (uint32_t)fs.modified_time() ||
+        itr->second.m_size != (int64_t)fs.size())
+      itr = base_type::erase(itr);
+    else
+      ++itr;
   }
+
+  m_generation++;
 }
 
 }
@@ -1,7 +1,7 @@
 #ifndef RTORRENT_UTILS_FILE_STATUS_CACHE_H
 #define RTORRENT_UTILS_FILE_STATUS_CACHE_H
 
-#include <map>
+#include <unordered_map>
 #include <string>
 #include <cinttypes>
 
@@ -11,22 +11,19 @@ struct file_status {
   int      m_flags;
   int64_t  m_size;
   uint32_t m_mtime;
+  uint64_t m_generation;
 };
 
-class FileStatusCache : public std::map<std::string, file_status> {
+class FileStatusCache : public std::unordered_map<std::string, file_status> {
 public:
-  typedef std::map<std::string, file_status> base_type;
+  typedef std::unordered_map<std::string, file_status> base_type;
 
   using base_type::iterator;
   using base_type::const_iterator;
-  using base_type::reverse_iterator;
-  using base_type::const_reverse_iterator;
   using base_type::value_type;
 
   using base_type::begin;
   using base_type::end;
-  using base_type::rbegin;
-  using base_type::rend;
 
   using base_type::empty;
   using base_type::size;
@@ -37,11 +34,17 @@ public:
   // status has changed.
   bool                insert(const std::string& path);
 
-  // Add a function for pruning a sorted list of paths.
+  // Mark an existing entry as seen without checking the file, returns
+  // false if there is no entry for the path.
+  bool                touch(const std::string& path);
 
   // Function for pruning entries that no longer points to a file, or
-  // has different status.
+  // has different status. Entries inserted or touched since the last
+  // prune are known to be in use and are kept without a stat.
   void                prune();
+
+private:
+  uint64_t            m_generation{};
 };
 
 }
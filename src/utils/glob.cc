@@ -0,0 +1,57 @@
+#include "config.h"
+
+#include "utils/glob.h"
+
+#include <algorithm>
+#include <fnmatch.h>
+
+namespace utils {
+
+namespace {
+
+inline bool glob_is_special(char c) { return c == '*' || c == '?' || c == '[' || c == ']' || c == '\\'; }
+
+}
+
+Glob::Glob(const std::string& pattern) :
+  m_pattern(pattern) {
+
+  auto first_special = std::find_if(m_pattern.begin(), m_pattern.end(), &glob_is_special);
+
+  if (first_special == m_pattern.end()) {
+    m_prefix_size = m_pattern.size();
+    return;
+  }
+
+  auto last_special = std::find_if(m_pattern.rbegin(), m_pattern.rend(), &glob_is_special);
+
+  m_prefix_size = std::distance(m_pattern.begin(), first_special);
+  m_suffix_size = std::distance(m_pattern.rbegin(), last_special);
+  m_literal     = false;
+}
+
+bool
+Glob::match(const std::string& str) const {
+  if (m_literal)
+    return str == m_pattern;
+
+  // Prefix and suffix are separated by at least one special
+  // character, so they can never overlap within a matching string.
+  if (str.size() < m_prefix_size + m_suffix_size)
+    return false;
+
+  if (str.compare(0, m_prefix_size, m_pattern, 0, m_prefix_size) != 0)
+    return false;
+
+  if (str.compare(str.size() - m_suffix_size, m_suffix_size, m_pattern, m_pattern.size() - m_suffix_size, m_suffix_size) != 0)
+    return false;
+
+  return fnmatch(m_pattern.c_str(), str.c_str(), 0) == 0;
+}
+
+bool
+GlobList::match_any(const std::string& str) const {
+  return std::any_of(begin(), end(), [&str](const Glob& glob) { return glob.match(str); });
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef RTORRENT_UTILS_GLOB_H
+#define RTORRENT_UTILS_GLOB_H
+
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// Compiled fnmatch(3) pattern, using the default flags.
+//
+// The literal prefix and suffix of the pattern are compared before
+// calling fnmatch, so the common 'dir/*' and '*.mkv' patterns reject
+// most paths without ever reaching it. Patterns without any special
+// characters are matched by string comparison only.
+
+class Glob {
+public:
+  Glob() = default;
+  explicit Glob(const std::string& pattern);
+
+  const std::string&  pattern() const    { return m_pattern; }
+  bool                is_literal() const { return m_literal; }
+
+  bool                match(const std::string& str) const;
+
+private:
+  std::string         m_pattern;
+
+  std::string::size_type m_prefix_size{};
+  std::string::size_type m_suffix_size{};
+
+  bool                m_literal{true};
+};
+
+class GlobList : private std::vector<Glob> {
+public:
+  typedef std::vector<Glob> base_type;
+
+  using base_type::const_iterator;
+  using base_type::begin;
+  using base_type::end;
+  using base_type::empty;
+  using base_type::size;
+
+  void                push_back(const std::string& pattern) { base_type::emplace_back(pattern); }
+
+  // An empty list matches nothing, callers should check empty() if
+  // that means 'match all'.
+  bool                match_any(const std::string& str) const;
+};
+
+}
+
+#endif
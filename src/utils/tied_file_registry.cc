@@ -0,0 +1,289 @@
+#include "config.h"
+
+#include "utils/tied_file_registry.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <torrent/exceptions.h>
+#include <torrent/system/callbacks.h>
+#include <torrent/system/thread.h>
+#include <torrent/utils/directory_events.h>
+#include <torrent/utils/file_stat.h>
+#include <torrent/utils/log.h>
+
+#include "globals.h"
+
+namespace utils {
+
+TiedFileRegistry::TiedFileRegistry() :
+  m_callback_id(torrent::system::make_callback_id()) {
+  m_task_reconcile.slot() = [this]() { process_reconcile(); };
+}
+
+TiedFileRegistry::~TiedFileRegistry() {
+  torrent::this_thread::scheduler()->erase(&m_task_reconcile);
+}
+
+void
+TiedFileRegistry::insert(core::Download* download) {
+  auto result = m_downloads.emplace(download, DownloadEntry{std::string(), ++m_sequence});
+
+  if (!result.second)
+    throw torrent::internal_error("TiedFileRegistry::insert(...) download already registered.");
+
+  result.first->second.path = m_slot_tied_path(download);
+
+  if (!result.first->second.path.empty())
+    insert_file(download, result.first->second.path);
+}
+
+void
+TiedFileRegistry::update(core::Download* download) {
+  auto itr = m_downloads.find(download);
+
+  if (itr == m_downloads.end())
+    return;
+
+  std::string path = m_slot_tied_path(download);
+
+  if (path == itr->second.path)
+    return;
+
+  if (!itr->second.path.empty())
+    erase_file(download, itr->second.path);
+
+  itr->second.path = std::move(path);
+
+  if (!itr->second.path.empty())
+    insert_file(download, itr->second.path);
+}
+
+void
+TiedFileRegistry::erase(core::Download* download) {
+  auto itr = m_downloads.find(download);
+
+  if (itr == m_downloads.end())
+    return;
+
+  if (!itr->second.path.empty())
+    erase_file(download, itr->second.path);
+
+  m_downloads.erase(itr);
+}
+
+void
+TiedFileRegistry::shutdown() {
+  m_active = false;
+
+  torrent::this_thread::scheduler()->erase(&m_task_reconcile);
+  torrent::system::cancel_callback_and_wait(m_callback_id, session_thread::thread(), torrent::main_thread::thread());
+
+  m_reconciling = false;
+}
+
+TiedFileRegistry::file_state
+TiedFileRegistry::state(core::Download* download) const {
+  auto download_itr = m_downloads.find(download);
+
+  if (download_itr == m_downloads.end() || download_itr->second.path.empty())
+    return state_unknown;
+
+  auto file_itr = m_files.find(download_itr->second.path);
+
+  if (file_itr == m_files.end())
+    throw torrent::internal_error("TiedFileRegistry::state(...) download has no file entry.");
+
+  return file_itr->second.state;
+}
+
+TiedFileRegistry::download_list
+TiedFileRegistry::downloads_with_state(file_state state) const {
+  std::vector<std::pair<uint64_t, core::Download*>> entries;
+
+  for (const auto& [path, file] : m_files)
+    if (file.state == state)
+      for (auto download : file.downloads)
+        entries.emplace_back(m_downloads.at(download).sequence, download);
+
+  std::sort(entries.begin(), entries.end());
+
+  download_list result;
+  result.reserve(entries.size());
+
+  for (const auto& entry : entries)
+    result.push_back(entry.second);
+
+  return result;
+}
+
+size_t
+TiedFileRegistry::count_state(file_state state) const {
+  return std::count_if(m_files.begin(), m_files.end(), [state](const auto& entry) { return entry.second.state == state; });
+}
+
+// A periodic reconciliation already waiting is moved to the new
+// interval, while one queued to run right away is left alone.
+
+void
+TiedFileRegistry::set_reconcile_interval(std::chrono::seconds interval) {
+  m_reconcile_interval = interval;
+
+  if (m_task_reconcile.is_scheduled() && m_periodic)
+    torrent::this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_reconcile, m_reconcile_interval);
+}
+
+void
+TiedFileRegistry::reconcile() {
+  schedule_reconcile(std::chrono::seconds(0));
+}
+
+void
+TiedFileRegistry::insert_file(core::Download* download, const std::string& path) {
+  auto result = m_files.emplace(path, File());
+
+  result.first->second.downloads.push_back(download);
+
+  if (!result.second)
+    return;
+
+  result.first->second.generation = ++m_generation;
+
+  watch_directory(path);
+  schedule_reconcile(std::chrono::seconds(0));
+}
+
+void
+TiedFileRegistry::erase_file(core::Download* download, const std::string& path) {
+  auto itr = m_files.find(path);
+
+  if (itr == m_files.end())
+    throw torrent::internal_error("TiedFileRegistry::erase_file(...) could not find file entry.");
+
+  auto& downloads = itr->second.downloads;
+  downloads.erase(std::remove(downloads.begin(), downloads.end(), download), downloads.end());
+
+  if (downloads.empty())
+    m_files.erase(itr);
+}
+
+// Directory watches are kept until shutdown as directory_events has
+// no way of removing them, so a directory is only ever watched once.
+
+void
+TiedFileRegistry::watch_directory(const std::string& path) {
+  auto pos = path.rfind('/');
+
+  if (pos == std::string::npos || !m_active)
+    return;
+
+  auto events = m_slot_directory_events ? m_slot_directory_events() : nullptr;
+
+  if (events == nullptr)
+    return;
+
+  std::string directory = path.substr(0, pos + 1);
+
+  if (!m_directories.insert(directory).second)
+    return;
+
+  if (!events->open()) {
+    lt_log_print(torrent::LOG_SYSTEM, "system: Could not open inotify for tied files: %s", std::strerror(errno));
+    return;
+  }
+
+  try {
+    events->notify_on(directory.c_str(),
+                      torrent::directory_events::flag_on_added | torrent::directory_events::flag_on_updated,
+                      [this](const std::string& event_path) { receive_event(event_path); });
+
+  } catch (const torrent::input_error& e) {
+    lt_log_print(torrent::LOG_SYSTEM, "system: Could not watch tied file directory \"%s\": %s", directory.c_str(), e.what());
+  }
+}
+
+void
+TiedFileRegistry::receive_event(const std::string& path) {
+  auto itr = m_files.find(path);
+
+  if (itr == m_files.end())
+    return;
+
+  torrent::utils::FileStat fs;
+  set_file_state(&itr->second, fs.update(path) ? state_present : state_missing);
+}
+
+void
+TiedFileRegistry::set_file_state(File* file, file_state state) {
+  file->state = state;
+  file->generation = ++m_generation;
+}
+
+// The stats are done in the session thread as tied files may well
+// live on slow network filesystems. Files whose state was changed by
+// an inotify event while the stats were in progress keep that state.
+
+void
+TiedFileRegistry::process_reconcile() {
+  if (!m_active || m_reconciling || m_files.empty())
+    return;
+
+  std::vector<std::string> paths;
+  paths.reserve(m_files.size());
+
+  for (const auto& entry : m_files)
+    paths.push_back(entry.first);
+
+  m_reconciling = true;
+
+  session_thread::callback(m_callback_id, [this, paths = std::move(paths), generation = m_generation]() mutable {
+      std::vector<char> exists;
+      exists.reserve(paths.size());
+
+      for (const auto& path : paths) {
+        torrent::utils::FileStat fs;
+        exists.push_back(fs.update(path));
+      }
+
+      torrent::main_thread::callback(m_callback_id, [this, paths = std::move(paths), exists = std::move(exists), generation]() mutable {
+          receive_reconcile(std::move(paths), std::move(exists), generation);
+        });
+    });
+}
+
+void
+TiedFileRegistry::receive_reconcile(std::vector<std::string> paths, std::vector<char> exists, uint64_t generation) {
+  m_reconciling = false;
+
+  if (!m_active)
+    return;
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    auto itr = m_files.find(paths[i]);
+
+    if (itr == m_files.end() || itr->second.generation > generation)
+      continue;
+
+    set_file_state(&itr->second, exists[i] ? state_present : state_missing);
+  }
+
+  if (count_state(state_unknown) != 0)
+    schedule_reconcile(std::chrono::seconds(0));
+  else
+    schedule_reconcile(m_reconcile_interval);
+}
+
+void
+TiedFileRegistry::schedule_reconcile(std::chrono::seconds delay) {
+  if (!m_active || m_reconciling)
+    return;
+
+  if (m_task_reconcile.is_scheduled() && delay != std::chrono::seconds(0))
+    return;
+
+  m_periodic = delay != std::chrono::seconds(0);
+
+  torrent::this_thread::scheduler()->update_wait_for_ceil_seconds(&m_task_reconcile, delay);
+}
+
+}
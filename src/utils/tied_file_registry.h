@@ -0,0 +1,142 @@
+#ifndef RTORRENT_UTILS_TIED_FILE_REGISTRY_H
+#define RTORRENT_UTILS_TIED_FILE_REGISTRY_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <torrent/common.h>
+#include <torrent/system/scheduler.h>
+
+namespace core {
+class Download;
+}
+
+namespace torrent {
+class directory_events;
+}
+
+namespace utils {
+
+// Keeps track of whether the files downloads are tied to exist, so
+// that 'start_tied' and friends don't need to stat every tied file
+// on each call.
+//
+// Parent directories are watched using directory_events, and files
+// showing up there are checked immediately. Everything else, such as
+// removed files or directories inotify can't watch, is caught by a
+// periodic reconciliation that stats the files in the session thread.
+//
+// Files start out in the unknown state and are only acted upon once
+// they've been checked.
+
+class TiedFileRegistry {
+public:
+  enum file_state {
+    state_unknown,
+    state_present,
+    state_missing
+  };
+
+  using download_list = std::vector<core::Download*>;
+
+  using slot_path     = std::function<std::string (core::Download*)>;
+  using slot_events   = std::function<torrent::directory_events* ()>;
+
+  static constexpr auto default_reconcile_interval = std::chrono::seconds(60);
+
+  TiedFileRegistry();
+  ~TiedFileRegistry();
+
+  // Control sets these to return the expanded path of the download's
+  // tied file, or an empty string, and the directory_events used for
+  // the watches. Directories aren't watched if there are no events.
+  slot_path&          slot_tied_path()                { return m_slot_tied_path; }
+  slot_events&        slot_directory_events()         { return m_slot_directory_events; }
+
+  // Downloads are registered when inserted into DownloadList and
+  // 'update' must be called whenever their tied file changes.
+  void                insert(core::Download* download);
+  void                update(core::Download* download);
+  void                erase(core::Download* download);
+
+  void                shutdown();
+
+  file_state          state(core::Download* download) const;
+
+  // In the order the downloads were registered.
+  download_list       downloads_with_state(file_state state) const;
+
+  size_t              size_downloads() const          { return m_downloads.size(); }
+  size_t              size_files() const              { return m_files.size(); }
+  size_t              size_directories() const        { return m_directories.size(); }
+  size_t              count_state(file_state state) const;
+
+  std::chrono::seconds reconcile_interval() const     { return m_reconcile_interval; }
+  void                set_reconcile_interval(std::chrono::seconds interval);
+
+  // Queue a reconciliation as soon as possible.
+  void                reconcile();
+
+  // A file in a watched directory was added or updated, checks it
+  // right away.
+  void                receive_event(const std::string& path);
+
+  // The result of stating 'paths' in a reconciliation started at
+  // 'generation', files changed since then keep their state.
+  void                receive_reconcile(std::vector<std::string> paths, std::vector<char> exists, uint64_t generation);
+
+  // Increases whenever a file is added or its state changes.
+  uint64_t            generation() const              { return m_generation; }
+
+private:
+  struct File {
+    download_list downloads;
+    file_state    state{state_unknown};
+    uint64_t      generation{};
+  };
+
+  struct DownloadEntry {
+    std::string   path;
+    uint64_t      sequence{};
+  };
+
+  using file_map      = std::unordered_map<std::string, File>;
+  using download_map  = std::unordered_map<core::Download*, DownloadEntry>;
+  using directory_set = std::unordered_set<std::string>;
+
+  void                insert_file(core::Download* download, const std::string& path);
+  void                erase_file(core::Download* download, const std::string& path);
+
+  void                watch_directory(const std::string& path);
+
+  void                set_file_state(File* file, file_state state);
+
+  void                process_reconcile();
+  void                schedule_reconcile(std::chrono::seconds delay);
+
+  file_map            m_files;
+  download_map        m_downloads;
+  directory_set       m_directories;
+
+  bool                m_active{true};
+  bool                m_reconciling{false};
+  bool                m_periodic{false};
+  uint64_t            m_generation{};
+  uint64_t            m_sequence{};
+
+  std::chrono::seconds m_reconcile_interval{default_reconcile_interval};
+
+  slot_path           m_slot_tied_path;
+  slot_events         m_slot_directory_events;
+
+  torrent::system::SchedulerEntry m_task_reconcile;
+  torrent::system::callback_id    m_callback_id;
+};
+
+}
+
+#endif
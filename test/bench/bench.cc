@@ -0,0 +1,64 @@
+#include "config.h"
+
+#include "test/bench/bench.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace bench {
+
+void
+Runner::run(const std::string& name, uint64_t items, const slot_type& slot) {
+  if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+    return;
+
+  std::cerr << "running " << name << std::endl;
+
+  // Warm up caches and any lazily built state.
+  slot();
+
+  uint64_t                 iterations = 1;
+  std::chrono::nanoseconds elapsed;
+
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i != iterations; i++)
+      slot();
+
+    elapsed = std::chrono::steady_clock::now() - start;
+
+    if (elapsed >= m_min_time || iterations >= (uint64_t(1) << 32))
+      break;
+
+    iterations *= 2;
+  }
+
+  double ns_per_iteration = double(elapsed.count()) / iterations;
+
+  m_results.push_back(result_type{name, items, iterations, ns_per_iteration, ns_per_iteration / std::max<uint64_t>(items, 1)});
+}
+
+void
+Runner::write_json(std::ostream& output, uint64_t download_count) const {
+  output << "{\"downloads\":" << download_count << ",\"benchmarks\":[";
+
+  for (auto itr = m_results.begin(); itr != m_results.end(); itr++) {
+    if (itr != m_results.begin())
+      output << ",";
+
+    // Benchmark names are plain identifiers, no escaping needed.
+    output << "{\"name\":\"" << itr->name << "\""
+           << ",\"items\":" << itr->items
+           << ",\"iterations\":" << itr->iterations
+           << std::fixed << std::setprecision(1)
+           << ",\"ns_per_iteration\":" << itr->ns_per_iteration
+           << ",\"ns_per_item\":" << itr->ns_per_item
+           << std::defaultfloat << "}";
+  }
+
+  output << "]}" << std::endl;
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef RTORRENT_TEST_BENCH_BENCH_H
+#define RTORRENT_TEST_BENCH_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Runs each benchmark with a doubling number of iterations until a
+// single round takes at least 'min_time', and reports the time per
+// iteration and per item from that final round.
+//
+// 'items' is the number of elements handled by one iteration, e.g. the
+// number of downloads in a d.multicall, so that results stay
+// comparable when the fixture size changes.
+
+struct result_type {
+  std::string   name;
+  uint64_t      items;
+  uint64_t      iterations;
+  double        ns_per_iteration;
+  double        ns_per_item;
+};
+
+class Runner {
+public:
+  typedef std::function<void()> slot_type;
+
+  Runner(const std::string& filter, std::chrono::nanoseconds min_time) :
+    m_filter(filter), m_min_time(min_time) {}
+
+  void                run(const std::string& name, uint64_t items, const slot_type& slot);
+
+  const std::vector<result_type>& results() const { return m_results; }
+
+  void                write_json(std::ostream& output, uint64_t download_count) const;
+
+private:
+  std::string               m_filter;
+  std::chrono::nanoseconds  m_min_time;
+
+  std::vector<result_type>  m_results;
+};
+
+void register_rpc_benchmarks(Runner& runner);
+void register_download_benchmarks(Runner& runner, uint64_t download_count);
+void register_utils_benchmarks(Runner& runner);
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "config.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <torrent/exceptions.h>
+#include <torrent/object.h>
+
+#include "control.h"
+#include "globals.h"
+#include "core/download.h"
+#include "core/download_list.h"
+#include "core/manager.h"
+#include "core/view.h"
+#include "core/view_manager.h"
+#include "rpc/parse_commands.h"
+#include "session/download_storer.h"
+#include "test/bench/bench.h"
+
+namespace bench {
+
+namespace {
+
+std::vector<std::shared_ptr<core::Download>> bench_downloads;
+
+// Synthetic single-file torrents with 1-64 pieces of 1 MiB. The name
+// makes each info hash unique.
+torrent::Object*
+create_torrent(uint64_t index) {
+  auto     torrent = new torrent::Object(torrent::Object::create_map());
+  auto&    info    = torrent->insert_key("info", torrent::Object::create_map());
+  uint64_t chunks  = index % 64 + 1;
+
+  info.insert_key("name", "bench-" + std::to_string(index));
+  info.insert_key("piece length", (int64_t)1 << 20);
+  info.insert_key("length", (int64_t)(chunks << 20));
+  info.insert_key("pieces", std::string(chunks * 20, (char)index));
+
+  auto& rtorrent = torrent->insert_key("rtorrent", torrent::Object::create_map());
+
+  rtorrent.insert_key("custom1", std::string());
+
+  torrent->insert_key("libtorrent_resume", torrent::Object::create_map());
+
+  return torrent;
+}
+
+core::View*
+create_view(const std::string& name) {
+  auto view = *control->view_manager()->insert(name);
+
+  for (const auto& download : bench_downloads)
+    view->insert(download);
+
+  // Downloads inserted directly start out filtered, the empty filter
+  // makes them all visible.
+  view->filter();
+  return view;
+}
+
+}
+
+void
+register_download_benchmarks(Runner& runner, uint64_t download_count) {
+  for (uint64_t i = bench_downloads.size(); i != download_count; i++) {
+    auto download = control->core()->download_list()->create(create_torrent(i), 0, true);
+
+    if (download == nullptr)
+      throw torrent::internal_error("register_download_benchmarks() could not create download.");
+
+    download->set_state(i % 2);
+    download->set_complete(i % 3 == 0);
+    download->set_priority(i % 4);
+
+    bench_downloads.emplace_back(download);
+  }
+
+  create_view("bench");
+
+  auto multicall_args = torrent::Object::create_list();
+  multicall_args.as_list().push_back("bench");
+
+  for (auto cmd : {"d.hash=", "d.name=", "d.size_bytes=", "d.state=", "d.complete=", "d.priority=", "d.custom1="})
+    multicall_args.as_list().push_back(cmd);
+
+  runner.run("download.d_multicall", download_count, [&multicall_args]() {
+      rpc::commands.call_command("d.multicall", multicall_args);
+    });
+
+  auto filter_view = create_view("bench_filter");
+  bool filter_state = false;
+
+  // Alternate between two filters so that every round moves downloads
+  // between the visible and filtered ranges.
+  runner.run("view.filter", download_count, [filter_view, &filter_state]() {
+      filter_view->set_filter(torrent::Object(filter_state ? "d.state=" : "d.complete="));
+      filter_view->filter();
+      filter_state = !filter_state;
+    });
+
+  auto sort_view = create_view("bench_sort");
+  bool sort_state = false;
+
+  runner.run("view.sort", download_count, [sort_view, &sort_state]() {
+      sort_view->set_sort_current(torrent::Object(sort_state ? "less=d.name=" : "greater=d.size_bytes="));
+      sort_view->sort();
+      sort_state = !sort_state;
+    });
+
+  runner.run("session.download_storer.build_streams", download_count, []() {
+      for (const auto& download : bench_downloads) {
+        session::DownloadStorer storer(download.get());
+        storer.build_full_streams();
+      }
+    });
+}
+
+}
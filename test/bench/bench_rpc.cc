@@ -0,0 +1,76 @@
+#include "config.h"
+
+#include <string>
+#include <torrent/exceptions.h>
+
+#include "command_helpers.h"
+#include "rpc/command_map.h"
+#include "rpc/jsonrpc.h"
+#include "rpc/parse_commands.h"
+#include "rpc/xmlrpc.h"
+#include "test/bench/bench.h"
+
+namespace bench {
+
+namespace {
+
+torrent::Object
+cmd_bench_reflect([[maybe_unused]] rpc::target_type target, const torrent::Object& obj) {
+  return obj;
+}
+
+const std::string parse_command_input = "cat=foo,bar,\"baz qux\",{1,2,3}";
+
+const std::string jsonrpc_request =
+  R"({"jsonrpc": "2.0", "method": "bench.reflect", "params": ["", "foo", 1, [1, 2, 3], {"a": "b"}], "id": 1})";
+
+const std::string xmlrpc_request =
+  "<?xml version=\"1.0\"?><methodCall><methodName>bench.reflect</methodName><params>"
+  "<param><value><string></string></value></param>"
+  "<param><value><string>foo</string></value></param>"
+  "<param><value><i8>1</i8></value></param>"
+  "<param><value><array><data><value><i4>1</i4></value><value><i4>2</i4></value></data></array></value></param>"
+  "</params></methodCall>";
+
+}
+
+void
+register_rpc_benchmarks(Runner& runner) {
+  if (!rpc::commands.has("bench.reflect"))
+    CMD2_ANY("bench.reflect", &cmd_bench_reflect);
+
+  runner.run("rpc.parse_command", 1, []() {
+      rpc::parse_command(rpc::make_target(), parse_command_input.c_str(), parse_command_input.c_str() + parse_command_input.size());
+    });
+
+  runner.run("rpc.call_command", 1, []() {
+      rpc::commands.call_command("bench.reflect", torrent::Object("foo"));
+    });
+
+  runner.run("rpc.call_command.missing", 1, []() {
+      try {
+        rpc::commands.call_command("bench.missing", torrent::Object());
+      } catch (torrent::input_error&) {
+      }
+    });
+
+  rpc::JsonRpc jsonrpc;
+  jsonrpc.initialize();
+
+  runner.run("rpc.jsonrpc.process", 1, [&jsonrpc]() {
+      std::string output;
+      jsonrpc.process(jsonrpc_request.c_str(), jsonrpc_request.size(), [&output](const char* c, uint32_t l) { output.append(c, l); return true; });
+    });
+
+#if defined(HAVE_XMLRPC_TINYXML2) || defined(HAVE_XMLRPC_C)
+  rpc::XmlRpc xmlrpc;
+  xmlrpc.initialize();
+
+  runner.run("rpc.xmlrpc.process", 1, [&xmlrpc]() {
+      std::string output;
+      xmlrpc.process(xmlrpc_request.c_str(), xmlrpc_request.size(), [&output](const char* c, uint32_t l) { output.append(c, l); return true; });
+    });
+#endif
+}
+
+}
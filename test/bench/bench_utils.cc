@@ -0,0 +1,27 @@
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+#include "test/bench/bench.h"
+#include "utils/gzip.h"
+
+namespace bench {
+
+void
+register_utils_benchmarks(Runner& runner) {
+  // A typical d.multicall response body, repetitive enough to compress
+  // the way real RPC output does.
+  std::string input;
+
+  for (int i = 0; input.size() < (1 << 20); i++)
+    input += "<value><array><data><value><string>download-" + std::to_string(i) +
+             "</string></value><value><i8>" + std::to_string(i * 4099) + "</i8></value></data></array></value>";
+
+  runner.run("utils.gzip_compress_to_vector", input.size(), [&input]() {
+      std::vector<char> output;
+      utils::gzip_compress_to_vector(input.c_str(), input.size(), output);
+    });
+}
+
+}
@@ -0,0 +1,63 @@
+#include "config.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <torrent/exceptions.h>
+#include <torrent/torrent.h>
+#include <torrent/utils/log.h>
+
+#include "control.h"
+#include "command_helpers.h"
+#include "globals.h"
+#include "scgi/thread_scgi.h"
+#include "session/thread_session.h"
+#include "test/bench/bench.h"
+
+// Usage: rtorrent_bench [download count] [name filter]
+//
+// Results are written as JSON to stdout, progress to stderr. The
+// minimum time per benchmark in milliseconds can be set with the
+// BENCH_MIN_TIME environment variable.
+
+int
+main(int argc, char** argv) {
+  uint64_t    download_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+  std::string filter         = argc > 2 ? argv[2] : "";
+  const char* min_time_env   = std::getenv("BENCH_MIN_TIME");
+
+  auto min_time = std::chrono::milliseconds(min_time_env != nullptr ? std::strtoul(min_time_env, nullptr, 10) : 200);
+
+  try {
+    setlocale(LC_ALL, "");
+
+    // Same initialization order as rtorrent's main, without the
+    // display, signal handlers or any network activity.
+    torrent::log_initialize();
+    torrent::initialize_main_thread();
+
+    control = new Control;
+
+    torrent::initialize();
+
+    scgi::ThreadScgi::create_thread();
+    session::ThreadSession::create_thread();
+
+    initialize_commands();
+
+    bench::Runner runner(filter, min_time);
+
+    bench::register_rpc_benchmarks(runner);
+    bench::register_download_benchmarks(runner, download_count);
+    bench::register_utils_benchmarks(runner);
+
+    runner.write_json(std::cout, download_count);
+
+  } catch (torrent::base_error& e) {
+    std::cerr << "rtorrent_bench: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // Skip the orderly shutdown, the process state is of no further use.
+  std::_Exit(0);
+}
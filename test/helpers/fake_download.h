@@ -0,0 +1,17 @@
+#ifndef TEST_HELPERS_FAKE_DOWNLOAD_H
+#define TEST_HELPERS_FAKE_DOWNLOAD_H
+
+#include <cstdint>
+
+namespace core {
+class Download;
+}
+
+// Distinct download pointers for tests of code that only uses
+// downloads as keys, they must never be dereferenced.
+inline core::Download*
+fake_download(uintptr_t id) {
+  return reinterpret_cast<core::Download*>(id * 8);
+}
+
+#endif
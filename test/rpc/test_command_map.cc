@@ -2,8 +2,12 @@
 
 #include "test/rpc/test_command_map.h"
 
+#include <numeric>
+#include <vector>
+
 #include "command_helpers.h"
 #include "rpc/command_map.h"
+#include "rpc/rpc_manager.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestCommandMap);
 
@@ -28,3 +32,67 @@ TestCommandMap::test_basics() {
   CPPUNIT_ASSERT(m_map.call_command("test_b", (int64_t)1).as_value() == 2);
   CPPUNIT_ASSERT(m_map.call_command("any_string", "").as_value() == 3);
 }
+
+void
+TestCommandMap::test_profile() {
+  CMD2_ANY("test_a", &cmd_test_map_a);
+  CMD2_ANY("test_nested", [this](auto, auto& obj) { return m_map.call_command("test_a", obj); });
+
+  CPPUNIT_ASSERT(!m_map.is_profiling());
+
+  m_map.call_command("test_a", (int64_t)1);
+  CPPUNIT_ASSERT(m_map.find("test_a")->second.m_profile.calls == 0);
+
+  m_map.set_profiling(true);
+  m_map.call_command("test_a", (int64_t)1);
+  m_map.call_command("test_nested", (int64_t)1);
+
+  auto& profile_a      = m_map.find("test_a")->second.m_profile;
+  auto& profile_nested = m_map.find("test_nested")->second.m_profile;
+
+  CPPUNIT_ASSERT(profile_a.calls == 2);
+  CPPUNIT_ASSERT(profile_nested.calls == 1);
+  CPPUNIT_ASSERT(std::accumulate(profile_a.histogram.begin(), profile_a.histogram.end(), uint64_t()) == 2);
+  CPPUNIT_ASSERT(profile_a.self_time == profile_a.inclusive_time);
+  CPPUNIT_ASSERT(profile_nested.self_time <= profile_nested.inclusive_time);
+
+  m_map.reset_profile();
+  CPPUNIT_ASSERT(m_map.find("test_a")->second.m_profile.calls == 0);
+  CPPUNIT_ASSERT(m_map.find("test_nested")->second.m_profile.inclusive_time == 0);
+}
+
+void
+TestCommandMap::test_profile_bucket() {
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(0) == 0);
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(999) == 0);
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(1000) == 1);
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(3999) == 2);
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(4000) == 3);
+  CPPUNIT_ASSERT(rpc::CommandMap::profile_bucket(~uint64_t()) == rpc::command_profile_type::histogram_size - 1);
+}
+
+void
+TestCommandMap::test_park() {
+  std::vector<bool> allowed;
+
+  CMD2_ANY("test_a", &cmd_test_map_a);
+  CMD2_ANY("test_park", [&allowed](auto, auto&) { allowed.push_back(rpc::rpc.is_park_allowed()); return torrent::Object(); });
+  CMD2_ANY("test_nested", [this](auto, auto& obj) { return m_map.call_command("test_park", obj); });
+
+  m_map.call_command("test_park", torrent::Object());
+
+  rpc::rpc.set_park_allowed(true);
+  m_map.call_command("test_park", torrent::Object());
+  m_map.call_command("test_park", torrent::Object());
+
+  rpc::rpc.set_park_allowed(true);
+  m_map.call_command("test_nested", torrent::Object());
+
+  rpc::rpc.set_park_allowed(true);
+  m_map.call_command("test_a", torrent::Object());
+  m_map.call_command("test_park", torrent::Object());
+
+  // Only the first top-level command of the request may park.
+  CPPUNIT_ASSERT(allowed == std::vector<bool>({false, true, false, false, false}));
+  CPPUNIT_ASSERT(!rpc::rpc.is_park_enabled());
+}
@@ -3,17 +3,27 @@
 #include "test/rpc/test_jsonrpc.h"
 
 #include <string>
+#include <vector>
 
 #include "control.h"
 #include "globals.h"
 #include "command_helpers.h"
 #include "rpc/command_map.h"
+#include "rpc/rpc_manager.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestJsonrpc);
 
 torrent::Object
 jsonrpc_cmd_test_reflect([[maybe_unused]] rpc::target_type t, const torrent::Object& obj) { return obj; }
 
+static std::vector<bool> jsonrpc_park_allowed;
+
+torrent::Object
+jsonrpc_cmd_test_park([[maybe_unused]] rpc::target_type t, [[maybe_unused]] const torrent::Object& obj) {
+  jsonrpc_park_allowed.push_back(rpc::rpc.is_park_allowed());
+  return torrent::Object();
+}
+
 void initialize_command_dynamic();
 
 // Name, Request, Expected response
@@ -130,6 +140,10 @@ TestJsonrpc::setUp() {
   if (rpc::commands.find("jsonrpc_reflect") == rpc::commands.end()) {
     CMD2_ANY("jsonrpc_reflect", &jsonrpc_cmd_test_reflect);
   }
+
+  if (rpc::commands.find("jsonrpc_park") == rpc::commands.end()) {
+    CMD2_ANY("jsonrpc_park", &jsonrpc_cmd_test_park);
+  }
 }
 
 void
@@ -145,3 +159,23 @@ TestJsonrpc::test_basics() {
     CPPUNIT_ASSERT_EQUAL_MESSAGE(std::get<0>(test), std::get<2>(test), output);
   }
 }
+
+void
+TestJsonrpc::test_park() {
+  std::string single = R"({"jsonrpc": "2.0", "method": "jsonrpc_park", "id": 1})";
+  std::string batch  = R"([{"jsonrpc": "2.0", "method": "jsonrpc_park", "id": 1}, {"jsonrpc": "2.0", "method": "jsonrpc_reflect", "id": 2}])";
+
+  auto process = [this](const std::string& request) {
+      rpc::rpc.set_park_allowed(true);
+      m_jsonrpc.process(request.c_str(), request.size(), [](const char*, uint32_t) { return true; });
+      rpc::rpc.set_park_allowed(false);
+    };
+
+  jsonrpc_park_allowed.clear();
+
+  process(single);
+  process(batch);
+
+  // A parked batch would run every call in it again.
+  CPPUNIT_ASSERT(jsonrpc_park_allowed == std::vector<bool>({true, false}));
+}
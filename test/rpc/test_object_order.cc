@@ -0,0 +1,65 @@
+#include "config.h"
+
+#include "test/rpc/test_object_order.h"
+
+#include "rpc/object_order.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestObjectOrder);
+
+typedef std::vector<size_t> index_list;
+
+// Positions 1 and 4 tie, as do 2 and 5.
+static std::vector<torrent::Object>
+make_keys() {
+  return std::vector<torrent::Object>{
+    torrent::Object(std::string("b")),
+    torrent::Object(int64_t{3}),
+    torrent::Object(std::string("a")),
+    torrent::Object(int64_t{1}),
+    torrent::Object(int64_t{3}),
+    torrent::Object(std::string("a")),
+  };
+}
+
+void
+TestObjectOrder::test_compare() {
+  CPPUNIT_ASSERT(rpc::object_order_compare(int64_t{1}, int64_t{2}) < 0);
+  CPPUNIT_ASSERT(rpc::object_order_compare(int64_t{2}, int64_t{1}) > 0);
+  CPPUNIT_ASSERT(rpc::object_order_compare(int64_t{2}, int64_t{2}) == 0);
+
+  CPPUNIT_ASSERT(rpc::object_order_compare(std::string("a"), std::string("b")) < 0);
+  CPPUNIT_ASSERT(rpc::object_order_compare(std::string("b"), std::string("a")) > 0);
+  CPPUNIT_ASSERT(rpc::object_order_compare(std::string("a"), std::string("a")) == 0);
+
+  CPPUNIT_ASSERT(rpc::object_order_compare(int64_t{100}, std::string("a")) < 0);
+  CPPUNIT_ASSERT(rpc::object_order_compare(std::string("a"), int64_t{100}) > 0);
+
+  CPPUNIT_ASSERT(rpc::object_order_compare(torrent::Object::create_list(), torrent::Object::create_list()) == 0);
+}
+
+void
+TestObjectOrder::test_range() {
+  auto keys = make_keys();
+
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, false, 0, 6) == (index_list{3, 1, 4, 2, 5, 0}));
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, false, 2, 4) == (index_list{4, 2}));
+}
+
+void
+TestObjectOrder::test_range_descending() {
+  auto keys = make_keys();
+
+  // Ties keep their original order.
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, true, 0, 6) == (index_list{0, 2, 5, 1, 4, 3}));
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, true, 1, 3) == (index_list{2, 5}));
+}
+
+void
+TestObjectOrder::test_range_bounds() {
+  auto keys = make_keys();
+
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, false, 4, 100) == (index_list{5, 0}));
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, false, 10, 20).empty());
+  CPPUNIT_ASSERT(rpc::object_order_range(keys, false, 3, 3).empty());
+  CPPUNIT_ASSERT(rpc::object_order_range({}, false, 0, 10).empty());
+}
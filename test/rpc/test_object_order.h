@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class TestObjectOrder : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestObjectOrder);
+
+  CPPUNIT_TEST(test_compare);
+  CPPUNIT_TEST(test_range);
+  CPPUNIT_TEST(test_range_descending);
+  CPPUNIT_TEST(test_range_bounds);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_compare();
+  void test_range();
+  void test_range_descending();
+  void test_range_bounds();
+};
@@ -0,0 +1,157 @@
+#include "config.h"
+
+#include "test/src/test_address_range_table.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "utils/address_range_table.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestAddressRangeTable);
+
+using utils::AddressRangeTable;
+
+static AddressRangeTable::ipv6_address
+make_ipv6(const char* str) {
+  AddressRangeTable::ipv6_address address;
+  CPPUNIT_ASSERT(inet_pton(AF_INET6, str, address.data()) == 1);
+  return address;
+}
+
+void
+TestAddressRangeTable::test_parse_range() {
+  AddressRangeTable::ipv4_range range4;
+  AddressRangeTable::ipv6_range range6;
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("10.0.0.1", &range4, &range6) == AddressRangeTable::parse_ipv4);
+  CPPUNIT_ASSERT(range4.first == 0x0a000001 && range4.last == 0x0a000001);
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("10.1.2.3/8 # comment", &range4, &range6) == AddressRangeTable::parse_ipv4);
+  CPPUNIT_ASSERT(range4.first == 0x0a000000 && range4.last == 0x0affffff);
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("Some Org:1.2.3.0 - 1.2.3.255", &range4, &range6) == AddressRangeTable::parse_ipv4);
+  CPPUNIT_ASSERT(range4.first == 0x01020300 && range4.last == 0x010203ff);
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("::ffff:1.2.3.4", &range4, &range6) == AddressRangeTable::parse_ipv4);
+  CPPUNIT_ASSERT(range4.first == 0x01020304 && range4.last == 0x01020304);
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("Some-Org:2001:db8::/32", &range4, &range6) == AddressRangeTable::parse_ipv6);
+  CPPUNIT_ASSERT(range6.first == make_ipv6("2001:db8::"));
+  CPPUNIT_ASSERT(range6.last == make_ipv6("2001:db8:ffff:ffff:ffff:ffff:ffff:ffff"));
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("2001:db8::1-2001:db8::5", &range4, &range6) == AddressRangeTable::parse_ipv6);
+  CPPUNIT_ASSERT(range6.first == make_ipv6("2001:db8::1") && range6.last == make_ipv6("2001:db8::5"));
+
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("1.2.3.4-1.2.3.0", &range4, &range6) == AddressRangeTable::parse_none);
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("1.2.3.4/33", &range4, &range6) == AddressRangeTable::parse_none);
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("2001:db8::/129", &range4, &range6) == AddressRangeTable::parse_none);
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("# 1.2.3.4", &range4, &range6) == AddressRangeTable::parse_none);
+  CPPUNIT_ASSERT(AddressRangeTable::parse_range("garbage", &range4, &range6) == AddressRangeTable::parse_none);
+}
+
+void
+TestAddressRangeTable::test_parse_list() {
+  AddressRangeTable::ipv4_list ipv4;
+  AddressRangeTable::ipv6_list ipv6;
+
+  auto count = AddressRangeTable::parse_list("# header\n"
+                                             "a:1.2.3.0-1.2.3.255\r\n"
+                                             "\n"
+                                             "not an address\n"
+                                             "2001:db8::/32\n"
+                                             "10.0.0.0/8", 3, &ipv4, &ipv6);
+
+  CPPUNIT_ASSERT_EQUAL(size_t{3}, count);
+  CPPUNIT_ASSERT_EQUAL(size_t{2}, ipv4.size());
+  CPPUNIT_ASSERT_EQUAL(size_t{1}, ipv6.size());
+  CPPUNIT_ASSERT_EQUAL(3, ipv4[1].value);
+  CPPUNIT_ASSERT_EQUAL(3, ipv6[0].value);
+}
+
+void
+TestAddressRangeTable::test_merge() {
+  AddressRangeTable table;
+  int               value;
+
+  table.merge({{0x0a000000, 0x0affffff, 1}, {0x0a000100, 0x0a0001ff, 2}, {0x0c000000, 0x0c0000ff, 1}}, {});
+
+  CPPUNIT_ASSERT_EQUAL(size_t{4}, table.size_ipv4());
+  CPPUNIT_ASSERT(table.find(0x0a000150, 0x0a000150, &value) && value == 2);
+  CPPUNIT_ASSERT(table.find(0x0a000200, 0x0a000300, &value) && value == 1);
+  CPPUNIT_ASSERT(!table.find(0x0a0000ff, 0x0a000100, &value));
+  CPPUNIT_ASSERT(!table.find(0x0d000000, 0x0d000000, &value));
+
+  // Later ranges override, and adjacent ranges with the same value
+  // are joined.
+  table.insert(AddressRangeTable::ipv4_range{0x0a000100, 0x0a0001ff, 1});
+  table.insert(AddressRangeTable::ipv4_range{0x0c000000, 0x0c0000ff, 1});
+  table.insert(AddressRangeTable::ipv4_range{0x0c000100, 0x0c0001ff, 1});
+
+  CPPUNIT_ASSERT_EQUAL(size_t{2}, table.size_ipv4());
+  CPPUNIT_ASSERT(table.find(0x0a000000, 0x0affffff, &value) && value == 1);
+  CPPUNIT_ASSERT(table.find(0x0c000000, 0x0c0001ff, &value) && value == 1);
+
+  table.insert(AddressRangeTable::ipv4_range{0, 0xffffffff, 2});
+
+  CPPUNIT_ASSERT_EQUAL(size_t{1}, table.size_ipv4());
+  CPPUNIT_ASSERT(table.find(0xffffffff, 0xffffffff, &value) && value == 2);
+}
+
+void
+TestAddressRangeTable::test_find_ipv6() {
+  AddressRangeTable table;
+  int               value;
+
+  table.merge({{0x01020300, 0x010203ff, 1}},
+              {{make_ipv6("2001:db8::"), make_ipv6("2001:db8::ffff"), 1},
+               {make_ipv6("::ffff:5.6.7.8"), make_ipv6("::ffff:5.6.7.8"), 2}});
+
+  CPPUNIT_ASSERT_EQUAL(size_t{2}, table.size_ipv4());
+  CPPUNIT_ASSERT_EQUAL(size_t{1}, table.size_ipv6());
+
+  sockaddr_in6 sa = {};
+  sa.sin6_family = AF_INET6;
+
+  inet_pton(AF_INET6, "2001:db8::10", &sa.sin6_addr);
+  CPPUNIT_ASSERT(table.find(reinterpret_cast<sockaddr*>(&sa), &value) && value == 1);
+
+  inet_pton(AF_INET6, "2001:db8::1:0", &sa.sin6_addr);
+  CPPUNIT_ASSERT(!table.find(reinterpret_cast<sockaddr*>(&sa), &value));
+
+  inet_pton(AF_INET6, "::ffff:1.2.3.4", &sa.sin6_addr);
+  CPPUNIT_ASSERT(table.find(reinterpret_cast<sockaddr*>(&sa), &value) && value == 1);
+
+  sockaddr_in sa4 = {};
+  sa4.sin_family = AF_INET;
+  inet_pton(AF_INET, "5.6.7.8", &sa4.sin_addr);
+  CPPUNIT_ASSERT(table.find(reinterpret_cast<sockaddr*>(&sa4), &value) && value == 2);
+}
+
+void
+TestAddressRangeTable::test_serialize() {
+  AddressRangeTable table;
+  AddressRangeTable result;
+
+  table.merge({{0x0a000000, 0x0affffff, 1}, {0x0b000000, 0x0b0000ff, 2}},
+              {{make_ipv6("2001:db8::"), make_ipv6("2001:db8::ffff"), 1}});
+
+  auto data = table.serialize();
+
+  CPPUNIT_ASSERT(AddressRangeTable::deserialize(data, &result));
+  CPPUNIT_ASSERT(result.ipv4() == table.ipv4());
+  CPPUNIT_ASSERT(result.ipv6() == table.ipv6());
+
+  CPPUNIT_ASSERT(!AddressRangeTable::deserialize(data.substr(0, data.size() - 1), &result));
+  CPPUNIT_ASSERT(!AddressRangeTable::deserialize("not a cache", &result));
+
+  // Overlapping ranges are rejected.
+  table.clear();
+  table.merge({{0x0a000000, 0x0affffff, 1}}, {});
+  data = table.serialize();
+  uint64_t size_ipv4 = 2;
+
+  data.append(data.substr(data.size() - 12));
+  data.replace(8, sizeof(size_ipv4), reinterpret_cast<const char*>(&size_ipv4), sizeof(size_ipv4));
+
+  CPPUNIT_ASSERT(!AddressRangeTable::deserialize(data, &result));
+}
@@ -0,0 +1,20 @@
+#include "test/helpers/test_fixture.h"
+
+class TestAddressRangeTable : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestAddressRangeTable);
+
+  CPPUNIT_TEST(test_parse_range);
+  CPPUNIT_TEST(test_parse_list);
+  CPPUNIT_TEST(test_merge);
+  CPPUNIT_TEST(test_find_ipv6);
+  CPPUNIT_TEST(test_serialize);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_parse_range();
+  void test_parse_list();
+  void test_merge();
+  void test_find_ipv6();
+  void test_serialize();
+};
@@ -0,0 +1,64 @@
+#include "config.h"
+
+#include "test/src/test_choke_balancer.h"
+
+#include "core/choke_balancer.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestChokeBalancer);
+
+using core::ChokeBalancer;
+
+static ChokeBalancer::entry_type
+make_entry(double weight, uint32_t demand, uint32_t min = 0, uint32_t max = ChokeBalancer::unlimited) {
+  return ChokeBalancer::entry_type{weight, min, max, demand, 0};
+}
+
+void
+TestChokeBalancer::test_allocate_weights() {
+  std::vector<ChokeBalancer::entry_type> entries{make_entry(1, 100), make_entry(3, 100)};
+
+  ChokeBalancer::allocate(100, entries);
+
+  CPPUNIT_ASSERT(entries[0].target == 25);
+  CPPUNIT_ASSERT(entries[1].target == 75);
+}
+
+void
+TestChokeBalancer::test_allocate_demand() {
+  std::vector<ChokeBalancer::entry_type> entries{make_entry(1, 10), make_entry(1, 200), make_entry(0, 50)};
+
+  ChokeBalancer::allocate(100, entries);
+
+  // The first group only has 10 interested peers, the rest goes to
+  // the second. Zero weight groups get nothing.
+  CPPUNIT_ASSERT(entries[0].target == 10);
+  CPPUNIT_ASSERT(entries[1].target == 90);
+  CPPUNIT_ASSERT(entries[2].target == 0);
+
+  entries = {make_entry(1, 10), make_entry(1, 20)};
+
+  ChokeBalancer::allocate(100, entries);
+
+  // Idle slots are spread once all demand is met.
+  CPPUNIT_ASSERT(entries[0].target + entries[1].target == 100);
+  CPPUNIT_ASSERT(entries[0].target == 50);
+}
+
+void
+TestChokeBalancer::test_allocate_bounds() {
+  std::vector<ChokeBalancer::entry_type> entries{make_entry(1, 0, 30), make_entry(1, 100, 0, 40), make_entry(1, 100)};
+
+  ChokeBalancer::allocate(100, entries);
+
+  CPPUNIT_ASSERT(entries[0].target == 30);
+  CPPUNIT_ASSERT(entries[1].target == 35);
+  CPPUNIT_ASSERT(entries[2].target == 35);
+
+  // Minimums are kept even when they exceed the pool.
+  entries = {make_entry(1, 100, 60), make_entry(1, 100, 60)};
+
+  ChokeBalancer::allocate(100, entries);
+
+  CPPUNIT_ASSERT(entries[0].target == 60);
+  CPPUNIT_ASSERT(entries[1].target == 60);
+}
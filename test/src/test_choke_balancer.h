@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class TestChokeBalancer : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestChokeBalancer);
+
+  CPPUNIT_TEST(test_allocate_weights);
+  CPPUNIT_TEST(test_allocate_demand);
+  CPPUNIT_TEST(test_allocate_bounds);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_allocate_weights();
+  void test_allocate_demand();
+  void test_allocate_bounds();
+};
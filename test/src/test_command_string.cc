@@ -259,3 +259,28 @@ TestCommandString::test_config_syntax() {
   // Commands nest, so a split can be joined back together.
   CPPUNIT_ASSERT_EQUAL(std::string("a-b-c"), parse("string.join=-,(string.split,a.b.c,.)").as_string());
 }
+
+void
+TestCommandString::test_parallel_safe() {
+  auto command = [](const char* key, torrent::Object arg) {
+    auto result = torrent::Object::create_dict_key();
+    result.as_dict_key() = key;
+    result.as_dict_obj() = std::move(arg);
+    return result;
+  };
+
+  CPPUNIT_ASSERT(rpc::is_parallel_safe(torrent::Object()));
+  CPPUNIT_ASSERT(rpc::is_parallel_safe(torrent::Object("literal")));
+  CPPUNIT_ASSERT(rpc::is_parallel_safe(torrent::Object("string.contains=abc,b")));
+  CPPUNIT_ASSERT(rpc::is_parallel_safe(command("string.equals", args({"a", "b"}))));
+  CPPUNIT_ASSERT(rpc::is_parallel_safe(command("string.length", args({command("string.length", "abc")}))));
+
+  // Commands that aren't marked, or arguments that could call any
+  // command, aren't safe.
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(torrent::Object("string.substr=abc,1")));
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(torrent::Object("string.length=$string.substr=abc,1")));
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(torrent::Object("string.length=(string.substr,abc,1)")));
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(torrent::Object("string.length=a\nstring.substr=abc,1")));
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(command("string.substr", args({"abc", int64_t(1)}))));
+  CPPUNIT_ASSERT(!rpc::is_parallel_safe(command("string.length", args({command("string.substr", "abc")}))));
+}
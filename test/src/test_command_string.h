@@ -17,6 +17,7 @@ class TestCommandString : public test_fixture {
   CPPUNIT_TEST(test_replace);
   CPPUNIT_TEST(test_invalid_arguments);
   CPPUNIT_TEST(test_config_syntax);
+  CPPUNIT_TEST(test_parallel_safe);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -38,4 +39,5 @@ public:
   void test_replace();
   void test_invalid_arguments();
   void test_config_syntax();
+  void test_parallel_safe();
 };
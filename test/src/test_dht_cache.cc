@@ -0,0 +1,158 @@
+#include "config.h"
+
+#include "test/src/test_dht_cache.h"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "core/dht_cache.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestDhtCache);
+
+static bool
+file_exists(const std::string& path) {
+  struct stat st;
+
+  return ::stat(path.c_str(), &st) == 0;
+}
+
+static torrent::Object
+make_cache(int64_t id) {
+  auto cache = torrent::Object::create_map();
+
+  cache.insert_key("self_id", std::string(20, (char)('a' + id)));
+  cache.insert_key("nodes", torrent::Object::create_map());
+  cache.insert_key("version", id);
+
+  return cache;
+}
+
+void
+TestDhtCache::setUp() {
+  test_fixture::setUp();
+
+  char path[] = "/tmp/rtorrent-dht-cache-XXXXXX";
+
+  CPPUNIT_ASSERT(::mkdtemp(path) != nullptr);
+  m_path = path;
+}
+
+void
+TestDhtCache::tearDown() {
+  ::unlink((m_path + "/dht_cache").c_str());
+  ::unlink((m_path + "/dht_cache.new").c_str());
+  ::unlink((m_path + "/directory/file").c_str());
+  ::rmdir((m_path + "/directory").c_str());
+  ::rmdir(m_path.c_str());
+
+  test_fixture::tearDown();
+}
+
+void
+TestDhtCache::test_read_missing() {
+  auto result = core::dht_cache_read(m_path + "/dht_cache");
+
+  CPPUNIT_ASSERT(!result.found);
+  CPPUNIT_ASSERT(result.error.empty());
+  CPPUNIT_ASSERT(result.cache.is_map() && result.cache.as_map().empty());
+}
+
+void
+TestDhtCache::test_read_corrupted() {
+  std::ofstream(m_path + "/dht_cache") << "d7:versioni1";
+
+  auto result = core::dht_cache_read(m_path + "/dht_cache");
+
+  CPPUNIT_ASSERT(result.found);
+  CPPUNIT_ASSERT(!result.error.empty());
+  CPPUNIT_ASSERT(result.cache.is_map() && result.cache.as_map().empty());
+}
+
+void
+TestDhtCache::test_write_read() {
+  auto path = m_path + "/dht_cache";
+
+  CPPUNIT_ASSERT(core::dht_cache_write(path, make_cache(1)).empty());
+  CPPUNIT_ASSERT(core::dht_cache_write(path, make_cache(2)).empty());
+  CPPUNIT_ASSERT(!file_exists(path + ".new"));
+
+  auto result = core::dht_cache_read(path);
+
+  CPPUNIT_ASSERT(result.found);
+  CPPUNIT_ASSERT(result.error.empty());
+  CPPUNIT_ASSERT(result.cache.get_key_value("version") == 2);
+  CPPUNIT_ASSERT(result.cache.get_key_string("self_id") == std::string(20, 'c'));
+  CPPUNIT_ASSERT(result.cache.get_key("nodes").is_map());
+}
+
+// A non-empty directory in place of the cache makes the rename fail,
+// the temporary file must not be left behind.
+void
+TestDhtCache::test_write_failed() {
+  auto path = m_path + "/directory";
+
+  CPPUNIT_ASSERT(::mkdir(path.c_str(), 0700) == 0);
+  std::ofstream(path + "/file") << "x";
+
+  CPPUNIT_ASSERT(!core::dht_cache_write(path, make_cache(1)).empty());
+  CPPUNIT_ASSERT(!file_exists(path + ".new"));
+  CPPUNIT_ASSERT(file_exists(path + "/file"));
+
+  CPPUNIT_ASSERT(!core::dht_cache_write(m_path + "/missing/dht_cache", make_cache(1)).empty());
+}
+
+// Replacing a pending job claims it, so the session thread skips it
+// and only the newer snapshot is written.
+void
+TestDhtCache::test_save_replaced() {
+  auto path = m_path + "/dht_cache";
+  auto old_job = std::make_shared<core::dht_cache_save_job>();
+  auto new_job = std::make_shared<core::dht_cache_save_job>();
+
+  old_job->path  = path;
+  old_job->cache = make_cache(1);
+  new_job->path  = path;
+  new_job->cache = make_cache(2);
+
+  CPPUNIT_ASSERT(old_job->claim());
+  CPPUNIT_ASSERT(!old_job->claim());
+
+  for (const auto& job : {old_job, new_job})
+    if (job->claim())
+      CPPUNIT_ASSERT(core::dht_cache_write(job->path, job->cache).empty());
+
+  CPPUNIT_ASSERT(core::dht_cache_read(path).cache.get_key_value("version") == 2);
+}
+
+// The session thread and 'flush_dht_cache' race for the same job, it
+// must be written exactly once.
+void
+TestDhtCache::test_save_flush() {
+  auto path = m_path + "/dht_cache";
+
+  for (int i = 0; i < 100; i++) {
+    auto job = std::make_shared<core::dht_cache_save_job>();
+    std::atomic<int> written{};
+
+    job->path  = path;
+    job->cache = make_cache(i % 20);
+
+    auto write_job = [&written, job]() {
+        if (job->claim() && core::dht_cache_write(job->path, job->cache).empty())
+          written++;
+      };
+
+    std::thread session_thread(write_job);
+    write_job();
+    session_thread.join();
+
+    CPPUNIT_ASSERT(written == 1);
+    CPPUNIT_ASSERT(core::dht_cache_read(path).cache.get_key_value("version") == i % 20);
+  }
+
+  CPPUNIT_ASSERT(!file_exists(path + ".new"));
+}
@@ -0,0 +1,30 @@
+#include "test/helpers/test_fixture.h"
+
+#include <string>
+
+class TestDhtCache : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestDhtCache);
+
+  CPPUNIT_TEST(test_read_missing);
+  CPPUNIT_TEST(test_read_corrupted);
+  CPPUNIT_TEST(test_write_read);
+  CPPUNIT_TEST(test_write_failed);
+  CPPUNIT_TEST(test_save_replaced);
+  CPPUNIT_TEST(test_save_flush);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+
+  void test_read_missing();
+  void test_read_corrupted();
+  void test_write_read();
+  void test_write_failed();
+  void test_save_replaced();
+  void test_save_flush();
+
+private:
+  std::string m_path;
+};
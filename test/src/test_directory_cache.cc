@@ -0,0 +1,223 @@
+#include "config.h"
+
+#include "test/src/test_directory_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "utils/directory.h"
+#include "utils/directory_cache.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestDirectoryCache);
+
+static std::vector<std::string>
+entry_names(const utils::Directory& directory) {
+  std::vector<std::string> names;
+
+  for (const auto& entry : directory)
+    names.push_back(entry.s_name);
+
+  return names;
+}
+
+static const utils::directory_entry*
+find_entry(const utils::Directory& directory, const std::string& name) {
+  auto itr = std::find_if(directory.begin(), directory.end(), [&](const auto& entry) { return entry.s_name == name; });
+
+  return itr != directory.end() ? &*itr : nullptr;
+}
+
+void
+TestDirectoryCache::setUp() {
+  test_fixture::setUp();
+
+  char path[] = "/tmp/rtorrent-directory-cache-XXXXXX";
+
+  CPPUNIT_ASSERT(::mkdtemp(path) != nullptr);
+  m_path = path;
+}
+
+void
+TestDirectoryCache::tearDown() {
+  utils::Directory directory(m_path);
+
+  if (directory.update(utils::Directory::update_hide_dot)) {
+    for (const auto& entry : directory) {
+      auto path = m_path + "/" + entry.s_name;
+
+      if (::unlink(path.c_str()) == -1)
+        ::rmdir(path.c_str());
+    }
+  }
+
+  ::unlink((m_path + "/.hidden").c_str());
+  ::rmdir(m_path.c_str());
+
+  test_fixture::tearDown();
+}
+
+void
+TestDirectoryCache::create_file(const std::string& name) {
+  int fd = ::open((m_path + "/" + name).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  CPPUNIT_ASSERT(fd != -1);
+  CPPUNIT_ASSERT(::close(fd) == 0);
+}
+
+void
+TestDirectoryCache::set_mtime(time_t mtime) {
+  struct timeval times[2] = {{mtime, 0}, {mtime, 0}};
+
+  CPPUNIT_ASSERT(::utimes(m_path.c_str(), times) == 0);
+}
+
+void
+TestDirectoryCache::test_update() {
+  create_file("b.torrent");
+  create_file("a.torrent");
+  create_file(".hidden");
+  CPPUNIT_ASSERT(::mkdir((m_path + "/sub").c_str(), 0700) == 0);
+
+  utils::Directory directory(m_path);
+
+  CPPUNIT_ASSERT(directory.update(utils::Directory::update_sort | utils::Directory::update_hide_dot));
+  CPPUNIT_ASSERT(entry_names(directory) == (std::vector<std::string>{"a.torrent", "b.torrent", "sub"}));
+
+  // Filesystems that don't report the type give DT_UNKNOWN, which
+  // must still be treated as a possible directory.
+  auto file = find_entry(directory, "a.torrent");
+  auto sub  = find_entry(directory, "sub");
+
+  CPPUNIT_ASSERT(sub->may_be_directory());
+  CPPUNIT_ASSERT(file->s_type == DT_REG || file->s_type == DT_UNKNOWN);
+  CPPUNIT_ASSERT(file->s_type == DT_UNKNOWN || !file->may_be_directory());
+
+  utils::Directory with_dot(m_path);
+
+  CPPUNIT_ASSERT(with_dot.update(0));
+  CPPUNIT_ASSERT(find_entry(with_dot, ".hidden") != nullptr);
+
+  utils::Directory missing(m_path + "/missing");
+
+  CPPUNIT_ASSERT(!missing.update(0));
+}
+
+// Enough entries to need several reads into the listing buffer.
+void
+TestDirectoryCache::test_update_large() {
+  std::vector<std::string> expected;
+
+  for (int i = 0; i != 3000; i++) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "file-%04d.torrent", i);
+
+    create_file(name);
+    expected.push_back(name);
+  }
+
+  utils::Directory directory(m_path);
+
+  CPPUNIT_ASSERT(directory.update(utils::Directory::update_sort | utils::Directory::update_hide_dot));
+  CPPUNIT_ASSERT(entry_names(directory) == expected);
+}
+
+void
+TestDirectoryCache::test_cached() {
+  utils::DirectoryCache cache;
+  bool                  changed = false;
+
+  CPPUNIT_ASSERT(cache.find(m_path + "/missing", &changed) == nullptr);
+  CPPUNIT_ASSERT(cache.size() == 0);
+
+  time_t settled = std::time(nullptr) - 100;
+
+  create_file("a.torrent");
+  set_mtime(settled);
+
+  auto directory = cache.find(m_path, &changed);
+
+  CPPUNIT_ASSERT(directory != nullptr);
+  CPPUNIT_ASSERT(changed);
+  CPPUNIT_ASSERT(find_entry(*directory, "a.torrent") != nullptr);
+
+  // An unchanged, settled directory is served from the cache.
+  directory = cache.find(m_path, &changed);
+
+  CPPUNIT_ASSERT(directory != nullptr);
+  CPPUNIT_ASSERT(!changed);
+
+  // Keeping the old mtime hides the new file, showing the listing
+  // wasn't read again.
+  create_file("b.torrent");
+  set_mtime(settled);
+
+  directory = cache.find(m_path, &changed);
+
+  CPPUNIT_ASSERT(!changed);
+  CPPUNIT_ASSERT(find_entry(*directory, "b.torrent") == nullptr);
+
+  set_mtime(settled + 50);
+
+  directory = cache.find(m_path, &changed);
+
+  CPPUNIT_ASSERT(changed);
+  CPPUNIT_ASSERT(find_entry(*directory, "b.torrent") != nullptr);
+
+}
+
+void
+TestDirectoryCache::test_settle() {
+  utils::DirectoryCache cache;
+  bool                  changed = false;
+
+  // Modified within the last second, so it is read on every lookup.
+  create_file("a.torrent");
+
+  CPPUNIT_ASSERT(cache.find(m_path, &changed) != nullptr);
+  CPPUNIT_ASSERT(changed);
+
+  set_mtime(std::time(nullptr) - 5);
+
+  CPPUNIT_ASSERT(cache.find(m_path, &changed) != nullptr);
+  CPPUNIT_ASSERT(changed);
+
+  // Served from the cache, but still reported as changed until it has
+  // settled.
+  CPPUNIT_ASSERT(cache.find(m_path, &changed) != nullptr);
+  CPPUNIT_ASSERT(changed);
+}
+
+void
+TestDirectoryCache::test_prune() {
+  utils::DirectoryCache cache;
+
+  CPPUNIT_ASSERT(::mkdir((m_path + "/sub").c_str(), 0700) == 0);
+
+  CPPUNIT_ASSERT(cache.find(m_path, nullptr) != nullptr);
+  CPPUNIT_ASSERT(cache.find(m_path + "/sub", nullptr) != nullptr);
+  CPPUNIT_ASSERT(cache.size() == 2);
+
+  // Listings used since the previous prune are kept.
+  cache.prune();
+  CPPUNIT_ASSERT(cache.size() == 2);
+
+  CPPUNIT_ASSERT(cache.find(m_path, nullptr) != nullptr);
+
+  cache.prune();
+  CPPUNIT_ASSERT(cache.size() == 1);
+
+  cache.prune();
+  CPPUNIT_ASSERT(cache.size() == 0);
+
+  // A directory that disappears is dropped on lookup.
+  CPPUNIT_ASSERT(cache.find(m_path + "/sub", nullptr) != nullptr);
+  CPPUNIT_ASSERT(::rmdir((m_path + "/sub").c_str()) == 0);
+  CPPUNIT_ASSERT(cache.find(m_path + "/sub", nullptr) == nullptr);
+  CPPUNIT_ASSERT(cache.size() == 0);
+}
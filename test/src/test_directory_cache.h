@@ -0,0 +1,32 @@
+#include "test/helpers/test_fixture.h"
+
+#include <ctime>
+#include <string>
+
+class TestDirectoryCache : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestDirectoryCache);
+
+  CPPUNIT_TEST(test_update);
+  CPPUNIT_TEST(test_update_large);
+  CPPUNIT_TEST(test_cached);
+  CPPUNIT_TEST(test_settle);
+  CPPUNIT_TEST(test_prune);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+
+  void test_update();
+  void test_update_large();
+  void test_cached();
+  void test_settle();
+  void test_prune();
+
+private:
+  void        create_file(const std::string& name);
+  void        set_mtime(time_t mtime);
+
+  std::string m_path;
+};
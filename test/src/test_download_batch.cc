@@ -0,0 +1,114 @@
+#include "config.h"
+
+#include "test/src/test_download_batch.h"
+
+#include <utility>
+#include <vector>
+#include <torrent/exceptions.h>
+
+#include "core/download_batch.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestDownloadBatch);
+
+// Records the filter deferral changes and the saves done.
+struct fake_session {
+  using save_list = std::vector<std::pair<core::Download*, bool>>;
+
+  std::vector<bool> deferred;
+  save_list         saves;
+
+  void
+  attach(core::DownloadBatch& batch) {
+    batch.slot_filter_deferred() = [this](bool state) { deferred.push_back(state); };
+    batch.slot_save_download()   = [this](core::Download* download, bool full) { saves.emplace_back(download, full); };
+  }
+};
+
+void
+TestDownloadBatch::test_filter_pass() {
+  fake_session        session;
+  core::DownloadBatch batch;
+
+  session.attach(batch);
+
+  batch.begin();
+  batch.begin();
+  batch.end();
+
+  CPPUNIT_ASSERT(batch.is_active());
+  CPPUNIT_ASSERT((session.deferred == std::vector<bool>{true}));
+
+  batch.begin();
+  batch.end();
+  batch.end();
+
+  // The views only filter once, when the outermost batch ends.
+  CPPUNIT_ASSERT(!batch.is_active());
+  CPPUNIT_ASSERT((session.deferred == std::vector<bool>{true, false}));
+
+  CPPUNIT_ASSERT_THROW(batch.end(), torrent::internal_error);
+}
+
+void
+TestDownloadBatch::test_save() {
+  fake_session        session;
+  core::DownloadBatch batch;
+
+  session.attach(batch);
+
+  batch.save(fake_download(1), false);
+  batch.save(fake_download(1), true);
+
+  CPPUNIT_ASSERT((session.saves == fake_session::save_list{{fake_download(1), false}, {fake_download(1), true}}));
+  CPPUNIT_ASSERT(session.deferred.empty());
+}
+
+void
+TestDownloadBatch::test_save_merge() {
+  fake_session        session;
+  core::DownloadBatch batch;
+
+  session.attach(batch);
+  batch.begin();
+
+  for (int i = 0; i < 3; i++) {
+    batch.save(fake_download(2), false);
+    batch.save(fake_download(1), false);
+  }
+
+  batch.save(fake_download(3), true);
+  batch.save(fake_download(3), false);
+  batch.save(fake_download(1), true);
+
+  CPPUNIT_ASSERT(batch.size_saves() == 3);
+  CPPUNIT_ASSERT(session.saves.empty());
+
+  batch.end();
+
+  CPPUNIT_ASSERT((session.saves == fake_session::save_list{{fake_download(2), false}, {fake_download(1), true}, {fake_download(3), true}}));
+  CPPUNIT_ASSERT(batch.size_saves() == 0);
+}
+
+void
+TestDownloadBatch::test_erase() {
+  fake_session        session;
+  core::DownloadBatch batch;
+
+  session.attach(batch);
+  batch.begin();
+
+  batch.save(fake_download(1), false);
+  batch.save(fake_download(2), true);
+  batch.save(fake_download(3), false);
+
+  batch.erase(fake_download(2));
+  batch.erase(fake_download(4));
+
+  CPPUNIT_ASSERT(batch.size_saves() == 2);
+
+  batch.save(fake_download(2), false);
+  batch.end();
+
+  CPPUNIT_ASSERT((session.saves == fake_session::save_list{{fake_download(1), false}, {fake_download(3), false}, {fake_download(2), false}}));
+}
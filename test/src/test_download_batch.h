@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class TestDownloadBatch : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestDownloadBatch);
+
+  CPPUNIT_TEST(test_filter_pass);
+  CPPUNIT_TEST(test_save);
+  CPPUNIT_TEST(test_save_merge);
+  CPPUNIT_TEST(test_erase);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_filter_pass();
+  void test_save();
+  void test_save_merge();
+  void test_erase();
+};
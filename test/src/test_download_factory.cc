@@ -0,0 +1,31 @@
+#include "config.h"
+
+#include "test/src/test_download_factory.h"
+
+#include <string>
+#include <torrent/exceptions.h>
+#include <torrent/object.h>
+
+#include "core/download_factory.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestDownloadFactory);
+
+void
+TestDownloadFactory::test_decode_raw_data() {
+  auto object = core::DownloadFactory::decode_raw_data("d8:announce9:http://a/4:infod4:name1:aee");
+
+  CPPUNIT_ASSERT(object->is_map());
+  CPPUNIT_ASSERT(object->get_key_string("announce") == "http://a/");
+  CPPUNIT_ASSERT(object->get_key("info").get_key_string("name") == "a");
+}
+
+void
+TestDownloadFactory::test_decode_raw_data_malformed() {
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data(""), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data("d8:announce"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data("d8:announce9:http"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data("i42e"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data("l4:spame"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data("not bencode"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(core::DownloadFactory::decode_raw_data(std::string(1000, 'l')), torrent::input_error);
+}
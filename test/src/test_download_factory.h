@@ -0,0 +1,14 @@
+#include "test/helpers/test_fixture.h"
+
+class TestDownloadFactory : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestDownloadFactory);
+
+  CPPUNIT_TEST(test_decode_raw_data);
+  CPPUNIT_TEST(test_decode_raw_data_malformed);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_decode_raw_data();
+  void test_decode_raw_data_malformed();
+};
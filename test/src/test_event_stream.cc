@@ -0,0 +1,78 @@
+#include "config.h"
+
+#include "test/src/test_event_stream.h"
+
+#include "core/event_stream.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestEventStream);
+
+void
+TestEventStream::test_cursor() {
+  core::EventStream stream;
+  int               pushed = 0;
+
+  stream.slot_pushed() = [&pushed]() { pushed++; };
+
+  CPPUNIT_ASSERT(!stream.has_events(0, {}));
+
+  stream.push("finished", "AA");
+  stream.push("erased", "AA");
+
+  CPPUNIT_ASSERT(pushed == 2);
+  CPPUNIT_ASSERT(stream.next_sequence() == 2);
+  CPPUNIT_ASSERT(stream.has_events(1, {}));
+  CPPUNIT_ASSERT(!stream.has_events(2, {}));
+
+  auto result = stream.events(0, 1, {});
+  auto events = result.get_key_list("events");
+
+  CPPUNIT_ASSERT(result.get_key_value("cursor") == 1);
+  CPPUNIT_ASSERT(events.size() == 1);
+  CPPUNIT_ASSERT(events.front().get_key_string("type") == "finished");
+  CPPUNIT_ASSERT(events.front().get_key_string("hash") == "AA");
+
+  result = stream.events(1, 10, {});
+
+  CPPUNIT_ASSERT(result.get_key_value("cursor") == 2);
+  CPPUNIT_ASSERT(result.get_key_list("events").front().get_key_string("type") == "erased");
+
+  // Cursors from before a restart start at the current end.
+  result = stream.events(100, 10, {});
+
+  CPPUNIT_ASSERT(result.get_key_value("cursor") == 2);
+  CPPUNIT_ASSERT(result.get_key_list("events").empty());
+}
+
+void
+TestEventStream::test_types() {
+  core::EventStream stream;
+
+  stream.push("hash_queued", "AA");
+  stream.push("tracker_failed", "BB", "timeout");
+  stream.push("hash_done", "AA");
+
+  CPPUNIT_ASSERT(stream.has_events(0, {"tracker_failed"}));
+  CPPUNIT_ASSERT(!stream.has_events(2, {"tracker_failed"}));
+
+  auto result = stream.events(0, 10, {"tracker_failed"});
+  auto events = result.get_key_list("events");
+
+  CPPUNIT_ASSERT(result.get_key_value("cursor") == 3);
+  CPPUNIT_ASSERT(events.size() == 1);
+  CPPUNIT_ASSERT(events.front().get_key_value("sequence") == 1);
+  CPPUNIT_ASSERT(events.front().get_key_string("message") == "timeout");
+}
+
+void
+TestEventStream::test_dropped() {
+  core::EventStream stream;
+
+  for (size_t i = 0; i != core::EventStream::max_events + 10; i++)
+    stream.push("finished", "AA");
+
+  auto result = stream.events(0, 1, {});
+
+  CPPUNIT_ASSERT(result.get_key_value("dropped") == 10);
+  CPPUNIT_ASSERT(result.get_key_list("events").front().get_key_value("sequence") == 10);
+  CPPUNIT_ASSERT(result.get_key_value("cursor") == 11);
+}
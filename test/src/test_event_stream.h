@@ -0,0 +1,16 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestEventStream : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestEventStream);
+
+  CPPUNIT_TEST(test_cursor);
+  CPPUNIT_TEST(test_types);
+  CPPUNIT_TEST(test_dropped);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_cursor();
+  void test_types();
+  void test_dropped();
+};
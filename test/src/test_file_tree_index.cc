@@ -0,0 +1,139 @@
+#include "config.h"
+
+#include "test/src/test_file_tree_index.h"
+
+#include <iterator>
+#include <limits>
+#include <torrent/exceptions.h>
+
+#include "core/file_tree_index.h"
+#include "utils/glob.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestFileTreeIndex);
+
+static const torrent::Object&
+list_at(const torrent::Object::list_type& list, size_t index) {
+  return *std::next(list.begin(), index);
+}
+
+//   a/x.mkv       100
+//   a/b/y.mkv      20
+//   a/b/z.nfo       3
+//   c.txt           1
+static void
+insert_files(core::FileTreeIndex& index) {
+  index.insert_file("a/x.mkv",   {"a", "x.mkv"},      100);
+  index.insert_file("a/b/y.mkv", {"a", "b", "y.mkv"}, 20);
+  index.insert_file("a/b/z.nfo", {"a", "b", "z.nfo"}, 3);
+  index.insert_file("c.txt",     {"c.txt"},           1);
+}
+
+void
+TestFileTreeIndex::test_tree() {
+  core::FileTreeIndex index;
+  insert_files(index);
+
+  CPPUNIT_ASSERT(index.size_files() == 4);
+  CPPUNIT_ASSERT(index.size_directories() == 3);
+
+  CPPUNIT_ASSERT(index.root().size_bytes == 124);
+  CPPUNIT_ASSERT(index.root().size_files == 4);
+  CPPUNIT_ASSERT(index.root().directories.size() == 1);
+  CPPUNIT_ASSERT(index.root().files == std::vector<uint32_t>{3});
+
+  auto a = index.find_directory("a");
+
+  CPPUNIT_ASSERT(a != nullptr);
+  CPPUNIT_ASSERT(a->name == "a");
+  CPPUNIT_ASSERT(a->parent == 0);
+  CPPUNIT_ASSERT(a->size_bytes == 123);
+  CPPUNIT_ASSERT(a->size_files == 3);
+  CPPUNIT_ASSERT(a->files == std::vector<uint32_t>{0});
+
+  auto b = index.find_directory("a/b");
+
+  CPPUNIT_ASSERT(b != nullptr);
+  CPPUNIT_ASSERT(b->name == "b");
+  CPPUNIT_ASSERT(b->path == "a/b");
+  CPPUNIT_ASSERT(b->size_bytes == 23);
+  CPPUNIT_ASSERT(b->files == (std::vector<uint32_t>{1, 2}));
+
+  CPPUNIT_ASSERT(index.file(1).name == "y.mkv");
+  CPPUNIT_ASSERT(index.path(1) == "a/b/y.mkv");
+
+  CPPUNIT_ASSERT(index.find_directory("b") == nullptr);
+  CPPUNIT_ASSERT(index.find_directory("a/b/y.mkv") == nullptr);
+}
+
+void
+TestFileTreeIndex::test_match_range() {
+  core::FileTreeIndex index;
+  insert_files(index);
+
+  int64_t total = -1;
+
+  CPPUNIT_ASSERT(index.match_range(nullptr, 1, 2, total) == (std::vector<uint32_t>{1, 2}));
+  CPPUNIT_ASSERT(total == 4);
+
+  CPPUNIT_ASSERT(index.match_range(nullptr, 10, 2, total).empty());
+  CPPUNIT_ASSERT(total == 4);
+
+  utils::GlobList patterns;
+  patterns.push_back("*.mkv");
+  patterns.push_back("c.txt");
+
+  CPPUNIT_ASSERT(index.match_range(&patterns, 0, 10, total) == (std::vector<uint32_t>{0, 1, 3}));
+  CPPUNIT_ASSERT(total == 3);
+
+  // The total counts all matches, not only those in the range.
+  CPPUNIT_ASSERT(index.match_range(&patterns, 1, 1, total) == std::vector<uint32_t>{1});
+  CPPUNIT_ASSERT(total == 3);
+
+  CPPUNIT_ASSERT(index.match_range(&patterns, 0, 0, total).empty());
+  CPPUNIT_ASSERT(total == 3);
+}
+
+void
+TestFileTreeIndex::test_list_directory() {
+  core::FileTreeIndex index;
+  insert_files(index);
+
+  auto max = std::numeric_limits<int64_t>::max();
+  auto result = index.list_directory("/a/", 0, max);
+
+  CPPUNIT_ASSERT(result.get_key_value("total") == 2);
+
+  auto& entries = result.get_key_list("entries");
+
+  CPPUNIT_ASSERT(entries.size() == 2);
+
+  // Directories come first, with a file index of -1.
+  auto& dir = entries.front().as_list();
+
+  CPPUNIT_ASSERT(dir.size() == 6);
+  CPPUNIT_ASSERT(list_at(dir, 0).as_string() == "b");
+  CPPUNIT_ASSERT(list_at(dir, 1).as_string() == "a/b");
+  CPPUNIT_ASSERT(list_at(dir, 2).as_value() == 1);
+  CPPUNIT_ASSERT(list_at(dir, 3).as_value() == -1);
+  CPPUNIT_ASSERT(list_at(dir, 4).as_value() == 23);
+  CPPUNIT_ASSERT(list_at(dir, 5).as_value() == 2);
+
+  auto& file = entries.back().as_list();
+
+  CPPUNIT_ASSERT(list_at(file, 0).as_string() == "x.mkv");
+  CPPUNIT_ASSERT(list_at(file, 1).as_string() == "a/x.mkv");
+  CPPUNIT_ASSERT(list_at(file, 2).as_value() == 0);
+  CPPUNIT_ASSERT(list_at(file, 3).as_value() == 0);
+  CPPUNIT_ASSERT(list_at(file, 4).as_value() == 100);
+  CPPUNIT_ASSERT(list_at(file, 5).as_value() == 1);
+
+  auto root = index.list_directory("", 1, 1);
+
+  CPPUNIT_ASSERT(root.get_key_value("total") == 2);
+  CPPUNIT_ASSERT(root.get_key_list("entries").size() == 1);
+  CPPUNIT_ASSERT(list_at(root.get_key_list("entries").front().as_list(), 0).as_string() == "c.txt");
+
+  CPPUNIT_ASSERT(index.list_directory("a/b", 5, max).get_key_list("entries").empty());
+
+  CPPUNIT_ASSERT_THROW(index.list_directory("missing", 0, max), torrent::input_error);
+}
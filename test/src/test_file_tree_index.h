@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class TestFileTreeIndex : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestFileTreeIndex);
+
+  CPPUNIT_TEST(test_tree);
+  CPPUNIT_TEST(test_match_range);
+  CPPUNIT_TEST(test_list_directory);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_tree();
+  void test_match_range();
+  void test_list_directory();
+};
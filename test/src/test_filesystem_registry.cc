@@ -0,0 +1,153 @@
+#include "config.h"
+
+#include "test/src/test_filesystem_registry.h"
+
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <torrent/system/thread.h>
+
+#include "core/filesystem_registry.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestFilesystemRegistry);
+
+void
+TestFilesystemRegistry::setUp() {
+  TestFixtureWithMainThread::setUp();
+
+  char path[] = "/tmp/rtorrent-filesystem-XXXXXX";
+
+  CPPUNIT_ASSERT(::mkdtemp(path) != nullptr);
+
+  m_path = path;
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+}
+
+void
+TestFilesystemRegistry::tearDown() {
+  ::rmdir((m_path + "/sub").c_str());
+  ::rmdir(m_path.c_str());
+
+  TestFixtureWithMainThread::tearDown();
+}
+
+void
+TestFilesystemRegistry::test_shared_filesystem() {
+  core::FilesystemRegistry registry;
+
+  CPPUNIT_ASSERT(::mkdir((m_path + "/sub").c_str(), 0700) == 0);
+
+  auto first  = registry.find_path(m_path);
+  auto second = registry.find_path(m_path + "/sub/");
+
+  CPPUNIT_ASSERT(first != nullptr);
+  CPPUNIT_ASSERT(first == second);
+  CPPUNIT_ASSERT(first->path == m_path);
+  CPPUNIT_ASSERT(first->total != 0);
+  CPPUNIT_ASSERT(!first->is_pending);
+  CPPUNIT_ASSERT(first->projected_free() == (int64_t)first->free);
+}
+
+void
+TestFilesystemRegistry::test_missing_path() {
+  core::FilesystemRegistry registry;
+
+  auto filesystem = registry.find_path(m_path + "/sub/missing");
+
+  CPPUNIT_ASSERT(filesystem != nullptr);
+  CPPUNIT_ASSERT(filesystem->path == m_path);
+
+  // Relative paths stop at the working directory.
+  core::FilesystemRegistry relative;
+
+  CPPUNIT_ASSERT(relative.find_path("rtorrent-missing/sub") != nullptr);
+  CPPUNIT_ASSERT(relative.find_path("rtorrent-missing/sub")->path == ".");
+}
+
+void
+TestFilesystemRegistry::test_current() {
+  core::FilesystemRegistry registry;
+  registry.set_ttl(10);
+
+  auto start      = torrent::this_thread::cached_time();
+  auto filesystem = registry.find_path(m_path);
+
+  CPPUNIT_ASSERT(filesystem != nullptr);
+  CPPUNIT_ASSERT(filesystem->time_updated == start);
+
+  // Fresh values are used as is.
+  m_main_thread->test_set_cached_time(std::chrono::seconds(5));
+
+  CPPUNIT_ASSERT(registry.find_path(m_path, true) == filesystem);
+  CPPUNIT_ASSERT(filesystem->time_updated == start);
+
+  // Stale values are refreshed in place rather than in the session
+  // thread.
+  m_main_thread->test_set_cached_time(std::chrono::seconds(10));
+
+  CPPUNIT_ASSERT(registry.find_path(m_path, true) == filesystem);
+  CPPUNIT_ASSERT(filesystem->time_updated == start + std::chrono::seconds(10));
+  CPPUNIT_ASSERT(!filesystem->is_pending);
+  CPPUNIT_ASSERT(filesystem->total != 0);
+}
+
+void
+TestFilesystemRegistry::test_accounting() {
+  core::FilesystemRegistry registry;
+
+  CPPUNIT_ASSERT(::mkdir((m_path + "/sub").c_str(), 0700) == 0);
+
+  registry.begin_accounting();
+
+  auto first  = registry.add_accounting(m_path, true, 1000, true);
+  auto second = registry.add_accounting(m_path + "/sub", true, 500, true);
+  auto third  = registry.add_accounting(m_path + "/sub", false, 200, true);
+
+  registry.end_accounting();
+
+  CPPUNIT_ASSERT(first != nullptr);
+  CPPUNIT_ASSERT(first == second && first == third);
+  CPPUNIT_ASSERT(first->downloads == 3);
+  CPPUNIT_ASSERT(first->bytes_left == 1500);
+  CPPUNIT_ASSERT(first->projected_free() == (int64_t)first->free - 1500);
+
+  // A new pass resets the sums and keeps filesystems still in use.
+  registry.begin_accounting();
+  registry.add_accounting(m_path, true, 100, true);
+  registry.end_accounting();
+
+  CPPUNIT_ASSERT(registry.size() == 1);
+  CPPUNIT_ASSERT(first->downloads == 1);
+  CPPUNIT_ASSERT(first->bytes_left == 100);
+
+  // Filesystems no longer used are removed.
+  registry.begin_accounting();
+  registry.end_accounting();
+
+  CPPUNIT_ASSERT(registry.size() == 0);
+}
+
+void
+TestFilesystemRegistry::test_select_closing() {
+  using candidate_type = core::FilesystemRegistry::candidate_type;
+
+  std::vector<candidate_type> candidates{
+    {fake_download(1), 2, 100},
+    {fake_download(2), 1, 50},
+    {fake_download(3), 1, 300},
+    {fake_download(4), 0, 10},
+  };
+
+  // Lowest priority first, then the largest within a priority.
+  auto result = core::FilesystemRegistry::select_closing(candidates, -1000, 0);
+
+  CPPUNIT_ASSERT(result == std::vector<core::Download*>({fake_download(4), fake_download(3), fake_download(2), fake_download(1)}));
+
+  // Stops once the projected free diskspace reaches the limit.
+  result = core::FilesystemRegistry::select_closing(candidates, -200, 0);
+
+  CPPUNIT_ASSERT(result == std::vector<core::Download*>({fake_download(4), fake_download(3)}));
+
+  CPPUNIT_ASSERT(core::FilesystemRegistry::select_closing(candidates, 0, 0).empty());
+}
@@ -0,0 +1,26 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestFilesystemRegistry : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestFilesystemRegistry);
+
+  CPPUNIT_TEST(test_shared_filesystem);
+  CPPUNIT_TEST(test_missing_path);
+  CPPUNIT_TEST(test_current);
+  CPPUNIT_TEST(test_accounting);
+  CPPUNIT_TEST(test_select_closing);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+
+  void test_shared_filesystem();
+  void test_missing_path();
+  void test_current();
+  void test_accounting();
+  void test_select_closing();
+
+private:
+  std::string m_path;
+};
@@ -0,0 +1,56 @@
+#include "config.h"
+
+#include "test/src/test_glob.h"
+
+#include "utils/glob.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestGlob);
+
+void
+TestGlob::test_literal() {
+  utils::Glob glob("foo/bar.mkv");
+
+  CPPUNIT_ASSERT(glob.is_literal());
+  CPPUNIT_ASSERT(glob.match("foo/bar.mkv"));
+  CPPUNIT_ASSERT(!glob.match("foo/bar.mk"));
+  CPPUNIT_ASSERT(!glob.match("foo/bar.mkvx"));
+  CPPUNIT_ASSERT(!glob.match(""));
+}
+
+void
+TestGlob::test_prefix_suffix() {
+  utils::Glob glob("foo/*.mkv");
+
+  CPPUNIT_ASSERT(!glob.is_literal());
+  CPPUNIT_ASSERT(glob.match("foo/bar.mkv"));
+  CPPUNIT_ASSERT(glob.match("foo/.mkv"));
+  CPPUNIT_ASSERT(!glob.match("foo.mkv"));
+  CPPUNIT_ASSERT(!glob.match("bar/bar.mkv"));
+  CPPUNIT_ASSERT(!glob.match("foo/bar.avi"));
+}
+
+void
+TestGlob::test_wildcards() {
+  CPPUNIT_ASSERT(utils::Glob("*").match(""));
+  CPPUNIT_ASSERT(utils::Glob("*").match("a/b/c"));
+  CPPUNIT_ASSERT(utils::Glob("?.txt").match("a.txt"));
+  CPPUNIT_ASSERT(!utils::Glob("?.txt").match("ab.txt"));
+  CPPUNIT_ASSERT(utils::Glob("[ab]*").match("b.txt"));
+  CPPUNIT_ASSERT(!utils::Glob("[ab]*").match("c.txt"));
+  CPPUNIT_ASSERT(utils::Glob("a\\*b").match("a*b"));
+  CPPUNIT_ASSERT(!utils::Glob("a\\*b").match("axb"));
+}
+
+void
+TestGlob::test_list() {
+  utils::GlobList list;
+
+  CPPUNIT_ASSERT(!list.match_any("foo"));
+
+  list.push_back("*.mkv");
+  list.push_back("sample/*");
+
+  CPPUNIT_ASSERT(list.match_any("movie.mkv"));
+  CPPUNIT_ASSERT(list.match_any("sample/clip.avi"));
+  CPPUNIT_ASSERT(!list.match_any("movie.avi"));
+}
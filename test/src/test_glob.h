@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class TestGlob : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestGlob);
+
+  CPPUNIT_TEST(test_literal);
+  CPPUNIT_TEST(test_prefix_suffix);
+  CPPUNIT_TEST(test_wildcards);
+  CPPUNIT_TEST(test_list);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_literal();
+  void test_prefix_suffix();
+  void test_wildcards();
+  void test_list();
+};
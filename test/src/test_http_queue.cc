@@ -0,0 +1,133 @@
+#include "config.h"
+
+#include "test/src/test_http_queue.h"
+
+#include "core/http_queue.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHttpQueue);
+
+void
+TestHttpQueue::test_host_limit() {
+  core::HttpHostQueue hosts;
+
+  hosts.push("a.example", "http://a.example/1");
+  hosts.push("a.example", "http://a.example/2");
+  hosts.push("a.example", "http://a.example/3");
+  hosts.push("b.example", "http://b.example/1");
+
+  CPPUNIT_ASSERT(hosts.pop_startable("a.example", 2) == std::vector<std::string>({"http://a.example/1", "http://a.example/2"}));
+  CPPUNIT_ASSERT(hosts.size_active("a.example") == 2);
+  CPPUNIT_ASSERT(hosts.size_queued("a.example") == 1);
+
+  // Full hosts start nothing, other hosts are unaffected.
+  CPPUNIT_ASSERT(hosts.pop_startable("a.example", 2).empty());
+  CPPUNIT_ASSERT(hosts.pop_startable("b.example", 2) == std::vector<std::string>({"http://b.example/1"}));
+  CPPUNIT_ASSERT(hosts.queued_hosts() == std::vector<std::string>({"a.example"}));
+
+  hosts.release("a.example");
+
+  CPPUNIT_ASSERT(hosts.pop_startable("a.example", 2) == std::vector<std::string>({"http://a.example/3"}));
+  CPPUNIT_ASSERT(hosts.size_queued("a.example") == 0);
+  CPPUNIT_ASSERT(hosts.queues().empty());
+
+  hosts.release("a.example");
+  hosts.release("a.example");
+  hosts.release("b.example");
+
+  CPPUNIT_ASSERT(hosts.active().empty());
+
+  // Releasing an idle host is ignored.
+  hosts.release("a.example");
+  CPPUNIT_ASSERT(hosts.size_active("a.example") == 0);
+}
+
+void
+TestHttpQueue::test_host_unlimited() {
+  core::HttpHostQueue hosts;
+
+  for (int i = 0; i < 10; i++)
+    hosts.push("a.example", "http://a.example/" + std::to_string(i));
+
+  CPPUNIT_ASSERT(hosts.pop_startable("a.example", 0).size() == 10);
+  CPPUNIT_ASSERT(hosts.size_active("a.example") == 10);
+  CPPUNIT_ASSERT(hosts.pop_startable("c.example", 0).empty());
+  CPPUNIT_ASSERT(hosts.size_active("c.example") == 0);
+
+  hosts.clear();
+
+  CPPUNIT_ASSERT(hosts.active().empty());
+  CPPUNIT_ASSERT(hosts.queues().empty());
+}
+
+void
+TestHttpQueue::test_cache_round_trip() {
+  core::HttpCacheIndex index;
+
+  index.update("http://a.example/1.torrent", 100);
+  index.update("http://b.example/2.torrent", 200);
+  index.find("http://b.example/2.torrent")->hash = "hash";
+
+  core::HttpCacheIndex loaded;
+
+  CPPUNIT_ASSERT(loaded.from_object(index.to_object()));
+  CPPUNIT_ASSERT(loaded.size() == 2);
+
+  auto entry = loaded.find("http://b.example/2.torrent");
+
+  CPPUNIT_ASSERT(entry != nullptr);
+  CPPUNIT_ASSERT(entry->file == core::HttpCacheIndex::file_name("http://b.example/2.torrent"));
+  CPPUNIT_ASSERT(entry->time == 200);
+  CPPUNIT_ASSERT(entry->hash == "hash");
+  CPPUNIT_ASSERT(loaded.find("http://a.example/1.torrent")->time == 100);
+
+  // Malformed entries are skipped, non-map indexes rejected.
+  auto object = index.to_object();
+  object.insert_key("http://c.example/", torrent::Object("not a map"));
+  object.get_key("http://a.example/1.torrent").erase_key("time");
+
+  CPPUNIT_ASSERT(loaded.from_object(object));
+  CPPUNIT_ASSERT(loaded.size() == 1);
+  CPPUNIT_ASSERT(loaded.find("http://b.example/2.torrent") != nullptr);
+
+  CPPUNIT_ASSERT(!loaded.from_object(torrent::Object("index")));
+  CPPUNIT_ASSERT(loaded.empty());
+}
+
+void
+TestHttpQueue::test_cache_expiry() {
+  core::HttpCacheIndex index;
+
+  index.update("http://a.example/", 1000);
+
+  CPPUNIT_ASSERT(index.find_fresh("http://a.example/", 1000, 60) != nullptr);
+  CPPUNIT_ASSERT(index.find_fresh("http://a.example/", 1060, 60) != nullptr);
+  CPPUNIT_ASSERT(index.find_fresh("http://a.example/", 1061, 60) == nullptr);
+  CPPUNIT_ASSERT(index.find_fresh("http://a.example/", 1000, 0) == nullptr);
+  CPPUNIT_ASSERT(index.find_fresh("http://b.example/", 1000, 60) == nullptr);
+
+  // Fetching again refreshes the entry and clears the cached hash.
+  index.find("http://a.example/")->hash = "hash";
+  index.update("http://a.example/", 2000);
+
+  auto entry = index.find_fresh("http://a.example/", 2030, 60);
+
+  CPPUNIT_ASSERT(entry != nullptr);
+  CPPUNIT_ASSERT(entry->hash.empty());
+}
+
+void
+TestHttpQueue::test_cache_eviction() {
+  core::HttpCacheIndex index;
+
+  for (size_t i = 0; i < core::HttpCacheIndex::max_entries; i++)
+    CPPUNIT_ASSERT(index.update("http://a.example/" + std::to_string(i), 1000 + i).empty());
+
+  auto oldest_file = index.find("http://a.example/0")->file;
+  auto removed     = index.update("http://b.example/", 500);
+
+  // The new entry is kept even when its time is the oldest.
+  CPPUNIT_ASSERT(removed == std::vector<std::string>({oldest_file}));
+  CPPUNIT_ASSERT(index.size() == core::HttpCacheIndex::max_entries);
+  CPPUNIT_ASSERT(index.find("http://a.example/0") == nullptr);
+  CPPUNIT_ASSERT(index.find("http://b.example/") != nullptr);
+}
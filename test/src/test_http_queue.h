@@ -0,0 +1,20 @@
+#include "test/helpers/test_fixture.h"
+
+class TestHttpQueue : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestHttpQueue);
+
+  CPPUNIT_TEST(test_host_limit);
+  CPPUNIT_TEST(test_host_unlimited);
+  CPPUNIT_TEST(test_cache_round_trip);
+  CPPUNIT_TEST(test_cache_expiry);
+  CPPUNIT_TEST(test_cache_eviction);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_host_limit();
+  void test_host_unlimited();
+  void test_cache_round_trip();
+  void test_cache_expiry();
+  void test_cache_eviction();
+};
@@ -0,0 +1,109 @@
+#include "config.h"
+
+#include "test/src/test_log_ring.h"
+
+#include <string>
+
+#include "core/log_ring.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestLogRing);
+
+static void
+push_messages(core::LogRing& ring, int group, int first, int last) {
+  for (int i = first; i != last; i++) {
+    auto message = std::to_string(i) + "\n";
+    ring.push(group, i, message.c_str(), message.size());
+  }
+}
+
+void
+TestLogRing::test_tail() {
+  core::LogRing ring(8);
+
+  auto empty = ring.tail(0, 10, {});
+
+  CPPUNIT_ASSERT(empty.cursor == 0);
+  CPPUNIT_ASSERT(empty.entries.empty());
+
+  push_messages(ring, 1, 0, 5);
+
+  auto first = ring.tail(0, 3, {});
+
+  CPPUNIT_ASSERT(first.cursor == 3);
+  CPPUNIT_ASSERT(first.dropped == 0);
+  CPPUNIT_ASSERT(first.entries.size() == 3);
+  CPPUNIT_ASSERT(first.entries.front().message == "0");
+  CPPUNIT_ASSERT(first.entries.back().sequence == 2);
+
+  auto second = ring.tail(first.cursor, 10, {});
+
+  CPPUNIT_ASSERT(second.cursor == 5);
+  CPPUNIT_ASSERT(second.entries.size() == 2);
+  CPPUNIT_ASSERT(second.entries.back().message == "4");
+  CPPUNIT_ASSERT(second.entries.back().time == 4);
+
+  // Cursors past the end, e.g. from a previous run, start at the end.
+  CPPUNIT_ASSERT(ring.tail(100, 10, {}).cursor == 5);
+}
+
+void
+TestLogRing::test_dropped() {
+  core::LogRing ring(4);
+
+  push_messages(ring, 1, 0, 10);
+
+  auto result = ring.tail(0, 10, {});
+
+  CPPUNIT_ASSERT(result.dropped == 6);
+  CPPUNIT_ASSERT(result.cursor == 10);
+  CPPUNIT_ASSERT(result.entries.size() == 4);
+  CPPUNIT_ASSERT(result.entries.front().sequence == 6);
+}
+
+void
+TestLogRing::test_groups() {
+  core::LogRing ring(16);
+
+  push_messages(ring, 1, 0, 3);
+  push_messages(ring, 2, 3, 6);
+  push_messages(ring, 1, 6, 8);
+
+  std::vector<bool> groups(4);
+  groups[2] = true;
+
+  auto result = ring.tail(0, 2, groups);
+
+  CPPUNIT_ASSERT(result.entries.size() == 2);
+  CPPUNIT_ASSERT(result.entries.front().sequence == 3);
+  CPPUNIT_ASSERT(result.cursor == 5);
+
+  result = ring.tail(result.cursor, 10, groups);
+
+  CPPUNIT_ASSERT(result.entries.size() == 1);
+  CPPUNIT_ASSERT(result.entries.front().group == 2);
+  CPPUNIT_ASSERT(result.cursor == 8);
+}
+
+void
+TestLogRing::test_resize() {
+  core::LogRing ring(8);
+
+  push_messages(ring, 1, 0, 6);
+  ring.set_size(3);
+
+  auto result = ring.tail(0, 10, {});
+
+  CPPUNIT_ASSERT(ring.size() == 3);
+  CPPUNIT_ASSERT(result.dropped == 3);
+  CPPUNIT_ASSERT(result.entries.size() == 3);
+  CPPUNIT_ASSERT(result.entries.front().message == "3");
+
+  ring.set_size(8);
+  push_messages(ring, 1, 6, 8);
+
+  result = ring.tail(0, 10, {});
+
+  CPPUNIT_ASSERT(result.entries.size() == 5);
+  CPPUNIT_ASSERT(result.entries.front().sequence == 3);
+  CPPUNIT_ASSERT(result.entries.back().message == "7");
+}
@@ -0,0 +1,18 @@
+#include "test/helpers/test_fixture.h"
+
+class TestLogRing : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestLogRing);
+
+  CPPUNIT_TEST(test_tail);
+  CPPUNIT_TEST(test_dropped);
+  CPPUNIT_TEST(test_groups);
+  CPPUNIT_TEST(test_resize);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_tail();
+  void test_dropped();
+  void test_groups();
+  void test_resize();
+};
@@ -0,0 +1,145 @@
+#include "config.h"
+
+#include "test/src/test_parallel_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+#include "core/parallel_pool.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestParallelPool);
+
+typedef std::pair<int, int> entry_type;
+
+// Few distinct keys, so stability decides most of the order.
+static std::vector<entry_type>
+make_entries(size_t size) {
+  std::vector<entry_type> entries;
+  uint32_t                seed = 1;
+
+  for (size_t i = 0; i != size; i++) {
+    seed = seed * 1103515245 + 12345;
+    entries.emplace_back((seed >> 16) % 7, i);
+  }
+
+  return entries;
+}
+
+static bool
+entry_less(const entry_type& a, const entry_type& b) {
+  return a.first < b.first;
+}
+
+void
+TestParallelPool::test_run() {
+  core::ParallelPool     pool;
+  std::atomic<unsigned>  calls[8]{};
+
+  pool.run(8, [&](unsigned index) { calls[index]++; });
+
+  for (auto& count : calls)
+    CPPUNIT_ASSERT(count == 1);
+
+  CPPUNIT_ASSERT(pool.size() == 7);
+
+  // A single index runs in the calling thread without starting any.
+  core::ParallelPool serial;
+  unsigned           serial_calls = 0;
+
+  serial.run(1, [&](unsigned) { serial_calls++; });
+
+  CPPUNIT_ASSERT(serial_calls == 1);
+  CPPUNIT_ASSERT(serial.size() == 0);
+}
+
+void
+TestParallelPool::test_reuse() {
+  core::ParallelPool    pool;
+  std::atomic<unsigned> calls{};
+
+  for (int i = 0; i != 100; i++)
+    pool.run(4, [&](unsigned) { calls++; });
+
+  CPPUNIT_ASSERT(calls == 400);
+  CPPUNIT_ASSERT(pool.size() == 3);
+
+  // Fewer indices than workers leaves the others idle, more grows the
+  // pool.
+  calls = 0;
+  pool.run(2, [&](unsigned) { calls++; });
+
+  CPPUNIT_ASSERT(calls == 2);
+  CPPUNIT_ASSERT(pool.size() == 3);
+
+  pool.run(6, [&](unsigned) { calls++; });
+
+  CPPUNIT_ASSERT(calls == 8);
+  CPPUNIT_ASSERT(pool.size() == 5);
+}
+
+void
+TestParallelPool::test_exception() {
+  core::ParallelPool    pool;
+  std::atomic<unsigned> calls{};
+
+  auto func = [&](unsigned index, size_t, size_t) {
+      calls++;
+
+      if (index == 2)
+        throw std::runtime_error("chunk failed");
+    };
+
+  CPPUNIT_ASSERT_THROW(core::parallel_for(pool, 1000, 4, func), std::runtime_error);
+
+  // The other chunks still ran and the pool is usable afterwards.
+  CPPUNIT_ASSERT(calls == 4);
+
+  pool.run(4, [&](unsigned) { calls++; });
+  CPPUNIT_ASSERT(calls == 8);
+}
+
+// Same pattern as the view filter, each chunk writes the matches of
+// its own range.
+void
+TestParallelPool::test_filter() {
+  core::ParallelPool pool;
+
+  for (size_t size : {0, 1, 7, 1000, 4099}) {
+    auto entries = make_entries(size);
+
+    std::vector<char> serial(size);
+    std::transform(entries.begin(), entries.end(), serial.begin(), [](const auto& e) { return e.first % 2 == 0; });
+
+    for (unsigned threads = 1; threads != 9; threads++) {
+      std::vector<char> matches(size, 2);
+
+      core::parallel_for(pool, size, threads, [&](unsigned, size_t first, size_t last) {
+          for (size_t i = first; i != last; i++)
+            matches[i] = entries[i].first % 2 == 0;
+        });
+
+      CPPUNIT_ASSERT(matches == serial);
+    }
+  }
+}
+
+void
+TestParallelPool::test_stable_sort() {
+  core::ParallelPool pool;
+
+  for (size_t size : {0, 1, 7, 1000, 4099}) {
+    auto serial = make_entries(size);
+    std::stable_sort(serial.begin(), serial.end(), &entry_less);
+
+    for (unsigned threads = 1; threads != 9; threads++) {
+      auto entries = make_entries(size);
+
+      core::parallel_stable_sort(pool, entries.begin(), entries.end(), threads,
+                                 [](unsigned) { return &entry_less; },
+                                 &entry_less);
+
+      CPPUNIT_ASSERT(entries == serial);
+    }
+  }
+}
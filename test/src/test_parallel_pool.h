@@ -0,0 +1,20 @@
+#include "test/helpers/test_fixture.h"
+
+class TestParallelPool : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestParallelPool);
+
+  CPPUNIT_TEST(test_run);
+  CPPUNIT_TEST(test_reuse);
+  CPPUNIT_TEST(test_exception);
+  CPPUNIT_TEST(test_filter);
+  CPPUNIT_TEST(test_stable_sort);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_run();
+  void test_reuse();
+  void test_exception();
+  void test_filter();
+  void test_stable_sort();
+};
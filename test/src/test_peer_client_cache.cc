@@ -0,0 +1,106 @@
+#include "config.h"
+
+#include "test/src/test_peer_client_cache.h"
+
+#include <cstring>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "core/peer_client_cache.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestPeerClientCache);
+
+// The peers are only used as keys and never dereferenced.
+
+static const torrent::PeerInfo*
+fake_peer(uintptr_t id) {
+  return reinterpret_cast<const torrent::PeerInfo*>(id * 8);
+}
+
+static core::PeerClientCache::identity_type
+make_identity(char id, uint16_t port = 6881) {
+  sockaddr_in sin{};
+  sin.sin_family      = AF_INET;
+  sin.sin_port        = htons(port);
+  sin.sin_addr.s_addr = htonl(0x7f000001);
+
+  return core::PeerClientCache::make_identity(std::string(20, id).c_str(), reinterpret_cast<const sockaddr*>(&sin));
+}
+
+void
+TestPeerClientCache::test_make_identity() {
+  CPPUNIT_ASSERT(make_identity('a') == make_identity('a'));
+  CPPUNIT_ASSERT(!(make_identity('a') == make_identity('b')));
+  CPPUNIT_ASSERT(!(make_identity('a') == make_identity('a', 6882)));
+
+  // Only the family, port and address of the socket address count.
+  sockaddr_in sin{};
+  sin.sin_family      = AF_INET;
+  sin.sin_port        = htons(6881);
+  sin.sin_addr.s_addr = htonl(0x7f000001);
+  std::memset(sin.sin_zero, 0xff, sizeof(sin.sin_zero));
+
+  auto id = std::string(20, 'a');
+
+  CPPUNIT_ASSERT(core::PeerClientCache::make_identity(id.c_str(), reinterpret_cast<const sockaddr*>(&sin)) == make_identity('a'));
+
+  sockaddr_in6 sin6{};
+  sin6.sin6_family = AF_INET6;
+  sin6.sin6_port   = htons(6881);
+  sin6.sin6_addr   = in6addr_loopback;
+
+  auto identity6 = core::PeerClientCache::make_identity(id.c_str(), reinterpret_cast<const sockaddr*>(&sin6));
+
+  CPPUNIT_ASSERT(!(identity6 == make_identity('a')));
+  CPPUNIT_ASSERT(identity6.family == AF_INET6);
+  CPPUNIT_ASSERT(std::memcmp(identity6.address, &in6addr_loopback, sizeof(in6addr_loopback)) == 0);
+}
+
+void
+TestPeerClientCache::test_identity() {
+  core::PeerClientCache cache;
+
+  cache.insert_entry(fake_peer(1), fake_download(1), make_identity('a')).client_name = "A";
+
+  auto entry = cache.find_entry(fake_peer(1), make_identity('a'));
+
+  CPPUNIT_ASSERT(entry != nullptr);
+  CPPUNIT_ASSERT(entry->client_name == "A");
+  CPPUNIT_ASSERT(entry->download == fake_download(1));
+
+  // A reused PeerInfo address belonging to another peer isn't matched.
+  CPPUNIT_ASSERT(cache.find_entry(fake_peer(1), make_identity('b')) == nullptr);
+  CPPUNIT_ASSERT(cache.find_entry(fake_peer(2), make_identity('a')) == nullptr);
+
+  // Inserting again replaces the stale entry.
+  cache.insert_entry(fake_peer(1), fake_download(2), make_identity('b'));
+
+  entry = cache.find_entry(fake_peer(1), make_identity('b'));
+
+  CPPUNIT_ASSERT(entry != nullptr);
+  CPPUNIT_ASSERT(entry->client_name.empty());
+  CPPUNIT_ASSERT(entry->download == fake_download(2));
+  CPPUNIT_ASSERT(cache.size() == 1);
+
+  cache.erase_entry(fake_peer(1));
+
+  CPPUNIT_ASSERT(cache.find_entry(fake_peer(1), make_identity('b')) == nullptr);
+  CPPUNIT_ASSERT(cache.size() == 0);
+}
+
+void
+TestPeerClientCache::test_erase_download() {
+  core::PeerClientCache cache;
+
+  cache.insert_entry(fake_peer(1), fake_download(1), make_identity('a'));
+  cache.insert_entry(fake_peer(2), fake_download(1), make_identity('b'));
+  cache.insert_entry(fake_peer(3), fake_download(2), make_identity('c'));
+
+  cache.erase(fake_download(1));
+
+  CPPUNIT_ASSERT(cache.size() == 1);
+  CPPUNIT_ASSERT(cache.find_entry(fake_peer(1), make_identity('a')) == nullptr);
+  CPPUNIT_ASSERT(cache.find_entry(fake_peer(3), make_identity('c')) != nullptr);
+}
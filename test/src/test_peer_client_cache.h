@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class TestPeerClientCache : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestPeerClientCache);
+
+  CPPUNIT_TEST(test_make_identity);
+  CPPUNIT_TEST(test_identity);
+  CPPUNIT_TEST(test_erase_download);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_make_identity();
+  void test_identity();
+  void test_erase_download();
+};
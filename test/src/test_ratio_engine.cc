@@ -0,0 +1,150 @@
+#include "config.h"
+
+#include "test/src/test_ratio_engine.h"
+
+#include <cstdlib>
+#include <map>
+
+#include "core/ratio_engine.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestRatioEngine);
+
+static core::RatioEngine::settings_type
+make_settings(int64_t min_ratio, int64_t max_ratio, int64_t min_upload) {
+  core::RatioEngine::settings_type settings;
+  settings.min_ratio = min_ratio;
+  settings.max_ratio = max_ratio;
+  settings.min_upload = min_upload;
+  return settings;
+}
+
+void
+TestRatioEngine::test_threshold_min() {
+  CPPUNIT_ASSERT_EQUAL(int64_t{2000}, core::RatioEngine::upload_threshold(1000, make_settings(200, 300, 20)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{1992}, core::RatioEngine::upload_threshold(1001, make_settings(199, 0, 0)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{5000}, core::RatioEngine::upload_threshold(1000, make_settings(200, 0, 5000)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{0},    core::RatioEngine::upload_threshold(0, make_settings(200, 0, 0)));
+}
+
+void
+TestRatioEngine::test_threshold_max() {
+  // The maximum ratio is reached before the minimum upload.
+  CPPUNIT_ASSERT_EQUAL(int64_t{3001}, core::RatioEngine::upload_threshold(1000, make_settings(200, 300, 5000)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{1},    core::RatioEngine::upload_threshold(0, make_settings(200, 300, 5000)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{3004}, core::RatioEngine::upload_threshold(1001, make_settings(200, 300, 5000)));
+}
+
+void
+TestRatioEngine::test_threshold_disabled() {
+  CPPUNIT_ASSERT_EQUAL(int64_t{20}, core::RatioEngine::upload_threshold(1000, make_settings(0, 0, 20)));
+  CPPUNIT_ASSERT_EQUAL(int64_t{0},  core::RatioEngine::upload_threshold(1000, make_settings(-100, -1, -20)));
+}
+
+void
+TestRatioEngine::test_heap_order() {
+  core::RatioHeap heap;
+
+  heap.push(fake_download(1), 300);
+  heap.push(fake_download(2), 100);
+  heap.push(fake_download(3), 200);
+
+  CPPUNIT_ASSERT(heap.pop_due(50).empty());
+
+  auto due = heap.pop_due(200);
+
+  CPPUNIT_ASSERT(due.size() == 2);
+  CPPUNIT_ASSERT(due[0].download == fake_download(2));
+  CPPUNIT_ASSERT(due[1].download == fake_download(3));
+  CPPUNIT_ASSERT(heap.size() == 1);
+}
+
+void
+TestRatioEngine::test_heap_erase() {
+  core::RatioHeap heap;
+
+  for (uintptr_t i = 1; i <= 5; i++)
+    heap.push(fake_download(i), i * 100);
+
+  CPPUNIT_ASSERT(heap.erase(fake_download(1)));
+  CPPUNIT_ASSERT(heap.erase(fake_download(4)));
+  CPPUNIT_ASSERT(!heap.erase(fake_download(4)));
+
+  CPPUNIT_ASSERT(!heap.contains(fake_download(1)));
+  CPPUNIT_ASSERT(heap.contains(fake_download(2)));
+
+  auto due = heap.pop_due(1000);
+
+  CPPUNIT_ASSERT(due.size() == 3);
+  CPPUNIT_ASSERT(due[0].download == fake_download(2));
+  CPPUNIT_ASSERT(due[1].download == fake_download(3));
+  CPPUNIT_ASSERT(due[2].download == fake_download(5));
+}
+
+void
+TestRatioEngine::test_heap_update() {
+  core::RatioHeap heap;
+
+  for (uintptr_t i = 1; i <= 5; i++)
+    heap.push(fake_download(i), i * 100);
+
+  // Pushing a download already in the heap moves it.
+  heap.push(fake_download(5), 50);
+  heap.push(fake_download(1), 450);
+  heap.push(fake_download(3), core::RatioHeap::never);
+
+  CPPUNIT_ASSERT(heap.size() == 5);
+  CPPUNIT_ASSERT(heap.contains(fake_download(3)));
+
+  auto due = heap.pop_due(1000);
+
+  CPPUNIT_ASSERT(due.size() == 4);
+  CPPUNIT_ASSERT(due[0].download == fake_download(5));
+  CPPUNIT_ASSERT(due[1].download == fake_download(2));
+  CPPUNIT_ASSERT(due[2].download == fake_download(4));
+  CPPUNIT_ASSERT(due[3].download == fake_download(1));
+
+  CPPUNIT_ASSERT(!heap.contains(fake_download(1)));
+  CPPUNIT_ASSERT(heap.contains(fake_download(3)));
+  CPPUNIT_ASSERT(heap.size() == 1);
+}
+
+void
+TestRatioEngine::test_heap_random() {
+  core::RatioHeap              heap;
+  std::map<uintptr_t, int64_t> keys;
+
+  ::srandom(1);
+
+  for (int i = 0; i < 2000; i++) {
+    uintptr_t id  = 1 + ::random() % 64;
+    int64_t   key = ::random() % 1000;
+
+    if (::random() % 4 == 0) {
+      CPPUNIT_ASSERT(heap.erase(fake_download(id)) == (keys.erase(id) != 0));
+    } else {
+      heap.push(fake_download(id), key);
+      keys[id] = key;
+    }
+
+    CPPUNIT_ASSERT(heap.size() == keys.size());
+  }
+
+  for (const auto& [id, key] : keys)
+    CPPUNIT_ASSERT(heap.contains(fake_download(id)));
+
+  auto    due  = heap.pop_due(1000);
+  int64_t last = -1;
+
+  CPPUNIT_ASSERT(due.size() == keys.size());
+
+  for (const auto& entry : due) {
+    auto id = reinterpret_cast<uintptr_t>(entry.download) / 8;
+
+    CPPUNIT_ASSERT(keys[id] == entry.key);
+    CPPUNIT_ASSERT(last <= entry.key);
+    last = entry.key;
+  }
+
+  CPPUNIT_ASSERT(heap.empty());
+}
@@ -0,0 +1,24 @@
+#include "test/helpers/test_fixture.h"
+
+class TestRatioEngine : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestRatioEngine);
+
+  CPPUNIT_TEST(test_threshold_min);
+  CPPUNIT_TEST(test_threshold_max);
+  CPPUNIT_TEST(test_threshold_disabled);
+  CPPUNIT_TEST(test_heap_order);
+  CPPUNIT_TEST(test_heap_erase);
+  CPPUNIT_TEST(test_heap_update);
+  CPPUNIT_TEST(test_heap_random);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_threshold_min();
+  void test_threshold_max();
+  void test_threshold_disabled();
+  void test_heap_order();
+  void test_heap_erase();
+  void test_heap_update();
+  void test_heap_random();
+};
@@ -0,0 +1,202 @@
+#include "config.h"
+
+#include "test/src/test_startup_admission.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "core/startup_admission.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStartupAdmission);
+
+// Stands in for TrackerGovernor and DownloadList, refusing every
+// download of the hosts in 'refused'.
+struct fake_governor {
+  std::map<core::Download*, std::string> hosts;
+  std::set<std::string>                  refused;
+  std::vector<core::Download*>           resumed;
+
+  core::Download*     add(uintptr_t id, const std::string& host) { hosts[fake_download(id)] = host; return fake_download(id); }
+
+  void
+  attach(core::StartupAdmission& admission) {
+    admission.slot_download_host()   = [this](core::Download* download) { return hosts.at(download); };
+    admission.slot_try_acquire()     = [this](core::Download* download) { return refused.find(hosts.at(download)) == refused.end(); };
+    admission.slot_resume_download() = [this](core::Download* download, int) { resumed.push_back(download); };
+  }
+};
+
+using download_list = std::vector<core::Download*>;
+
+void
+TestStartupAdmission::tick() {
+  m_main_thread->test_add_cached_time(std::chrono::seconds(1));
+  m_main_thread->test_process_events_without_cached_time();
+}
+
+void
+TestStartupAdmission::test_rate_cap() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  fake_governor          governor;
+  core::StartupAdmission admission;
+
+  governor.attach(admission);
+  admission.set_resume_rate(2);
+  admission.begin();
+
+  for (uintptr_t id = 1; id <= 5; id++)
+    governor.add(id, "a");
+
+  CPPUNIT_ASSERT(admission.admit(fake_download(1), 0));
+  CPPUNIT_ASSERT(admission.admit(fake_download(2), 0));
+  CPPUNIT_ASSERT(!admission.admit(fake_download(3), 0));
+  CPPUNIT_ASSERT(!admission.admit(fake_download(4), 0));
+  CPPUNIT_ASSERT(!admission.admit(fake_download(5), 0));
+  CPPUNIT_ASSERT(!admission.admit(fake_download(3), 0));
+  CPPUNIT_ASSERT(admission.size_queued() == 3);
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(3), fake_download(4)}));
+  CPPUNIT_ASSERT(admission.size_queued() == 1);
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(3), fake_download(4), fake_download(5)}));
+  CPPUNIT_ASSERT(admission.size_queued() == 0);
+  CPPUNIT_ASSERT(admission.count_admitted() == 5);
+
+  // Admitted downloads are let through until the warm-up ends.
+  CPPUNIT_ASSERT(admission.admit(fake_download(3), 0));
+}
+
+void
+TestStartupAdmission::test_host_order() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  fake_governor          governor;
+  core::StartupAdmission admission;
+
+  governor.attach(admission);
+  admission.set_resume_rate(1);
+  admission.begin();
+
+  CPPUNIT_ASSERT(admission.admit(governor.add(1, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(2, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(3, "b"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(4, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(5, "c"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(6, "b"), 0));
+
+  // Each tick takes one download from the next host in turn.
+  tick();
+  tick();
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(2), fake_download(3), fake_download(5)}));
+
+  admission.set_resume_rate(10);
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(2), fake_download(3), fake_download(5),
+                                                    fake_download(4), fake_download(6)}));
+}
+
+void
+TestStartupAdmission::test_refused_host() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  fake_governor          governor;
+  core::StartupAdmission admission;
+
+  governor.attach(admission);
+  admission.set_resume_rate(10);
+  admission.begin();
+
+  governor.refused = {"a", "b"};
+
+  CPPUNIT_ASSERT(!admission.admit(governor.add(1, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(2, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(3, "b"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(4, "b"), 0));
+
+  // Host 'a' is still refused, which doesn't hold back host 'b'.
+  governor.refused = {"a"};
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(3), fake_download(4)}));
+  CPPUNIT_ASSERT(admission.size_queued() == 2);
+
+  // A host without a queue is admitted directly.
+  CPPUNIT_ASSERT(admission.admit(governor.add(5, "c"), 0));
+
+  governor.refused.clear();
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(3), fake_download(4), fake_download(1), fake_download(2)}));
+  CPPUNIT_ASSERT(admission.size_queued() == 0);
+}
+
+void
+TestStartupAdmission::test_erase() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  fake_governor          governor;
+  core::StartupAdmission admission;
+
+  governor.attach(admission);
+  admission.set_resume_rate(1);
+  admission.begin();
+
+  CPPUNIT_ASSERT(admission.admit(governor.add(1, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(2, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(3, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(4, "b"), 0));
+
+  admission.erase(fake_download(2));
+  CPPUNIT_ASSERT(admission.size_queued() == 2);
+
+  // Resuming a download may erase others admitted in the same tick.
+  admission.slot_resume_download() = [&](core::Download* download, int) {
+      governor.resumed.push_back(download);
+      admission.erase(fake_download(4));
+    };
+
+  admission.set_resume_rate(10);
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(3)}));
+  CPPUNIT_ASSERT(admission.size_queued() == 0);
+}
+
+void
+TestStartupAdmission::test_settle() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  fake_governor          governor;
+  core::StartupAdmission admission;
+
+  governor.attach(admission);
+  admission.set_resume_rate(1);
+  admission.begin();
+
+  CPPUNIT_ASSERT(admission.admit(governor.add(1, "a"), 0));
+  CPPUNIT_ASSERT(!admission.admit(governor.add(2, "a"), 0));
+
+  tick();
+  CPPUNIT_ASSERT(governor.resumed == download_list({fake_download(2)}));
+
+  // The warm-up ends once nothing has been queued for 'settle_time'.
+  for (int i = 2; i < 5; i++) {
+    tick();
+    CPPUNIT_ASSERT(admission.is_active());
+  }
+
+  tick();
+  CPPUNIT_ASSERT(!admission.is_active());
+  CPPUNIT_ASSERT(admission.elapsed() == std::chrono::seconds(5));
+
+  CPPUNIT_ASSERT(admission.admit(governor.add(3, "a"), 0));
+  CPPUNIT_ASSERT(admission.count_admitted() == 2);
+}
@@ -0,0 +1,23 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestStartupAdmission : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestStartupAdmission);
+
+  CPPUNIT_TEST(test_rate_cap);
+  CPPUNIT_TEST(test_host_order);
+  CPPUNIT_TEST(test_refused_host);
+  CPPUNIT_TEST(test_erase);
+  CPPUNIT_TEST(test_settle);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_rate_cap();
+  void test_host_order();
+  void test_refused_host();
+  void test_erase();
+  void test_settle();
+
+private:
+  void tick();
+};
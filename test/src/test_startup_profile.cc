@@ -0,0 +1,105 @@
+#include "config.h"
+
+#include "test/src/test_startup_profile.h"
+
+#include <torrent/system/thread.h>
+
+#include "core/startup_profile.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStartupProfile);
+
+// Times are taken from the test's cached time so they can be checked
+// exactly.
+static std::chrono::microseconds
+cached_time() {
+  return torrent::this_thread::cached_time();
+}
+
+void
+TestStartupProfile::test_spans() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  core::StartupProfile profile(&cached_time);
+
+  {
+    core::StartupProfile::scope outer(&profile, "phase", "config");
+    m_main_thread->test_add_cached_time(std::chrono::milliseconds(10));
+
+    {
+      core::StartupProfile::scope inner(&profile, "import", "rtorrent.rc");
+      m_main_thread->test_add_cached_time(std::chrono::milliseconds(5));
+    }
+
+    m_main_thread->test_add_cached_time(std::chrono::milliseconds(1));
+  }
+
+  // Spans are recorded as they end, so nested spans come first.
+  CPPUNIT_ASSERT_EQUAL(size_t{2}, profile.spans().size());
+  CPPUNIT_ASSERT_EQUAL(std::string("rtorrent.rc"), profile.spans()[0].name);
+  CPPUNIT_ASSERT_EQUAL(std::string("config"), profile.spans()[1].name);
+
+  CPPUNIT_ASSERT(profile.spans()[0].start == std::chrono::milliseconds(10));
+  CPPUNIT_ASSERT(profile.spans()[0].duration == std::chrono::milliseconds(5));
+  CPPUNIT_ASSERT(profile.spans()[1].start == std::chrono::milliseconds(0));
+  CPPUNIT_ASSERT(profile.spans()[1].duration == std::chrono::milliseconds(16));
+}
+
+void
+TestStartupProfile::test_finish() {
+  m_main_thread->test_set_cached_time(std::chrono::seconds(0));
+
+  core::StartupProfile profile(&cached_time);
+
+  m_main_thread->test_add_cached_time(std::chrono::milliseconds(20));
+  CPPUNIT_ASSERT(profile.elapsed() == std::chrono::milliseconds(20));
+
+  profile.insert_pending_load();
+  profile.set_startup_done();
+  CPPUNIT_ASSERT(profile.is_recording());
+
+  m_main_thread->test_add_cached_time(std::chrono::milliseconds(30));
+  CPPUNIT_ASSERT(profile.elapsed() == std::chrono::milliseconds(50));
+
+  profile.erase_pending_load();
+  CPPUNIT_ASSERT(!profile.is_recording());
+
+  // The elapsed time stops when finished, and nothing more is
+  // recorded.
+  m_main_thread->test_add_cached_time(std::chrono::milliseconds(100));
+
+  { core::StartupProfile::scope span(&profile, "phase", "late"); }
+
+  CPPUNIT_ASSERT(profile.spans().empty());
+  CPPUNIT_ASSERT(profile.elapsed() == std::chrono::milliseconds(50));
+  CPPUNIT_ASSERT_EQUAL(int64_t{50000}, profile.summary().get_key_value("elapsed_usec"));
+}
+
+void
+TestStartupProfile::test_summary() {
+  core::StartupProfile profile;
+
+  { core::StartupProfile::scope span(&profile, "phase", "config"); }
+  { core::StartupProfile::scope span(&profile, "import", "a.rc"); }
+  { core::StartupProfile::scope span(&profile, "import", "b.rc"); }
+
+  auto summary = profile.summary();
+
+  CPPUNIT_ASSERT_EQUAL(int64_t{0}, summary.get_key_value("finished"));
+  CPPUNIT_ASSERT_EQUAL(int64_t{3}, summary.get_key_value("spans"));
+  CPPUNIT_ASSERT(summary.get_key("phases").has_key("config"));
+  CPPUNIT_ASSERT_EQUAL(int64_t{2}, summary.get_key("categories").get_key("import").get_key_value("count"));
+  CPPUNIT_ASSERT_EQUAL(size_t{2}, summary.get_key_list("slowest").size());
+}
+
+void
+TestStartupProfile::test_trace_events() {
+  core::StartupProfile profile;
+
+  { core::StartupProfile::scope span(&profile, "import", "quote\".rc"); }
+
+  auto trace = profile.trace_events();
+
+  CPPUNIT_ASSERT(trace.find("\"traceEvents\":[") != std::string::npos);
+  CPPUNIT_ASSERT(trace.find("\"ph\":\"X\"") != std::string::npos);
+  CPPUNIT_ASSERT(trace.find("\"name\":\"quote\\\".rc\"") != std::string::npos);
+}
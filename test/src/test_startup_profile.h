@@ -0,0 +1,18 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestStartupProfile : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestStartupProfile);
+
+  CPPUNIT_TEST(test_spans);
+  CPPUNIT_TEST(test_finish);
+  CPPUNIT_TEST(test_summary);
+  CPPUNIT_TEST(test_trace_events);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_spans();
+  void test_finish();
+  void test_summary();
+  void test_trace_events();
+};
@@ -0,0 +1,109 @@
+#include "config.h"
+
+#include "test/src/test_throttle_groups.h"
+
+#include <torrent/exceptions.h>
+
+#include "core/throttle_groups.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestThrottleGroups);
+
+using history_type = core::ThrottleGroups::history_type;
+
+void
+TestThrottleGroups::test_history() {
+  history_type history;
+
+  CPPUNIT_ASSERT(history.peak() == 0);
+  CPPUNIT_ASSERT(history.average() == 0);
+  CPPUNIT_ASSERT(history.to_list().as_list().empty());
+
+  history.push(100);
+  history.push(300);
+  history.push(200);
+
+  CPPUNIT_ASSERT(history.peak() == 300);
+  CPPUNIT_ASSERT(history.average() == 200);
+
+  auto samples = history.to_list().as_list();
+
+  CPPUNIT_ASSERT(samples.size() == 3);
+  CPPUNIT_ASSERT(samples.front().as_value() == 100);
+  CPPUNIT_ASSERT(samples.back().as_value() == 200);
+}
+
+void
+TestThrottleGroups::test_history_wrap() {
+  history_type history;
+
+  for (uint32_t i = 0; i != core::ThrottleGroups::history_size + 10; i++)
+    history.push(i);
+
+  CPPUNIT_ASSERT(history.size == core::ThrottleGroups::history_size);
+  CPPUNIT_ASSERT(history.peak() == core::ThrottleGroups::history_size + 9);
+
+  auto samples = history.to_list().as_list();
+
+  CPPUNIT_ASSERT(samples.size() == core::ThrottleGroups::history_size);
+  CPPUNIT_ASSERT(samples.front().as_value() == 10);
+  CPPUNIT_ASSERT(samples.back().as_value() == core::ThrottleGroups::history_size + 9);
+}
+
+void
+TestThrottleGroups::test_insert() {
+  core::ThrottleGroups::throttle_map throttles;
+  core::ThrottleGroups               groups(&throttles);
+
+  auto site  = groups.insert("site", core::ThrottleGroups::invalid_id);
+  auto label = groups.insert("label", site);
+
+  CPPUNIT_ASSERT(groups.size() == 2);
+  CPPUNIT_ASSERT(groups.find("site") == site);
+  CPPUNIT_ASSERT(groups.find("label") == label);
+  CPPUNIT_ASSERT(groups.find("missing") == core::ThrottleGroups::invalid_id);
+  CPPUNIT_ASSERT(groups.find_or_insert("site") == site);
+
+  CPPUNIT_ASSERT(groups.at(label).parent == site);
+  CPPUNIT_ASSERT(groups.at(label).depth == 1);
+
+  CPPUNIT_ASSERT_THROW(groups.find_throw("missing"), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(groups.insert("site", core::ThrottleGroups::invalid_id), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(groups.insert("", core::ThrottleGroups::invalid_id), torrent::input_error);
+  CPPUNIT_ASSERT_THROW(groups.insert("orphan", 100), torrent::input_error);
+
+  auto parent = label;
+
+  for (uint32_t depth = 2; depth != core::ThrottleGroups::max_depth; depth++)
+    parent = groups.insert("nested" + std::to_string(depth), parent);
+
+  CPPUNIT_ASSERT_THROW(groups.insert("too_deep", parent), torrent::input_error);
+}
+
+void
+TestThrottleGroups::test_throttle_map() {
+  core::ThrottleGroups::throttle_map throttles;
+  core::ThrottleGroups               groups(&throttles);
+
+  // Never dereferenced.
+  auto up   = reinterpret_cast<torrent::Throttle*>(8);
+  auto down = reinterpret_cast<torrent::Throttle*>(16);
+
+  auto fixed = groups.insert_fixed("NULL", up, down);
+
+  CPPUNIT_ASSERT(throttles.size() == 1);
+  CPPUNIT_ASSERT(throttles["NULL"] == std::make_pair(up, down));
+
+  // Fixed groups can't be parents.
+  CPPUNIT_ASSERT_THROW(groups.insert("child", fixed), torrent::input_error);
+
+  // Groups without throttles are not listed for the UI.
+  groups.insert("empty", core::ThrottleGroups::invalid_id);
+
+  CPPUNIT_ASSERT(throttles.size() == 1);
+  CPPUNIT_ASSERT(throttles.find("empty") == throttles.end());
+
+  CPPUNIT_ASSERT(groups.find_throttle("NULL", true) == up);
+  CPPUNIT_ASSERT(groups.find_throttle("NULL", false) == down);
+  CPPUNIT_ASSERT(groups.find_throttle("empty", true) == nullptr);
+  CPPUNIT_ASSERT(groups.find_throttle("missing", false) == nullptr);
+}
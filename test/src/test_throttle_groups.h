@@ -0,0 +1,18 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestThrottleGroups : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestThrottleGroups);
+
+  CPPUNIT_TEST(test_history);
+  CPPUNIT_TEST(test_history_wrap);
+  CPPUNIT_TEST(test_insert);
+  CPPUNIT_TEST(test_throttle_map);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_history();
+  void test_history_wrap();
+  void test_insert();
+  void test_throttle_map();
+};
@@ -0,0 +1,178 @@
+#include "config.h"
+
+#include "test/src/test_tied_file_registry.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <torrent/exceptions.h>
+
+#include "test/helpers/fake_download.h"
+#include "utils/tied_file_registry.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestTiedFileRegistry);
+
+// Stands in for the tied_to_file of the downloads, no directories are
+// watched as there are no directory_events.
+struct fake_tied_files {
+  std::map<core::Download*, std::string> paths;
+
+  void
+  attach(utils::TiedFileRegistry& registry) {
+    registry.slot_tied_path() = [this](core::Download* download) { return paths[download]; };
+  }
+};
+
+using download_list = utils::TiedFileRegistry::download_list;
+
+void
+TestTiedFileRegistry::test_tie() {
+  fake_tied_files         files;
+  utils::TiedFileRegistry registry;
+
+  files.attach(registry);
+  files.paths[fake_download(1)] = "/tied/a.torrent";
+  files.paths[fake_download(2)] = "/tied/a.torrent";
+  files.paths[fake_download(3)] = "/tied/b.torrent";
+
+  registry.insert(fake_download(3));
+  registry.insert(fake_download(1));
+  registry.insert(fake_download(2));
+  registry.insert(fake_download(4));
+
+  CPPUNIT_ASSERT(registry.size_downloads() == 4);
+  CPPUNIT_ASSERT(registry.size_files() == 2);
+  CPPUNIT_ASSERT(registry.size_directories() == 0);
+  CPPUNIT_ASSERT(registry.count_state(utils::TiedFileRegistry::state_unknown) == 2);
+
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT(registry.state(fake_download(4)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT((registry.downloads_with_state(utils::TiedFileRegistry::state_unknown) == download_list{fake_download(3), fake_download(1), fake_download(2)}));
+
+  CPPUNIT_ASSERT_THROW(registry.insert(fake_download(1)), torrent::internal_error);
+}
+
+void
+TestTiedFileRegistry::test_untie() {
+  fake_tied_files         files;
+  utils::TiedFileRegistry registry;
+
+  files.attach(registry);
+  files.paths[fake_download(1)] = "/tied/a.torrent";
+  files.paths[fake_download(2)] = "/tied/a.torrent";
+
+  registry.insert(fake_download(1));
+  registry.insert(fake_download(2));
+  registry.receive_reconcile({"/tied/a.torrent"}, {1}, registry.generation());
+
+  files.paths[fake_download(1)] = "";
+  registry.update(fake_download(1));
+
+  CPPUNIT_ASSERT(registry.size_files() == 1);
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT(registry.state(fake_download(2)) == utils::TiedFileRegistry::state_present);
+
+  files.paths[fake_download(2)] = "/tied/b.torrent";
+  registry.update(fake_download(2));
+
+  CPPUNIT_ASSERT(registry.size_files() == 1);
+  CPPUNIT_ASSERT(registry.state(fake_download(2)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT(registry.downloads_with_state(utils::TiedFileRegistry::state_present).empty());
+
+  files.paths[fake_download(1)] = "/tied/b.torrent";
+  registry.update(fake_download(1));
+  registry.update(fake_download(3));
+
+  CPPUNIT_ASSERT(registry.size_files() == 1);
+  CPPUNIT_ASSERT((registry.downloads_with_state(utils::TiedFileRegistry::state_unknown) == download_list{fake_download(1), fake_download(2)}));
+}
+
+void
+TestTiedFileRegistry::test_reconcile() {
+  fake_tied_files         files;
+  utils::TiedFileRegistry registry;
+
+  files.attach(registry);
+  files.paths[fake_download(1)] = "/tied/a.torrent";
+  files.paths[fake_download(2)] = "/tied/b.torrent";
+  files.paths[fake_download(3)] = "/tied/c.torrent";
+
+  for (uintptr_t id = 1; id <= 3; id++)
+    registry.insert(fake_download(id));
+
+  registry.receive_reconcile({"/tied/a.torrent", "/tied/b.torrent", "/tied/gone.torrent"}, {1, 0, 1}, registry.generation());
+
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_present);
+  CPPUNIT_ASSERT(registry.state(fake_download(2)) == utils::TiedFileRegistry::state_missing);
+  CPPUNIT_ASSERT(registry.state(fake_download(3)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT(registry.size_files() == 3);
+
+  registry.receive_reconcile({"/tied/a.torrent", "/tied/b.torrent", "/tied/c.torrent"}, {0, 0, 1}, registry.generation());
+
+  CPPUNIT_ASSERT((registry.downloads_with_state(utils::TiedFileRegistry::state_missing) == download_list{fake_download(1), fake_download(2)}));
+  CPPUNIT_ASSERT((registry.downloads_with_state(utils::TiedFileRegistry::state_present) == download_list{fake_download(3)}));
+  CPPUNIT_ASSERT(registry.count_state(utils::TiedFileRegistry::state_unknown) == 0);
+}
+
+void
+TestTiedFileRegistry::test_reconcile_generation() {
+  fake_tied_files         files;
+  utils::TiedFileRegistry registry;
+
+  files.attach(registry);
+  files.paths[fake_download(1)] = "/nonexistent/tied/a.torrent";
+
+  registry.insert(fake_download(1));
+
+  auto generation = registry.generation();
+
+  // Files added or changed while the stats were in progress keep
+  // their state.
+  files.paths[fake_download(2)] = "/nonexistent/tied/b.torrent";
+  registry.insert(fake_download(2));
+  registry.receive_event("/nonexistent/tied/a.torrent");
+
+  CPPUNIT_ASSERT(registry.generation() > generation);
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_missing);
+
+  registry.receive_reconcile({"/nonexistent/tied/a.torrent", "/nonexistent/tied/b.torrent"}, {1, 1}, generation);
+
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_missing);
+  CPPUNIT_ASSERT(registry.state(fake_download(2)) == utils::TiedFileRegistry::state_unknown);
+
+  registry.receive_reconcile({"/nonexistent/tied/a.torrent", "/nonexistent/tied/b.torrent"}, {1, 1}, registry.generation());
+
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_present);
+  CPPUNIT_ASSERT(registry.state(fake_download(2)) == utils::TiedFileRegistry::state_present);
+}
+
+void
+TestTiedFileRegistry::test_remove() {
+  fake_tied_files         files;
+  utils::TiedFileRegistry registry;
+
+  files.attach(registry);
+  files.paths[fake_download(1)] = "/tied/a.torrent";
+  files.paths[fake_download(2)] = "/tied/a.torrent";
+  files.paths[fake_download(3)] = "/tied/b.torrent";
+
+  for (uintptr_t id = 1; id <= 3; id++)
+    registry.insert(fake_download(id));
+
+  registry.receive_reconcile({"/tied/a.torrent", "/tied/b.torrent"}, {0, 0}, registry.generation());
+
+  registry.erase(fake_download(1));
+  registry.erase(fake_download(3));
+  registry.erase(fake_download(4));
+
+  CPPUNIT_ASSERT(registry.size_downloads() == 1);
+  CPPUNIT_ASSERT(registry.size_files() == 1);
+  CPPUNIT_ASSERT(registry.state(fake_download(1)) == utils::TiedFileRegistry::state_unknown);
+  CPPUNIT_ASSERT((registry.downloads_with_state(utils::TiedFileRegistry::state_missing) == download_list{fake_download(2)}));
+
+  registry.erase(fake_download(2));
+
+  CPPUNIT_ASSERT(registry.size_downloads() == 0);
+  CPPUNIT_ASSERT(registry.size_files() == 0);
+  CPPUNIT_ASSERT(registry.downloads_with_state(utils::TiedFileRegistry::state_missing).empty());
+}
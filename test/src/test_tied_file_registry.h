@@ -0,0 +1,20 @@
+#include "test/helpers/test_main_thread.h"
+
+class TestTiedFileRegistry : public TestFixtureWithMainThread {
+  CPPUNIT_TEST_SUITE(TestTiedFileRegistry);
+
+  CPPUNIT_TEST(test_tie);
+  CPPUNIT_TEST(test_untie);
+  CPPUNIT_TEST(test_reconcile);
+  CPPUNIT_TEST(test_reconcile_generation);
+  CPPUNIT_TEST(test_remove);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_tie();
+  void test_untie();
+  void test_reconcile();
+  void test_reconcile_generation();
+  void test_remove();
+};
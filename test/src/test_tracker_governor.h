@@ -0,0 +1,22 @@
+#include "test/helpers/test_fixture.h"
+
+class TestTrackerGovernor : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestTrackerGovernor);
+
+  CPPUNIT_TEST(test_url_host);
+  CPPUNIT_TEST(test_defaults);
+  CPPUNIT_TEST(test_token_bucket);
+  CPPUNIT_TEST(test_max_active);
+  CPPUNIT_TEST(test_queue);
+  CPPUNIT_TEST(test_idle);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_url_host();
+  void test_defaults();
+  void test_token_bucket();
+  void test_max_active();
+  void test_queue();
+  void test_idle();
+};
@@ -0,0 +1,118 @@
+#include "config.h"
+
+#include "test/src/test_view_stats.h"
+
+#include <map>
+
+#include "core/view_stats.h"
+#include "test/helpers/fake_download.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestViewStats);
+
+static core::ViewStats::stats_type
+make_stats(bool complete, bool active, uint64_t size_bytes, uint64_t left_bytes, uint64_t up_rate = 0) {
+  core::ViewStats::stats_type stats;
+
+  stats.size            = 1;
+  stats.complete        = complete;
+  stats.active          = active;
+  stats.size_bytes      = size_bytes;
+  stats.completed_bytes = size_bytes - left_bytes;
+  stats.left_bytes      = left_bytes;
+  stats.up_rate         = up_rate;
+
+  return stats;
+}
+
+void
+TestViewStats::test_insert_erase() {
+  core::ViewStats stats;
+
+  stats.insert(fake_download(1), make_stats(true, false, 100, 0));
+  stats.insert(fake_download(2), make_stats(false, true, 50, 20));
+
+  CPPUNIT_ASSERT(stats.size() == 2);
+  CPPUNIT_ASSERT(stats.totals().size == 2);
+  CPPUNIT_ASSERT(stats.totals().complete == 1);
+  CPPUNIT_ASSERT(stats.totals().active == 1);
+  CPPUNIT_ASSERT(stats.totals().size_bytes == 150);
+  CPPUNIT_ASSERT(stats.totals().completed_bytes == 130);
+  CPPUNIT_ASSERT(stats.totals().left_bytes == 20);
+
+  // Inserting again replaces the contribution instead of adding it.
+  stats.insert(fake_download(2), make_stats(false, true, 50, 10));
+
+  CPPUNIT_ASSERT(stats.totals().size == 2);
+  CPPUNIT_ASSERT(stats.totals().left_bytes == 10);
+
+  stats.erase(fake_download(1));
+  stats.erase(fake_download(3));
+
+  CPPUNIT_ASSERT(stats.size() == 1);
+  CPPUNIT_ASSERT(stats.totals().size == 1);
+  CPPUNIT_ASSERT(stats.totals().complete == 0);
+  CPPUNIT_ASSERT(stats.totals().size_bytes == 50);
+
+  stats.clear();
+
+  CPPUNIT_ASSERT(stats.size() == 0);
+  CPPUNIT_ASSERT(stats.size_live() == 0);
+  CPPUNIT_ASSERT(stats.totals().size == 0);
+  CPPUNIT_ASSERT(stats.totals().size_bytes == 0);
+}
+
+void
+TestViewStats::test_update() {
+  core::ViewStats stats;
+
+  stats.insert(fake_download(1), make_stats(false, true, 100, 40));
+
+  CPPUNIT_ASSERT(stats.update(fake_download(1), make_stats(true, true, 100, 0)));
+  CPPUNIT_ASSERT(stats.totals().complete == 1);
+  CPPUNIT_ASSERT(stats.totals().left_bytes == 0);
+
+  // Downloads not in the view aren't added by an update.
+  CPPUNIT_ASSERT(!stats.update(fake_download(2), make_stats(false, true, 10, 10)));
+  CPPUNIT_ASSERT(stats.size() == 1);
+  CPPUNIT_ASSERT(stats.totals().size_bytes == 100);
+}
+
+void
+TestViewStats::test_update_live() {
+  core::ViewStats stats;
+
+  stats.insert(fake_download(1), make_stats(true, false, 100, 0));
+  stats.insert(fake_download(2), make_stats(false, true, 100, 50, 10));
+  stats.insert(fake_download(3), make_stats(true, false, 100, 0, 5));
+
+  // Stopped downloads without any rate aren't sampled.
+  CPPUNIT_ASSERT(stats.size_live() == 2);
+  CPPUNIT_ASSERT(stats.totals().up_rate == 15);
+
+  std::map<core::Download*, core::ViewStats::stats_type> current{
+    {fake_download(2), make_stats(false, true, 100, 30, 20)},
+    {fake_download(3), make_stats(true, false, 100, 0, 0)},
+  };
+
+  std::map<core::Download*, int> sampled;
+
+  stats.update_live([&](core::Download* download) {
+      sampled[download]++;
+      return current.at(download);
+    });
+
+  CPPUNIT_ASSERT(sampled.size() == 2);
+  CPPUNIT_ASSERT(sampled[fake_download(2)] == 1);
+  CPPUNIT_ASSERT(sampled[fake_download(3)] == 1);
+
+  CPPUNIT_ASSERT(stats.totals().up_rate == 20);
+  CPPUNIT_ASSERT(stats.totals().left_bytes == 30);
+
+  // The download whose rate dropped to zero is no longer live.
+  CPPUNIT_ASSERT(stats.size_live() == 1);
+
+  stats.erase(fake_download(2));
+
+  CPPUNIT_ASSERT(stats.size_live() == 0);
+  CPPUNIT_ASSERT(stats.totals().up_rate == 0);
+}
@@ -0,0 +1,16 @@
+#include "test/helpers/test_fixture.h"
+
+class TestViewStats : public test_fixture {
+  CPPUNIT_TEST_SUITE(TestViewStats);
+
+  CPPUNIT_TEST(test_insert_erase);
+  CPPUNIT_TEST(test_update);
+  CPPUNIT_TEST(test_update_live);
+
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void test_insert_erase();
+  void test_update();
+  void test_update_live();
+};